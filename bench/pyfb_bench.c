@@ -0,0 +1,674 @@
+/**
+ * Native benchmark harness of the drawing and flush operations.
+ *
+ * The native sources are linked directly and run against virtual framebuffers, so no
+ * display is needed. Build and run it with:
+ * \code{.sh}
+ * python3 setup.py build_bench
+ * ./build/pyfb_bench --json
+ * \endcode
+ */
+#include "pyframebuffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The framebuffer number the benchmarks draw on.
+ */
+#define BENCH_FB 0
+
+/**
+ * The framebuffer number of the source of the transformed blits.
+ */
+#define BENCH_SOURCE_FB 1
+
+/**
+ * The edge length of the tiles, sprites and arrays the benchmarks draw.
+ */
+#define BENCH_TILE 128
+
+/**
+ * The amount of points of the benchmarked polyline.
+ */
+#define BENCH_POLYLINE 4096
+
+/**
+ * The maximum amount of resolutions and depths to benchmark.
+ */
+#define BENCH_MAX_CONFIGS 16
+
+/**
+ * The default minimum run time of a benchmark case in seconds.
+ */
+#define BENCH_DEFAULT_TIME 0.25
+
+/**
+ * The counters a benchmark case reports for one batch.
+ */
+struct bench_counters {
+    /**
+     * The count of pixels written.
+     */
+    double pixels;
+
+    /**
+     * The count of bytes written to the device.
+     */
+    double bytes;
+};
+
+/**
+ * A benchmark case, running a batch of operations.
+ */
+struct bench_case {
+    /**
+     * The name of the case.
+     */
+    const char* name;
+
+    /**
+     * Runs a batch of operations.
+     *
+     * @param xres The X resolution
+     * @param yres The Y resolution
+     * @param depth The color depth
+     * @param count The amount of operations
+     * @param counters The counters to add the batch to
+     *
+     * @return 0 on success, else -1 with a Python exception set
+     */
+    int (*run)(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+               struct bench_counters* counters);
+};
+
+/**
+ * The state of the pseudo random coordinates, so every run draws the same.
+ */
+static uint32_t bench_seed = 1;
+
+/**
+ * Returns a pseudo random number below a limit.
+ */
+static inline unsigned long int bench_random(unsigned long int limit) {
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return (unsigned long int)((uint64_t)(bench_seed >> 8) * limit >> 24);
+}
+
+/**
+ * The color the benchmarks draw with.
+ */
+static struct pyfb_color bench_color;
+
+static int bench_pixels(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                        struct bench_counters* counters) {
+    for(unsigned long int i = 0; i < count; i++) {
+        pyfb_ssetPixel(BENCH_FB, bench_random(xres), bench_random(yres), &bench_color);
+    }
+
+    counters->pixels += count;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_spans(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                       struct bench_counters* counters) {
+    for(unsigned long int i = 0; i < count; i++) {
+        pyfb_sdrawHorizontalLine(BENCH_FB, 0, i % yres, xres, &bench_color);
+    }
+
+    counters->pixels += (double)count * xres;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_vlines(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                        struct bench_counters* counters) {
+    for(unsigned long int i = 0; i < count; i++) {
+        pyfb_sdrawVerticalLine(BENCH_FB, i % xres, 0, yres, &bench_color);
+    }
+
+    counters->pixels += (double)count * yres;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_lines(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                       struct bench_counters* counters) {
+    for(unsigned long int i = 0; i < count; i++) {
+        unsigned long int x1 = bench_random(xres);
+        unsigned long int y1 = bench_random(yres);
+        unsigned long int x2 = bench_random(xres);
+        unsigned long int y2 = bench_random(yres);
+        unsigned long int dx = x1 > x2 ? x1 - x2 : x2 - x1;
+        unsigned long int dy = y1 > y2 ? y1 - y2 : y2 - y1;
+
+        pyfb_sdrawLine(BENCH_FB, x1, y1, x2, y2, &bench_color);
+        counters->pixels += (dx > dy ? dx : dy) + 1;
+    }
+
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_circles(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                         struct bench_counters* counters) {
+    unsigned long int radius = (xres < yres ? xres : yres) / 4;
+
+    for(unsigned long int i = 0; i < count; i++) {
+        unsigned long int xm = radius + bench_random(xres - 2 * radius);
+        unsigned long int ym = radius + bench_random(yres - 2 * radius);
+
+        pyfb_sdrawCircle(BENCH_FB, xm, ym, radius, &bench_color);
+    }
+
+    // a circle sets about 2 * pi * r pixels
+    counters->pixels += (double)count * radius * 6.283;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_ellipses(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                          struct bench_counters* counters) {
+    unsigned long int a = (xres < yres ? xres : yres) / 4;
+    unsigned long int b = a / 2;
+
+    for(unsigned long int i = 0; i < count; i++) {
+        unsigned long int xm = a + bench_random(xres - 2 * a);
+        unsigned long int ym = b + bench_random(yres - 2 * b);
+
+        pyfb_sdrawEllipse(BENCH_FB, xm, ym, a, b, &bench_color);
+    }
+
+    // the circumference of an ellipse with b = a / 2 is about 4.844 * a
+    counters->pixels += (double)count * a * 4.844;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_text(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                      struct bench_counters* counters) {
+    // a PSF1 font of 256 glyphs of 8x16 pixels with a stripe pattern, so no font file is needed
+    uint8_t font_data[4 + 256 * 16] = {0x36, 0x04, 0, 16};
+    for(size_t i = 4; i < sizeof(font_data); i++) {
+        font_data[i] = (uint8_t)(i * 37);
+    }
+
+    int fontnum = pyfb_loadFont(font_data, sizeof(font_data));
+    if(fontnum < 0) {
+        return -1;
+    }
+
+    // lines of 32 characters, which draw from the glyph cache of the color
+    uint32_t text[32];
+    for(int i = 0; i < 32; i++) {
+        text[i] = 'A' + i;
+    }
+
+    for(unsigned long int i = 0; i < count; i++) {
+        pyfb_sdrawText(BENCH_FB,
+                       bench_random(xres - 32 * 8),
+                       bench_random(yres - 16),
+                       text,
+                       32,
+                       (uint8_t)fontnum,
+                       &bench_color,
+                       NULL);
+    }
+
+    pyfb_freeFont((uint8_t)fontnum);
+    counters->pixels += (double)count * 32 * 8 * 16;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static int bench_copyArea(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                          struct bench_counters* counters) {
+    // scroll the screen up by one row
+    for(unsigned long int i = 0; i < count; i++) {
+        pyfb_scopyArea(BENCH_FB, 0, 1, xres, yres - 1, 0, 0);
+    }
+
+    counters->pixels += (double)count * xres * (yres - 1);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+/**
+ * The RGBA8888 pixels of a tile, opaque inside of a disc and transparent around it.
+ */
+static uint8_t bench_tile[BENCH_TILE * BENCH_TILE * 4];
+
+/**
+ * Fills the tile pixels.
+ *
+ * @return The count of opaque pixels
+ */
+static unsigned long int bench_fillTile(void) {
+    unsigned long int opaque = 0;
+    long int center          = BENCH_TILE / 2;
+
+    for(long int y = 0; y < BENCH_TILE; y++) {
+        for(long int x = 0; x < BENCH_TILE; x++) {
+            uint8_t* pixel = bench_tile + (y * BENCH_TILE + x) * 4;
+            int inside     = (x - center) * (x - center) + (y - center) * (y - center) < center * center;
+
+            pixel[0] = (uint8_t)(x * 2);
+            pixel[1] = (uint8_t)(y * 2);
+            pixel[2] = 0x80;
+            pixel[3] = inside ? 0xFF : 0x00;
+            opaque += inside;
+        }
+    }
+
+    return opaque;
+}
+
+static int bench_writeRect(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                           struct bench_counters* counters) {
+    bench_fillTile();
+
+    for(unsigned long int i = 0; i < count; i++) {
+        if(pyfb_suploadRect(BENCH_FB,
+                            bench_random(xres - BENCH_TILE),
+                            bench_random(yres - BENCH_TILE),
+                            BENCH_TILE,
+                            BENCH_TILE,
+                            bench_tile,
+                            sizeof(bench_tile)) != 0) {
+            return -1;
+        }
+    }
+
+    counters->pixels += (double)count * BENCH_TILE * BENCH_TILE;
+    return 0;
+}
+
+static int bench_blitTransformed(unsigned long int xres,
+                                 unsigned long int yres,
+                                 unsigned int depth,
+                                 unsigned long int count,
+                                 struct bench_counters* counters) {
+    // the tile rotated by 30 degrees around its center, bilinear sampled
+    if(pyfb_openVirtual(BENCH_SOURCE_FB, BENCH_TILE, BENCH_TILE, depth, -1, PYFB_DUMP_RAW) != 0) {
+        return -1;
+    }
+
+    bench_fillTile();
+    int exitcode = pyfb_suploadRect(BENCH_SOURCE_FB, 0, 0, BENCH_TILE, BENCH_TILE, bench_tile, sizeof(bench_tile));
+
+    const double c = 0.8660254;
+    const double s = 0.5;
+
+    for(unsigned long int i = 0; i < count && exitcode == 0; i++) {
+        double dx        = (double)bench_random(xres - BENCH_TILE) + BENCH_TILE / 2;
+        double dy        = (double)bench_random(yres - BENCH_TILE) + BENCH_TILE / 2;
+        double matrix[6] = {c, -s, dx - (c - s) * BENCH_TILE / 2, s, c, dy - (s + c) * BENCH_TILE / 2};
+        exitcode         = pyfb_sblitTransformed(BENCH_FB, BENCH_SOURCE_FB, matrix, PYFB_FILTER_BILINEAR);
+    }
+
+    pyfb_close(BENCH_SOURCE_FB);
+    counters->pixels += (double)count * BENCH_TILE * BENCH_TILE;
+    return exitcode;
+}
+
+static int bench_sprite(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                        struct bench_counters* counters) {
+    // the disc of the tile, dropping the transparent corners
+    unsigned long int opaque = bench_fillTile();
+    int spritenum            = pyfb_loadSprite(bench_tile, sizeof(bench_tile), BENCH_TILE, BENCH_TILE, NULL, 128);
+    if(spritenum < 0) {
+        return -1;
+    }
+
+    int exitcode = 0;
+    for(unsigned long int i = 0; i < count && exitcode == 0; i++) {
+        exitcode = pyfb_sdrawSprite(BENCH_FB,
+                                    (uint8_t)spritenum,
+                                    (long int)bench_random(xres - BENCH_TILE),
+                                    (long int)bench_random(yres - BENCH_TILE));
+    }
+
+    pyfb_freeSprite((uint8_t)spritenum);
+    counters->pixels += (double)count * opaque;
+    return exitcode;
+}
+
+static int bench_blitScalar(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                            struct bench_counters* counters) {
+    // a float heatmap of the tile size through a gray colormap
+    static float values[BENCH_TILE * BENCH_TILE];
+    uint32_t colormap[PYFB_COLORMAP_SIZE];
+
+    for(int i = 0; i < BENCH_TILE * BENCH_TILE; i++) {
+        values[i] = (float)((i * 7) % 1000);
+    }
+
+    for(unsigned int i = 0; i < PYFB_COLORMAP_SIZE; i++) {
+        colormap[i] = i * 0x01010100u | 0xFF;
+    }
+
+    for(unsigned long int i = 0; i < count; i++) {
+        if(pyfb_sblitScalar(BENCH_FB,
+                            values,
+                            sizeof(values),
+                            PYFB_SCALAR_F32,
+                            BENCH_TILE,
+                            BENCH_TILE,
+                            (long int)bench_random(xres - BENCH_TILE),
+                            (long int)bench_random(yres - BENCH_TILE),
+                            colormap,
+                            0.0,
+                            1000.0,
+                            1) != 0) {
+            return -1;
+        }
+    }
+
+    counters->pixels += (double)count * BENCH_TILE * BENCH_TILE;
+    return 0;
+}
+
+static int bench_polyline(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                          struct bench_counters* counters) {
+    // a trace of random samples over the width of the screen
+    static double points[BENCH_POLYLINE * 2];
+    double pixels = 0;
+
+    for(int i = 0; i < BENCH_POLYLINE; i++) {
+        points[i * 2]     = (double)i * (xres - 1) / (BENCH_POLYLINE - 1);
+        points[i * 2 + 1] = (double)bench_random(yres);
+
+        if(i > 0) {
+            double dx = points[i * 2] - points[i * 2 - 2];
+            double dy = points[i * 2 + 1] - points[i * 2 - 1];
+            dy        = dy < 0 ? -dy : dy;
+            pixels += dx > dy ? dx : dy;
+        }
+    }
+
+    for(unsigned long int i = 0; i < count; i++) {
+        if(pyfb_sdrawPolyline(BENCH_FB, points, sizeof(points), PYFB_SCALAR_F64, 0, &bench_color) != 0) {
+            return -1;
+        }
+    }
+
+    counters->pixels += (double)count * pixels;
+    return 0;
+}
+
+static int bench_flush(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                       struct bench_counters* counters) {
+    for(unsigned long int i = 0; i < count; i++) {
+        if(pyfb_flushBuffer(BENCH_FB) != 0) {
+            return -1;
+        }
+    }
+
+    counters->bytes += (double)count * xres * yres * (depth / 8);
+    return 0;
+}
+
+static int bench_rotate(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                        struct bench_counters* counters) {
+    // the same flush as above, but assembling the device rows from the canvas columns
+    if(pyfb_ssetRotation(BENCH_FB, 90, 0) != 0) {
+        return -1;
+    }
+
+    int exitcode = 0;
+    for(unsigned long int i = 0; i < count && exitcode == 0; i++) {
+        exitcode = pyfb_flushBuffer(BENCH_FB);
+    }
+
+    pyfb_ssetRotation(BENCH_FB, 0, 0);
+    counters->bytes += (double)count * xres * yres * (depth / 8);
+    return exitcode;
+}
+
+static int bench_indexed(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                         struct bench_counters* counters) {
+    // the same flush as above, but expanding the palette indices to the device rows
+    uint32_t palette[PYFB_PALETTE_SIZE];
+    for(unsigned int i = 0; i < PYFB_PALETTE_SIZE; i++) {
+        palette[i] = i * 0x01010100u | 0xFF;
+    }
+
+    if(pyfb_ssetPalette(BENCH_FB, palette, PYFB_PALETTE_SIZE) != 0) {
+        return -1;
+    }
+
+    int exitcode = 0;
+    for(unsigned long int i = 0; i < count && exitcode == 0; i++) {
+        exitcode = pyfb_flushBuffer(BENCH_FB);
+    }
+
+    pyfb_sclearPalette(BENCH_FB);
+    counters->bytes += (double)count * xres * yres * (depth / 8);
+    return exitcode;
+}
+
+static int bench_triangles(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                           struct bench_counters* counters) {
+    // shaded triangles with 64 pixel legs
+    const uint32_t colors[3] = {0xFF0000FF, 0x00FF00FF, 0x0000FFFF};
+
+    for(unsigned long int i = 0; i < count; i++) {
+        double x         = (double)bench_random(xres - 64);
+        double y         = (double)bench_random(yres - 64);
+        double coords[6] = {x, y, x + 64, y, x, y + 64};
+
+        if(pyfb_sfillTriangle(BENCH_FB, coords, colors) != 0) {
+            return -1;
+        }
+    }
+
+    counters->pixels += (double)count * 64 * 64 / 2;
+    return 0;
+}
+
+static int bench_gradient(unsigned long int xres, unsigned long int yres, unsigned int depth, unsigned long int count,
+                          struct bench_counters* counters) {
+    // a diagonal background of three stops, dithered on 16 bit
+    struct pyfb_gradient gradient = {0};
+    gradient.type                 = PYFB_GRADIENT_LINEAR;
+    gradient.x1                   = (double)xres;
+    gradient.y1                   = (double)yres;
+    gradient.stops                = 3;
+    gradient.offsets[1]           = 0.5;
+    gradient.offsets[2]           = 1.0;
+    gradient.colors[0]            = 0x000040FF;
+    gradient.colors[1]            = 0x60A0FFFF;
+    gradient.colors[2]            = 0xFFFFFFFF;
+
+    for(unsigned long int i = 0; i < count; i++) {
+        if(pyfb_sfillGradient(BENCH_FB, &gradient, 0, 0, xres, yres, PYFB_SHAPE_RECT, 1) != 0) {
+            return -1;
+        }
+    }
+
+    counters->pixels += (double)count * xres * yres;
+    return 0;
+}
+
+/**
+ * All benchmark cases.
+ */
+static const struct bench_case bench_cases[] = {
+    {"pixels", bench_pixels},
+    {"spans", bench_spans},
+    {"vlines", bench_vlines},
+    {"lines", bench_lines},
+    {"circles", bench_circles},
+    {"ellipses", bench_ellipses},
+    {"text", bench_text},
+    {"copyArea", bench_copyArea},
+    {"writeRect", bench_writeRect},
+    {"blitTransformed", bench_blitTransformed},
+    {"sprite", bench_sprite},
+    {"blitScalar", bench_blitScalar},
+    {"polyline", bench_polyline},
+    {"flush", bench_flush},
+    {"rotate", bench_rotate},
+    {"indexed", bench_indexed},
+    {"triangles", bench_triangles},
+    {"gradient", bench_gradient},
+};
+
+/**
+ * Returns the monotonic time in seconds.
+ */
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Prints the usage of the harness.
+ */
+static void bench_usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [--json] [--time SECONDS] [--resolution WxH]... [--depth 16|32]...\n"
+            "Benchmarks the native drawing and flush operations on virtual framebuffers.\n"
+            "Defaults are the resolutions 320x240, 800x480 and 1920x1080 at 16 and 32 bit,\n"
+            "a resolution must be at least %dx%d.\n",
+            name,
+            2 * BENCH_TILE,
+            BENCH_TILE);
+}
+
+int main(int argc, char** argv) {
+    unsigned long int xres[BENCH_MAX_CONFIGS];
+    unsigned long int yres[BENCH_MAX_CONFIGS];
+    unsigned int depths[BENCH_MAX_CONFIGS];
+    int resolutions = 0;
+    int depth_count = 0;
+    int json        = 0;
+    double min_time = BENCH_DEFAULT_TIME;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if(strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else if(strcmp(argv[i], "--resolution") == 0 && i + 1 < argc && resolutions < BENCH_MAX_CONFIGS) {
+            if(sscanf(argv[++i], "%lux%lu", &xres[resolutions], &yres[resolutions]) != 2 ||
+               xres[resolutions] < 2 * BENCH_TILE || yres[resolutions] < BENCH_TILE) {
+                bench_usage(argv[0]);
+                return 2;
+            }
+            resolutions++;
+        } else if(strcmp(argv[i], "--depth") == 0 && i + 1 < argc && depth_count < BENCH_MAX_CONFIGS) {
+            depths[depth_count++] = (unsigned int)atoi(argv[++i]);
+        } else {
+            bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if(resolutions == 0) {
+        unsigned long int default_xres[] = {320, 800, 1920};
+        unsigned long int default_yres[] = {240, 480, 1080};
+
+        for(resolutions = 0; resolutions < 3; resolutions++) {
+            xres[resolutions] = default_xres[resolutions];
+            yres[resolutions] = default_yres[resolutions];
+        }
+    }
+
+    if(depth_count == 0) {
+        depths[depth_count++] = 16;
+        depths[depth_count++] = 32;
+    }
+
+    // the native sources report errors as Python exceptions
+    Py_InitializeEx(0);
+    pyfb_init();
+    pyfb_initcolor_u32(&bench_color, 0x3399CCFF);
+
+    if(json) {
+        printf("[");
+    } else {
+        printf("%-11s %5s %-15s %14s %12s %10s\n", "resolution", "depth", "case", "ops/s", "Mpixels/s", "MB/s");
+    }
+
+    int first = 1;
+
+    for(int r = 0; r < resolutions; r++) {
+        for(int d = 0; d < depth_count; d++) {
+            if(pyfb_openVirtual(BENCH_FB, xres[r], yres[r], depths[d], -1, PYFB_DUMP_RAW) != 0) {
+                PyErr_Print();
+                Py_Finalize();
+                return 1;
+            }
+
+            for(size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++) {
+                struct bench_counters counters = {0, 0};
+                unsigned long int ops          = 0;
+                unsigned long int batch        = 1;
+                double start                   = bench_now();
+                double elapsed                 = 0;
+
+                // double the batches until the minimum time is reached
+                bench_seed = 1;
+                while(elapsed < min_time) {
+                    // a failing case would report the timing of doing nothing
+                    if(bench_cases[c].run(xres[r], yres[r], depths[d], batch, &counters) != 0 || PyErr_Occurred()) {
+                        fprintf(stderr,
+                                "The case %s failed at %lux%lu, %u bit:\n",
+                                bench_cases[c].name,
+                                xres[r],
+                                yres[r],
+                                depths[d]);
+                        PyErr_Print();
+                        pyfb_close(BENCH_FB);
+                        Py_Finalize();
+                        return 1;
+                    }
+
+                    ops += batch;
+                    batch *= 2;
+                    elapsed = bench_now() - start;
+                }
+
+                double ops_s    = ops / elapsed;
+                double pixels_s = counters.pixels / elapsed;
+                double bytes_s  = counters.bytes / elapsed;
+
+                if(json) {
+                    printf("%s\n  {\"resolution\": \"%lux%lu\", \"width\": %lu, \"height\": %lu, \"depth\": %u, "
+                           "\"case\": \"%s\", \"ops\": %lu, \"seconds\": %.6f, \"ops_per_s\": %.1f, "
+                           "\"pixels_per_s\": %.1f, \"bytes_per_s\": %.1f}",
+                           first ? "" : ",",
+                           xres[r],
+                           yres[r],
+                           xres[r],
+                           yres[r],
+                           depths[d],
+                           bench_cases[c].name,
+                           ops,
+                           elapsed,
+                           ops_s,
+                           pixels_s,
+                           bytes_s);
+                } else {
+                    char resolution[24];
+                    snprintf(resolution, sizeof(resolution), "%lux%lu", xres[r], yres[r]);
+                    printf("%-11s %5u %-15s %14.1f %12.2f %10.1f\n",
+                           resolution,
+                           depths[d],
+                           bench_cases[c].name,
+                           ops_s,
+                           pixels_s / 1e6,
+                           bytes_s / 1e6);
+                }
+
+                first = 0;
+            }
+
+            pyfb_close(BENCH_FB);
+        }
+    }
+
+    if(json) {
+        printf("\n]\n");
+    }
+
+    Py_Finalize();
+    return 0;
+}
@@ -0,0 +1,349 @@
+/**
+ * Async worker sources.
+ */
+#include "pyframebuffer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/**
+ * The async worker of a framebuffer.
+ */
+struct pyfb_async {
+    /**
+     * The lock of the slot, held while starting, stopping and using the worker.
+     */
+    lock_t lock;
+
+    /**
+     * Not 0 if the worker is started.
+     */
+    int used;
+
+    /**
+     * The framebuffer number.
+     */
+    uint8_t fbnum;
+
+    /**
+     * The eventfd signaled on every completion.
+     */
+    int efd;
+
+    /**
+     * Cleared to stop the worker thread, protected by the mutex.
+     */
+    int running;
+
+    /**
+     * The ticket of the last requested flush, protected by the mutex.
+     */
+    unsigned long int flush_requested;
+
+    /**
+     * Not 0 if the last requested flush has not started yet, protected by the mutex.
+     */
+    int flush_pending;
+
+    /**
+     * The ticket of the last requested frame clock wait, protected by the mutex.
+     */
+    unsigned long int tick_requested;
+
+    /**
+     * Not 0 if the last requested frame clock wait has not started yet, protected by the mutex.
+     */
+    int tick_pending;
+
+    /**
+     * The clock of the last requested frame clock wait, protected by the mutex.
+     */
+    uint8_t tick_clock;
+
+    /**
+     * The completion state, protected by the mutex.
+     */
+    struct pyfb_asyncstate state;
+
+    /**
+     * The worker thread.
+     */
+    pthread_t thread;
+
+    /**
+     * The mutex protecting the requests and the completion state.
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     * Signaled if a request is pending or the worker is stopped.
+     */
+    pthread_cond_t cond;
+};
+
+/**
+ * The async workers, one per framebuffer.
+ */
+static struct pyfb_async asyncs[MAX_FRAMEBUFFERS];
+
+void __APISTATUS_internal pyfb_asyncinit(void) {
+    for(int i = 0; i < MAX_FRAMEBUFFERS; i++) {
+        memset((void*)&asyncs[i], 0, sizeof(struct pyfb_async));
+        atomic_flag flag = ATOMIC_FLAG_INIT;
+        asyncs[i].lock   = flag;
+        asyncs[i].efd    = -1;
+    }
+}
+
+/**
+ * The worker thread, running the requests one after another. Flushes go first, as a
+ * frame clock wait may take a whole frame.
+ */
+static void* pyfb_asyncThread(void* arg) {
+    struct pyfb_async* worker = (struct pyfb_async*)arg;
+
+    pthread_mutex_lock(&worker->mutex);
+
+    while(1) {
+        while(worker->running && !worker->flush_pending && !worker->tick_pending) {
+            pthread_cond_wait(&worker->cond, &worker->mutex);
+        }
+
+        if(!worker->running) {
+            break;
+        }
+
+        if(worker->flush_pending) {
+            unsigned long int ticket = worker->flush_requested;
+            worker->flush_pending    = 0;
+            pthread_mutex_unlock(&worker->mutex);
+
+            // the flush does not set a Python exception for a valid framebuffer number
+            errno     = 0;
+            int error = pyfb_flushBuffer(worker->fbnum) == 0 ? 0 : (errno != 0 ? errno : EBADF);
+
+            pthread_mutex_lock(&worker->mutex);
+            worker->state.flush_done  = ticket;
+            worker->state.flush_error = error;
+        } else {
+            unsigned long int ticket = worker->tick_requested;
+            uint8_t clocknum         = worker->tick_clock;
+            worker->tick_pending     = 0;
+            pthread_mutex_unlock(&worker->mutex);
+
+            struct pyfb_clocktick tick;
+            int error = pyfb_clockWait(clocknum, &tick) == 0 ? 0 : errno;
+
+            pthread_mutex_lock(&worker->mutex);
+            worker->state.tick_done  = ticket;
+            worker->state.tick_error = error;
+            if(error == 0) {
+                worker->state.tick = tick;
+            }
+        }
+
+        // wake the event loop, the counter of the eventfd merges the completions
+        uint64_t one = 1;
+        ssize_t len  = write(worker->efd, &one, sizeof(one));
+        (void)len;
+    }
+
+    pthread_mutex_unlock(&worker->mutex);
+    return NULL;
+}
+
+/**
+ * Checks the framebuffer number and locks the slot of a started worker.
+ *
+ * @return The worker, or NULL with a Python exception set
+ */
+static struct pyfb_async* pyfb_asyncLock(uint8_t fbnum) {
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return NULL;
+    }
+
+    lock(asyncs[fbnum].lock);
+
+    if(!asyncs[fbnum].used) {
+        PyErr_SetString(PyExc_IOError, "The async worker is not started");
+        unlock(asyncs[fbnum].lock);
+        return NULL;
+    }
+
+    return &asyncs[fbnum];
+}
+
+int pyfb_sasyncOpen(uint8_t fbnum) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    struct pyfb_async* worker = &asyncs[fbnum];
+
+    lock(worker->lock);
+
+    if(worker->used) {
+        PyErr_SetString(PyExc_IOError, "The async worker is already started");
+        unlock(worker->lock);
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+    int used = pyfb_fbused(fbnum);
+    pyfb_fbunlock(fbnum);
+
+    if(!used) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        unlock(worker->lock);
+        return -1;
+    }
+
+    worker->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(worker->efd == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not create the eventfd of the async worker");
+        unlock(worker->lock);
+        return -1;
+    }
+
+    worker->fbnum           = fbnum;
+    worker->running         = 1;
+    worker->flush_requested = 0;
+    worker->flush_pending   = 0;
+    worker->tick_requested  = 0;
+    worker->tick_pending    = 0;
+    memset(&worker->state, 0, sizeof(struct pyfb_asyncstate));
+
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+
+    if(pthread_create(&worker->thread, NULL, pyfb_asyncThread, worker) != 0) {
+        PyErr_SetString(PyExc_IOError, "Could not start the async worker thread");
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->mutex);
+        close(worker->efd);
+        worker->efd = -1;
+        unlock(worker->lock);
+        return -1;
+    }
+
+    worker->used = 1;
+
+    int efd = worker->efd;
+    unlock(worker->lock);
+    return efd;
+}
+
+int pyfb_sasyncClose(uint8_t fbnum) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    struct pyfb_async* worker = &asyncs[fbnum];
+
+    lock(worker->lock);
+
+    if(!worker->used) {
+        unlock(worker->lock);
+        return 0;
+    }
+
+    // a running request finishes first, pending requests are dropped
+    pthread_mutex_lock(&worker->mutex);
+    worker->running = 0;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    pthread_join(worker->thread, NULL);
+
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+    close(worker->efd);
+    worker->efd  = -1;
+    worker->used = 0;
+
+    unlock(worker->lock);
+    return 0;
+}
+
+unsigned long int pyfb_sasyncFlush(uint8_t fbnum) {
+    struct pyfb_async* worker = pyfb_asyncLock(fbnum);
+    if(worker == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+
+    // merge into a flush which has not started yet
+    if(!worker->flush_pending) {
+        worker->flush_requested++;
+        worker->flush_pending = 1;
+        pthread_cond_signal(&worker->cond);
+    }
+
+    unsigned long int ticket = worker->flush_requested;
+
+    pthread_mutex_unlock(&worker->mutex);
+    unlock(worker->lock);
+    return ticket;
+}
+
+unsigned long int pyfb_sasyncTick(uint8_t fbnum, uint8_t clocknum) {
+    if(clocknum >= MAX_CLOCKS) {
+        PyErr_SetString(PyExc_ValueError, "The frame clock number is not valid");
+        return 0;
+    }
+
+    struct pyfb_async* worker = pyfb_asyncLock(fbnum);
+    if(worker == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+
+    if(worker->tick_pending && worker->tick_clock != clocknum) {
+        PyErr_SetString(PyExc_IOError, "A wait for another frame clock is pending");
+        pthread_mutex_unlock(&worker->mutex);
+        unlock(worker->lock);
+        return 0;
+    }
+
+    // merge into a wait which has not started yet
+    if(!worker->tick_pending) {
+        worker->tick_requested++;
+        worker->tick_pending = 1;
+        worker->tick_clock   = clocknum;
+        pthread_cond_signal(&worker->cond);
+    }
+
+    unsigned long int ticket = worker->tick_requested;
+
+    pthread_mutex_unlock(&worker->mutex);
+    unlock(worker->lock);
+    return ticket;
+}
+
+int pyfb_sasyncPoll(uint8_t fbnum, struct pyfb_asyncstate* state) {
+    struct pyfb_async* worker = pyfb_asyncLock(fbnum);
+    if(worker == NULL) {
+        return -1;
+    }
+
+    // clear the eventfd before reading the state, so no completion is missed
+    uint64_t count;
+    ssize_t len = read(worker->efd, &count, sizeof(count));
+    (void)len;
+
+    pthread_mutex_lock(&worker->mutex);
+    *state = worker->state;
+    pthread_mutex_unlock(&worker->mutex);
+
+    unlock(worker->lock);
+    return 0;
+}
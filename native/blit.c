@@ -0,0 +1,450 @@
+/**
+ * Blit sources.
+ */
+#include "pyframebuffer.h"
+
+#include <endian.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The alpha value from which on a pixel of a 32 bit source is drawn.
+ */
+#define PYFB_BLIT_ALPHA 128
+
+/**
+ * A copy of the canvas of a source framebuffer, so the destination is the only
+ * framebuffer locked while blitting.
+ */
+struct pyfb_surface {
+    /**
+     * The pixels in the offscreen buffer format.
+     */
+    void* pixels;
+
+    /**
+     * The size of the canvas.
+     */
+    unsigned long int xres;
+    unsigned long int yres;
+
+    /**
+     * The pixel depth, 16 or 32.
+     */
+    unsigned int depth;
+};
+
+/**
+ * Copies the canvas of a framebuffer.
+ *
+ * @param fbnum The framebuffer number, must be valid and not locked
+ * @param surface The surface to fill, the pixels must be freed by the caller
+ * @param widen Not 0 to widen 16 bit pixels to 32 bit color values while copying
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+static int pyfb_surfaceCopy(uint8_t fbnum, struct pyfb_surface* surface, int widen) {
+    pyfb_fblock(fbnum);
+
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The source framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    surface->xres                     = fb->canvas.xres;
+    surface->yres                     = fb->canvas.yres;
+    surface->depth                    = fb->fb_info.vinfo.bits_per_pixel == 16 && fb->palette == NULL ? 16 : 32;
+
+    size_t count    = surface->xres * surface->yres;
+    size_t len      = count * (widen ? 4 : surface->depth / 8);
+    surface->pixels = malloc(len);
+
+    if(surface->pixels == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the copy of the source framebuffer");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(fb->palette != NULL) {
+        // an indexed canvas is widened to the colors of its palette, with their alpha
+        const uint32_t* colors = pyfb_paletteColors(fbnum);
+        for(size_t i = 0; i < count; i++) {
+            ((uint32_t*)surface->pixels)[i] = colors[fb->u8_buffer[i]];
+        }
+    } else if(widen && surface->depth == 16) {
+        // the widened pixels are opaque, so the surface keeps the depth of 16 bits
+        for(size_t i = 0; i < count; i++) {
+            ((uint32_t*)surface->pixels)[i] = pyfb_rgba8888(fb->u16_buffer[i]);
+        }
+    } else {
+        memcpy(surface->pixels, fb->u32_buffer, len);
+    }
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+/**
+ * Divides and rounds towards negative infinity.
+ */
+static inline int64_t pyfb_floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/**
+ * Narrows a range of steps to the steps where a fixed point coordinate stays inside
+ * the source, so the inner loops need no bounds checks.
+ *
+ * @param start The coordinate at step 0
+ * @param step The coordinate step
+ * @param limit The end of the source, the coordinate must be below
+ * @param k0 The first step of the range, narrowed in place
+ * @param k1 The step after the range, narrowed in place
+ */
+static void pyfb_blitSpan(int64_t start, int64_t step, int64_t limit, int64_t* k0, int64_t* k1) {
+    int64_t lo, hi;
+
+    if(step == 0) {
+        if(start < 0 || start >= limit) {
+            *k1 = *k0;
+        }
+        return;
+    }
+
+    if(step > 0) {
+        lo = pyfb_floorDiv(-start + step - 1, step);
+        hi = pyfb_floorDiv(limit - start + step - 1, step);
+    } else {
+        lo = pyfb_floorDiv(start - limit, -step) + 1;
+        hi = pyfb_floorDiv(start, -step) + 1;
+    }
+
+    *k0 = lo > *k0 ? lo : *k0;
+    *k1 = hi < *k1 ? hi : *k1;
+}
+
+/**
+ * Interpolates two 32 bit colors, two channels per multiplication.
+ *
+ * @param a The color at the weight 0
+ * @param b The color at the weight 256
+ * @param f The weight of b, 0 to 256
+ */
+static inline uint32_t pyfb_lerp(uint32_t a, uint32_t b, uint32_t f) {
+    uint32_t rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f) >> 8) & 0x00FF00FF;
+    uint32_t ga = ((((a >> 8) & 0x00FF00FF) * (256 - f) + ((b >> 8) & 0x00FF00FF) * f)) & 0xFF00FF00;
+    return rb | ga;
+}
+
+/**
+ * Draws a row with nearest sampling. The fixed point source coordinates stay inside the
+ * source for all pixels of the row.
+ *
+ * @return The count of pixels drawn
+ */
+static unsigned long int pyfb_blitNearest(struct pyfb_framebuffer* fb,
+                                          const struct pyfb_surface* src,
+                                          unsigned long int y,
+                                          int64_t x0,
+                                          int64_t x1,
+                                          int64_t u,
+                                          int64_t v,
+                                          int64_t du,
+                                          int64_t dv) {
+    unsigned long int offset = y * fb->canvas.xres;
+    unsigned long int stride = src->xres;
+    unsigned long int count  = 0;
+
+    if(src->depth == 32) {
+        const uint32_t* in = (const uint32_t*)src->pixels;
+
+        // a transparent pixel of the source keeps the destination
+        if(fb->fb_info.vinfo.bits_per_pixel == 32) {
+            uint32_t* out = fb->u32_buffer + offset;
+            for(int64_t x = x0; x < x1; x++, u += du, v += dv) {
+                uint32_t px = in[(v >> 16) * stride + (u >> 16)];
+                if((px & 0xFF) >= PYFB_BLIT_ALPHA) {
+                    out[x] = px;
+                    count++;
+                }
+            }
+        } else {
+            uint16_t* out = fb->u16_buffer + offset;
+            for(int64_t x = x0; x < x1; x++, u += du, v += dv) {
+                uint32_t px = in[(v >> 16) * stride + (u >> 16)];
+                if((px & 0xFF) >= PYFB_BLIT_ALPHA) {
+                    out[x] = pyfb_rgb565(px);
+                    count++;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // a 16 bit source is opaque, so the loops are plain gathers
+    const uint16_t* in = (const uint16_t*)src->pixels;
+
+    if(fb->fb_info.vinfo.bits_per_pixel == 16) {
+        uint16_t* out = fb->u16_buffer + offset;
+        for(int64_t x = x0; x < x1; x++, u += du, v += dv) {
+            out[x] = in[(v >> 16) * stride + (u >> 16)];
+        }
+    } else {
+        uint32_t* out = fb->u32_buffer + offset;
+        for(int64_t x = x0; x < x1; x++, u += du, v += dv) {
+            out[x] = pyfb_rgba8888(in[(v >> 16) * stride + (u >> 16)]);
+        }
+    }
+
+    return (unsigned long int)(x1 - x0);
+}
+
+/**
+ * Draws a row with bilinear sampling of the four source pixels around the sample point.
+ * The taps are clamped to the source edges. The source pixels must be widened to 32 bit.
+ *
+ * @return The count of pixels drawn
+ */
+static unsigned long int pyfb_blitBilinear(struct pyfb_framebuffer* fb,
+                                           const struct pyfb_surface* src,
+                                           unsigned long int y,
+                                           int64_t x0,
+                                           int64_t x1,
+                                           int64_t u,
+                                           int64_t v,
+                                           int64_t du,
+                                           int64_t dv) {
+    const uint32_t* in       = (const uint32_t*)src->pixels;
+    unsigned long int offset = y * fb->canvas.xres;
+    int64_t stride           = (int64_t)src->xres;
+    int64_t max_x            = (int64_t)src->xres - 1;
+    int64_t max_y            = (int64_t)src->yres - 1;
+    unsigned long int count  = 0;
+
+    // sample between the pixel centers
+    u -= 0x8000;
+    v -= 0x8000;
+
+    for(int64_t x = x0; x < x1; x++, u += du, v += dv) {
+        int64_t sx  = u >> 16;
+        int64_t sy  = v >> 16;
+        uint32_t fx = (uint32_t)(u >> 8) & 0xFF;
+        uint32_t fy = (uint32_t)(v >> 8) & 0xFF;
+
+        int64_t ax = sx < 0 ? 0 : (sx > max_x ? max_x : sx);
+        int64_t ay = sy < 0 ? 0 : (sy > max_y ? max_y : sy);
+        int64_t bx = sx + 1 > max_x ? max_x : (sx + 1 < 0 ? 0 : sx + 1);
+        int64_t by = sy + 1 > max_y ? max_y : (sy + 1 < 0 ? 0 : sy + 1);
+
+        uint32_t top    = pyfb_lerp(in[ay * stride + ax], in[ay * stride + bx], fx);
+        uint32_t bottom = pyfb_lerp(in[by * stride + ax], in[by * stride + bx], fx);
+        uint32_t px     = pyfb_lerp(top, bottom, fy);
+
+        if(src->depth == 32 && (px & 0xFF) < PYFB_BLIT_ALPHA) {
+            continue;
+        }
+
+        if(fb->fb_info.vinfo.bits_per_pixel == 32) {
+            fb->u32_buffer[offset + x] = px;
+        } else {
+            fb->u16_buffer[offset + x] = pyfb_rgb565(px);
+        }
+        count++;
+    }
+
+    return count;
+}
+
+int pyfb_sblitTransformed(uint8_t fbnum, uint8_t srcnum, const double* matrix, int filter) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS || srcnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(filter != PYFB_FILTER_NEAREST && filter != PYFB_FILTER_BILINEAR) {
+        PyErr_SetString(PyExc_ValueError, "The filter is not valid");
+        return -1;
+    }
+
+    // the inverse maps the destination pixels back to the source
+    double det = matrix[0] * matrix[4] - matrix[1] * matrix[3];
+
+    if(!isfinite(det) || fabs(det) < 1e-9) {
+        PyErr_SetString(PyExc_ValueError, "The matrix is not invertible");
+        return -1;
+    }
+
+    double inv[6];
+    inv[0] = matrix[4] / det;
+    inv[1] = -matrix[1] / det;
+    inv[2] = -(inv[0] * matrix[2] + inv[1] * matrix[5]);
+    inv[3] = -matrix[3] / det;
+    inv[4] = matrix[0] / det;
+    inv[5] = -(inv[3] * matrix[2] + inv[4] * matrix[5]);
+
+    struct pyfb_surface src;
+    if(pyfb_surfaceCopy(srcnum, &src, filter == PYFB_FILTER_BILINEAR) != 0) {
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        free(src.pixels);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "Pixels can not be written to an indexed canvas");
+        pyfb_fbunlock(fbnum);
+        free(src.pixels);
+        return -1;
+    }
+
+    // the bounding box of the transformed source, clipped to the canvas
+    double corners[4][2] = {{0, 0}, {(double)src.xres, 0}, {0, (double)src.yres}, {(double)src.xres, (double)src.yres}};
+    double min_x         = INFINITY;
+    double min_y         = INFINITY;
+    double max_x         = -INFINITY;
+    double max_y         = -INFINITY;
+
+    for(int i = 0; i < 4; i++) {
+        double x = matrix[0] * corners[i][0] + matrix[1] * corners[i][1] + matrix[2];
+        double y = matrix[3] * corners[i][0] + matrix[4] * corners[i][1] + matrix[5];
+        min_x    = x < min_x ? x : min_x;
+        min_y    = y < min_y ? y : min_y;
+        max_x    = x > max_x ? x : max_x;
+        max_y    = y > max_y ? y : max_y;
+    }
+
+    double xres = (double)fb->canvas.xres;
+    double yres = (double)fb->canvas.yres;
+    int64_t bx0 = min_x > 0 ? (int64_t)floor(min_x) : 0;
+    int64_t by0 = min_y > 0 ? (int64_t)floor(min_y) : 0;
+    int64_t bx1 = max_x < xres ? (int64_t)ceil(max_x) : (int64_t)fb->canvas.xres;
+    int64_t by1 = max_y < yres ? (int64_t)ceil(max_y) : (int64_t)fb->canvas.yres;
+
+    // the source coordinates are stepped in 16.16 fixed point
+    int64_t du           = (int64_t)llround(inv[0] * 65536.0);
+    int64_t dv           = (int64_t)llround(inv[3] * 65536.0);
+    int64_t limit_u      = (int64_t)src.xres << 16;
+    int64_t limit_v      = (int64_t)src.yres << 16;
+    unsigned long int px = 0;
+
+    for(int64_t y = by0; y < by1; y++) {
+        // the row start is computed exactly, so the steps do not drift from row to row
+        double cx = (double)bx0 + 0.5;
+        double cy = (double)y + 0.5;
+        int64_t u = (int64_t)llround((inv[0] * cx + inv[1] * cy + inv[2]) * 65536.0);
+        int64_t v = (int64_t)llround((inv[3] * cx + inv[4] * cy + inv[5]) * 65536.0);
+
+        int64_t k0 = 0;
+        int64_t k1 = bx1 - bx0;
+        pyfb_blitSpan(u, du, limit_u, &k0, &k1);
+        pyfb_blitSpan(v, dv, limit_v, &k0, &k1);
+
+        if(k0 >= k1) {
+            continue;
+        }
+
+        u += k0 * du;
+        v += k0 * dv;
+
+        if(filter == PYFB_FILTER_NEAREST) {
+            px += pyfb_blitNearest(fb, &src, (unsigned long int)y, bx0 + k0, bx0 + k1, u, v, du, dv);
+        } else {
+            px += pyfb_blitBilinear(fb, &src, (unsigned long int)y, bx0 + k0, bx0 + k1, u, v, du, dv);
+        }
+    }
+
+    PYFB_STAT_CALL(fb, PYFB_STAT_BLIT);
+    PYFB_STAT_PIXELS(fb, px);
+
+    pyfb_fbunlock(fbnum);
+    free(src.pixels);
+    PYFB_TRACE_END("blitTransformed", fbnum, trace_start);
+    return 0;
+}
+
+int pyfb_suploadRect(uint8_t fbnum,
+                     unsigned long int x,
+                     unsigned long int y,
+                     unsigned long int width,
+                     unsigned long int height,
+                     const uint8_t* src,
+                     size_t src_len) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    unsigned long int xres      = fb->canvas.xres;
+    unsigned long int yres      = fb->canvas.yres;
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "Pixels can not be written to an indexed canvas");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(x >= xres || y >= yres || width > xres - x || height > yres - y) {
+        PyErr_SetString(PyExc_ValueError, "The area is not on the screen");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(src_len < width * height * 4) {
+        PyErr_SetString(PyExc_ValueError, "The buffer is too small for the area");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // all data is valid, so convert row by row from the red, green, blue and alpha bytes
+    for(unsigned long int row = 0; row < height; row++) {
+        const uint8_t* in = src + row * width * 4;
+        size_t offset     = (y + row) * xres + x;
+
+        for(unsigned long int i = 0; i < width; i++) {
+            uint32_t value;
+            memcpy(&value, in + i * 4, 4);
+            value = be32toh(value);
+
+            if(fb->fb_info.vinfo.bits_per_pixel == 32) {
+                fb->u32_buffer[offset + i] = value;
+            } else {
+                fb->u16_buffer[offset + i] = pyfb_rgb565(value);
+            }
+        }
+    }
+
+    PYFB_STAT_CALL(fb, PYFB_STAT_WRITERECT);
+    PYFB_STAT_PIXELS(fb, width * height);
+
+    // ready, so return
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
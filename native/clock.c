@@ -0,0 +1,514 @@
+/**
+ * Frame clock sources.
+ */
+#include "pyframebuffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The frame rate of a timer clock if neither a rate is requested nor the display rate is known.
+ */
+#define PYFB_CLOCK_DEFAULT_FPS 60.0
+
+/**
+ * A frame clock.
+ */
+struct pyfb_clock {
+    /**
+     * The lock of the clock.
+     */
+    lock_t lock;
+
+    /**
+     * Not 0 if the clock is opened.
+     */
+    int used;
+
+    /**
+     * Not 0 while a thread waits for the clock.
+     */
+    atomic_int waiting;
+
+    /**
+     * PYFB_CLOCK_VSYNC or PYFB_CLOCK_TIMER.
+     */
+    int mode;
+
+    /**
+     * The duplicated framebuffer device file descriptor for the vsync mode, else the timerfd.
+     */
+    int fd;
+
+    /**
+     * The vertical blanks per frame in the vsync mode.
+     */
+    unsigned int divisor;
+
+    /**
+     * The frame period in nanoseconds.
+     */
+    uint64_t period;
+
+    /**
+     * The time of frame 0.
+     */
+    uint64_t base;
+
+    /**
+     * The number of the last frame.
+     */
+    unsigned long int frame;
+
+    /**
+     * The deadline of the last frame.
+     */
+    uint64_t deadline;
+
+    /**
+     * The statistics, the jitter fields are computed on request.
+     */
+    struct pyfb_clockstats stats;
+
+    /**
+     * The sum of the lateness of all ticks.
+     */
+    double lateness_sum;
+
+    /**
+     * The sum of the squared lateness of all ticks.
+     */
+    double lateness_sumsq;
+};
+
+/**
+ * The frame clock slots.
+ */
+static struct pyfb_clock clocks[MAX_CLOCKS];
+
+/**
+ * Returns the monotonic time in nanoseconds.
+ */
+static uint64_t pyfb_clockNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Returns the refresh period of the video mode, computed from the pixel clock and the
+ * margins, or 0 if the driver does not report the timings.
+ */
+static uint64_t pyfb_clockModePeriod(const struct fb_var_screeninfo* vinfo) {
+    uint64_t htotal = (uint64_t)vinfo->xres + vinfo->left_margin + vinfo->right_margin + vinfo->hsync_len;
+    uint64_t vtotal = (uint64_t)vinfo->yres + vinfo->upper_margin + vinfo->lower_margin + vinfo->vsync_len;
+
+    if(vinfo->pixclock == 0 || htotal == 0 || vtotal == 0) {
+        return 0;
+    }
+
+    // the pixel clock is the picoseconds per pixel
+    return (uint64_t)vinfo->pixclock * htotal * vtotal / 1000;
+}
+
+/**
+ * Waits for the next vertical blank.
+ *
+ * @return 0 on success, else -1 with errno set
+ */
+static int pyfb_clockVsync(int fd) {
+    __u32 crtc = 0;
+    int result = 0;
+
+    do {
+        result = ioctl(fd, FBIO_WAITFORVSYNC, &crtc);
+    } while(result == -1 && errno == EINTR);
+
+    return result;
+}
+
+void __APISTATUS_internal pyfb_clockinit(void) {
+    for(int i = 0; i < MAX_CLOCKS; i++) {
+        memset((void*)&clocks[i], 0, sizeof(struct pyfb_clock));
+        atomic_flag flag = ATOMIC_FLAG_INIT;
+        clocks[i].lock   = flag;
+        clocks[i].fd     = -1;
+    }
+}
+
+/**
+ * Measures the display period with two vertical blanks. This takes about two frames, so
+ * it is called without any lock and without the global interpreter lock.
+ *
+ * @param fd The duplicated framebuffer device file descriptor
+ * @param period The pointer to the period of the video mode, replaced by the measured one if 0
+ * @param base The pointer to store the time of the last vertical blank to
+ *
+ * @return 0 on success, else -1 if the driver does not support waiting for the vertical blank
+ */
+static int pyfb_clockMeasureVsync(int fd, uint64_t* period, uint64_t* base) {
+    // the first wait tests the support, the second measures the period
+    if(pyfb_clockVsync(fd) != 0) {
+        return -1;
+    }
+
+    uint64_t first = pyfb_clockNow();
+    if(pyfb_clockVsync(fd) != 0) {
+        return -1;
+    }
+
+    *base = pyfb_clockNow();
+    if(*period == 0) {
+        *period = *base - first;
+    }
+
+    return 0;
+}
+
+/**
+ * Opens the vsync mode of a clock with a measured display period.
+ */
+static void pyfb_clockOpenVsync(struct pyfb_clock* clock, int fd, uint64_t period, uint64_t base, double fps) {
+    // divide the display rate to the closest requested rate
+    double divisor = fps > 0 ? round(1e9 / (fps * (double)period)) : 1;
+
+    clock->mode     = PYFB_CLOCK_VSYNC;
+    clock->fd       = fd;
+    clock->divisor  = divisor < 1 ? 1 : (unsigned int)divisor;
+    clock->period   = period * clock->divisor;
+    clock->base     = base;
+    clock->deadline = base;
+}
+
+/**
+ * Opens the timer mode of a clock.
+ *
+ * @param clock The clock
+ * @param mode_period The refresh period of the video mode, or 0 if not known
+ * @param fps The requested frame rate, or 0 for the display rate
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+static int pyfb_clockOpenTimer(struct pyfb_clock* clock, uint64_t mode_period, double fps) {
+    uint64_t period = fps > 0 ? (uint64_t)(1e9 / fps) : mode_period;
+    if(period == 0) {
+        period = (uint64_t)(1e9 / PYFB_CLOCK_DEFAULT_FPS);
+    }
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(fd == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not create the frame timer");
+        return -1;
+    }
+
+    // the timer expires at every frame deadline
+    uint64_t base = pyfb_clockNow();
+    uint64_t next = base + period;
+
+    struct itimerspec spec;
+    spec.it_value.tv_sec     = (time_t)(next / 1000000000u);
+    spec.it_value.tv_nsec    = (long)(next % 1000000000u);
+    spec.it_interval.tv_sec  = (time_t)(period / 1000000000u);
+    spec.it_interval.tv_nsec = (long)(period % 1000000000u);
+
+    if(timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, NULL) != 0) {
+        PyErr_SetString(PyExc_IOError, "Could not start the frame timer");
+        close(fd);
+        return -1;
+    }
+
+    clock->mode     = PYFB_CLOCK_TIMER;
+    clock->fd       = fd;
+    clock->divisor  = 1;
+    clock->period   = period;
+    clock->base     = base;
+    clock->deadline = base;
+    return 0;
+}
+
+int pyfb_sclockOpen(uint8_t fbnum, double fps, int vsync) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(fps < 0 || fps > 1000) {
+        PyErr_SetString(PyExc_ValueError, "The frame rate is not valid");
+        return -1;
+    }
+
+    for(int i = 0; i < MAX_CLOCKS; i++) {
+        lock(clocks[i].lock);
+
+        if(clocks[i].used) {
+            unlock(clocks[i].lock);
+            continue;
+        }
+
+        // the framebuffer is only needed to duplicate its device and read its video mode
+        pyfb_fblock(fbnum);
+
+        if(!pyfb_fbused(fbnum)) {
+            PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+            pyfb_fbunlock(fbnum);
+            unlock(clocks[i].lock);
+            return -1;
+        }
+
+        struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+        uint64_t mode_period        = pyfb_clockModePeriod(&fb->fb_info.vinfo);
+        int fd                      = vsync && !fb->fb_virtual ? fcntl(fb->fb_fd, F_DUPFD_CLOEXEC, 0) : -1;
+
+        pyfb_fbunlock(fbnum);
+
+        // reserve the slot, the waiting flag refuses waits and closes until it is opened
+        struct pyfb_clock* clock = &clocks[i];
+        memset(&clock->stats, 0, sizeof(struct pyfb_clockstats));
+        clock->frame          = 0;
+        clock->lateness_sum   = 0;
+        clock->lateness_sumsq = 0;
+        clock->mode           = PYFB_CLOCK_TIMER;
+        clock->used           = 1;
+        atomic_store(&clock->waiting, 1);
+        unlock(clock->lock);
+
+        uint64_t period = mode_period;
+        uint64_t base   = 0;
+        int measured    = -1;
+
+        if(fd != -1) {
+            Py_BEGIN_ALLOW_THREADS
+            measured = pyfb_clockMeasureVsync(fd, &period, &base);
+            Py_END_ALLOW_THREADS
+        }
+
+        lock(clock->lock);
+
+        int exitcode = 0;
+        if(measured == 0) {
+            pyfb_clockOpenVsync(clock, fd, period, base, fps);
+        } else {
+            // the driver does not support waiting for the vertical blank
+            if(fd != -1) {
+                close(fd);
+            }
+
+            exitcode = pyfb_clockOpenTimer(clock, mode_period, fps);
+        }
+
+        clock->used = exitcode == 0;
+        atomic_store(&clock->waiting, 0);
+        unlock(clock->lock);
+        return exitcode == 0 ? i : -1;
+    }
+
+    PyErr_SetString(PyExc_IOError, "All frame clock slots are in use");
+    return -1;
+}
+
+int pyfb_sclockClose(uint8_t clocknum) {
+    if(clocknum >= MAX_CLOCKS) {
+        PyErr_SetString(PyExc_ValueError, "The frame clock number is not valid");
+        return -1;
+    }
+
+    lock(clocks[clocknum].lock);
+
+    if(!clocks[clocknum].used) {
+        PyErr_SetString(PyExc_IOError, "The frame clock is not opened");
+        unlock(clocks[clocknum].lock);
+        return -1;
+    }
+
+    if(atomic_load(&clocks[clocknum].waiting)) {
+        PyErr_SetString(PyExc_IOError, "The frame clock is waited for by another thread");
+        unlock(clocks[clocknum].lock);
+        return -1;
+    }
+
+    close(clocks[clocknum].fd);
+    clocks[clocknum].fd   = -1;
+    clocks[clocknum].used = 0;
+
+    unlock(clocks[clocknum].lock);
+    return 0;
+}
+
+int pyfb_sclockMode(uint8_t clocknum) {
+    if(clocknum >= MAX_CLOCKS) {
+        PyErr_SetString(PyExc_ValueError, "The frame clock number is not valid");
+        return -1;
+    }
+
+    lock(clocks[clocknum].lock);
+
+    if(!clocks[clocknum].used) {
+        PyErr_SetString(PyExc_IOError, "The frame clock is not opened");
+        unlock(clocks[clocknum].lock);
+        return -1;
+    }
+
+    int mode = clocks[clocknum].mode;
+
+    unlock(clocks[clocknum].lock);
+    return mode;
+}
+
+/**
+ * Waits for the next deadline of a timer clock in the future, or not older than half a
+ * period.
+ *
+ * @return The number of the frame, or 0 with errno set on failure
+ */
+static unsigned long int pyfb_clockWaitTimer(struct pyfb_clock* clock) {
+    unsigned long int frame = clock->frame;
+
+    while(1) {
+        uint64_t expirations = 0;
+        ssize_t len          = read(clock->fd, &expirations, sizeof(expirations));
+
+        if(len < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if(len != sizeof(expirations)) {
+            return 0;
+        }
+
+        // the timer coalesces the expired deadlines, so missed frames are not queued
+        frame += (unsigned long int)expirations;
+
+        uint64_t deadline = clock->base + frame * clock->period;
+        if(pyfb_clockNow() - deadline <= clock->period / 2) {
+            return frame;
+        }
+
+        // the deadline is too old to start a frame, so wait for the next one
+    }
+}
+
+/**
+ * Waits for the vertical blank of the next frame of a vsync clock.
+ *
+ * @return The number of the frame, or 0 with errno set on failure
+ */
+static unsigned long int pyfb_clockWaitVsync(struct pyfb_clock* clock) {
+    uint64_t blank  = clock->period / clock->divisor;
+    uint64_t target = clock->deadline + clock->period;
+
+    while(1) {
+        if(pyfb_clockVsync(clock->fd) != 0) {
+            return 0;
+        }
+
+        // skip the blanks between the frames of a divided display rate
+        uint64_t now = pyfb_clockNow();
+        if(now + blank / 2 < target) {
+            continue;
+        }
+
+        // a late caller missed blanks, the frames of them are dropped
+        return (unsigned long int)((now - clock->base + clock->period / 2) / clock->period);
+    }
+}
+
+int pyfb_clockWait(uint8_t clocknum, struct pyfb_clocktick* tick) {
+    if(clocknum >= MAX_CLOCKS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct pyfb_clock* clock = &clocks[clocknum];
+
+    lock(clock->lock);
+
+    if(!clock->used) {
+        unlock(clock->lock);
+        errno = EBADF;
+        return -1;
+    }
+
+    int expected = 0;
+    if(!atomic_compare_exchange_strong(&clock->waiting, &expected, 1)) {
+        unlock(clock->lock);
+        errno = EBUSY;
+        return -1;
+    }
+
+    unlock(clock->lock);
+
+    // wait without the lock, the waiting flag keeps the clock opened
+    unsigned long int frame = clock->mode == PYFB_CLOCK_VSYNC ? pyfb_clockWaitVsync(clock) : pyfb_clockWaitTimer(clock);
+    uint64_t now            = pyfb_clockNow();
+
+    lock(clock->lock);
+
+    if(frame == 0) {
+        int error = errno;
+        atomic_store(&clock->waiting, 0);
+        unlock(clock->lock);
+        errno = error;
+        return -1;
+    }
+
+    if(frame <= clock->frame) {
+        frame = clock->frame + 1;
+    }
+
+    tick->frame    = frame;
+    tick->dropped  = frame - clock->frame - 1;
+    tick->deadline = clock->base + frame * clock->period;
+    tick->lateness = now > tick->deadline ? now - tick->deadline : 0;
+
+    clock->frame    = frame;
+    clock->deadline = tick->deadline;
+    clock->stats.ticks++;
+    clock->stats.dropped += tick->dropped;
+    clock->stats.missed += tick->dropped > 0;
+    clock->lateness_sum += (double)tick->lateness;
+    clock->lateness_sumsq += (double)tick->lateness * (double)tick->lateness;
+
+    if(tick->lateness > clock->stats.jitter_max_ns) {
+        clock->stats.jitter_max_ns = tick->lateness;
+    }
+
+    atomic_store(&clock->waiting, 0);
+    unlock(clock->lock);
+    return 0;
+}
+
+int pyfb_sclockStats(uint8_t clocknum, struct pyfb_clockstats* stats) {
+    if(clocknum >= MAX_CLOCKS) {
+        PyErr_SetString(PyExc_ValueError, "The frame clock number is not valid");
+        return -1;
+    }
+
+    lock(clocks[clocknum].lock);
+
+    if(!clocks[clocknum].used) {
+        PyErr_SetString(PyExc_IOError, "The frame clock is not opened");
+        unlock(clocks[clocknum].lock);
+        return -1;
+    }
+
+    struct pyfb_clock* clock = &clocks[clocknum];
+    *stats                   = clock->stats;
+    stats->period_ns         = clock->period;
+
+    if(clock->stats.ticks > 0) {
+        double mean             = clock->lateness_sum / (double)clock->stats.ticks;
+        double variance         = clock->lateness_sumsq / (double)clock->stats.ticks - mean * mean;
+        stats->jitter_mean_ns   = (uint64_t)mean;
+        stats->jitter_stddev_ns = variance > 0 ? (uint64_t)sqrt(variance) : 0;
+    }
+
+    unlock(clocks[clocknum].lock);
+    return 0;
+}
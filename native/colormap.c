@@ -0,0 +1,292 @@
+/**
+ * Colormap sources, drawing scalar arrays.
+ */
+#include "pyframebuffer.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The mapping of the values of a scalar array to the colormap indices. Integer values
+ * are looked up in @c table if they are 8 bit, all others are scaled in float.
+ */
+struct pyfb_scalarmap {
+    /**
+     * The factor from a value to the index.
+     */
+    float scale;
+
+    /**
+     * The index of the value 0, plus 0.5 to round.
+     */
+    float offset;
+
+    /**
+     * The index of every 8 bit value.
+     */
+    uint8_t table[256];
+};
+
+/**
+ * Maps a value to the colormap index. The comparisons are written so NaN maps to 0, and
+ * the compiler turns them into vector min and max operations.
+ */
+static inline uint8_t pyfb_scalarIndex(const struct pyfb_scalarmap* map, float value) {
+    float f = value * map->scale + map->offset;
+    f       = f > 0.0f ? f : 0.0f;
+    f       = f < 255.0f ? f : 255.0f;
+    return (uint8_t)f;
+}
+
+/**
+ * Maps a row of values to colormap indices.
+ *
+ * @param map The mapping
+ * @param src The first value of the row
+ * @param type The type of the values
+ * @param dst The indices
+ * @param count The amount of values
+ */
+static void pyfb_scalarRow(const struct pyfb_scalarmap* map, const void* src, int type, uint8_t* restrict dst, size_t count) {
+    if(type == PYFB_SCALAR_U8) {
+        const uint8_t* in = (const uint8_t*)src;
+        for(size_t i = 0; i < count; i++) {
+            dst[i] = map->table[in[i]];
+        }
+    } else if(type == PYFB_SCALAR_U16) {
+        const uint16_t* in = (const uint16_t*)src;
+        for(size_t i = 0; i < count; i++) {
+            dst[i] = pyfb_scalarIndex(map, (float)in[i]);
+        }
+    } else {
+        const float* in = (const float*)src;
+        for(size_t i = 0; i < count; i++) {
+            dst[i] = pyfb_scalarIndex(map, in[i]);
+        }
+    }
+}
+
+/**
+ * Writes a row of colormap indices to a 32 bit canvas row, zoomed and clipped.
+ *
+ * @param out The canvas row
+ * @param lut The colormap in the pixel format
+ * @param idx The indices of the visible values
+ * @param x The canvas x coordinate of the first value of the array row
+ * @param c0 The first visible value
+ * @param c1 The end of the visible values
+ * @param dx0 The first canvas column to write
+ * @param dx1 The end of the canvas columns to write
+ * @param zoom The edge length of the square of a value
+ */
+static void pyfb_scalarWrite32(uint32_t* restrict out,
+                               const uint32_t* restrict lut,
+                               const uint8_t* restrict idx,
+                               long int x,
+                               long int c0,
+                               long int c1,
+                               long int dx0,
+                               long int dx1,
+                               long int zoom) {
+    if(zoom == 1) {
+        for(long int i = 0; i < dx1 - dx0; i++) {
+            out[dx0 + i] = lut[idx[i]];
+        }
+        return;
+    }
+
+    for(long int c = c0; c < c1; c++) {
+        uint32_t color = lut[idx[c - c0]];
+        long int s     = x + c * zoom > dx0 ? x + c * zoom : dx0;
+        long int e     = x + (c + 1) * zoom < dx1 ? x + (c + 1) * zoom : dx1;
+
+        for(long int dx = s; dx < e; dx++) {
+            out[dx] = color;
+        }
+    }
+}
+
+/**
+ * Writes a row of colormap indices to a 16 bit canvas row. See pyfb_scalarWrite32.
+ */
+static void pyfb_scalarWrite16(uint16_t* restrict out,
+                               const uint16_t* restrict lut,
+                               const uint8_t* restrict idx,
+                               long int x,
+                               long int c0,
+                               long int c1,
+                               long int dx0,
+                               long int dx1,
+                               long int zoom) {
+    if(zoom == 1) {
+        for(long int i = 0; i < dx1 - dx0; i++) {
+            out[dx0 + i] = lut[idx[i]];
+        }
+        return;
+    }
+
+    for(long int c = c0; c < c1; c++) {
+        uint16_t color = lut[idx[c - c0]];
+        long int s     = x + c * zoom > dx0 ? x + c * zoom : dx0;
+        long int e     = x + (c + 1) * zoom < dx1 ? x + (c + 1) * zoom : dx1;
+
+        for(long int dx = s; dx < e; dx++) {
+            out[dx] = color;
+        }
+    }
+}
+
+int pyfb_sblitScalar(uint8_t fbnum,
+                     const void* data,
+                     size_t data_len,
+                     int type,
+                     unsigned long int width,
+                     unsigned long int height,
+                     long int x,
+                     long int y,
+                     const uint32_t* colormap,
+                     double vmin,
+                     double vmax,
+                     unsigned int zoom) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(type != PYFB_SCALAR_U8 && type != PYFB_SCALAR_U16 && type != PYFB_SCALAR_F32) {
+        PyErr_SetString(PyExc_ValueError, "The scalar type is not valid");
+        return -1;
+    }
+
+    size_t item = pyfb_scalarSize(type);
+
+    if(width == 0 || height == 0 || width > LONG_MAX / 512 || height > LONG_MAX / 512) {
+        PyErr_SetString(PyExc_ValueError, "The array size is not valid");
+        return -1;
+    }
+
+    if(data_len / item / width < height) {
+        PyErr_SetString(PyExc_ValueError, "The buffer is too small for the array");
+        return -1;
+    }
+
+    if(!isfinite(vmin) || !isfinite(vmax) || vmin == vmax) {
+        PyErr_SetString(PyExc_ValueError, "The value range is not valid");
+        return -1;
+    }
+
+    if(zoom < 1 || zoom > 256) {
+        PyErr_SetString(PyExc_ValueError, "The zoom must be between 1 and 256");
+        return -1;
+    }
+
+    // the mapping of the values to the colormap indices
+    struct pyfb_scalarmap map;
+    double scale = (PYFB_COLORMAP_SIZE - 1) / (vmax - vmin);
+    map.scale    = (float)scale;
+    map.offset   = (float)(0.5 - vmin * scale);
+
+    for(int i = 0; i < 256; i++) {
+        map.table[i] = pyfb_scalarIndex(&map, (float)i);
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "Pixels can not be written to an indexed canvas");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the visible canvas area and the values drawn into it
+    long int z  = (long int)zoom;
+    long int xr = (long int)fb->canvas.xres;
+    long int yr = (long int)fb->canvas.yres;
+
+    if(x >= xr || y >= yr) {
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    long int dx0 = x > 0 ? x : 0;
+    long int dy0 = y > 0 ? y : 0;
+    long int dx1 = x + (long int)width * z < xr ? x + (long int)width * z : xr;
+    long int dy1 = y + (long int)height * z < yr ? y + (long int)height * z : yr;
+
+    if(dx0 >= dx1 || dy0 >= dy1) {
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    long int c0 = (dx0 - x) / z;
+    long int c1 = (dx1 - x + z - 1) / z;
+    long int r0 = (dy0 - y) / z;
+    long int r1 = (dy1 - y + z - 1) / z;
+
+    uint8_t* idx = malloc((size_t)(c1 - c0));
+    if(idx == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the row buffer");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the colormap in the pixel format of the device
+    uint32_t lut32[PYFB_COLORMAP_SIZE];
+    uint16_t lut16[PYFB_COLORMAP_SIZE];
+    for(int i = 0; i < PYFB_COLORMAP_SIZE; i++) {
+        lut32[i] = colormap[i];
+        lut16[i] = pyfb_rgb565(colormap[i]);
+    }
+
+    int depth     = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+    size_t bytes  = (size_t)depth / 8;
+    uint8_t* rows = (uint8_t*)fb->u32_buffer;
+
+    // the arguments are valid and the array is held by the caller, so draw without the GIL
+    Py_BEGIN_ALLOW_THREADS;
+
+    for(long int r = r0; r < r1; r++) {
+        const uint8_t* src = (const uint8_t*)data + ((size_t)r * width + (size_t)c0) * item;
+        pyfb_scalarRow(&map, src, type, idx, (size_t)(c1 - c0));
+
+        // the first canvas row of the value row, the others are copies of it
+        long int first = y + r * z > dy0 ? y + r * z : dy0;
+        long int end   = y + (r + 1) * z < dy1 ? y + (r + 1) * z : dy1;
+        uint8_t* out   = rows + (size_t)(first * xr) * bytes;
+
+        if(depth == 16) {
+            pyfb_scalarWrite16((uint16_t*)out, lut16, idx, x, c0, c1, dx0, dx1, z);
+        } else {
+            pyfb_scalarWrite32((uint32_t*)out, lut32, idx, x, c0, c1, dx0, dx1, z);
+        }
+
+        for(long int row = first + 1; row < end; row++) {
+            memcpy(rows + ((size_t)(row * xr) + (size_t)dx0) * bytes, out + (size_t)dx0 * bytes, (size_t)(dx1 - dx0) * bytes);
+        }
+    }
+
+    Py_END_ALLOW_THREADS;
+
+    PYFB_STAT_CALL(fb, PYFB_STAT_SCALAR);
+    PYFB_STAT_PIXELS(fb, (unsigned long int)((dx1 - dx0) * (dy1 - dy0)));
+
+    free(idx);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("blitScalar", fbnum, trace_start);
+    return 0;
+}
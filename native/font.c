@@ -0,0 +1,911 @@
+/**
+ * Bitmap font loading and text rendering sources.
+ */
+#include "pyframebuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The magic bytes of a PSF1 font.
+ */
+#define PSF1_MAGIC0 0x36
+#define PSF1_MAGIC1 0x04
+
+/**
+ * The PSF1 mode flags.
+ */
+#define PSF1_MODE512    0x01
+#define PSF1_MODEHASTAB 0x02
+#define PSF1_MODEHASSEQ 0x04
+
+/**
+ * The PSF1 unicode table markers.
+ */
+#define PSF1_SEPARATOR 0xFFFF
+#define PSF1_STARTSEQ  0xFFFE
+
+/**
+ * The magic number of a PSF2 font.
+ */
+#define PSF2_MAGIC 0x864AB572
+
+/**
+ * The PSF2 header size in bytes.
+ */
+#define PSF2_HEADER_SIZE 32
+
+/**
+ * The PSF2 flag for a font with an unicode table.
+ */
+#define PSF2_HAS_UNICODE_TABLE 0x01
+
+/**
+ * The PSF2 unicode table markers.
+ */
+#define PSF2_SEPARATOR 0xFF
+#define PSF2_STARTSEQ  0xFE
+
+/**
+ * Marks an entry of the latin1 lookup table without a glyph.
+ */
+#define PYFB_NOGLYPH 0xFFFF
+
+/**
+ * The array with the fonts.
+ */
+static struct pyfb_font fonts[MAX_FONTS];
+
+/**
+ * A unicode table entry, only used while loading a font.
+ */
+struct pyfb_unicode_entry {
+    uint32_t cp;
+    uint16_t glyph;
+};
+
+/**
+ * Reads a little endian 32 bit number.
+ *
+ * @param p The pointer to the first byte
+ *
+ * @return The number
+ */
+static inline uint32_t pyfb_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Compares two unicode table entries by the codepoint for qsort.
+ */
+static int pyfb_unicode_cmp(const void* a, const void* b) {
+    uint32_t cpa = ((const struct pyfb_unicode_entry*)a)->cp;
+    uint32_t cpb = ((const struct pyfb_unicode_entry*)b)->cp;
+    return cpa < cpb ? -1 : (cpa > cpb ? 1 : 0);
+}
+
+/**
+ * Decodes one UTF-8 character of a PSF2 unicode table.
+ *
+ * @param p The pointer to the current position, advanced by this function
+ * @param end The end of the data
+ *
+ * @return The codepoint, or 0xFFFFFFFF if the sequence is invalid
+ */
+static uint32_t pyfb_utf8(const uint8_t** p, const uint8_t* end) {
+    const uint8_t* s = *p;
+    uint32_t cp      = *s++;
+    int follow       = 0;
+
+    if(cp >= 0xF0) {
+        cp &= 0x07;
+        follow = 3;
+    } else if(cp >= 0xE0) {
+        cp &= 0x0F;
+        follow = 2;
+    } else if(cp >= 0xC0) {
+        cp &= 0x1F;
+        follow = 1;
+    } else if(cp >= 0x80) {
+        *p = s;
+        return 0xFFFFFFFF;
+    }
+
+    while(follow-- > 0) {
+        if(s >= end || (*s & 0xC0) != 0x80) {
+            *p = s;
+            return 0xFFFFFFFF;
+        }
+        cp = (cp << 6) | (*s++ & 0x3F);
+    }
+
+    *p = s;
+    return cp;
+}
+
+/**
+ * Releases all memory of a font and marks the slot as unused.
+ *
+ * @param font The font to release
+ */
+static void pyfb_fontrelease(struct pyfb_font* font) {
+    free(font->glyphs);
+    free(font->unicode_cp);
+    free(font->unicode_glyph);
+    free(font->mask16);
+    free(font->mask32);
+
+    for(int i = 0; i < PYFB_GLYPHCACHE_SLOTS; i++) {
+        free(font->cache[i].pixels);
+        free(font->cache[i].expanded);
+    }
+
+    lock_t font_lock = font->font_lock;
+    memset((void*)font, 0, sizeof(struct pyfb_font));
+    font->font_lock = font_lock;
+}
+
+/**
+ * Builds the lookup tables of a font from the entries of its unicode table.
+ *
+ * @param font The font
+ * @param entries The unicode table entries, are sorted by this function
+ * @param count The amount of entries
+ *
+ * @return By success 0, else -1
+ */
+static int pyfb_fontmap(struct pyfb_font* font, struct pyfb_unicode_entry* entries, size_t count) {
+    for(int i = 0; i < 256; i++) {
+        font->latin1[i] = PYFB_NOGLYPH;
+    }
+
+    if(entries == NULL) {
+        // no unicode table, so the glyph index is the codepoint
+        for(unsigned int i = 0; i < 256 && i < font->numglyphs; i++) {
+            font->latin1[i] = (uint16_t)i;
+        }
+        return 0;
+    }
+
+    qsort(entries, count, sizeof(struct pyfb_unicode_entry), pyfb_unicode_cmp);
+
+    font->unicode_cp    = malloc(count * sizeof(uint32_t) + 1);
+    font->unicode_glyph = malloc(count * sizeof(uint16_t) + 1);
+    if(font->unicode_cp == NULL || font->unicode_glyph == NULL) {
+        return -1;
+    }
+
+    // keep only the first glyph of each codepoint
+    size_t len = 0;
+    for(size_t i = 0; i < count; i++) {
+        if(len > 0 && font->unicode_cp[len - 1] == entries[i].cp) {
+            continue;
+        }
+
+        font->unicode_cp[len]    = entries[i].cp;
+        font->unicode_glyph[len] = entries[i].glyph;
+        len++;
+
+        if(entries[i].cp < 256) {
+            font->latin1[entries[i].cp] = entries[i].glyph;
+        }
+    }
+
+    font->unicode_len = len;
+    return 0;
+}
+
+/**
+ * Adds an entry to the temporary unicode table.
+ *
+ * @return By success 0, else -1
+ */
+static int pyfb_unicode_add(struct pyfb_unicode_entry** entries,
+                            size_t* count,
+                            size_t* capacity,
+                            uint32_t cp,
+                            unsigned int glyph) {
+    if(*count == *capacity) {
+        size_t new_capacity                = *capacity == 0 ? 512 : *capacity * 2;
+        struct pyfb_unicode_entry* new_ptr = realloc(*entries, new_capacity * sizeof(struct pyfb_unicode_entry));
+        if(new_ptr == NULL) {
+            return -1;
+        }
+        *entries  = new_ptr;
+        *capacity = new_capacity;
+    }
+
+    (*entries)[*count].cp    = cp;
+    (*entries)[*count].glyph = (uint16_t)glyph;
+    (*count)++;
+    return 0;
+}
+
+/**
+ * Parses the content of a PSF1 or PSF2 font file into a font structure.
+ *
+ * @param font The font slot to fill
+ * @param data The file content
+ * @param len The length of the file content
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+static int pyfb_parsePSF(struct pyfb_font* font, const uint8_t* data, size_t len) {
+    const uint8_t* end = data + len;
+    const uint8_t* glyphs;
+    const uint8_t* table = NULL;
+    int psf2             = 0;
+
+    if(len >= 4 && data[0] == PSF1_MAGIC0 && data[1] == PSF1_MAGIC1) {
+        unsigned int mode = data[2];
+        font->width       = 8;
+        font->height      = data[3];
+        font->numglyphs   = (mode & PSF1_MODE512) ? 512 : 256;
+        glyphs            = data + 4;
+
+        if(mode & (PSF1_MODEHASTAB | PSF1_MODEHASSEQ)) {
+            table = glyphs + (size_t)font->numglyphs * font->height;
+        }
+    } else if(len >= PSF2_HEADER_SIZE && pyfb_le32(data) == PSF2_MAGIC) {
+        uint32_t headersize = pyfb_le32(data + 8);
+        uint32_t flags      = pyfb_le32(data + 12);
+        uint32_t length     = pyfb_le32(data + 16);
+        uint32_t charsize   = pyfb_le32(data + 20);
+        font->height        = pyfb_le32(data + 24);
+        font->width         = pyfb_le32(data + 28);
+        font->numglyphs     = length;
+        psf2                = 1;
+
+        if(font->width == 0 || font->width > 256 || length > 0xFFFF || headersize > len ||
+           charsize != font->height * ((font->width + 7) / 8)) {
+            PyErr_SetString(PyExc_ValueError, "The PSF2 font header is invalid");
+            return -1;
+        }
+
+        glyphs = data + headersize;
+
+        if(flags & PSF2_HAS_UNICODE_TABLE) {
+            table = glyphs + (size_t)font->numglyphs * charsize;
+        }
+    } else {
+        PyErr_SetString(PyExc_ValueError, "The font data is not a valid PSF1 or PSF2 font");
+        return -1;
+    }
+
+    font->bytes_per_row = (font->width + 7) / 8;
+    size_t glyphs_len   = (size_t)font->numglyphs * font->bytes_per_row * font->height;
+
+    if(font->height == 0 || font->numglyphs == 0 || glyphs_len > (size_t)(end - glyphs)) {
+        PyErr_SetString(PyExc_ValueError, "The font data is truncated");
+        return -1;
+    }
+
+    font->glyphs = malloc(glyphs_len);
+    if(font->glyphs == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the font glyphs");
+        return -1;
+    }
+    memcpy(font->glyphs, glyphs, glyphs_len);
+
+    // now read the unicode table if there is one
+    struct pyfb_unicode_entry* entries = NULL;
+    size_t count                       = 0;
+    size_t capacity                    = 0;
+    int failed                         = 0;
+
+    if(table != NULL) {
+        const uint8_t* p = table;
+
+        for(unsigned int glyph = 0; glyph < font->numglyphs && p < end && !failed; glyph++) {
+            int in_seq = 0;
+
+            if(psf2) {
+                while(p < end) {
+                    if(*p == PSF2_SEPARATOR) {
+                        p++;
+                        break;
+                    }
+
+                    if(*p == PSF2_STARTSEQ) {
+                        in_seq = 1;
+                        p++;
+                        continue;
+                    }
+
+                    uint32_t cp = pyfb_utf8(&p, end);
+                    if(!in_seq && cp != 0xFFFFFFFF && pyfb_unicode_add(&entries, &count, &capacity, cp, glyph) != 0) {
+                        failed = 1;
+                        break;
+                    }
+                }
+            } else {
+                while(p + 1 < end) {
+                    uint32_t cp = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+                    p += 2;
+
+                    if(cp == PSF1_SEPARATOR) {
+                        break;
+                    }
+
+                    if(cp == PSF1_STARTSEQ) {
+                        in_seq = 1;
+                        continue;
+                    }
+
+                    if(!in_seq && pyfb_unicode_add(&entries, &count, &capacity, cp, glyph) != 0) {
+                        failed = 1;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if(failed || pyfb_fontmap(font, table != NULL ? entries : NULL, count) != 0) {
+        free(entries);
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the font unicode table");
+        return -1;
+    }
+
+    free(entries);
+
+    // and choose the glyph for unknown characters
+    font->fallback = font->latin1['?'] != PYFB_NOGLYPH ? font->latin1['?'] : 0;
+    return 0;
+}
+
+/**
+ * Returns the glyph to draw for a codepoint.
+ *
+ * @param font The font
+ * @param cp The unicode codepoint
+ *
+ * @return The glyph index
+ */
+static inline unsigned int pyfb_glyph(const struct pyfb_font* font, uint32_t cp) {
+    if(cp < 256) {
+        uint16_t glyph = font->latin1[cp];
+        return glyph == PYFB_NOGLYPH ? font->fallback : glyph;
+    }
+
+    if(font->unicode_len == 0) {
+        return cp < font->numglyphs ? cp : font->fallback;
+    }
+
+    // binary search in the sorted unicode table
+    size_t lo = 0;
+    size_t hi = font->unicode_len;
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(font->unicode_cp[mid] < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if(lo < font->unicode_len && font->unicode_cp[lo] == cp) {
+        return font->unicode_glyph[lo];
+    }
+
+    return font->fallback;
+}
+
+/**
+ * Expands a 1bpp glyph row to 32 bit pixels. Set bits become the @c on value, and
+ * cleared bits the @c off value. The inner loop is branchless to let the compiler
+ * vectorize it.
+ *
+ * @param bits The row bits, MSB first
+ * @param width The amount of pixels
+ * @param on The pixel value of set bits
+ * @param off The pixel value of cleared bits
+ * @param out The output pixels
+ */
+static void pyfb_expandRow32(const uint8_t* bits, unsigned int width, uint32_t on, uint32_t off, uint32_t* restrict out) {
+    const uint32_t diff = on ^ off;
+    unsigned int full   = width / 8;
+
+    for(unsigned int b = 0; b < full; b++) {
+        const uint32_t byte = bits[b];
+        uint32_t* o         = out + b * 8;
+        for(unsigned int i = 0; i < 8; i++) {
+            o[i] = off ^ (diff & (0u - ((byte >> (7 - i)) & 1u)));
+        }
+    }
+
+    for(unsigned int i = full * 8; i < width; i++) {
+        const uint32_t bit = (bits[i / 8] >> (7 - (i & 7))) & 1u;
+        out[i]             = off ^ (diff & (0u - bit));
+    }
+}
+
+/**
+ * Expands a 1bpp glyph row to 16 bit pixels. See pyfb_expandRow32.
+ */
+static void pyfb_expandRow16(const uint8_t* bits, unsigned int width, uint16_t on, uint16_t off, uint16_t* restrict out) {
+    const uint16_t diff = on ^ off;
+    unsigned int full   = width / 8;
+
+    for(unsigned int b = 0; b < full; b++) {
+        const uint16_t byte = bits[b];
+        uint16_t* o         = out + b * 8;
+        for(unsigned int i = 0; i < 8; i++) {
+            o[i] = off ^ (diff & (uint16_t)(0u - ((byte >> (7 - i)) & 1u)));
+        }
+    }
+
+    for(unsigned int i = full * 8; i < width; i++) {
+        const uint16_t bit = (bits[i / 8] >> (7 - (i & 7))) & 1u;
+        out[i]             = off ^ (diff & (uint16_t)(0u - bit));
+    }
+}
+
+/**
+ * Expands a complete glyph into a pixel buffer.
+ *
+ * @param font The font
+ * @param glyph The glyph index
+ * @param depth The pixel depth, 16 or 32
+ * @param on The pixel value of set bits
+ * @param off The pixel value of cleared bits
+ * @param out The output buffer of @c width*height pixels
+ */
+static void pyfb_expandGlyph(const struct pyfb_font* font,
+                             unsigned int glyph,
+                             unsigned int depth,
+                             uint32_t on,
+                             uint32_t off,
+                             void* out) {
+    const uint8_t* bits = font->glyphs + (size_t)glyph * font->bytes_per_row * font->height;
+
+    for(unsigned int row = 0; row < font->height; row++) {
+        if(depth == 16) {
+            pyfb_expandRow16(bits, font->width, (uint16_t)on, (uint16_t)off, (uint16_t*)out + (size_t)row * font->width);
+        } else {
+            pyfb_expandRow32(bits, font->width, on, off, (uint32_t*)out + (size_t)row * font->width);
+        }
+        bits += font->bytes_per_row;
+    }
+}
+
+/**
+ * Returns the expanded glyph masks of a font in a pixel depth. The masks are
+ * created on the first call.
+ *
+ * @param font The font
+ * @param depth The pixel depth, 16 or 32
+ *
+ * @return The masks, or NULL if out of memory
+ */
+static void* pyfb_glyphmask(struct pyfb_font* font, unsigned int depth) {
+    void** mask        = depth == 16 ? (void**)&font->mask16 : (void**)&font->mask32;
+    size_t glyph_px    = (size_t)font->width * font->height;
+    unsigned int bytes = depth / 8;
+
+    if(*mask != NULL) {
+        return *mask;
+    }
+
+    *mask = malloc(glyph_px * font->numglyphs * bytes);
+    if(*mask == NULL) {
+        return NULL;
+    }
+
+    for(unsigned int glyph = 0; glyph < font->numglyphs; glyph++) {
+        pyfb_expandGlyph(font, glyph, depth, 0xFFFFFFFF, 0, (uint8_t*)*mask + glyph * glyph_px * bytes);
+    }
+
+    return *mask;
+}
+
+/**
+ * Returns the glyph cache slot for a color combination. If no slot exists for the
+ * colors, the least recently used slot is reset for them.
+ *
+ * @param font The font
+ * @param depth The pixel depth, 16 or 32
+ * @param fg The foreground pixel value
+ * @param bg The background pixel value
+ * @param opaque 1 if the background is painted, else 0
+ *
+ * @return The cache slot, or NULL if out of memory
+ */
+static struct pyfb_glyphcache* pyfb_glyphcache(struct pyfb_font* font,
+                                               unsigned int depth,
+                                               uint32_t fg,
+                                               uint32_t bg,
+                                               int opaque) {
+    struct pyfb_glyphcache* victim = &font->cache[0];
+    font->cache_clock++;
+
+    for(int i = 0; i < PYFB_GLYPHCACHE_SLOTS; i++) {
+        struct pyfb_glyphcache* slot = &font->cache[i];
+
+        if(slot->depth == depth && slot->fg == fg && slot->opaque == opaque && (!opaque || slot->bg == bg)) {
+            slot->stamp = font->cache_clock;
+            return slot;
+        }
+
+        if(slot->stamp < victim->stamp) {
+            victim = slot;
+        }
+    }
+
+    // reuse the least recently used slot
+    size_t size = (size_t)font->width * font->height * font->numglyphs * (depth / 8);
+
+    if(victim->pixels == NULL || victim->depth != depth) {
+        free(victim->pixels);
+        victim->pixels = malloc(size);
+    }
+
+    if(victim->expanded == NULL) {
+        victim->expanded = malloc(font->numglyphs);
+    }
+
+    if(victim->pixels == NULL || victim->expanded == NULL) {
+        victim->depth = 0;
+        victim->stamp = 0;
+        return NULL;
+    }
+
+    memset(victim->expanded, 0, font->numglyphs);
+    victim->depth  = depth;
+    victim->fg     = fg;
+    victim->bg     = bg;
+    victim->opaque = opaque;
+    victim->stamp  = font->cache_clock;
+    return victim;
+}
+
+/**
+ * Blits a clipped glyph to a 32 bit offscreen buffer.
+ *
+ * @param dst The first destination pixel
+ * @param stride The destination row length in pixel
+ * @param src The expanded glyph pixels
+ * @param mask The expanded glyph mask, or NULL if opaque
+ * @param gw The glyph width
+ * @param cw The clipped width to paint
+ * @param ch The clipped height to paint
+ */
+static void pyfb_blitGlyph32(uint32_t* restrict dst,
+                             unsigned long int stride,
+                             const uint32_t* restrict src,
+                             const uint32_t* restrict mask,
+                             unsigned int gw,
+                             unsigned int cw,
+                             unsigned int ch) {
+    for(unsigned int row = 0; row < ch; row++) {
+        if(mask == NULL) {
+            memcpy(dst, src, cw * sizeof(uint32_t));
+        } else {
+            for(unsigned int i = 0; i < cw; i++) {
+                dst[i] = (dst[i] & ~mask[i]) | src[i];
+            }
+            mask += gw;
+        }
+
+        dst += stride;
+        src += gw;
+    }
+}
+
+/**
+ * Blits a clipped glyph to a 16 bit offscreen buffer. See pyfb_blitGlyph32.
+ */
+static void pyfb_blitGlyph16(uint16_t* restrict dst,
+                             unsigned long int stride,
+                             const uint16_t* restrict src,
+                             const uint16_t* restrict mask,
+                             unsigned int gw,
+                             unsigned int cw,
+                             unsigned int ch) {
+    for(unsigned int row = 0; row < ch; row++) {
+        if(mask == NULL) {
+            memcpy(dst, src, cw * sizeof(uint16_t));
+        } else {
+            for(unsigned int i = 0; i < cw; i++) {
+                dst[i] = (dst[i] & ~mask[i]) | src[i];
+            }
+            mask += gw;
+        }
+
+        dst += stride;
+        src += gw;
+    }
+}
+
+/**
+ * Paints a clipped glyph pixel by pixel. Only used if the glyph cache could not be
+ * allocated.
+ */
+static void pyfb_paintGlyph(uint8_t fbnum,
+                            const struct pyfb_font* font,
+                            unsigned int glyph,
+                            unsigned long int x,
+                            unsigned long int y,
+                            unsigned int cw,
+                            unsigned int ch,
+                            const struct pyfb_color* color,
+                            const struct pyfb_color* background) {
+    const uint8_t* bits = font->glyphs + (size_t)glyph * font->bytes_per_row * font->height;
+
+    for(unsigned int row = 0; row < ch; row++) {
+        for(unsigned int i = 0; i < cw; i++) {
+            if((bits[i / 8] >> (7 - (i & 7))) & 1) {
+                pyfb_setPixel(fbnum, x + i, y + row, color);
+            } else if(background != NULL) {
+                pyfb_setPixel(fbnum, x + i, y + row, background);
+            }
+        }
+        bits += font->bytes_per_row;
+    }
+}
+
+void __APISTATUS_internal pyfb_fontinit(void) {
+    for(int i = 0; i < MAX_FONTS; i++) {
+        memset((void*)&fonts[i], 0, sizeof(struct pyfb_font));
+        atomic_flag flag   = ATOMIC_FLAG_INIT;
+        fonts[i].font_lock = flag;
+    }
+}
+
+int pyfb_loadFont(const uint8_t* data, size_t len) {
+    for(int i = 0; i < MAX_FONTS; i++) {
+        lock(fonts[i].font_lock);
+
+        if(fonts[i].used) {
+            unlock(fonts[i].font_lock);
+            continue;
+        }
+
+        // found a free slot, so parse the font into it
+        if(pyfb_parsePSF(&fonts[i], data, len) != 0) {
+            pyfb_fontrelease(&fonts[i]);
+            unlock(fonts[i].font_lock);
+            return -1;
+        }
+
+        fonts[i].used = 1;
+        unlock(fonts[i].font_lock);
+        return i;
+    }
+
+    PyErr_SetString(PyExc_MemoryError, "No free font slot available");
+    return -1;
+}
+
+void pyfb_freeFont(uint8_t fontnum) {
+    if(fontnum >= MAX_FONTS) {
+        PyErr_SetString(PyExc_ValueError, "The font number is not valid");
+        return;
+    }
+
+    lock(fonts[fontnum].font_lock);
+
+    if(!fonts[fontnum].used) {
+        PyErr_SetString(PyExc_IOError, "The font is allready freed");
+        unlock(fonts[fontnum].font_lock);
+        return;
+    }
+
+    pyfb_fontrelease(&fonts[fontnum]);
+    unlock(fonts[fontnum].font_lock);
+}
+
+int pyfb_sfontInfo(uint8_t fontnum, unsigned int* width, unsigned int* height, unsigned int* numglyphs) {
+    if(fontnum >= MAX_FONTS) {
+        PyErr_SetString(PyExc_ValueError, "The font number is not valid");
+        return -1;
+    }
+
+    lock(fonts[fontnum].font_lock);
+
+    if(!fonts[fontnum].used) {
+        PyErr_SetString(PyExc_IOError, "The font is not loaded");
+        unlock(fonts[fontnum].font_lock);
+        return -1;
+    }
+
+    *width     = fonts[fontnum].width;
+    *height    = fonts[fontnum].height;
+    *numglyphs = fonts[fontnum].numglyphs;
+
+    unlock(fonts[fontnum].font_lock);
+    return 0;
+}
+
+int pyfb_smeasureText(uint8_t fontnum,
+                      const uint32_t* text,
+                      size_t len,
+                      unsigned long int* width,
+                      unsigned long int* height) {
+    if(fontnum >= MAX_FONTS) {
+        PyErr_SetString(PyExc_ValueError, "The font number is not valid");
+        return -1;
+    }
+
+    lock(fonts[fontnum].font_lock);
+
+    if(!fonts[fontnum].used) {
+        PyErr_SetString(PyExc_IOError, "The font is not loaded");
+        unlock(fonts[fontnum].font_lock);
+        return -1;
+    }
+
+    unsigned long int line    = 0;
+    unsigned long int longest = 0;
+    unsigned long int lines   = len > 0 ? 1 : 0;
+
+    for(size_t i = 0; i < len; i++) {
+        if(text[i] == '\n') {
+            lines++;
+            line = 0;
+            continue;
+        }
+
+        line++;
+        if(line > longest) {
+            longest = line;
+        }
+    }
+
+    *width  = longest * fonts[fontnum].width;
+    *height = lines * fonts[fontnum].height;
+
+    unlock(fonts[fontnum].font_lock);
+    return 0;
+}
+
+void __APISTATUS_internal pyfb_drawText(uint8_t fbnum,
+                                        unsigned long int x,
+                                        unsigned long int y,
+                                        const uint32_t* text,
+                                        size_t len,
+                                        uint8_t fontnum,
+                                        const struct pyfb_color* color,
+                                        const struct pyfb_color* background) {
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    struct pyfb_font* font      = &fonts[fontnum];
+
+    const unsigned long int xres = fb->canvas.xres;
+    const unsigned long int yres = fb->canvas.yres;
+    const unsigned int depth     = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+    const int opaque             = background != NULL;
+
+    uint32_t fg = depth == 16 ? color->u16_color : color->u32_color;
+    uint32_t bg = 0;
+    if(opaque) {
+        bg = depth == 16 ? background->u16_color : background->u32_color;
+    }
+
+    // get the cached glyphs of this color and the masks for transparent painting, an
+    // indexed canvas is painted pixel by pixel
+    struct pyfb_glyphcache* cache = NULL;
+    void* mask                    = NULL;
+    size_t glyph_px               = (size_t)font->width * font->height;
+
+    if(fb->palette == NULL) {
+        cache = pyfb_glyphcache(font, depth, fg, bg, opaque);
+        mask  = opaque ? NULL : pyfb_glyphmask(font, depth);
+    }
+
+    if(!opaque && mask == NULL) {
+        cache = NULL;
+    }
+
+    unsigned long int cx     = x;
+    unsigned long int cy     = y;
+    unsigned long int pixels = 0;
+
+    for(size_t i = 0; i < len; i++) {
+        if(text[i] == '\n') {
+            cx = x;
+            cy += font->height;
+            continue;
+        }
+
+        if(cy >= yres) {
+            break;
+        }
+
+        if(cx < xres) {
+            unsigned int glyph = pyfb_glyph(font, text[i]);
+            unsigned int cw    = xres - cx < font->width ? (unsigned int)(xres - cx) : font->width;
+            unsigned int ch    = yres - cy < font->height ? (unsigned int)(yres - cy) : font->height;
+            pixels += (unsigned long int)cw * ch;
+
+            if(cache == NULL) {
+                pyfb_paintGlyph(fbnum, font, glyph, cx, cy, cw, ch, color, background);
+            } else {
+                if(!cache->expanded[glyph]) {
+                    pyfb_expandGlyph(font, glyph, depth, fg, bg, (uint8_t*)cache->pixels + glyph * glyph_px * (depth / 8));
+                    cache->expanded[glyph] = 1;
+                }
+
+                if(depth == 16) {
+                    pyfb_blitGlyph16(fb->u16_buffer + cy * xres + cx,
+                                     xres,
+                                     (const uint16_t*)cache->pixels + glyph * glyph_px,
+                                     opaque ? NULL : (const uint16_t*)mask + glyph * glyph_px,
+                                     font->width,
+                                     cw,
+                                     ch);
+                } else {
+                    pyfb_blitGlyph32(fb->u32_buffer + cy * xres + cx,
+                                     xres,
+                                     (const uint32_t*)cache->pixels + glyph * glyph_px,
+                                     opaque ? NULL : (const uint32_t*)mask + glyph * glyph_px,
+                                     font->width,
+                                     cw,
+                                     ch);
+                }
+            }
+        }
+
+        cx += font->width;
+    }
+
+    PYFB_STAT_PIXELS(fb, pixels);
+}
+
+void pyfb_sdrawText(uint8_t fbnum,
+                    unsigned long int x,
+                    unsigned long int y,
+                    const uint32_t* text,
+                    size_t len,
+                    uint8_t fontnum,
+                    const struct pyfb_color* color,
+                    const struct pyfb_color* background) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if fbnum and fontnum are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return;
+    }
+
+    if(fontnum >= MAX_FONTS) {
+        PyErr_SetString(PyExc_ValueError, "The font number is not valid");
+        return;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return;
+    }
+
+    // check if the starting point is on the screen
+    const struct pyfb_canvas* canvas = &pyfb_fbptr(fbnum)->canvas;
+
+    if(x >= canvas->xres || y >= canvas->yres) {
+        PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
+        pyfb_fbunlock(fbnum);
+        return;
+    }
+
+    // and lock the font
+    lock(fonts[fontnum].font_lock);
+
+    if(!fonts[fontnum].used) {
+        PyErr_SetString(PyExc_IOError, "The font is not loaded");
+        unlock(fonts[fontnum].font_lock);
+        pyfb_fbunlock(fbnum);
+        return;
+    }
+
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_TEXT);
+    pyfb_drawText(fbnum, x, y, text, len, fontnum, color, background);
+
+    // ready, so return
+    unlock(fonts[fontnum].font_lock);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawText", fbnum, trace_start);
+}
@@ -3,40 +3,93 @@
  */
 #include "pyframebuffer.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <linux/fb.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+/**
+ * The amount of offscreen buffer rows written with one pwritev call.
+ */
+#define PYFB_IOV_ROWS 64
+
+/**
+ * The maximum length of a PPM header for the resolution of a virtual framebuffer.
+ */
+#define PYFB_PPM_HEADER 32
+
 /**
  * The array with the framebuffers.
  */
 static struct pyfb_framebuffer framebuffers[MAX_FRAMEBUFFERS];
 
-void pyfb_init(void) {
-
-    static int allready_init = 0;
-    if(allready_init == 1) {
-        return;
-    }
-    allready_init = 1;
+/**
+ * Guards the initialization of the tables, which are shared by all interpreters of the process.
+ */
+static pthread_once_t pyfb_initonce = PTHREAD_ONCE_INIT;
 
+/**
+ * Initializes the framebuffer, font, clock, async worker and sprite tables.
+ */
+static void pyfb_initTables(void) {
     for(int i = 0; i < MAX_FRAMEBUFFERS; i++) {
         framebuffers[i].fb_fd             = -1;
         framebuffers[i].users             = 0;
         framebuffers[i].fb_info.fb_size_b = 0;
         framebuffers[i].u32_buffer        = NULL;
+        framebuffers[i].fb_map            = NULL;
+        framebuffers[i].stream            = NULL;
+        framebuffers[i].shared            = NULL;
+        framebuffers[i].fb_virtual        = 0;
+        framebuffers[i].dump_fd           = -1;
+        framebuffers[i].dump_buffer       = NULL;
+        framebuffers[i].stats_enabled     = 0;
+        framebuffers[i].keepalive_ns      = 0;
+        framebuffers[i].idle_until        = 0;
         atomic_flag flag                  = ATOMIC_FLAG_INIT;
         framebuffers[i].fb_lock           = flag;
     }
+
+    pyfb_fontinit();
+    pyfb_clockinit();
+    pyfb_asyncinit();
+    pyfb_spriteinit();
+}
+
+void pyfb_init(void) {
+    // every interpreter importing the module calls this, maybe at the same time
+    pthread_once(&pyfb_initonce, pyfb_initTables);
+}
+
+struct pyfb_framebuffer* __APISTATUS_internal pyfb_fbptr(uint8_t fbnum) {
+    return &framebuffers[fbnum];
+}
+
+const uint8_t* __APISTATUS_internal pyfb_fbmap(uint8_t fbnum) {
+    if(framebuffers[fbnum].fb_map == NULL) {
+        void* map = mmap(NULL, framebuffers[fbnum].fb_mem_len, PROT_READ, MAP_SHARED, framebuffers[fbnum].fb_fd, 0);
+        if(map == MAP_FAILED) {
+            return NULL;
+        }
+
+        framebuffers[fbnum].fb_map = map;
+    }
+
+    return (const uint8_t*)framebuffers[fbnum].fb_map;
 }
 
 int __APISTATUS_internal pyfb_fbused(uint8_t fbnum) {
-    if(framebuffers[fbnum].fb_fd == -1) {
+    // a framebuffer kept alive without users holds its device file, but is not in use
+    if(framebuffers[fbnum].users == 0) {
         return 0;
     }
 
@@ -50,197 +103,1198 @@ void __APISTATUS_internal pyfb_fblock(uint8_t fbnum) {
         return;
     }
 
-    lock(framebuffers[fbnum].fb_lock);
+    if(__builtin_expect(atomic_load_explicit(&pyfb_trace_enabled, memory_order_relaxed), 0)) {
+        // only trace the lock if another thread holds it
+        if(!atomic_flag_test_and_set(&framebuffers[fbnum].fb_lock)) {
+            return;
+        }
+
+        PYFB_TRACE_BEGIN(start);
+        lock(framebuffers[fbnum].fb_lock);
+        PYFB_TRACE_END("lockWait", fbnum, start);
+        return;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+}
+
+void __APISTATUS_internal pyfb_fbunlock(uint8_t fbnum) {
+    // first test if this device number is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        return;
+    }
+
+    unlock(framebuffers[fbnum].fb_lock);
+}
+
+/**
+ * Pans the display of a framebuffer to an offset in the device memory.
+ *
+ * @param fbnum The framebuffer number, must be opened and locked
+ * @param x The x offset
+ * @param y The y offset
+ *
+ * @return By success 0, else -1 if the driver does not support it
+ */
+static int pyfb_pan(uint8_t fbnum, unsigned long int x, unsigned long int y) {
+    struct fb_var_screeninfo vinfo = framebuffers[fbnum].fb_info.vinfo;
+    vinfo.xoffset                  = x;
+    vinfo.yoffset                  = y;
+
+    if(ioctl(framebuffers[fbnum].fb_fd, FBIOPAN_DISPLAY, &vinfo) == -1) {
+        return -1;
+    }
+
+    framebuffers[fbnum].fb_info.vinfo.xoffset = x;
+    framebuffers[fbnum].fb_info.vinfo.yoffset = y;
+    return 0;
+}
+
+/**
+ * Allocates the offscreen buffer for a canvas of the screen size and fills the
+ * framebuffer structure for a freshly opened device. The vinfo must be read before.
+ * On failure the device file is closed and the vinfo cleared.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ * @param fb_fd The opened device file
+ * @param line_length The length of a row of the device memory in bytes
+ * @param mem_len The length of the device memory in bytes
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+static int pyfb_setup(uint8_t fbnum, int fb_fd, unsigned long int line_length, unsigned long int mem_len) {
+    struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+
+    // Now alocate the offscreen buffer for a canvas of the screen size
+    unsigned long int fb_size_b = vinfo->yres * vinfo->xres * vinfo->bits_per_pixel / 8;
+
+    // offscreen buffers
+    void* buffer = calloc(fb_size_b, 1);
+
+    if(buffer == NULL) {
+        // got out of memory for the offscreen buffers
+
+        // free up all other resources for the new buffer
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
+        close(fb_fd);
+        memset((void*)vinfo, 0, sizeof(struct fb_var_screeninfo));
+        return -1;
+    }
+
+    // if we get here, all is right and the structure can be filled.
+    framebuffers[fbnum].users = 1;
+    framebuffers[fbnum].fb_fd = fb_fd;
+
+    if(vinfo->bits_per_pixel == 32) {
+        framebuffers[fbnum].u32_buffer = (uint32_t*)buffer;
+    } else {
+        framebuffers[fbnum].u16_buffer = (uint16_t*)buffer;
+    }
+
+    framebuffers[fbnum].fb_info.fb_size_b = fb_size_b;
+    framebuffers[fbnum].fb_line_length    = line_length;
+    framebuffers[fbnum].fb_mem_len        = mem_len;
+    framebuffers[fbnum].fb_virtual        = 0;
+    framebuffers[fbnum].dump_fd           = -1;
+    framebuffers[fbnum].dump_buffer       = NULL;
+    framebuffers[fbnum].stats_enabled     = 0;
+    framebuffers[fbnum].stale             = 0;
+    memset((void*)&framebuffers[fbnum].stats, 0, sizeof(struct pyfb_stats));
+    memset((void*)&framebuffers[fbnum].damage, 0, sizeof(struct pyfb_damage));
+
+    struct pyfb_canvas canvas  = {.xres = vinfo->xres, .yres = vinfo->yres};
+    framebuffers[fbnum].canvas = canvas;
+    return 0;
+}
+
+/**
+ * Closes the dump of a virtual framebuffer, if it is dumped.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ */
+static void pyfb_closeDump(uint8_t fbnum) {
+    if(framebuffers[fbnum].dump_fd >= 0) {
+        close(framebuffers[fbnum].dump_fd);
+    }
+
+    free(framebuffers[fbnum].dump_buffer);
+    framebuffers[fbnum].dump_fd     = -1;
+    framebuffers[fbnum].dump_buffer = NULL;
+    framebuffers[fbnum].fb_virtual  = 0;
+}
+
+/**
+ * The bit of every framebuffer kept alive without users, so the reaper only locks these.
+ */
+static atomic_ulong pyfb_idlemask = 0;
+
+/**
+ * The mutex of the reaper state.
+ */
+static pthread_mutex_t pyfb_reapermutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Signaled if a framebuffer is kept alive or its period changed, with the monotonic clock.
+ */
+static pthread_cond_t pyfb_reapercond;
+
+/**
+ * Not 0 if the reaper thread is started, protected by the mutex.
+ */
+static int pyfb_reaperstarted = 0;
+
+/**
+ * Not 0 if the reaper must look at the idle framebuffers again, protected by the mutex.
+ */
+static int pyfb_reaperpending = 0;
+
+/**
+ * Marks a framebuffer as kept alive without users or not.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ * @param idle Not 0 if the framebuffer is kept alive
+ */
+static inline void pyfb_setIdle(uint8_t fbnum, int idle) {
+    if(idle) {
+        atomic_fetch_or(&pyfb_idlemask, 1ul << fbnum);
+    } else {
+        atomic_fetch_and(&pyfb_idlemask, ~(1ul << fbnum));
+    }
+}
+
+/**
+ * Frees all resources of a framebuffer, closes the device file and invalidates
+ * the videomode info.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ */
+static void pyfb_release(uint8_t fbnum) {
+    // stop the stream and the mirror group, and leave the group of a source
+    pyfb_streamStop(fbnum);
+    pyfb_mirrorStop(fbnum);
+    framebuffers[fbnum].mirror_source = 0;
+
+    // close file descriptors and mapping if are still opened
+    pyfb_closeDump(fbnum);
+
+    if(framebuffers[fbnum].fb_map != NULL) {
+        munmap(framebuffers[fbnum].fb_map, framebuffers[fbnum].fb_mem_len);
+        framebuffers[fbnum].fb_map = NULL;
+    }
+
+    if(framebuffers[fbnum].fb_fd >= 0) {
+        close(framebuffers[fbnum].fb_fd);
+    }
+
+    framebuffers[fbnum].fb_fd = -1;
+
+    // a shared offscreen buffer is unmapped instead of freed
+    if(framebuffers[fbnum].shared != NULL) {
+        pyfb_sharedClose(fbnum);
+    }
+
+    // free the offscreen buffers
+    void** buffer;
+
+    if(framebuffers[fbnum].fb_info.vinfo.bits_per_pixel == 32) {
+        buffer = ((void*)&framebuffers[fbnum].u32_buffer);
+    } else {
+        buffer = ((void*)&framebuffers[fbnum].u16_buffer);
+    }
+
+    if(*buffer != NULL) {
+        free(*buffer);
+    }
+
+    *buffer = NULL;
+
+    free(framebuffers[fbnum].rotate_buffer);
+    free(framebuffers[fbnum].palette);
+    framebuffers[fbnum].rotate_buffer = NULL;
+    framebuffers[fbnum].palette       = NULL;
+
+    // and clean up the videomode info
+    framebuffers[fbnum].fb_info.fb_size_b = 0;
+    memset((void*)&framebuffers[fbnum].fb_info.vinfo, 0, sizeof(struct fb_var_screeninfo));
+    memset((void*)&framebuffers[fbnum].canvas, 0, sizeof(struct pyfb_canvas));
+}
+
+/**
+ * Returns if a framebuffer is kept alive without users.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ */
+static inline int pyfb_isIdle(uint8_t fbnum) {
+    return framebuffers[fbnum].users == 0 && framebuffers[fbnum].fb_fd != -1;
+}
+
+/**
+ * Clears the offscreen buffer of a framebuffer kept alive, if it still holds the frame of
+ * its previous user.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ */
+static void pyfb_clearStale(uint8_t fbnum) {
+    if(framebuffers[fbnum].stale) {
+        memset(framebuffers[fbnum].u8_buffer, 0, framebuffers[fbnum].fb_info.fb_size_b);
+        framebuffers[fbnum].stale = 0;
+    }
+}
+
+/**
+ * Releases the framebuffers kept alive longer than their idle period, and clears the
+ * offscreen buffers of the others. The caller must not hold a framebuffer lock.
+ *
+ * @return The time the next framebuffer kept alive expires at, or 0 if there is none
+ */
+static uint64_t pyfb_expireIdle(void) {
+    unsigned long int mask = atomic_load(&pyfb_idlemask);
+    uint64_t now           = pyfb_traceNow();
+    uint64_t next          = 0;
+
+    for(int i = 0; i < MAX_FRAMEBUFFERS && mask != 0; i++) {
+        if(!(mask & (1ul << i))) {
+            continue;
+        }
+
+        lock(framebuffers[i].fb_lock);
+
+        if(pyfb_isIdle((uint8_t)i)) {
+            if(now >= framebuffers[i].idle_until) {
+                pyfb_release((uint8_t)i);
+                pyfb_setIdle((uint8_t)i, 0);
+            } else {
+                // cleared here, so the next open does not pay for it
+                pyfb_clearStale((uint8_t)i);
+                next = next == 0 || framebuffers[i].idle_until < next ? framebuffers[i].idle_until : next;
+            }
+        }
+
+        unlock(framebuffers[i].fb_lock);
+    }
+
+    return next;
+}
+
+/**
+ * The reaper thread, releasing the framebuffers kept alive when their idle period
+ * ends, even if no framebuffer is opened or closed anymore.
+ */
+static void* pyfb_reaperThread(void* arg) {
+    uint64_t next = 0;
+
+    pthread_mutex_lock(&pyfb_reapermutex);
+
+    while(1) {
+        if(!pyfb_reaperpending) {
+            if(next == 0) {
+                pthread_cond_wait(&pyfb_reapercond, &pyfb_reapermutex);
+            } else {
+                // the idle timestamps are of the monotonic clock, see pyfb_traceNow
+                struct timespec ts = {(time_t)(next / 1000000000u), (long)(next % 1000000000u)};
+                pthread_cond_timedwait(&pyfb_reapercond, &pyfb_reapermutex, &ts);
+            }
+        }
+
+        pyfb_reaperpending = 0;
+
+        // the framebuffer locks are taken without the mutex, see pyfb_reaperNotify
+        pthread_mutex_unlock(&pyfb_reapermutex);
+        next = pyfb_expireIdle();
+        pthread_mutex_lock(&pyfb_reapermutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * Starts the reaper thread, if it is not started yet.
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+static int pyfb_reaperStart(void) {
+    int exitcode = 0;
+
+    pthread_mutex_lock(&pyfb_reapermutex);
+
+    if(!pyfb_reaperstarted) {
+        // the reaper waits for the idle timestamps of the monotonic clock
+        pthread_condattr_t condattr;
+        pthread_condattr_init(&condattr);
+        pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+        pthread_cond_init(&pyfb_reapercond, &condattr);
+        pthread_condattr_destroy(&condattr);
+
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+        if(pthread_create(&thread, &attr, pyfb_reaperThread, NULL) == 0) {
+            pyfb_reaperstarted = 1;
+        } else {
+            PyErr_SetString(PyExc_IOError, "Could not start the keep-alive thread");
+            pthread_cond_destroy(&pyfb_reapercond);
+            exitcode = -1;
+        }
+
+        pthread_attr_destroy(&attr);
+    }
+
+    pthread_mutex_unlock(&pyfb_reapermutex);
+    return exitcode;
+}
+
+/**
+ * Wakes the reaper thread to look at the idle framebuffers again. Must be called
+ * without a framebuffer lock, as the reaper takes them.
+ */
+static void pyfb_reaperNotify(void) {
+    pthread_mutex_lock(&pyfb_reapermutex);
+    pyfb_reaperpending = 1;
+    pthread_cond_signal(&pyfb_reapercond);
+    pthread_mutex_unlock(&pyfb_reapermutex);
+}
+
+/**
+ * Reuses a framebuffer kept alive like freshly opened, without the frame, counters,
+ * rotation, flip and damage of its previous user.
+ *
+ * @param fbnum The framebuffer number, must be locked and kept alive
+ */
+static void pyfb_reuse(uint8_t fbnum) {
+    pyfb_setIdle(fbnum, 0);
+    pyfb_clearStale(fbnum);
+    free(framebuffers[fbnum].rotate_buffer);
+    framebuffers[fbnum].rotate_buffer = NULL;
+    framebuffers[fbnum].stats_enabled = 0;
+    memset((void*)&framebuffers[fbnum].stats, 0, sizeof(struct pyfb_stats));
+    memset((void*)&framebuffers[fbnum].damage, 0, sizeof(struct pyfb_damage));
+
+    const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    struct pyfb_canvas canvas             = {.xres = vinfo->xres, .yres = vinfo->yres};
+    framebuffers[fbnum].canvas            = canvas;
+}
+
+int pyfb_open(uint8_t fbnum) {
+    // first test if this device number is valid.
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -2;
+    }
+
+    // Now try to open the framebuffer
+    lock(framebuffers[fbnum].fb_lock);
+
+    // a virtual framebuffer kept alive gives the number free
+    if(pyfb_isIdle(fbnum) && framebuffers[fbnum].fb_virtual) {
+        pyfb_release(fbnum);
+        pyfb_setIdle(fbnum, 0);
+    }
+
+    // first check if we need to open the framebuffer
+    if(framebuffers[fbnum].fb_fd != -1) {
+        if(framebuffers[fbnum].users == 0) {
+            pyfb_reuse(fbnum);
+        }
+
+        // the framebuffer is allready opened,
+        // so it is okay with just increment the user count and return
+        framebuffers[fbnum].users++;
+        unlock(framebuffers[fbnum].fb_lock);
+        return 0;
+    }
+
+    // else if we get here, we must open and initialize the framebuffer structure
+    char fb_device[14];
+    snprintf(fb_device, 14, "/dev/fb%hhu", fbnum);
+
+    // open the framebuffer
+    int fb_fd = open(fb_device, O_RDWR);
+    if(fb_fd == -1) {
+        // failed to open the requested device
+        PyErr_SetString(PyExc_ValueError, "Could not open requested framebuffer");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    // Now get the screen info
+    struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    if(ioctl(fb_fd, FBIOGET_VSCREENINFO, vinfo) == -1) {
+        // failed to get the vinfo structure
+        PyErr_SetString(PyExc_IOError, "Could not read display information. Is it really a framebuffer device file?");
+        unlock(framebuffers[fbnum].fb_lock);
+        close(fb_fd);
+        return -1;
+    }
+
+    // and the length of a row and of the whole device memory
+    struct fb_fix_screeninfo finfo;
+    unsigned long int line_length = vinfo->xres_virtual * vinfo->bits_per_pixel / 8;
+    unsigned long int mem_len     = 0;
+
+    if(ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo) == 0 && finfo.line_length != 0) {
+        line_length = finfo.line_length;
+        mem_len     = finfo.smem_len;
+    }
+
+    if(mem_len == 0) {
+        mem_len = line_length * vinfo->yres_virtual;
+    }
+
+    int exitcode = pyfb_setup(fbnum, fb_fd, line_length, mem_len);
+
+    // structure ready, return
+    unlock(framebuffers[fbnum].fb_lock);
+    return exitcode;
+}
+
+int pyfb_openVirtual(uint8_t fbnum,
+                     unsigned long int xres,
+                     unsigned long int yres,
+                     unsigned int depth,
+                     int dump_fd,
+                     int dump_format) {
+    // first test if the arguments are valid.
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(xres == 0 || yres == 0 || xres > PYFB_VIRTUAL_MAXRES || yres > PYFB_VIRTUAL_MAXRES || (depth != 16 && depth != 32)) {
+        PyErr_SetString(PyExc_ValueError, "The resolution of the virtual framebuffer is not valid");
+        return -1;
+    }
+
+    if(dump_format != PYFB_DUMP_RAW && dump_format != PYFB_DUMP_PPM) {
+        PyErr_SetString(PyExc_ValueError, "The dump format is not valid");
+        return -1;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    // a virtual framebuffer of the same size kept alive is reused, if it is not dumped,
+    // any other framebuffer kept alive gives the number free
+    if(pyfb_isIdle(fbnum)) {
+        const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+
+        if(framebuffers[fbnum].fb_virtual && dump_fd < 0 && vinfo->xres == xres && vinfo->yres == yres &&
+           vinfo->bits_per_pixel == depth) {
+            pyfb_reuse(fbnum);
+        } else {
+            pyfb_release(fbnum);
+            pyfb_setIdle(fbnum, 0);
+        }
+    }
+
+    // first check if the same virtual framebuffer is allready opened
+    if(framebuffers[fbnum].fb_fd != -1) {
+        const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+
+        if(!framebuffers[fbnum].fb_virtual || vinfo->xres != xres || vinfo->yres != yres || vinfo->bits_per_pixel != depth) {
+            PyErr_SetString(PyExc_ValueError, "The framebuffer number is allready in use by another device");
+            unlock(framebuffers[fbnum].fb_lock);
+            return -1;
+        }
+
+        framebuffers[fbnum].users++;
+        unlock(framebuffers[fbnum].fb_lock);
+        return 0;
+    }
+
+    // the device memory is a memory file, so the flush writes to it like to a device file
+    unsigned long int line_length = xres * depth / 8;
+    unsigned long int mem_len     = line_length * yres;
+    int fb_fd                     = memfd_create("pyframebuffer", MFD_CLOEXEC);
+
+    if(fb_fd == -1 || ftruncate(fb_fd, (off_t)mem_len) == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not create the memory of the virtual framebuffer");
+        if(fb_fd != -1) {
+            close(fb_fd);
+        }
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    // the frames are dumped to a duplicate of the caller's file descriptor
+    int dump = -1;
+    if(dump_fd >= 0) {
+        dump = fcntl(dump_fd, F_DUPFD_CLOEXEC, 0);
+        if(dump == -1) {
+            PyErr_SetString(PyExc_IOError, "Could not duplicate the dump file descriptor");
+            close(fb_fd);
+            unlock(framebuffers[fbnum].fb_lock);
+            return -1;
+        }
+    }
+
+    // describe the memory like a framebuffer driver, with the pixel format of the colors
+    struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    memset((void*)vinfo, 0, sizeof(struct fb_var_screeninfo));
+    vinfo->xres           = xres;
+    vinfo->yres           = yres;
+    vinfo->xres_virtual   = xres;
+    vinfo->yres_virtual   = yres;
+    vinfo->bits_per_pixel = depth;
+
+    if(depth == 32) {
+        vinfo->red.offset    = 24;
+        vinfo->green.offset  = 16;
+        vinfo->blue.offset   = 8;
+        vinfo->transp.offset = 0;
+        vinfo->red.length    = 8;
+        vinfo->green.length  = 8;
+        vinfo->blue.length   = 8;
+        vinfo->transp.length = 8;
+    } else {
+        vinfo->red.offset   = 11;
+        vinfo->green.offset = 5;
+        vinfo->blue.offset  = 0;
+        vinfo->red.length   = 5;
+        vinfo->green.length = 6;
+        vinfo->blue.length  = 5;
+    }
+
+    // a PPM frame is assembled completely, with the header and a conversion row behind
+    uint8_t* dump_buffer = NULL;
+    if(dump != -1 && dump_format == PYFB_DUMP_PPM) {
+        dump_buffer = (uint8_t*)malloc(PYFB_PPM_HEADER + xres * yres * 3 + xres * 4);
+    }
+
+    if((dump != -1 && dump_format == PYFB_DUMP_PPM && dump_buffer == NULL) ||
+       pyfb_setup(fbnum, fb_fd, line_length, mem_len) != 0) {
+        if(!PyErr_Occurred()) {
+            PyErr_SetString(PyExc_MemoryError, "Could not allocate the dump buffer");
+            close(fb_fd);
+            memset((void*)vinfo, 0, sizeof(struct fb_var_screeninfo));
+        }
+
+        if(dump != -1) {
+            close(dump);
+        }
+
+        free(dump_buffer);
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    framebuffers[fbnum].fb_virtual  = 1;
+    framebuffers[fbnum].dump_fd     = dump;
+    framebuffers[fbnum].dump_format = dump_format;
+    framebuffers[fbnum].dump_buffer = dump_buffer;
+
+    // structure ready, return with success
+    unlock(framebuffers[fbnum].fb_lock);
+    return 0;
+}
+
+void pyfb_close(uint8_t fbnum) {
+    // first test if this device number is valid.
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return;
+    }
+
+    // Now try to open the framebuffer
+    lock(framebuffers[fbnum].fb_lock);
+
+    if(framebuffers[fbnum].users > 1) {
+        // this means that we are not the only user of this framebuffer,
+        // so that we can just release our reference on it
+        framebuffers[fbnum].users--;
+        unlock(framebuffers[fbnum].fb_lock);
+        return;
+    }
+
+    // for wrong usage of this library
+    if(framebuffers[fbnum].users == 0) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is allready closed.");
+        // should never happen, but if we get here, clean all up to not break internals
+        printf("WARNING: Detected internal mismatch of libaray usage.\nPlease check your program or report if is a bug from "
+               "our side.\n");
+
+        pyfb_setIdle(fbnum, 0);
+        pyfb_release(fbnum);
+
+        // ok, return
+        unlock(framebuffers[fbnum].fb_lock);
+        return;
+    }
+
+    // Okay, now handle a real close
+    framebuffers[fbnum].users = 0;
+
+    // move the display back if it has been panned
+    if(framebuffers[fbnum].canvas.panning && (framebuffers[fbnum].canvas.xoffset || framebuffers[fbnum].canvas.yoffset)) {
+        pyfb_pan(fbnum, 0, 0);
+    }
+
+    // keep a device with a canvas of the screen size alive, so the next open is only a
+    // refcount bump. The reaper thread clears the frame of the offscreen buffer meanwhile.
+    const struct pyfb_canvas* canvas = &framebuffers[fbnum].canvas;
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
+
+    if(framebuffers[fbnum].keepalive_ns != 0 && framebuffers[fbnum].dump_fd < 0 && framebuffers[fbnum].shared == NULL &&
+       framebuffers[fbnum].palette == NULL && !canvas->panning && canvas->xres == xres && canvas->yres == yres) {
+        pyfb_streamStop(fbnum);
+        pyfb_mirrorStop(fbnum);
+        framebuffers[fbnum].mirror_source = 0;
+        framebuffers[fbnum].idle_until    = pyfb_traceNow() + framebuffers[fbnum].keepalive_ns;
+        framebuffers[fbnum].stale         = 1;
+        pyfb_setIdle(fbnum, 1);
+        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_reaperNotify();
+        return;
+    }
+
+    pyfb_release(fbnum);
+
+    // all cleaned up and resources free
+    // can return now
+    unlock(framebuffers[fbnum].fb_lock);
+}
+
+int pyfb_ssetKeepAlive(uint8_t fbnum, double seconds) {
+    // first test if this device number is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(!(seconds >= 0 && seconds <= PYFB_KEEPALIVE_MAX)) {
+        PyErr_SetString(PyExc_ValueError, "The keep-alive period is not valid");
+        return -1;
+    }
+
+    // the framebuffers kept alive are released by the reaper thread
+    if(seconds > 0 && pyfb_reaperStart() != 0) {
+        return -1;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    framebuffers[fbnum].keepalive_ns = (uint64_t)(seconds * 1e9);
+
+    // a framebuffer kept alive expires with the new period, counted from now
+    int idle = pyfb_isIdle(fbnum);
+    if(idle) {
+        if(framebuffers[fbnum].keepalive_ns == 0) {
+            pyfb_release(fbnum);
+            pyfb_setIdle(fbnum, 0);
+        } else {
+            framebuffers[fbnum].idle_until = pyfb_traceNow() + framebuffers[fbnum].keepalive_ns;
+        }
+    }
+
+    unlock(framebuffers[fbnum].fb_lock);
+
+    if(idle && seconds > 0) {
+        pyfb_reaperNotify();
+    }
+
+    return 0;
+}
+
+void pyfb_svinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr) {
+    // first test if this device number is valid.
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        return;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    memcpy(info_ptr, &framebuffers[fbnum].fb_info, sizeof(struct pyfb_videomode_info));
+
+    unlock(framebuffers[fbnum].fb_lock);
+}
+
+void __APISTATUS_internal pyfb_vinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr) {
+    memcpy(info_ptr, &framebuffers[fbnum].fb_info, sizeof(struct pyfb_videomode_info));
+}
+
+void pyfb_scanvas(uint8_t fbnum, struct pyfb_canvas* canvas_ptr) {
+    // first test if this device number is valid.
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        memset((void*)canvas_ptr, 0, sizeof(struct pyfb_canvas));
+        return;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    memcpy(canvas_ptr, &framebuffers[fbnum].canvas, sizeof(struct pyfb_canvas));
+
+    unlock(framebuffers[fbnum].fb_lock);
+}
+
+void __APISTATUS_internal pyfb_screenSize(uint8_t fbnum, unsigned long int* xres, unsigned long int* yres) {
+    const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+
+    // a quarter turn swaps the sides
+    if(framebuffers[fbnum].canvas.rotation & 1) {
+        *xres = vinfo->yres;
+        *yres = vinfo->xres;
+    } else {
+        *xres = vinfo->xres;
+        *yres = vinfo->yres;
+    }
+}
+
+int pyfb_ssetCanvas(uint8_t fbnum, unsigned long int xres, unsigned long int yres) {
+    // first test if this device number is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    // next, test if the device is really in use
+    if(framebuffers[fbnum].users == 0) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    if(framebuffers[fbnum].shared != NULL) {
+        PyErr_SetString(PyExc_IOError, "The canvas of a shared offscreen buffer can not be changed");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    int indexed                           = framebuffers[fbnum].palette != NULL;
+    unsigned long int bytes               = indexed ? 1 : vinfo->bits_per_pixel / 8;
+    unsigned long int screen_x, screen_y;
+    pyfb_screenSize(fbnum, &screen_x, &screen_y);
+
+    if(xres < screen_x || yres < screen_y) {
+        PyErr_SetString(PyExc_ValueError, "The canvas must be at least as large as the screen");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    if(xres > SIZE_MAX / bytes / yres) {
+        PyErr_SetString(PyExc_ValueError, "The canvas is too large");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    // allocate the new offscreen buffer
+    unsigned long int fb_size_b = xres * yres * bytes;
+    void* buffer                = calloc(fb_size_b, 1);
+
+    if(buffer == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    free(framebuffers[fbnum].u32_buffer);
+    framebuffers[fbnum].u32_buffer        = (uint32_t*)buffer;
+    framebuffers[fbnum].fb_info.fb_size_b = fb_size_b;
+
+    // move the display back if the old canvas has been panned
+    if(framebuffers[fbnum].canvas.panning) {
+        pyfb_pan(fbnum, 0, 0);
+    }
+
+    // the driver can pan the canvas only if it has the layout of the device memory
+    int rotation = framebuffers[fbnum].canvas.rotation;
+    int flip     = framebuffers[fbnum].canvas.flip;
+    int panning  = !indexed && rotation == 0 && flip == 0 && xres == vinfo->xres_virtual && yres <= vinfo->yres_virtual &&
+                   xres * bytes == framebuffers[fbnum].fb_line_length;
+
+    if(panning && pyfb_pan(fbnum, 0, 0) != 0) {
+        panning = 0;
+    }
+
+    struct pyfb_canvas canvas  = {xres, yres, 0, 0, panning, rotation, flip};
+    framebuffers[fbnum].canvas = canvas;
+
+    unlock(framebuffers[fbnum].fb_lock);
+    return 0;
+}
+
+int pyfb_ssetViewport(uint8_t fbnum, unsigned long int x, unsigned long int y) {
+    // first test if this device number is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    lock(framebuffers[fbnum].fb_lock);
+
+    // next, test if the device is really in use
+    if(framebuffers[fbnum].users == 0) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    struct pyfb_canvas* canvas = &framebuffers[fbnum].canvas;
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
+
+    if(x > canvas->xres - xres || y > canvas->yres - yres) {
+        PyErr_SetString(PyExc_ValueError, "The viewport is not on the canvas");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    canvas->xoffset = x;
+    canvas->yoffset = y;
+
+    int panned = 0;
+    if(canvas->panning) {
+        if(pyfb_pan(fbnum, x, y) == 0) {
+            panned = 1;
+        } else {
+            // the driver refused, so fall back to copy the viewport by the flush
+            canvas->panning = 0;
+        }
+    }
+
+    unlock(framebuffers[fbnum].fb_lock);
+    return panned;
+}
+
+int __APISTATUS_internal pyfb_writeRect(uint8_t fbnum, const struct pyfb_damage* damage) {
+    const struct pyfb_framebuffer* fb     = &framebuffers[fbnum];
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+
+    size_t bytes           = vinfo->bits_per_pixel / 8;
+    size_t row_len         = (damage->x1 - damage->x0) * bytes;
+    size_t stride          = fb->canvas.xres * bytes;
+    size_t line_length     = fb->fb_line_length;
+    unsigned long int rows = damage->y1 - damage->y0;
+    off_t offset           = (off_t)((vinfo->yoffset + damage->y0) * line_length + (vinfo->xoffset + damage->x0) * bytes);
+    const uint8_t* src     = (const uint8_t*)fb->u32_buffer + (fb->canvas.yoffset + damage->y0) * stride +
+                         (fb->canvas.xoffset + damage->x0) * bytes;
+
+    if(row_len == stride && row_len == line_length) {
+        // the rows are contiguous on both sides, so write all at once
+        size_t len = row_len * rows;
+        return pwrite(fb->fb_fd, src, len, offset) == (ssize_t)len ? 0 : -1;
+    }
+
+    if(row_len == line_length) {
+        // the device rows are contiguous, so gather the canvas rows
+        struct iovec iov[PYFB_IOV_ROWS];
+
+        for(unsigned long int row = 0; row < rows; row += PYFB_IOV_ROWS) {
+            int count = rows - row < PYFB_IOV_ROWS ? (int)(rows - row) : PYFB_IOV_ROWS;
+
+            for(int i = 0; i < count; i++) {
+                iov[i].iov_base = (void*)(src + (row + i) * stride);
+                iov[i].iov_len  = row_len;
+            }
+
+            if(pwritev(fb->fb_fd, iov, count, offset + (off_t)(row * row_len)) != (ssize_t)(count * row_len)) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    // else write row by row
+    for(unsigned long int row = 0; row < rows; row++) {
+        if(pwrite(fb->fb_fd, src + row * stride, row_len, offset + (off_t)(row * line_length)) != (ssize_t)row_len) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the viewport of the canvas to the visible area of the device memory.
+ *
+ * @param fbnum The framebuffer number, must be opened and locked
+ *
+ * @return By success 0, else -1
+ */
+static int pyfb_writeViewport(uint8_t fbnum) {
+    const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    struct pyfb_damage viewport           = {0, 0, vinfo->xres, vinfo->yres};
+    return pyfb_writeRect(fbnum, &viewport);
+}
+
+/**
+ * Writes data completely to a file descriptor.
+ *
+ * @param fd The file descriptor
+ * @param data The data to write
+ * @param len The length of the data
+ *
+ * @return By success 0, else -1
+ */
+static int pyfb_writeAll(int fd, const uint8_t* data, size_t len) {
+    while(len > 0) {
+        ssize_t written = write(fd, data, len);
+
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        data += written;
+        len -= (size_t)written;
+    }
+
+    return 0;
+}
+
+/**
+ * Dumps the visible area of the memory of a virtual framebuffer, means the frame just
+ * flushed, to the dump file descriptor.
+ *
+ * @param fbnum The framebuffer number, must be locked and dumped
+ *
+ * @return By success 0, else -1
+ */
+static int pyfb_dumpFrame(uint8_t fbnum) {
+    const struct pyfb_framebuffer* fb     = &framebuffers[fbnum];
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+
+    const uint8_t* map = pyfb_fbmap(fbnum);
+    if(map == NULL) {
+        return -1;
+    }
+
+    size_t bytes   = vinfo->bits_per_pixel / 8;
+    size_t row_len = vinfo->xres * bytes;
+
+    if(fb->dump_format == PYFB_DUMP_RAW) {
+        // the memory of a virtual framebuffer has no padding, so write it at once
+        return pyfb_writeAll(fb->dump_fd, map, row_len * vinfo->yres);
+    }
+
+    // else assemble a PPM image, converting each row through RGBA
+    uint8_t* ppm    = fb->dump_buffer;
+    int header_len  = snprintf((char*)ppm, PYFB_PPM_HEADER, "P6\n%u %u\n255\n", vinfo->xres, vinfo->yres);
+    uint8_t* pixels = ppm + header_len;
+    uint8_t* rgba   = ppm + PYFB_PPM_HEADER + vinfo->xres * vinfo->yres * 3;
+
+    for(unsigned long int row = 0; row < vinfo->yres; row++) {
+        uint8_t* rgb = pixels + row * vinfo->xres * 3;
+        pyfb_convertRGBA(map + row * fb->fb_line_length, vinfo->bits_per_pixel, rgba, vinfo->xres);
+
+        for(unsigned long int x = 0; x < vinfo->xres; x++) {
+            rgb[x * 3]     = rgba[x * 4];
+            rgb[x * 3 + 1] = rgba[x * 4 + 1];
+            rgb[x * 3 + 2] = rgba[x * 4 + 2];
+        }
+    }
+
+    return pyfb_writeAll(fb->dump_fd, ppm, header_len + vinfo->xres * vinfo->yres * 3);
 }
 
-void __APISTATUS_internal pyfb_fbunlock(uint8_t fbnum) {
-    // first test if this device number is valid
-    if(fbnum >= MAX_FRAMEBUFFERS) {
-        return;
+/**
+ * Counts a flush in the performance counters.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ * @param start The time the flush started
+ * @param bytes The bytes written to the device
+ */
+static void pyfb_statFlush(uint8_t fbnum, const struct timespec* start, size_t bytes) {
+    struct pyfb_stats* stats = &framebuffers[fbnum].stats;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t ns = (uint64_t)(end.tv_sec - start->tv_sec) * 1000000000u + (uint64_t)end.tv_nsec - (uint64_t)start->tv_nsec;
+    uint64_t us = ns / 1000;
+
+    // bucket i counts the latencies below 2^i microseconds
+    unsigned int bucket = us == 0 ? 0 : 64 - (unsigned int)__builtin_clzll(us);
+    if(bucket >= PYFB_STAT_BUCKETS) {
+        bucket = PYFB_STAT_BUCKETS - 1;
     }
 
-    unlock(framebuffers[fbnum].fb_lock);
+    atomic_fetch_add_explicit(&stats->flushes, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->flush_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->flush_ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->flush_hist[bucket], 1, memory_order_relaxed);
 }
 
-int pyfb_open(uint8_t fbnum) {
-    // first test if this device number is valid.
+int pyfb_flushBuffer(uint8_t fbnum) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first test if this device number is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
-        return -2;
+        return -1;
     }
 
-    // Now try to open the framebuffer
-    lock(framebuffers[fbnum].fb_lock);
+    pyfb_fblock(fbnum);
 
-    // first check if we need to open the framebuffer
-    if(framebuffers[fbnum].fb_fd != -1) {
-        // the framebuffer is allready opened,
-        // so it is okay with just increment the user count and return
-        framebuffers[fbnum].users++;
-        unlock(framebuffers[fbnum].fb_lock);
-        return 0;
+    // next, test if the device is really in use
+    if(framebuffers[fbnum].users == 0) {
+        // this framebuffer is not in use, so ignore
+        pyfb_fbunlock(fbnum);
+        return -1;
     }
 
-    // else if we get here, we must open and initialize the framebuffer structure
-    char fb_device[14];
-    snprintf(fb_device, 14, "/dev/fb%hhu", fbnum);
+    // if we get here, flush the offscreen buffer to the framebuffer
+    int exitcode = 0;
+    size_t bytes = 0;
 
-    // open the framebuffer
-    int fb_fd = open(fb_device, O_RDWR);
-    if(fb_fd == -1) {
-        // failed to open the requested device
-        PyErr_SetString(PyExc_ValueError, "Could not open requested framebuffer");
-        unlock(framebuffers[fbnum].fb_lock);
-        return -1;
+    struct timespec start;
+    if(framebuffers[fbnum].stats_enabled) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
     }
 
-    // Now get the screen info
-    struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
-    if(ioctl(fb_fd, FBIOGET_VSCREENINFO, vinfo) == -1) {
-        // failed to get the vinfo structure
-        PyErr_SetString(PyExc_IOError, "Could not read display information. Is it really a framebuffer device file?");
-        unlock(framebuffers[fbnum].fb_lock);
-        close(fb_fd);
-        return -1;
+    PYFB_TRACE_BEGIN(write_start);
+
+    struct pyfb_damage* damage            = &framebuffers[fbnum].damage;
+    const struct pyfb_canvas* canvas      = &framebuffers[fbnum].canvas;
+    const struct fb_var_screeninfo* vinfo = &framebuffers[fbnum].fb_info.vinfo;
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
+
+    // the damage, or the whole viewport if nothing has been marked
+    struct pyfb_damage area = {0, 0, xres, yres};
+
+    if(damage->x1 > damage->x0) {
+        area = *damage;
     }
 
-    // Now alocate the two buffers
-    unsigned long int fb_size_b = vinfo->yres_virtual * vinfo->xres_virtual * vinfo->bits_per_pixel / 8;
+    if(framebuffers[fbnum].shared != NULL) {
+        // the owner writes the damage of all processes, the others only hand it over
+        exitcode = pyfb_sharedFlush(fbnum, &bytes);
+    } else if(framebuffers[fbnum].palette != NULL) {
+        // the indices are expanded to the device rows through the palette
+        ssize_t len = pyfb_writeIndexed(fbnum, &area);
+        exitcode    = len < 0 ? -1 : 0;
+        bytes       = len < 0 ? 0 : (size_t)len;
+    } else if(canvas->rotation != 0 || canvas->flip != 0) {
+        // the device rows are assembled from the columns or reversed rows of the canvas
+        ssize_t len = pyfb_writeRotated(fbnum, &area);
+        exitcode    = len < 0 ? -1 : 0;
+        bytes       = len < 0 ? 0 : (size_t)len;
+    } else if(canvas->panning && damage->x1 > damage->x0) {
+        // the canvas has the layout of the device memory and the driver panned to the
+        // viewport, so the damage of the viewport maps directly onto the device memory
+        exitcode = pyfb_writeRect(fbnum, damage);
+        bytes    = (damage->x1 - damage->x0) * (damage->y1 - damage->y0) * (vinfo->bits_per_pixel / 8);
+    } else if(canvas->panning) {
+        // nothing marked, so the drawing may be anywhere on the canvas, write it completely
+        size_t buf_len = (size_t)framebuffers[fbnum].fb_info.fb_size_b;
+        ssize_t len    = pwrite(framebuffers[fbnum].fb_fd, (void*)framebuffers[fbnum].u32_buffer, buf_len, 0);
+        exitcode       = len == (ssize_t)buf_len ? 0 : -1;
+        bytes          = buf_len;
+    } else if(damage->x1 > damage->x0 && canvas->xres == vinfo->xres && canvas->yres == vinfo->yres) {
+        // only the damaged area changed
+        exitcode = pyfb_writeRect(fbnum, damage);
+        bytes    = (damage->x1 - damage->x0) * (damage->y1 - damage->y0) * (vinfo->bits_per_pixel / 8);
+    } else {
+        exitcode = pyfb_writeViewport(fbnum);
+        bytes    = (size_t)vinfo->xres * vinfo->yres * (vinfo->bits_per_pixel / 8);
+    }
 
-    // offscreen buffers
-    void* buffer = calloc(fb_size_b, 1);
+    memset((void*)damage, 0, sizeof(struct pyfb_damage));
 
-    if(buffer == NULL) {
-        // got out of memory for the offscreen buffers
+    PYFB_TRACE_END("flushWrite", fbnum, write_start);
 
-        // free up all other resources for the new buffer
-        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
-        close(fb_fd);
-        memset((void*)vinfo, 0, sizeof(struct fb_var_screeninfo));
-        unlock(framebuffers[fbnum].fb_lock);
-        return -1;
+    if(framebuffers[fbnum].stats_enabled) {
+        pyfb_statFlush(fbnum, &start, exitcode == 0 ? bytes : 0);
     }
 
-    // if we get here, all is right and the structure can be filled.
-    framebuffers[fbnum].users = 1;
-    framebuffers[fbnum].fb_fd = fb_fd;
+    // dump the frame of a virtual framebuffer
+    if(exitcode == 0 && framebuffers[fbnum].dump_fd >= 0) {
+        exitcode = pyfb_dumpFrame(fbnum);
+    }
 
-    if(vinfo->bits_per_pixel == 32) {
-        framebuffers[fbnum].u32_buffer = (uint32_t*)buffer;
-    } else {
-        framebuffers[fbnum].u16_buffer = (uint16_t*)buffer;
+    // hand the frame to the stream thread, it does not wait for the encoding
+    if(exitcode == 0 && framebuffers[fbnum].stream != NULL) {
+        pyfb_streamFrame(fbnum);
     }
 
-    framebuffers[fbnum].fb_info.fb_size_b = fb_size_b;
+    // convert the damage to the mirror members, they are flushed in parallel
+    if(exitcode == 0 && framebuffers[fbnum].mirror != NULL) {
+        exitcode = pyfb_mirrorFlush(fbnum, &area);
+    }
 
-    // structure ready, return with success
-    unlock(framebuffers[fbnum].fb_lock);
-    return 0;
+    // okay, ready flushed
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("flush", fbnum, trace_start);
+    return exitcode;
 }
 
-void pyfb_close(uint8_t fbnum) {
-    // first test if this device number is valid.
+int pyfb_sdamage(uint8_t fbnum, unsigned long int x, unsigned long int y, unsigned long int w, unsigned long int h) {
+    // first test if this device number is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
-        return;
+        return -1;
     }
 
-    // Now try to open the framebuffer
-    lock(framebuffers[fbnum].fb_lock);
-
-    if(framebuffers[fbnum].users > 1) {
-        // this means that we are not the only user of this framebuffer,
-        // so that we can just release our reference on it
-        framebuffers[fbnum].users--;
-        unlock(framebuffers[fbnum].fb_lock);
-        return;
-    }
+    pyfb_fblock(fbnum);
 
-    // for wrong usage of this library
+    // next, test if the device is really in use
     if(framebuffers[fbnum].users == 0) {
-        PyErr_SetString(PyExc_IOError, "The framebuffer is allready closed.");
-        // should never happen, but if we get here, clean all up to not break internals
-        printf("WARNING: Detected internal mismatch of libaray usage.\nPlease check your program or report if is a bug from "
-               "our side.\n");
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
 
-        // close file descriptor if is still opened
-        if(framebuffers[fbnum].fb_fd >= 0) {
-            close(framebuffers[fbnum].fb_fd);
-        }
+    // clip the rectangle to the screen
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
 
-        framebuffers[fbnum].fb_fd = -1;
+    unsigned long int x1 = x < xres && w < xres - x ? x + w : xres;
+    unsigned long int y1 = y < yres && h < yres - y ? y + h : yres;
 
-        // free all buffers if are active
-        void** buffer;
+    if(x < x1 && y < y1) {
+        struct pyfb_damage* damage = &framebuffers[fbnum].damage;
 
-        if(framebuffers[fbnum].fb_info.vinfo.bits_per_pixel == 32) {
-            buffer = ((void*)&framebuffers[fbnum].u32_buffer);
+        if(damage->x1 <= damage->x0) {
+            struct pyfb_damage rect = {x, y, x1, y1};
+            *damage                 = rect;
         } else {
-            buffer = ((void*)&framebuffers[fbnum].u16_buffer);
-        }
-
-        if(*buffer != NULL) {
-            free(*buffer);
+            damage->x0 = x < damage->x0 ? x : damage->x0;
+            damage->y0 = y < damage->y0 ? y : damage->y0;
+            damage->x1 = x1 > damage->x1 ? x1 : damage->x1;
+            damage->y1 = y1 > damage->y1 ? y1 : damage->y1;
         }
-
-        *buffer = NULL;
-
-        // Now invalidate the videomode info
-        framebuffers[fbnum].fb_info.fb_size_b = 0;
-        memset((void*)&framebuffers[fbnum].fb_info.vinfo, 0, sizeof(struct fb_var_screeninfo));
-
-        // ok, return
-        unlock(framebuffers[fbnum].fb_lock);
-        return;
-    }
-
-    // Okay, now handle a real close
-    framebuffers[fbnum].users = 0;
-    close(framebuffers[fbnum].fb_fd);
-    framebuffers[fbnum].fb_fd = -1;
-
-    // free the offscreen buffers
-    void** buffer;
-
-    if(framebuffers[fbnum].fb_info.vinfo.bits_per_pixel == 32) {
-        buffer = ((void*)&framebuffers[fbnum].u32_buffer);
-    } else {
-        buffer = ((void*)&framebuffers[fbnum].u16_buffer);
-    }
-
-    if(*buffer != NULL) {
-        free(*buffer);
     }
 
-    *buffer = NULL;
-
-    // and clean up the videomode info
-    framebuffers[fbnum].fb_info.fb_size_b = 0;
-    memset((void*)&framebuffers[fbnum].fb_info.vinfo, 0, sizeof(struct fb_var_screeninfo));
-
-    // all cleaned up and resources free
-    // can return now
-    unlock(framebuffers[fbnum].fb_lock);
+    pyfb_fbunlock(fbnum);
+    return 0;
 }
 
-void pyfb_svinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr) {
-    // first test if this device number is valid.
+int pyfb_ssetStats(uint8_t fbnum, int enabled) {
+    // first test if this device number is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
-        return;
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
     }
 
     lock(framebuffers[fbnum].fb_lock);
 
-    memcpy(info_ptr, &framebuffers[fbnum].fb_info.vinfo, sizeof(struct fb_var_screeninfo));
+    // next, test if the device is really in use
+    if(framebuffers[fbnum].users == 0) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        unlock(framebuffers[fbnum].fb_lock);
+        return -1;
+    }
+
+    framebuffers[fbnum].stats_enabled = enabled ? 1 : 0;
 
     unlock(framebuffers[fbnum].fb_lock);
+    return 0;
 }
 
-void __APISTATUS_internal pyfb_vinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr) {
-    memcpy(info_ptr, &framebuffers[fbnum].fb_info.vinfo, sizeof(struct fb_var_screeninfo));
-}
+/**
+ * Reads and optionally resets a counter.
+ */
+#define PYFB_STAT_READ(counter, reset)                                       \
+    ((reset) ? atomic_exchange_explicit(&(counter), 0, memory_order_relaxed) \
+             : atomic_load_explicit(&(counter), memory_order_relaxed))
 
-int pyfb_flushBuffer(uint8_t fbnum) {
+int pyfb_sstats(uint8_t fbnum, struct pyfb_statsinfo* info, int reset) {
     // first test if this device number is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -250,31 +1304,30 @@ int pyfb_flushBuffer(uint8_t fbnum) {
     lock(framebuffers[fbnum].fb_lock);
 
     // next, test if the device is really in use
-    if(framebuffers[fbnum].fb_fd == -1) {
-        // this framebuffer is not in use, so ignore
+    if(framebuffers[fbnum].users == 0) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
         unlock(framebuffers[fbnum].fb_lock);
         return -1;
     }
 
-    // if we get here, flush the offscreen buffer to the framebuffer
-    if(lseek(framebuffers[fbnum].fb_fd, 0L, SEEK_SET) == -1) {
-        unlock(framebuffers[fbnum].fb_lock);
-        PyErr_SetString(PyExc_IOError, "Could not seek to begin of the framebuffer device file");
-        return -1;
-    }
+    // the counters are only written while the framebuffer is locked, so the snapshot is consistent
+    struct pyfb_stats* stats = &framebuffers[fbnum].stats;
 
-    size_t buf_len             = (size_t)framebuffers[fbnum].fb_info.fb_size_b;
-    unsigned long int exitcode = 0;
+    for(int i = 0; i < PYFB_STAT_PRIMITIVES; i++) {
+        info->calls[i] = PYFB_STAT_READ(stats->calls[i], reset);
+    }
 
-    if(framebuffers[fbnum].fb_info.vinfo.bits_per_pixel == 32) {
-        exitcode = (unsigned int)write(framebuffers[fbnum].fb_fd, (void*)framebuffers[fbnum].u32_buffer, buf_len);
-    } else {
-        exitcode = (unsigned int)write(framebuffers[fbnum].fb_fd, (void*)framebuffers[fbnum].u16_buffer, buf_len);
+    for(int i = 0; i < PYFB_STAT_BUCKETS; i++) {
+        info->flush_hist[i] = PYFB_STAT_READ(stats->flush_hist[i], reset);
     }
 
-    // okay, ready flushed
+    info->pixels      = PYFB_STAT_READ(stats->pixels, reset);
+    info->flushes     = PYFB_STAT_READ(stats->flushes, reset);
+    info->flush_bytes = PYFB_STAT_READ(stats->flush_bytes, reset);
+    info->flush_ns    = PYFB_STAT_READ(stats->flush_ns, reset);
+
     unlock(framebuffers[fbnum].fb_lock);
-    return buf_len == exitcode ? 0 : -1;
+    return 0;
 }
 
 /**
@@ -297,6 +1350,26 @@ static inline void pyfb_pixel32(uint8_t fbnum,
     framebuffers[fbnum].u32_buffer[y * xres + x] = color->u32_color;
 }
 
+/**
+ * Sets a pixel into an indexed canvas. The color value is the palette index. Please only
+ * call if the canvas is indexed.
+ *
+ * Warning: All arguments are unchecked
+ *
+ * @param fbnum The framebuffer number to use
+ * @param x The x coordniate of the pixel
+ * @param y The y coordinate of the pixel
+ * @param color The color structure
+ * @param xres The x resolution
+ */
+static inline void pyfb_pixel8(uint8_t fbnum,
+                               unsigned long int x,
+                               unsigned long int y,
+                               const struct pyfb_color* color,
+                               unsigned int xres) {
+    framebuffers[fbnum].u8_buffer[y * xres + x] = (uint8_t)color->u32_color;
+}
+
 /**
  * Sets a pixel into a 16 bit framebuffer. Please only call if the pixel format is a
  * 16 bit rgba buffer.
@@ -322,10 +1395,12 @@ void __APISTATUS_internal pyfb_setPixel(uint8_t fbnum,
                                         unsigned long int y,
                                         const struct pyfb_color* color) {
     // do
-    unsigned int xres  = framebuffers[fbnum].fb_info.vinfo.xres;
+    unsigned int xres  = framebuffers[fbnum].canvas.xres;
     unsigned int width = framebuffers[fbnum].fb_info.vinfo.bits_per_pixel;
 
-    if(width == 16) {
+    if(framebuffers[fbnum].palette != NULL) {
+        pyfb_pixel8(fbnum, x, y, color, xres);
+    } else if(width == 16) {
         pyfb_pixel16(fbnum, x, y, color, xres);
     } else {
         pyfb_pixel32(fbnum, x, y, color, xres);
@@ -333,6 +1408,8 @@ void __APISTATUS_internal pyfb_setPixel(uint8_t fbnum,
 }
 
 void pyfb_ssetPixel(uint8_t fbnum, unsigned long int x, unsigned long int y, const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // first check if fbnum is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -340,38 +1417,44 @@ void pyfb_ssetPixel(uint8_t fbnum, unsigned long int x, unsigned long int y, con
     }
 
     // Is valid, so lock it!
-    lock(framebuffers[fbnum].fb_lock);
+    pyfb_fblock(fbnum);
 
     // next, test if the device is really in use
-    if(framebuffers[fbnum].fb_fd == -1) {
+    if(framebuffers[fbnum].users == 0) {
         // this framebuffer is not in use, so ignore
         PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // check if all values are valid
-    unsigned int xres = framebuffers[fbnum].fb_info.vinfo.xres;
-    unsigned int yres = framebuffers[fbnum].fb_info.vinfo.yres;
+    unsigned int xres = framebuffers[fbnum].canvas.xres;
+    unsigned int yres = framebuffers[fbnum].canvas.yres;
 
     if(x >= xres || y >= yres) {
         // x or y is not valid
         PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // else all is okay and we can continue
     unsigned int width = framebuffers[fbnum].fb_info.vinfo.bits_per_pixel;
 
-    if(width == 16) {
+    PYFB_STAT_CALL(&framebuffers[fbnum], PYFB_STAT_PIXEL);
+    PYFB_STAT_PIXELS(&framebuffers[fbnum], 1);
+
+    if(framebuffers[fbnum].palette != NULL) {
+        pyfb_pixel8(fbnum, x, y, color, xres);
+    } else if(width == 16) {
         pyfb_pixel16(fbnum, x, y, color, xres);
     } else {
         pyfb_pixel32(fbnum, x, y, color, xres);
     }
 
     // ready, so return
-    unlock(framebuffers[fbnum].fb_lock);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("setPixel", fbnum, trace_start);
 }
 
 void __APISTATUS_internal pyfb_drawHorizontalLine(uint8_t fbnum,
@@ -384,6 +1467,8 @@ void __APISTATUS_internal pyfb_drawHorizontalLine(uint8_t fbnum,
     for(unsigned long int ix = x; ix < x1; ix++) {
         pyfb_setPixel(fbnum, ix, y, color);
     }
+
+    PYFB_STAT_PIXELS(&framebuffers[fbnum], len);
 }
 
 void pyfb_sdrawHorizontalLine(uint8_t fbnum,
@@ -391,6 +1476,8 @@ void pyfb_sdrawHorizontalLine(uint8_t fbnum,
                               unsigned long int y,
                               unsigned long int len,
                               const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // first check if fbnum and len are valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -403,37 +1490,39 @@ void pyfb_sdrawHorizontalLine(uint8_t fbnum,
     }
 
     // Is valid, so lock it!
-    lock(framebuffers[fbnum].fb_lock);
+    pyfb_fblock(fbnum);
 
     // next, test if the device is really in use
-    if(framebuffers[fbnum].fb_fd == -1) {
+    if(framebuffers[fbnum].users == 0) {
         // this framebuffer is not in use, so ignore
         PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // Now test if the ranges are okay
-    unsigned long int xres = framebuffers[fbnum].fb_info.vinfo.xres;
-    unsigned long int yres = framebuffers[fbnum].fb_info.vinfo.yres;
+    unsigned long int xres = framebuffers[fbnum].canvas.xres;
+    unsigned long int yres = framebuffers[fbnum].canvas.yres;
 
     if(y >= yres) {
         PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     if(x >= xres || (x + len - 1) >= xres) {
         PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // all data is valid, so proceed
+    PYFB_STAT_CALL(&framebuffers[fbnum], PYFB_STAT_HLINE);
     pyfb_drawHorizontalLine(fbnum, x, y, len, color);
 
     // ok, ready
-    unlock(framebuffers[fbnum].fb_lock);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawHorizontalLine", fbnum, trace_start);
 }
 
 void __APISTATUS_internal pyfb_drawVerticalLine(uint8_t fbnum,
@@ -446,6 +1535,8 @@ void __APISTATUS_internal pyfb_drawVerticalLine(uint8_t fbnum,
     for(unsigned int long iy = y; iy < y1; iy++) {
         pyfb_setPixel(fbnum, x, iy, color);
     }
+
+    PYFB_STAT_PIXELS(&framebuffers[fbnum], len);
 }
 
 void pyfb_sdrawVerticalLine(uint8_t fbnum,
@@ -453,6 +1544,8 @@ void pyfb_sdrawVerticalLine(uint8_t fbnum,
                             unsigned long int y,
                             unsigned long int len,
                             const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // first check if fbnum and len are valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -465,35 +1558,135 @@ void pyfb_sdrawVerticalLine(uint8_t fbnum,
     }
 
     // Is valid, so lock it!
-    lock(framebuffers[fbnum].fb_lock);
+    pyfb_fblock(fbnum);
 
     // next, test if the device is really in use
-    if(framebuffers[fbnum].fb_fd == -1) {
+    if(framebuffers[fbnum].users == 0) {
         // this framebuffer is not in use, so ignore
         PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // Now test if the ranges are okay
-    unsigned long int xres = framebuffers[fbnum].fb_info.vinfo.xres;
-    unsigned long int yres = framebuffers[fbnum].fb_info.vinfo.yres;
+    unsigned long int xres = framebuffers[fbnum].canvas.xres;
+    unsigned long int yres = framebuffers[fbnum].canvas.yres;
 
     if(y >= yres || (y + len - 1) >= yres) {
         PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     if(x >= xres) {
         PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
-        unlock(framebuffers[fbnum].fb_lock);
+        pyfb_fbunlock(fbnum);
         return;
     }
 
     // all data is valid, so proceed
+    PYFB_STAT_CALL(&framebuffers[fbnum], PYFB_STAT_VLINE);
     pyfb_drawVerticalLine(fbnum, x, y, len, color);
 
     // ok, ready
-    unlock(framebuffers[fbnum].fb_lock);
-}
\ No newline at end of file
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawVerticalLine", fbnum, trace_start);
+}
+
+void __APISTATUS_internal pyfb_copyArea(uint8_t fbnum,
+                                        unsigned long int sx,
+                                        unsigned long int sy,
+                                        unsigned long int width,
+                                        unsigned long int height,
+                                        unsigned long int dx,
+                                        unsigned long int dy) {
+    unsigned long int xres  = framebuffers[fbnum].canvas.xres;
+    unsigned long int bytes = framebuffers[fbnum].fb_info.vinfo.bits_per_pixel == 16 ? 2 : 4;
+    uint8_t* buffer         = (uint8_t*)framebuffers[fbnum].u32_buffer;
+
+    if(framebuffers[fbnum].palette != NULL) {
+        bytes = 1;
+    }
+
+    size_t row_len = (size_t)(width * bytes);
+    size_t stride  = (size_t)(xres * bytes);
+
+    PYFB_STAT_PIXELS(&framebuffers[fbnum], width * height);
+
+    if(sx == 0 && dx == 0 && width == xres) {
+        // full rows are contiguous, so move the whole area at once
+        memmove(buffer + dy * stride, buffer + sy * stride, height * stride);
+        return;
+    }
+
+    if(dy > sy) {
+        // moving down, so copy bottom up to not overwrite rows not moved yet
+        for(unsigned long int row = height; row > 0; row--) {
+            memmove(buffer + (dy + row - 1) * stride + dx * bytes, buffer + (sy + row - 1) * stride + sx * bytes, row_len);
+        }
+    } else {
+        for(unsigned long int row = 0; row < height; row++) {
+            memmove(buffer + (dy + row) * stride + dx * bytes, buffer + (sy + row) * stride + sx * bytes, row_len);
+        }
+    }
+}
+
+void pyfb_scopyArea(uint8_t fbnum,
+                    unsigned long int sx,
+                    unsigned long int sy,
+                    unsigned long int width,
+                    unsigned long int height,
+                    unsigned long int dx,
+                    unsigned long int dy) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return;
+    }
+
+    // Is valid, so lock it!
+    pyfb_fblock(fbnum);
+
+    // next, test if the device is really in use
+    if(framebuffers[fbnum].users == 0) {
+        // this framebuffer is not in use, so ignore
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return;
+    }
+
+    // Now test if the ranges are okay
+    unsigned long int xres = framebuffers[fbnum].canvas.xres;
+    unsigned long int yres = framebuffers[fbnum].canvas.yres;
+
+    if(sx >= xres || sy >= yres || dx >= xres || dy >= yres) {
+        PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
+        pyfb_fbunlock(fbnum);
+        return;
+    }
+
+    // clip the area on the source and destination side
+    unsigned long int max_x = sx > dx ? sx : dx;
+    unsigned long int max_y = sy > dy ? sy : dy;
+
+    if(width > xres - max_x) {
+        width = xres - max_x;
+    }
+
+    if(height > yres - max_y) {
+        height = yres - max_y;
+    }
+
+    // all data is valid, so proceed
+    PYFB_STAT_CALL(&framebuffers[fbnum], PYFB_STAT_COPYAREA);
+
+    if(width > 0 && height > 0 && (sx != dx || sy != dy)) {
+        pyfb_copyArea(fbnum, sx, sy, width, height, dx, dy);
+    }
+
+    // ok, ready
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("copyArea", fbnum, trace_start);
+}
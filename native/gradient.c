@@ -0,0 +1,418 @@
+/**
+ * Gradient sources, filling shapes with linear and radial gradients.
+ */
+#include "pyframebuffer.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * The amount of colors a gradient is sampled to before filling.
+ */
+#define PYFB_GRADIENT_LUT 1024
+
+/**
+ * The fraction bits of the lookup table position stepped along a row.
+ */
+#define PYFB_GRADIENT_FRACTION 16
+
+/**
+ * The ordered 4x4 dither thresholds from 0 to 15.
+ */
+static const uint8_t pyfb_bayer[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+/**
+ * Samples the colors of a gradient to a lookup table, blending the channels between the stops.
+ *
+ * @param gradient The gradient
+ * @param lut The @c PYFB_GRADIENT_LUT color values in 32 bits
+ */
+static void pyfb_gradientSample(const struct pyfb_gradient* gradient, uint32_t* lut) {
+    unsigned int last = gradient->stops - 1;
+    unsigned int k    = 0;
+
+    for(int i = 0; i < PYFB_GRADIENT_LUT; i++) {
+        double t = (double)i / (PYFB_GRADIENT_LUT - 1);
+
+        if(t <= gradient->offsets[0]) {
+            lut[i] = gradient->colors[0];
+            continue;
+        }
+
+        if(t >= gradient->offsets[last]) {
+            lut[i] = gradient->colors[last];
+            continue;
+        }
+
+        // the segment of the stops k and k + 1 holding t
+        while(gradient->offsets[k + 1] < t) {
+            k++;
+        }
+
+        double f     = (t - gradient->offsets[k]) / (gradient->offsets[k + 1] - gradient->offsets[k]);
+        uint32_t c0  = gradient->colors[k];
+        uint32_t c1  = gradient->colors[k + 1];
+        uint32_t out = 0;
+
+        for(int shift = 0; shift < 32; shift += 8) {
+            double a = (double)((c0 >> shift) & 0xFF);
+            double b = (double)((c1 >> shift) & 0xFF);
+            out |= (uint32_t)(a + (b - a) * f + 0.5) << shift;
+        }
+
+        lut[i] = out;
+    }
+}
+
+/**
+ * Computes the lookup table positions of a row of a linear gradient. The position changes
+ * by a constant step from a pixel to the next, so the part between the ends of the gradient
+ * is stepped in fixed point, and the parts before and after it are filled with the end colors.
+ *
+ * @param idx The positions
+ * @param count The amount of pixels
+ * @param start The position of the first pixel
+ * @param step The change of the position from a pixel to the next
+ */
+static void pyfb_gradientLinearRow(uint16_t* restrict idx, long int count, double start, double step) {
+    const double end = PYFB_GRADIENT_LUT - 1;
+    long int first   = 0;
+    long int last    = count - 1;
+
+    if(step > 0.0) {
+        first = start >= 0.0 ? 0 : (long int)fmin(ceil(-start / step), (double)count);
+        last  = start > end ? -1 : (long int)fmin(floor((end - start) / step), (double)(count - 1));
+    } else if(step < 0.0) {
+        first = start <= end ? 0 : (long int)fmin(ceil((end - start) / step), (double)count);
+        last  = start < 0.0 ? -1 : (long int)fmin(floor(-start / step), (double)(count - 1));
+    } else if(start < 0.0 || start > end) {
+        // the whole row is beside the gradient
+        first = count;
+        last  = count - 1;
+    }
+
+    // the end colors beside the gradient
+    uint16_t before = (step > 0.0 || (step == 0.0 && start < 0.0)) ? 0 : PYFB_GRADIENT_LUT - 1;
+    uint16_t after  = before == 0 ? PYFB_GRADIENT_LUT - 1 : 0;
+
+    for(long int i = 0; i < first && i < count; i++) {
+        idx[i] = before;
+    }
+
+    if(first <= last) {
+        // the steps of a part longer than one pixel are below the table size
+        const int32_t max = (PYFB_GRADIENT_LUT - 1) << PYFB_GRADIENT_FRACTION;
+        int32_t pos       = (int32_t)lrint((start + step * first) * (1 << PYFB_GRADIENT_FRACTION));
+        int32_t delta     = (int32_t)lrint(fmax(fmin(step, end), -end) * (1 << PYFB_GRADIENT_FRACTION));
+
+        for(int32_t i = 0; i < (int32_t)(last - first + 1); i++) {
+            int32_t p      = pos + i * delta;
+            p              = p < 0 ? 0 : (p > max ? max : p);
+            idx[first + i] = (uint16_t)((p + (1 << (PYFB_GRADIENT_FRACTION - 1))) >> PYFB_GRADIENT_FRACTION);
+        }
+    }
+
+    for(long int i = (last + 1 > first ? last + 1 : first); i < count; i++) {
+        idx[i] = after;
+    }
+}
+
+/**
+ * Computes the lookup table positions of a row of a radial gradient from the distances of
+ * the pixels to the center.
+ *
+ * @param idx The positions
+ * @param count The amount of pixels
+ * @param dx The x distance of the first pixel to the center
+ * @param dy2 The squared y distance of the row to the center
+ * @param scale The factor from a distance to the position
+ */
+static void pyfb_gradientRadialRow(uint16_t* restrict idx, long int count, float dx, float dy2, float scale) {
+    const float end = PYFB_GRADIENT_LUT - 1;
+
+    for(long int i = 0; i < count; i++) {
+        float d = dx + (float)i;
+        float p = sqrtf(d * d + dy2) * scale;
+        p       = p < end ? p : end;
+        idx[i]  = (uint16_t)(p + 0.5f);
+    }
+}
+
+/**
+ * Writes a row of gradient colors to 32 bit pixels.
+ */
+static void pyfb_gradientWrite32(uint32_t* restrict out,
+                                 const uint32_t* restrict lut,
+                                 const uint16_t* restrict idx,
+                                 long int count) {
+    for(long int i = 0; i < count; i++) {
+        out[i] = lut[idx[i]];
+    }
+}
+
+/**
+ * Writes a row of gradient colors to 16 bit pixels.
+ */
+static void pyfb_gradientWrite16(uint16_t* restrict out,
+                                 const uint16_t* restrict lut,
+                                 const uint16_t* restrict idx,
+                                 long int count) {
+    for(long int i = 0; i < count; i++) {
+        out[i] = lut[idx[i]];
+    }
+}
+
+/**
+ * Converts the gradient colors to 16 bits once for every ordered dither threshold, adding
+ * the threshold before the channels are truncated.
+ *
+ * @param lut The colors in 32 bits
+ * @param table The 16 tables of @c PYFB_GRADIENT_LUT colors in 16 bits, one per threshold
+ */
+static void pyfb_gradientDitherTable(const uint32_t* lut, uint16_t* table) {
+    for(uint32_t t = 0; t < 16; t++) {
+        for(int i = 0; i < PYFB_GRADIENT_LUT; i++) {
+            uint32_t color = lut[i];
+            uint32_t r     = (((color >> 24) & 0xFF) + (t >> 1)) >> 3;
+            uint32_t g     = (((color >> 16) & 0xFF) + (t >> 2)) >> 2;
+            uint32_t b     = (((color >> 8) & 0xFF) + (t >> 1)) >> 3;
+            r              = r < 31 ? r : 31;
+            g              = g < 63 ? g : 63;
+            b              = b < 31 ? b : 31;
+
+            table[t * PYFB_GRADIENT_LUT + i] = (uint16_t)(r << 11 | g << 5 | b);
+        }
+    }
+}
+
+/**
+ * Writes a row of dithered gradient colors to 16 bit pixels.
+ *
+ * @param out The pixels
+ * @param table The dithered colors, see pyfb_gradientDitherTable
+ * @param idx The positions
+ * @param count The amount of pixels
+ * @param x The canvas x coordinate of the first pixel
+ * @param y The canvas row
+ */
+static void pyfb_gradientDither16(uint16_t* restrict out,
+                                  const uint16_t* restrict table,
+                                  const uint16_t* restrict idx,
+                                  long int count,
+                                  long int x,
+                                  long int y) {
+    // the tables of the four columns of the pattern row
+    const uint16_t* luts[4];
+    for(long int i = 0; i < 4; i++) {
+        luts[i] = table + pyfb_bayer[y & 3][(x + i) & 3] * PYFB_GRADIENT_LUT;
+    }
+
+    for(long int i = 0; i < count; i++) {
+        out[i] = luts[i & 3][idx[i]];
+    }
+}
+
+/**
+ * Validates a gradient.
+ *
+ * @param gradient The gradient
+ *
+ * @return NULL if the gradient is valid, else the error message
+ */
+static const char* pyfb_gradientCheck(const struct pyfb_gradient* gradient) {
+    if(gradient->type != PYFB_GRADIENT_LINEAR && gradient->type != PYFB_GRADIENT_RADIAL) {
+        return "The gradient type is not valid";
+    }
+
+    if(gradient->stops == 0 || gradient->stops > PYFB_GRADIENT_STOPS) {
+        return "A gradient must have 1 to 16 color stops";
+    }
+
+    for(unsigned int i = 0; i < gradient->stops; i++) {
+        double offset = gradient->offsets[i];
+        if(!(offset >= 0.0 && offset <= 1.0) || (i > 0 && offset < gradient->offsets[i - 1])) {
+            return "The stop offsets must rise from 0 to 1";
+        }
+    }
+
+    if(!isfinite(gradient->x0) || !isfinite(gradient->y0)) {
+        return "The gradient position is not valid";
+    }
+
+    if(gradient->type == PYFB_GRADIENT_LINEAR) {
+        if(!isfinite(gradient->x1) || !isfinite(gradient->y1) ||
+           (gradient->x0 == gradient->x1 && gradient->y0 == gradient->y1)) {
+            return "The gradient points must differ";
+        }
+    } else if(!isfinite(gradient->radius) || !(gradient->radius > 0.0)) {
+        return "The gradient radius must be positive";
+    }
+
+    return NULL;
+}
+
+int pyfb_sfillGradient(uint8_t fbnum,
+                       const struct pyfb_gradient* gradient,
+                       long int x,
+                       long int y,
+                       unsigned long int width,
+                       unsigned long int height,
+                       int shape,
+                       int dither) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    const char* error = pyfb_gradientCheck(gradient);
+    if(error != NULL) {
+        PyErr_SetString(PyExc_ValueError, error);
+        return -1;
+    }
+
+    if(shape != PYFB_SHAPE_RECT && shape != PYFB_SHAPE_ELLIPSE) {
+        PyErr_SetString(PyExc_ValueError, "The shape is not valid");
+        return -1;
+    }
+
+    if(width > LONG_MAX / 4 || height > LONG_MAX / 4 || x > LONG_MAX / 4 || y > LONG_MAX / 4) {
+        PyErr_SetString(PyExc_ValueError, "The rectangle is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "Pixels can not be written to an indexed canvas");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the rows and columns of the rectangle on the canvas
+    long int xr  = (long int)fb->canvas.xres;
+    long int yr  = (long int)fb->canvas.yres;
+    long int cx0 = x > 0 ? x : 0;
+    long int cy0 = y > 0 ? y : 0;
+    long int cx1 = x + (long int)width < xr ? x + (long int)width : xr;
+    long int cy1 = y + (long int)height < yr ? y + (long int)height : yr;
+
+    if(cx0 >= cx1 || cy0 >= cy1) {
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    // the row positions, followed by the dithered colors if needed
+    size_t row_len = (size_t)(cx1 - cx0);
+    int depth      = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+    dither         = dither && depth == 16;
+    uint16_t* idx  = malloc((row_len + (dither ? 16 * PYFB_GRADIENT_LUT : 0)) * sizeof(uint16_t));
+    if(idx == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the row buffer");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the colors in the pixel format of the device
+    uint32_t lut32[PYFB_GRADIENT_LUT];
+    uint16_t lut16[PYFB_GRADIENT_LUT];
+    pyfb_gradientSample(gradient, lut32);
+    for(int i = 0; i < PYFB_GRADIENT_LUT; i++) {
+        lut16[i] = pyfb_rgb565(lut32[i]);
+    }
+
+    uint16_t* table = idx + row_len;
+    if(dither) {
+        pyfb_gradientDitherTable(lut32, table);
+    }
+
+    size_t bytes             = (size_t)depth / 8;
+    uint8_t* rows            = (uint8_t*)fb->u32_buffer;
+    unsigned long int pixels = 0;
+
+    // the position on the lookup table as a plane over the pixel centers, or the scale of the distance
+    double gx = 0.0, gy = 0.0, gc = 0.0;
+    if(gradient->type == PYFB_GRADIENT_LINEAR) {
+        double dx = gradient->x1 - gradient->x0;
+        double dy = gradient->y1 - gradient->y0;
+        double f  = (PYFB_GRADIENT_LUT - 1) / (dx * dx + dy * dy);
+        gx        = dx * f;
+        gy        = dy * f;
+        gc        = ((0.5 - gradient->x0) * dx + (0.5 - gradient->y0) * dy) * f;
+    } else {
+        gc = (PYFB_GRADIENT_LUT - 1) / gradient->radius;
+    }
+
+    // the ellipse inscribed in the rectangle
+    double ecx = (double)x + (double)width / 2.0;
+    double ecy = (double)y + (double)height / 2.0;
+    double ea  = (double)width / 2.0;
+    double eb  = (double)height / 2.0;
+
+    // the arguments are valid, so fill without the GIL
+    Py_BEGIN_ALLOW_THREADS;
+
+    for(long int row = cy0; row < cy1; row++) {
+        long int x0 = cx0;
+        long int x1 = cx1 - 1;
+
+        if(shape == PYFB_SHAPE_ELLIPSE) {
+            double u = ((double)row + 0.5 - ecy) / eb;
+            if(u * u >= 1.0) {
+                continue;
+            }
+
+            double half  = ea * sqrt(1.0 - u * u);
+            double left  = ceil(ecx - half - 0.5);
+            double right = floor(ecx + half - 0.5);
+            x0           = left > (double)x0 ? (long int)left : x0;
+            x1           = right < (double)x1 ? (long int)right : x1;
+        }
+
+        if(x0 > x1) {
+            continue;
+        }
+
+        long int count = x1 - x0 + 1;
+        uint8_t* out   = rows + ((size_t)row * (size_t)xr + (size_t)x0) * bytes;
+        pixels += (unsigned long int)count;
+
+        if(gradient->type == PYFB_GRADIENT_LINEAR) {
+            pyfb_gradientLinearRow(idx, count, gx * (double)x0 + gy * (double)row + gc, gx);
+        } else {
+            double dy = (double)row + 0.5 - gradient->y0;
+            pyfb_gradientRadialRow(idx, count, (float)((double)x0 + 0.5 - gradient->x0), (float)(dy * dy), (float)gc);
+        }
+
+        if(depth == 32) {
+            pyfb_gradientWrite32((uint32_t*)out, lut32, idx, count);
+        } else if(dither) {
+            pyfb_gradientDither16((uint16_t*)out, table, idx, count, x0, row);
+        } else {
+            pyfb_gradientWrite16((uint16_t*)out, lut16, idx, count);
+        }
+    }
+
+    Py_END_ALLOW_THREADS;
+
+    PYFB_STAT_CALL(fb, PYFB_STAT_GRADIENT);
+    PYFB_STAT_PIXELS(fb, pixels);
+
+    free(idx);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("fillGradient", fbnum, trace_start);
+    return 0;
+}
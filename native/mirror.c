@@ -0,0 +1,554 @@
+/**
+ * Mirror group sources.
+ */
+#include "pyframebuffer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A member of a mirror group, converting the source into its framebuffer on its own thread.
+ */
+struct pyfb_mirrormember {
+    /**
+     * The group of the member.
+     */
+    struct pyfb_mirror* group;
+
+    /**
+     * The framebuffer number of the member.
+     */
+    uint8_t fbnum;
+
+    /**
+     * The resolution and depth of the member.
+     */
+    unsigned long int xres;
+    unsigned long int yres;
+    unsigned int depth;
+
+    /**
+     * The source column of every member column, and the source row of every member row.
+     */
+    uint32_t* xmap;
+    uint32_t* ymap;
+
+    /**
+     * The last job generation handled, protected by the group mutex.
+     */
+    unsigned long int generation;
+
+    /**
+     * Cleared to stop the thread, protected by the group mutex.
+     */
+    int running;
+
+    /**
+     * Set by the thread if the member framebuffer has been closed, protected by the group mutex.
+     */
+    int gone;
+
+    /**
+     * Set by the thread if the flush of the member failed, protected by the group mutex.
+     */
+    int failed;
+
+    /**
+     * The thread of the member.
+     */
+    pthread_t thread;
+};
+
+/**
+ * The mirror group of a source framebuffer.
+ */
+struct pyfb_mirror {
+    /**
+     * The framebuffer number of the source.
+     */
+    uint8_t source;
+
+    /**
+     * The count of members.
+     */
+    int count;
+
+    /**
+     * The members, allocated separately so their address stays while others are removed.
+     */
+    struct pyfb_mirrormember* members[MAX_FRAMEBUFFERS];
+
+    /**
+     * The generation of the current job, protected by the mutex.
+     */
+    unsigned long int generation;
+
+    /**
+     * The count of members still working on the current job, protected by the mutex.
+     */
+    int pending;
+
+    /**
+     * The damaged area of the source to convert, in screen coordinates, protected by the mutex.
+     */
+    struct pyfb_damage rect;
+
+    /**
+     * The mutex protecting the job.
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     * Signaled if a job is started or a member is stopped.
+     */
+    pthread_cond_t work;
+
+    /**
+     * Signaled if a member finished the job.
+     */
+    pthread_cond_t done;
+};
+
+/**
+ * Maps a range of source coordinates to the range of member coordinates reading from it.
+ *
+ * @param map The source coordinate of every member coordinate, ascending
+ * @param len The length of the map
+ * @param s0 The first source coordinate
+ * @param s1 The source coordinate after the last
+ * @param m0 The pointer to store the first member coordinate to
+ * @param m1 The pointer to store the member coordinate after the last to
+ */
+static void pyfb_mirrorRange(const uint32_t* map, unsigned long int len, unsigned long int s0, unsigned long int s1,
+                             unsigned long int* m0, unsigned long int* m1) {
+    unsigned long int lo = 0;
+    unsigned long int hi = len;
+
+    // the first member coordinate reading s0 or later
+    while(lo < hi) {
+        unsigned long int mid = (lo + hi) / 2;
+        if(map[mid] < s0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *m0 = lo;
+    hi  = len;
+
+    // the first member coordinate reading s1 or later
+    while(lo < hi) {
+        unsigned long int mid = (lo + hi) / 2;
+        if(map[mid] < s1) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *m1 = lo;
+}
+
+/**
+ * Scales and converts the damaged area of the source into the member framebuffer and
+ * marks it damaged there.
+ *
+ * @param member The member, its framebuffer must be locked
+ * @param src The source framebuffer, locked by the flushing thread
+ * @param rect The damaged area of the source
+ *
+ * @return Not 0 if an area of the member changed, else 0 if no member pixel samples the damage
+ */
+static int pyfb_mirrorConvert(const struct pyfb_mirrormember* member,
+                              const struct pyfb_framebuffer* src,
+                              const struct pyfb_damage* rect) {
+    struct pyfb_framebuffer* dst = pyfb_fbptr(member->fbnum);
+
+    unsigned long int x0, x1, y0, y1;
+    pyfb_mirrorRange(member->xmap, member->xres, rect->x0, rect->x1, &x0, &x1);
+    pyfb_mirrorRange(member->ymap, member->yres, rect->y0, rect->y1, &y0, &y1);
+
+    if(x0 >= x1 || y0 >= y1) {
+        return 0;
+    }
+
+    unsigned int src_depth       = src->fb_info.vinfo.bits_per_pixel;
+    unsigned long int src_stride = src->canvas.xres;
+    unsigned long int dst_stride = dst->canvas.xres;
+    unsigned long int src_offset = src->canvas.yoffset * src_stride + src->canvas.xoffset;
+    unsigned long int dst_offset = dst->canvas.yoffset * dst_stride + dst->canvas.xoffset;
+    const uint32_t* xmap         = member->xmap;
+
+    for(unsigned long int y = y0; y < y1; y++) {
+        unsigned long int src_row = src_offset + member->ymap[y] * src_stride;
+        unsigned long int dst_row = dst_offset + y * dst_stride;
+
+        if(src_depth == 32 && member->depth == 32) {
+            const uint32_t* in = src->u32_buffer + src_row;
+            uint32_t* out      = dst->u32_buffer + dst_row;
+            for(unsigned long int x = x0; x < x1; x++) {
+                out[x] = in[xmap[x]];
+            }
+        } else if(src_depth == 32) {
+            const uint32_t* in = src->u32_buffer + src_row;
+            uint16_t* out      = dst->u16_buffer + dst_row;
+            for(unsigned long int x = x0; x < x1; x++) {
+                out[x] = pyfb_rgb565(in[xmap[x]]);
+            }
+        } else if(member->depth == 32) {
+            const uint16_t* in = src->u16_buffer + src_row;
+            uint32_t* out      = dst->u32_buffer + dst_row;
+            for(unsigned long int x = x0; x < x1; x++) {
+                out[x] = pyfb_rgba8888(in[xmap[x]]);
+            }
+        } else {
+            const uint16_t* in = src->u16_buffer + src_row;
+            uint16_t* out      = dst->u16_buffer + dst_row;
+            for(unsigned long int x = x0; x < x1; x++) {
+                out[x] = in[xmap[x]];
+            }
+        }
+    }
+
+    // merge into the damage of the member, so its flush only writes the converted area
+    struct pyfb_damage* damage = &dst->damage;
+
+    if(damage->x1 <= damage->x0) {
+        struct pyfb_damage area = {x0, y0, x1, y1};
+        *damage                 = area;
+    } else {
+        damage->x0 = x0 < damage->x0 ? x0 : damage->x0;
+        damage->y0 = y0 < damage->y0 ? y0 : damage->y0;
+        damage->x1 = x1 > damage->x1 ? x1 : damage->x1;
+        damage->y1 = y1 > damage->y1 ? y1 : damage->y1;
+    }
+
+    return 1;
+}
+
+/**
+ * The thread of a member, converting and flushing the source once per job.
+ */
+static void* pyfb_mirrorThread(void* arg) {
+    struct pyfb_mirrormember* member = (struct pyfb_mirrormember*)arg;
+    struct pyfb_mirror* group        = member->group;
+
+    pthread_mutex_lock(&group->mutex);
+
+    while(1) {
+        while(member->running && member->generation == group->generation) {
+            pthread_cond_wait(&group->work, &group->mutex);
+        }
+
+        if(!member->running) {
+            break;
+        }
+
+        member->generation      = group->generation;
+        struct pyfb_damage rect = group->rect;
+        pthread_mutex_unlock(&group->mutex);
+
+        // the source stays locked by the flushing thread until all members are done
+        const struct pyfb_framebuffer* src = pyfb_fbptr(group->source);
+        struct pyfb_framebuffer* dst       = pyfb_fbptr(member->fbnum);
+        int gone                           = 0;
+        int failed                         = 0;
+
+        pyfb_fblock(member->fbnum);
+
+        // a closed member may have been opened again by someone else
+        if(!pyfb_fbused(member->fbnum) || dst->mirror_source != group->source + 1) {
+            gone = 1;
+            pyfb_fbunlock(member->fbnum);
+        } else {
+            int changed = pyfb_mirrorConvert(member, src, &rect);
+            pyfb_fbunlock(member->fbnum);
+            failed = changed && pyfb_flushBuffer(member->fbnum) != 0;
+        }
+
+        pthread_mutex_lock(&group->mutex);
+        member->gone   = gone;
+        member->failed = failed;
+
+        if(--group->pending == 0) {
+            pthread_cond_signal(&group->done);
+        }
+    }
+
+    pthread_mutex_unlock(&group->mutex);
+    return NULL;
+}
+
+/**
+ * Stops the thread of a member, frees it and clears its membership.
+ *
+ * @param group The group, its source must be locked
+ * @param index The index of the member
+ * @param clear Not 0 to clear the membership of the member framebuffer, which locks it
+ */
+static void pyfb_mirrorDrop(struct pyfb_mirror* group, int index, int clear) {
+    struct pyfb_mirrormember* member = group->members[index];
+
+    pthread_mutex_lock(&group->mutex);
+    member->running = 0;
+    pthread_cond_broadcast(&group->work);
+    pthread_mutex_unlock(&group->mutex);
+    pthread_join(member->thread, NULL);
+
+    if(clear) {
+        pyfb_fblock(member->fbnum);
+        struct pyfb_framebuffer* dst = pyfb_fbptr(member->fbnum);
+        if(dst->mirror_source == group->source + 1) {
+            dst->mirror_source = 0;
+        }
+        pyfb_fbunlock(member->fbnum);
+    }
+
+    free(member->xmap);
+    free(member->ymap);
+    free(member);
+
+    group->members[index]            = group->members[group->count - 1];
+    group->members[group->count - 1] = NULL;
+    group->count--;
+}
+
+/**
+ * Frees a group without members.
+ *
+ * @param fbnum The framebuffer number of the source, must be locked
+ */
+static void pyfb_mirrorFree(uint8_t fbnum) {
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    pthread_cond_destroy(&fb->mirror->done);
+    pthread_cond_destroy(&fb->mirror->work);
+    pthread_mutex_destroy(&fb->mirror->mutex);
+    free(fb->mirror);
+    fb->mirror = NULL;
+}
+
+/**
+ * Builds the nearest neighbour map of the member coordinates to the source coordinates,
+ * sampling the center of every member pixel in 16.16 fixed point.
+ *
+ * @return The map, or NULL if out of memory
+ */
+static uint32_t* pyfb_mirrorMap(unsigned long int src_len, unsigned long int dst_len) {
+    uint32_t* map = (uint32_t*)malloc(dst_len * sizeof(uint32_t));
+    if(map == NULL) {
+        return NULL;
+    }
+
+    uint64_t step = ((uint64_t)src_len << 16) / dst_len;
+    uint64_t pos  = step / 2;
+
+    for(unsigned long int i = 0; i < dst_len; i++, pos += step) {
+        uint64_t value = pos >> 16;
+        map[i]         = (uint32_t)(value < src_len ? value : src_len - 1);
+    }
+
+    return map;
+}
+
+int pyfb_smirrorAdd(uint8_t fbnum, uint8_t member_fbnum) {
+    // first check if the numbers are valid
+    if(fbnum >= MAX_FRAMEBUFFERS || member_fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(fbnum == member_fbnum) {
+        PyErr_SetString(PyExc_ValueError, "A framebuffer can not mirror itself");
+        return -1;
+    }
+
+    // the source is always locked before its members
+    pyfb_fblock(fbnum);
+
+    struct pyfb_framebuffer* src = pyfb_fbptr(fbnum);
+
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(src->mirror_source != 0) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer is already a mirror member");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(src->palette != NULL) {
+        PyErr_SetString(PyExc_ValueError, "An indexed canvas can not be mirrored");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    pyfb_fblock(member_fbnum);
+
+    struct pyfb_framebuffer* dst = pyfb_fbptr(member_fbnum);
+    const char* error            = NULL;
+
+    if(!pyfb_fbused(member_fbnum)) {
+        error = "The mirror member framebuffer is not opened";
+    } else if(dst->mirror_source != 0) {
+        error = "The framebuffer is already a mirror member";
+    } else if(dst->mirror != NULL) {
+        error = "A mirror source can not be a mirror member";
+    } else if(dst->shared != NULL) {
+        error = "A shared framebuffer can not be a mirror member";
+    } else if(dst->palette != NULL) {
+        error = "An indexed canvas can not be a mirror member";
+    }
+
+    if(error != NULL) {
+        PyErr_SetString(PyExc_ValueError, error);
+        pyfb_fbunlock(member_fbnum);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // create the group on the first member
+    if(src->mirror == NULL) {
+        src->mirror = (struct pyfb_mirror*)calloc(1, sizeof(struct pyfb_mirror));
+        if(src->mirror == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Could not allocate the mirror group");
+            pyfb_fbunlock(member_fbnum);
+            pyfb_fbunlock(fbnum);
+            return -1;
+        }
+
+        src->mirror->source = fbnum;
+        pthread_mutex_init(&src->mirror->mutex, NULL);
+        pthread_cond_init(&src->mirror->work, NULL);
+        pthread_cond_init(&src->mirror->done, NULL);
+    }
+
+    struct pyfb_mirror* group        = src->mirror;
+    struct pyfb_mirrormember* member = (struct pyfb_mirrormember*)calloc(1, sizeof(struct pyfb_mirrormember));
+
+    // both screens in the orientation of their canvas
+    unsigned long int src_x, src_y, dst_x, dst_y;
+    pyfb_screenSize(fbnum, &src_x, &src_y);
+    pyfb_screenSize(member_fbnum, &dst_x, &dst_y);
+
+    if(member != NULL) {
+        member->group      = group;
+        member->fbnum      = member_fbnum;
+        member->xres       = dst_x;
+        member->yres       = dst_y;
+        member->depth      = dst->fb_info.vinfo.bits_per_pixel;
+        member->xmap       = pyfb_mirrorMap(src_x, dst_x);
+        member->ymap       = pyfb_mirrorMap(src_y, dst_y);
+        member->running    = 1;
+        member->generation = group->generation;
+    }
+
+    if(member == NULL || member->xmap == NULL || member->ymap == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the mirror member");
+    } else if(pthread_create(&member->thread, NULL, pyfb_mirrorThread, member) != 0) {
+        PyErr_SetString(PyExc_IOError, "Could not start the mirror thread");
+    } else {
+        group->members[group->count++] = member;
+        dst->mirror_source             = fbnum + 1;
+
+        pyfb_fbunlock(member_fbnum);
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    if(member != NULL) {
+        free(member->xmap);
+        free(member->ymap);
+        free(member);
+    }
+
+    if(group->count == 0) {
+        pyfb_mirrorFree(fbnum);
+    }
+
+    pyfb_fbunlock(member_fbnum);
+    pyfb_fbunlock(fbnum);
+    return -1;
+}
+
+int pyfb_smirrorRemove(uint8_t fbnum, uint8_t member_fbnum) {
+    // first check if the numbers are valid
+    if(fbnum >= MAX_FRAMEBUFFERS || member_fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    struct pyfb_mirror* group = pyfb_fbptr(fbnum)->mirror;
+
+    for(int i = 0; group != NULL && i < group->count; i++) {
+        if(group->members[i]->fbnum == member_fbnum) {
+            pyfb_mirrorDrop(group, i, 1);
+
+            if(group->count == 0) {
+                pyfb_mirrorFree(fbnum);
+            }
+
+            pyfb_fbunlock(fbnum);
+            return 0;
+        }
+    }
+
+    PyErr_SetString(PyExc_ValueError, "The framebuffer is not a mirror member");
+    pyfb_fbunlock(fbnum);
+    return -1;
+}
+
+void __APISTATUS_internal pyfb_mirrorStop(uint8_t fbnum) {
+    struct pyfb_mirror* group = pyfb_fbptr(fbnum)->mirror;
+
+    if(group == NULL) {
+        return;
+    }
+
+    while(group->count > 0) {
+        pyfb_mirrorDrop(group, group->count - 1, 1);
+    }
+
+    pyfb_mirrorFree(fbnum);
+}
+
+int __APISTATUS_internal pyfb_mirrorFlush(uint8_t fbnum, const struct pyfb_damage* rect) {
+    struct pyfb_mirror* group = pyfb_fbptr(fbnum)->mirror;
+
+    // start all members at once and wait for them, the source must not change meanwhile
+    pthread_mutex_lock(&group->mutex);
+    group->rect    = *rect;
+    group->pending = group->count;
+    group->generation++;
+    pthread_cond_broadcast(&group->work);
+
+    while(group->pending > 0) {
+        pthread_cond_wait(&group->done, &group->mutex);
+    }
+
+    pthread_mutex_unlock(&group->mutex);
+
+    // drop the members closed meanwhile, their framebuffer is not touched anymore
+    int exitcode = 0;
+
+    for(int i = group->count - 1; i >= 0; i--) {
+        if(group->members[i]->gone) {
+            pyfb_mirrorDrop(group, i, 0);
+        } else if(group->members[i]->failed) {
+            exitcode = -1;
+        }
+    }
+
+    if(group->count == 0) {
+        pyfb_mirrorFree(fbnum);
+    }
+
+    return exitcode;
+}
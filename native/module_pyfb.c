@@ -4,6 +4,46 @@
 
 #include "pyframebuffer.h"
 
+#include <errno.h>
+#include <limits.h>
+
+/**
+ * The state of the module in an interpreter. The framebuffers are shared by all
+ * interpreters of the process, so every interpreter counts its own references.
+ */
+struct pyfb_modulestate {
+    /**
+     * The references on the framebuffers taken by this interpreter, released when the
+     * module is freed.
+     */
+    atomic_ulong opened[MAX_FRAMEBUFFERS];
+};
+
+/**
+ * Returns the state of the module.
+ */
+static inline struct pyfb_modulestate* pyfb_modstate(PyObject* module) {
+    return (struct pyfb_modulestate*)PyModule_GetState(module);
+}
+
+/**
+ * Releases a reference of this interpreter on a framebuffer, if it holds one.
+ *
+ * @return Not 0 if a reference has been released
+ */
+static int pyfb_modrelease(PyObject* module, uint8_t fbnum) {
+    atomic_ulong* opened    = &pyfb_modstate(module)->opened[fbnum];
+    unsigned long int count = atomic_load(opened);
+
+    while(count > 0) {
+        if(atomic_compare_exchange_weak(opened, &count, count - 1)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Python wrapper for the pyfb_open function.
  *
@@ -19,7 +59,54 @@ static PyObject* pyfunc_pyfb_open(PyObject* self, PyObject* args) {
         return NULL;
     }
 
+    PYFB_RECORD_BEGIN(record_start);
     int exitcode = pyfb_open((uint8_t)fbnum_c);
+
+    if(exitcode == 0) {
+        atomic_fetch_add(&pyfb_modstate(self)->opened[fbnum_c], 1);
+    }
+
+    if(record_start != 0 && exitcode == 0) {
+        pyfb_recordOpen((uint8_t)fbnum_c, record_start);
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_openVirtual function.
+ *
+ * @param self This function
+ * @param args The arguments, expecting byte of the fbnum, long of the xres, long of the yres, int of the depth,
+ *             int of the dump file descriptor or -1 and int of the dump format
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_openVirtual(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c = 0;
+    unsigned long int xres;
+    unsigned long int yres;
+    unsigned int depth;
+    int dump_fd;
+    int dump_format;
+
+    if(!PyArg_ParseTuple(args, "bkkIii", &fbnum_c, &xres, &yres, &depth, &dump_fd, &dump_format)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, int, int, int)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_openVirtual((uint8_t)fbnum_c, xres, yres, depth, dump_fd, dump_format);
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&pyfb_modstate(self)->opened[fbnum_c], 1);
+
+    if(record_start != 0) {
+        pyfb_recordOpen((uint8_t)fbnum_c, record_start);
+    }
+
     return PyLong_FromLong(exitcode);
 }
 
@@ -39,7 +126,162 @@ static PyObject* pyfunc_pyfb_close(PyObject* self, PyObject* args) {
     }
 
     int exitcode = 0;
+    PYFB_RECORD_BEGIN(record_start);
+
+    if(fbnum_c >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return NULL;
+    }
+
+    // only a reference of this interpreter is closed, else the reference of another
+    // interpreter would be dropped and closed again when this interpreter ends
+    if(!pyfb_modrelease(self, (uint8_t)fbnum_c)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        return NULL;
+    }
+
     pyfb_close((uint8_t)fbnum_c);
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        pyfb_recordCall(PYFB_RECORD_CLOSE, (uint8_t)fbnum_c, record_start, NULL, 0, NULL, 0);
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sopenShared function.
+ *
+ * @param self This function
+ * @param args The arguments, expecting byte of the fbnum, str of the segment name, bool if this process is the owner,
+ *             and long of the xres, long of the yres and int of the depth of a virtual framebuffer for the owner,
+ *             the xres 0 for the device file
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sopenShared(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c = 0;
+    const char* name;
+    int owner;
+    unsigned long int xres;
+    unsigned long int yres;
+    unsigned int depth;
+
+    if(!PyArg_ParseTuple(args, "bspkkI", &fbnum_c, &name, &owner, &xres, &yres, &depth)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, str, bool, long, long, int)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sopenShared((uint8_t)fbnum_c, name, owner, xres, yres, depth);
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&pyfb_modstate(self)->opened[fbnum_c], 1);
+
+    if(record_start != 0) {
+        pyfb_recordOpen((uint8_t)fbnum_c, record_start);
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sdamage function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x coordinate, long of the y coordinate, long of
+ *             the width and long of the height
+ *
+ * @return Just a 0
+ */
+static PyObject* pyfunc_pyfb_sdamage(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c = 0;
+    unsigned long int x;
+    unsigned long int y;
+    unsigned long int w;
+    unsigned long int h;
+
+    if(!PyArg_ParseTuple(args, "bkkkk", &fbnum_c, &x, &y, &w, &h)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, long, long)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_sdamage((uint8_t)fbnum_c, x, y, w, h) != 0) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_DAMAGE, (uint8_t)fbnum_c, record_start, x, y, w, h);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_waitDamage function. Other Python threads run while waiting.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and float of the timeout in seconds, negative to wait
+ *             without a timeout
+ *
+ * @return True if another process flushed damage, False on timeout
+ */
+static PyObject* pyfunc_pyfb_waitDamage(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c = 0;
+    double timeout;
+
+    if(!PyArg_ParseTuple(args, "bd", &fbnum_c, &timeout)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, float)");
+        return NULL;
+    }
+
+    int timeout_ms = timeout < 0 ? -1 : (timeout > INT_MAX / 1000 ? INT_MAX : (int)(timeout * 1000));
+    int result;
+
+    Py_BEGIN_ALLOW_THREADS;
+    result = pyfb_waitDamage((uint8_t)fbnum_c, timeout_ms);
+    Py_END_ALLOW_THREADS;
+
+    if(result < 0) {
+        if(errno == EINVAL) {
+            PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        } else {
+            PyErr_SetString(PyExc_IOError, "The framebuffer is not opened as owner of a shared offscreen buffer");
+        }
+
+        return NULL;
+    }
+
+    return PyBool_FromLong(result);
+}
+
+/**
+ * Python wrapper for the pyfb_ssetKeepAlive function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and float of the keep-alive period in seconds
+ *
+ * @return Just a 0
+ */
+static PyObject* pyfunc_pyfb_ssetKeepAlive(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c = 0;
+    double seconds;
+
+    if(!PyArg_ParseTuple(args, "bd", &fbnum_c, &seconds)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, float)");
+        return NULL;
+    }
+
+    if(pyfb_ssetKeepAlive((uint8_t)fbnum_c, seconds) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
     return PyLong_FromLong(exitcode);
 }
 
@@ -67,7 +309,9 @@ static PyObject* pyfunc_pyfb_ssetPixel(PyObject* self, PyObject* args) {
     pyfb_initcolor_u32(&color, color_val);
 
     // And invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_ssetPixel((uint8_t)fbnum_c, x, y, &color);
+    PYFB_RECORD(PYFB_RECORD_PIXEL, (uint8_t)fbnum_c, record_start, x, y, color_val);
 
     // ready
     int exitcode = 0;
@@ -99,7 +343,9 @@ static PyObject* pyfunc_pyfb_sdrawHorizontalLine(PyObject* self, PyObject* args)
     pyfb_initcolor_u32(&color, color_val);
 
     // And invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_sdrawHorizontalLine((uint8_t)fbnum_c, x, y, len, &color);
+    PYFB_RECORD(PYFB_RECORD_HLINE, (uint8_t)fbnum_c, record_start, x, y, len, color_val);
 
     // ready
     int exitcode = 0;
@@ -131,7 +377,9 @@ static PyObject* pyfunc_pyfb_sdrawVerticalLine(PyObject* self, PyObject* args) {
     pyfb_initcolor_u32(&color, color_val);
 
     // and invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_sdrawVerticalLine((uint8_t)fbnum_c, x, y, len, &color);
+    PYFB_RECORD(PYFB_RECORD_VLINE, (uint8_t)fbnum_c, record_start, x, y, len, color_val);
 
     // ready
     int exitcode = 0;
@@ -155,7 +403,12 @@ static PyObject* pyfunc_pyfb_flushBuffer(PyObject* self, PyObject* args) {
     }
 
     // Now invoke the function
+    PYFB_RECORD_BEGIN(record_start);
     int exitcode = pyfb_flushBuffer((uint8_t)fbnum_c);
+
+    if(record_start != 0 && exitcode == 0) {
+        pyfb_recordCall(PYFB_RECORD_FLUSH, (uint8_t)fbnum_c, record_start, NULL, 0, NULL, 0);
+    }
     return PyLong_FromLong(exitcode);
 }
 
@@ -185,11 +438,166 @@ static PyObject* pyfunc_pyfb_getResolution(PyObject* self, PyObject* args) {
         return NULL;
     }
 
+    // a canvas rotated by a quarter turn swaps the sides
+    struct pyfb_canvas canvas;
+    pyfb_scanvas((uint8_t)fbnum_c, &canvas);
+
+    if(canvas.rotation & 1) {
+        unsigned int xres = vinfo.vinfo.xres;
+        vinfo.vinfo.xres  = vinfo.vinfo.yres;
+        vinfo.vinfo.yres  = xres;
+    }
+
     // else build the tuple
     PyObject* tuple = Py_BuildValue("III", vinfo.vinfo.xres, vinfo.vinfo.yres, vinfo.vinfo.bits_per_pixel);
     return tuple;
 }
 
+/**
+ * Returns the canvas of the framebuffer.
+ *
+ * @param self The function
+ * @param args The arguments, expecting long of the fbnum
+ *
+ * @return A python tuple of (xres, yres, xoffset, yoffset, panning)
+ */
+static PyObject* pyfunc_pyfb_getCanvas(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_canvas canvas;
+    pyfb_scanvas((uint8_t)fbnum_c, &canvas);
+
+    // check if valid
+    if(canvas.xres == 0) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return NULL;
+    }
+
+    // else build the tuple
+    PyObject* tuple = Py_BuildValue("kkkki", canvas.xres, canvas.yres, canvas.xoffset, canvas.yoffset, canvas.panning);
+    return tuple;
+}
+
+/**
+ * Python wrapper for the pyfb_ssetRotation function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, int of the degrees and int of the flip bits
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_ssetRotation(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned int degrees;
+    int flip;
+
+    if(!PyArg_ParseTuple(args, "bIi", &fbnum_c, &degrees, &flip)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, int, int)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_ssetRotation((uint8_t)fbnum_c, degrees, flip) != 0) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_ROTATION, (uint8_t)fbnum_c, record_start, degrees, (uint64_t)flip);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Returns the rotation of the canvas of the framebuffer.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return A python tuple of (degrees, flip)
+ */
+static PyObject* pyfunc_pyfb_getRotation(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_canvas canvas;
+    pyfb_scanvas((uint8_t)fbnum_c, &canvas);
+
+    // check if valid
+    if(canvas.xres == 0) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return NULL;
+    }
+
+    return Py_BuildValue("ii", canvas.rotation * 90, canvas.flip);
+}
+
+/**
+ * Python wrapper for the pyfb_ssetCanvas function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the canvas width and long of the canvas height
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_ssetCanvas(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int xres;
+    unsigned long int yres;
+
+    if(!PyArg_ParseTuple(args, "bkk", &fbnum_c, &xres, &yres)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_ssetCanvas((uint8_t)fbnum_c, xres, yres) != 0) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_CANVAS, (uint8_t)fbnum_c, record_start, xres, yres);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_ssetViewport function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x offset and long of the y offset
+ *
+ * @return 1 if the display has been panned by the driver, else 0 if a flush is required
+ */
+static PyObject* pyfunc_pyfb_ssetViewport(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int x;
+    unsigned long int y;
+
+    if(!PyArg_ParseTuple(args, "bkk", &fbnum_c, &x, &y)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    int panned = pyfb_ssetViewport((uint8_t)fbnum_c, x, y);
+    if(panned < 0) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_VIEWPORT, (uint8_t)fbnum_c, record_start, x, y);
+
+    return PyLong_FromLong(panned);
+}
+
 /**
  * Python wrapper for the pyfb_drawLine function.
  * 
@@ -216,7 +624,9 @@ static PyObject* pyfunc_pyfb_sdrawLine(PyObject* self, PyObject* args) {
     pyfb_initcolor_u32(&color, color_val);
 
     // and invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_sdrawLine((uint8_t)fbnum_c, x1, y1, x2, y2, &color);
+    PYFB_RECORD(PYFB_RECORD_LINE, (uint8_t)fbnum_c, record_start, x1, y1, x2, y2, color_val);
 
     // and return just 0
     int exitcode = 0;
@@ -248,7 +658,9 @@ static PyObject* pyfunc_pyfb_sdrawCircle(PyObject* self, PyObject* args) {
     pyfb_initcolor_u32(&color, color_val);
 
     // and invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_sdrawCircle((uint8_t)fbnum_c, xm, ym, radius, &color);
+    PYFB_RECORD(PYFB_RECORD_CIRCLE, (uint8_t)fbnum_c, record_start, xm, ym, radius, color_val);
 
     // and return just 0
     int exitcode = 0;
@@ -281,51 +693,1920 @@ static PyObject* pyfunc_pyfb_sdrawEllipse(PyObject* self, PyObject* args) {
     pyfb_initcolor_u32(&color, color_val);
 
     // and invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
     pyfb_sdrawEllipse((uint8_t)fbnum_c, xm, ym, a, b, &color);
+    PYFB_RECORD(PYFB_RECORD_ELLIPSE, (uint8_t)fbnum_c, record_start, xm, ym, a, b, color_val);
 
     // and return just 0
     int exitcode = 0;
     return PyLong_FromLong(exitcode);
 }
 
-// The module def
-
 /**
- * The method definitions.
+ * Python wrapper for the pyfb_scopyArea function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the sx, long of the sy, long of the width, long
+ *             of the height, long of the dx and long of the dy
+ *
+ * @return Just 0
  */
-static PyMethodDef pyfb_methods[] = {
-    {"pyfb_open", pyfunc_pyfb_open, METH_VARARGS, "Framebuffer open function"},
-    {"pyfb_close", pyfunc_pyfb_close, METH_VARARGS, "Framebuffer close function"},
-    {"pyfb_setPixel", pyfunc_pyfb_ssetPixel, METH_VARARGS, "Draw a pixel on the framebuffer"},
-    {"pyfb_drawLine", pyfunc_pyfb_sdrawLine, METH_VARARGS, "Draw a line on the framebuffer"},
-    {"pyfb_drawHorizontalLine", pyfunc_pyfb_sdrawHorizontalLine, METH_VARARGS, "Draw a horizontal line on the framebuffer"},
-    {"pyfb_drawVerticalLine", pyfunc_pyfb_sdrawVerticalLine, METH_VARARGS, "Draw a vertical line on the framebuffer"},
-    {"pyfb_drawCircle", pyfunc_pyfb_sdrawCircle, METH_VARARGS, "Draw a circle on the framebuffer"},
-    {"pyfb_drawEllipse", pyfunc_pyfb_sdrawEllipse, METH_VARARGS, "Draw a ellipse on the framebuffer"},
-    {"pyfb_flushBuffer", pyfunc_pyfb_flushBuffer, METH_VARARGS, "Flush the offscreen buffer to the framebuffer"},
-    {"pyfb_getResolution", pyfunc_pyfb_getResolution, METH_VARARGS, "Returns a tupel of the framebuffer resolution"},
-    {NULL, NULL, 0, NULL}};
+static PyObject* pyfunc_pyfb_scopyArea(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int sx;
+    unsigned long int sy;
+    unsigned long int width;
+    unsigned long int height;
+    unsigned long int dx;
+    unsigned long int dy;
 
-static struct PyModuleDef module__pyfb = {PyModuleDef_HEAD_INIT,
-                                          "_pyfb",
-                                          "Native interface for the pyframebuffer C sources",
-                                          -1,
-                                          pyfb_methods};
+    if(!PyArg_ParseTuple(args, "bkkkkkk", &fbnum_c, &sx, &sy, &width, &height, &dx, &dy)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, long, long, long, long)");
+        return NULL;
+    }
+
+    // invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
+    pyfb_scopyArea((uint8_t)fbnum_c, sx, sy, width, height, dx, dy);
+
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_COPYAREA, (uint8_t)fbnum_c, record_start, sx, sy, width, height, dx, dy);
+
+    // and return just 0
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sgetPixel function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x and long of the y
+ *
+ * @return The 32 bit color value of the pixel
+ */
+static PyObject* pyfunc_pyfb_sgetPixel(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int x;
+    unsigned long int y;
+
+    if(!PyArg_ParseTuple(args, "bkk", &fbnum_c, &x, &y)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long)");
+        return NULL;
+    }
+
+    uint32_t value;
+    if(pyfb_sgetPixel((uint8_t)fbnum_c, x, y, &value) != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLong(value);
+}
+
+/**
+ * Python wrapper for the pyfb_sreadRect function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x, long of the y, long of the width, long of
+ *             the height and a writable buffer for the RGBA8888 pixels
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sreadRect(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int x;
+    unsigned long int y;
+    unsigned long int width;
+    unsigned long int height;
+    Py_buffer buffer;
+
+    if(!PyArg_ParseTuple(args, "bkkkkw*", &fbnum_c, &x, &y, &width, &height, &buffer)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, long, long, writable buffer)");
+        return NULL;
+    }
+
+    // invoke the target function
+    int exitcode = pyfb_sreadRect((uint8_t)fbnum_c, x, y, width, height, (uint8_t*)buffer.buf, (size_t)buffer.len);
+    PyBuffer_Release(&buffer);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_suploadRect function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x, long of the y, long of the width, long of
+ *             the height and a buffer with the RGBA8888 pixels
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_suploadRect(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int x;
+    unsigned long int y;
+    unsigned long int width;
+    unsigned long int height;
+    Py_buffer buffer;
+
+    if(!PyArg_ParseTuple(args, "bkkkky*", &fbnum_c, &x, &y, &width, &height, &buffer)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, long, long, buffer)");
+        return NULL;
+    }
+
+    // invoke the target function, the recording keeps only the pixels of the area
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_suploadRect((uint8_t)fbnum_c, x, y, width, height, (const uint8_t*)buffer.buf, (size_t)buffer.len);
+
+    if(record_start != 0 && exitcode == 0) {
+        const uint64_t record_args[] = {x, y, width, height};
+        pyfb_recordCall(PYFB_RECORD_WRITERECT, (uint8_t)fbnum_c, record_start, record_args, 4, buffer.buf, width * height * 4);
+    }
+
+    PyBuffer_Release(&buffer);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Returns the scalar type of a buffer from its struct module format.
+ *
+ * @param buffer The buffer, requested with its format
+ *
+ * @return The @c PYFB_SCALAR_ type, or -1 if the values are not of a supported type
+ */
+static int pyfb_scalarType(const Py_buffer* buffer) {
+    const char* format = buffer->format != NULL ? buffer->format : "B";
+
+    // native or little endian byte order
+    if(*format == '@' || *format == '=' || (*format == '<' && PY_LITTLE_ENDIAN)) {
+        format++;
+    }
+
+    // the integer formats are matched by their size, as it differs between the platforms
+    if(format[0] == '\0' || format[1] != '\0') {
+        return -1;
+    }
+
+    switch(format[0]) {
+    case 'B':
+        return buffer->itemsize == 1 ? PYFB_SCALAR_U8 : -1;
+    case 'H':
+        return buffer->itemsize == 2 ? PYFB_SCALAR_U16 : -1;
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+        if(buffer->itemsize == 2) {
+            return PYFB_SCALAR_I16;
+        }
+        if(buffer->itemsize == 4) {
+            return PYFB_SCALAR_I32;
+        }
+        return buffer->itemsize == 8 ? PYFB_SCALAR_I64 : -1;
+    case 'f':
+        return buffer->itemsize == 4 ? PYFB_SCALAR_F32 : -1;
+    case 'd':
+        return buffer->itemsize == 8 ? PYFB_SCALAR_F64 : -1;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * Requests a C contiguous buffer of scalar values from an object.
+ *
+ * @param obj The object, e.g. an array.array or a numpy array
+ * @param buffer The buffer to fill, release it with PyBuffer_Release
+ * @param type The @c PYFB_SCALAR_ type of the values
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+static int pyfb_scalarBuffer(PyObject* obj, Py_buffer* buffer, int* type) {
+    if(PyObject_GetBuffer(obj, buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return -1;
+    }
+
+    *type = pyfb_scalarType(buffer);
+    if(*type < 0) {
+        PyErr_SetString(PyExc_TypeError, "The array must hold integers or floats");
+        PyBuffer_Release(buffer);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Records a call with the data of two buffers, joined one after the other.
+ *
+ * @param op The call type, see pyfb_recordop
+ * @param fbnum The framebuffer number
+ * @param start The variable declared by PYFB_RECORD_BEGIN
+ * @param args The integer arguments
+ * @param nargs The amount of arguments
+ * @param first The first buffer
+ * @param first_len The length of the first buffer
+ * @param second The second buffer
+ * @param second_len The length of the second buffer
+ */
+static void pyfb_recordJoined(uint8_t op,
+                              uint8_t fbnum,
+                              uint64_t start,
+                              const uint64_t* args,
+                              size_t nargs,
+                              const void* first,
+                              size_t first_len,
+                              const void* second,
+                              size_t second_len) {
+    uint8_t* data = (uint8_t*)malloc(first_len + second_len);
+    if(data == NULL) {
+        // the recording misses the call rather than failing the drawing
+        return;
+    }
+
+    memcpy(data, first, first_len);
+    memcpy(data + first_len, second, second_len);
+    pyfb_recordCall(op, fbnum, start, args, nargs, data, first_len + second_len);
+    free(data);
+}
+
+/**
+ * Python wrapper for the pyfb_sblitScalar function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, a C contiguous uint8, uint16 or float32 array, long of the
+ *             width or 0 to take it from a two dimensional array, long of the x, long of the y, a buffer of the
+ *             256 colormap colors as native 32 bit integers, float of vmin, float of vmax and int of the zoom
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sblitScalar(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    PyObject* array_obj;
+    unsigned long int width;
+    long int x;
+    long int y;
+    Py_buffer colormap;
+    double vmin;
+    double vmax;
+    unsigned int zoom;
+
+    if(!PyArg_ParseTuple(args, "bOklly*ddI", &fbnum_c, &array_obj, &width, &x, &y, &colormap, &vmin, &vmax, &zoom)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Expecting arguments of type (byte, buffer, long, long, long, buffer, float, float, int)");
+        return NULL;
+    }
+
+    // copy the colors, the buffer may not be aligned
+    uint32_t colors[PYFB_COLORMAP_SIZE];
+    int valid = colormap.len == sizeof(colors);
+    if(valid) {
+        memcpy(colors, colormap.buf, sizeof(colors));
+    }
+    PyBuffer_Release(&colormap);
+
+    if(!valid) {
+        PyErr_SetString(PyExc_ValueError, "The colormap must have 256 colors");
+        return NULL;
+    }
+
+    Py_buffer array;
+    int type;
+    if(pyfb_scalarBuffer(array_obj, &array, &type) != 0) {
+        return NULL;
+    }
+
+    if(type != PYFB_SCALAR_U8 && type != PYFB_SCALAR_U16 && type != PYFB_SCALAR_F32) {
+        PyErr_SetString(PyExc_TypeError, "The array must hold uint8, uint16 or float32 values");
+        PyBuffer_Release(&array);
+        return NULL;
+    }
+
+    if(width == 0) {
+        if(array.ndim != 2) {
+            PyErr_SetString(PyExc_ValueError, "The width is required for an array that is not two dimensional");
+            PyBuffer_Release(&array);
+            return NULL;
+        }
+        width = (unsigned long int)array.shape[1];
+    }
+
+    size_t count = (size_t)array.len / (size_t)array.itemsize;
+    if(width == 0 || count % width != 0) {
+        PyErr_SetString(PyExc_ValueError, "The array length is not a multiple of the width");
+        PyBuffer_Release(&array);
+        return NULL;
+    }
+
+    // invoke the target function, the array stays held while it draws without the GIL
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sblitScalar((uint8_t)fbnum_c,
+                                    array.buf,
+                                    (size_t)array.len,
+                                    type,
+                                    width,
+                                    count / width,
+                                    x,
+                                    y,
+                                    colors,
+                                    vmin,
+                                    vmax,
+                                    zoom);
+
+    // the recording keeps the colormap followed by the values, and the bits of the doubles
+    if(record_start != 0 && exitcode == 0) {
+        const uint64_t record_args[] = {(uint64_t)type,
+                                        width,
+                                        (uint64_t)(int64_t)x,
+                                        (uint64_t)(int64_t)y,
+                                        zoom,
+                                        pyfb_recordDouble(vmin),
+                                        pyfb_recordDouble(vmax)};
+        pyfb_recordJoined(PYFB_RECORD_SCALAR,
+                          (uint8_t)fbnum_c,
+                          record_start,
+                          record_args,
+                          7,
+                          colors,
+                          sizeof(colors),
+                          array.buf,
+                          (size_t)array.len);
+    }
+
+    PyBuffer_Release(&array);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sdrawPoints function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, a C contiguous array of the x coordinates, a C contiguous
+ *             array of the y coordinates and long of the color
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sdrawPoints(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    PyObject* xs_obj;
+    PyObject* ys_obj;
+    uint32_t color_val;
+
+    if(!PyArg_ParseTuple(args, "bOOI", &fbnum_c, &xs_obj, &ys_obj, &color_val)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, buffer, buffer, long)");
+        return NULL;
+    }
+
+    Py_buffer xs;
+    Py_buffer ys;
+    int xtype;
+    int ytype;
+
+    if(pyfb_scalarBuffer(xs_obj, &xs, &xtype) != 0) {
+        return NULL;
+    }
+
+    if(pyfb_scalarBuffer(ys_obj, &ys, &ytype) != 0) {
+        PyBuffer_Release(&xs);
+        return NULL;
+    }
+
+    struct pyfb_color color;
+    pyfb_initcolor_u32(&color, color_val);
+
+    // invoke the target function, the arrays stay held while it draws without the GIL
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sdrawPoints((uint8_t)fbnum_c, xs.buf, (size_t)xs.len, xtype, ys.buf, (size_t)ys.len, ytype, &color);
+
+    // the recording keeps the x coordinates followed by the y coordinates
+    if(record_start != 0 && exitcode == 0) {
+        const uint64_t record_args[] = {(uint64_t)xtype, (uint64_t)ytype, (uint64_t)xs.len, color_val};
+        pyfb_recordJoined(PYFB_RECORD_POINTS,
+                          (uint8_t)fbnum_c,
+                          record_start,
+                          record_args,
+                          4,
+                          xs.buf,
+                          (size_t)xs.len,
+                          ys.buf,
+                          (size_t)ys.len);
+    }
+
+    PyBuffer_Release(&xs);
+    PyBuffer_Release(&ys);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sdrawPolyline function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, a C contiguous array of the coordinates as pairs of x and y,
+ *             bool if the points of a column are decimated and long of the color
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sdrawPolyline(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    PyObject* points_obj;
+    int decimate;
+    uint32_t color_val;
+
+    if(!PyArg_ParseTuple(args, "bOpI", &fbnum_c, &points_obj, &decimate, &color_val)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, buffer, bool, long)");
+        return NULL;
+    }
+
+    Py_buffer points;
+    int type;
+
+    if(pyfb_scalarBuffer(points_obj, &points, &type) != 0) {
+        return NULL;
+    }
+
+    struct pyfb_color color;
+    pyfb_initcolor_u32(&color, color_val);
+
+    // invoke the target function, the array stays held while it draws without the GIL
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sdrawPolyline((uint8_t)fbnum_c, points.buf, (size_t)points.len, type, decimate, &color);
+
+    if(record_start != 0 && exitcode == 0) {
+        const uint64_t record_args[] = {(uint64_t)type, (uint64_t)decimate, color_val};
+        pyfb_recordCall(PYFB_RECORD_POLYLINE, (uint8_t)fbnum_c, record_start, record_args, 3, points.buf, (size_t)points.len);
+    }
+
+    PyBuffer_Release(&points);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sfillTriangle function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, tuple of the x1, y1, x2, y2, x3 and y3 and tuple of the
+ *             colors of the three vertices
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sfillTriangle(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    double c[6];
+    uint32_t k[3];
+
+    if(!PyArg_ParseTuple(args, "b(dddddd)(III)", &fbnum_c, &c[0], &c[1], &c[2], &c[3], &c[4], &c[5], &k[0], &k[1], &k[2])) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, tuple of 6 floats, tuple of 3 longs)");
+        return NULL;
+    }
+
+    // invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sfillTriangle((uint8_t)fbnum_c, c, k);
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    // the recording keeps the coordinates followed by the colors
+    if(record_start != 0) {
+        pyfb_recordJoined(PYFB_RECORD_TRIANGLE, (uint8_t)fbnum_c, record_start, NULL, 0, c, sizeof(c), k, sizeof(k));
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sfillTriangles function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, a C contiguous array of the coordinates as three pairs of x
+ *             and y per triangle and a buffer of the colors as native 32 bit integers
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sfillTriangles(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    PyObject* vertices_obj;
+    Py_buffer colors;
+
+    if(!PyArg_ParseTuple(args, "bOy*", &fbnum_c, &vertices_obj, &colors)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, buffer, buffer)");
+        return NULL;
+    }
+
+    Py_buffer vertices;
+    int type;
+
+    if(pyfb_scalarBuffer(vertices_obj, &vertices, &type) != 0) {
+        PyBuffer_Release(&colors);
+        return NULL;
+    }
+
+    // invoke the target function, the buffers stay held while it fills without the GIL
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sfillTriangles((uint8_t)fbnum_c,
+                                       vertices.buf,
+                                       (size_t)vertices.len,
+                                       type,
+                                       colors.buf,
+                                       (size_t)colors.len);
+
+    // the recording keeps the coordinates followed by the colors
+    if(record_start != 0 && exitcode == 0) {
+        const uint64_t record_args[] = {(uint64_t)type, (uint64_t)vertices.len};
+        pyfb_recordJoined(PYFB_RECORD_TRIANGLES,
+                          (uint8_t)fbnum_c,
+                          record_start,
+                          record_args,
+                          2,
+                          vertices.buf,
+                          (size_t)vertices.len,
+                          colors.buf,
+                          (size_t)colors.len);
+    }
+
+    PyBuffer_Release(&vertices);
+    PyBuffer_Release(&colors);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sfillGradient function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, int of the gradient type, tuple of the x0, y0, x1, y1 and
+ *             radius of the gradient, a buffer of the stop offsets as native doubles, a buffer of the stop colors as
+ *             native 32 bit integers, long of the x, long of the y, long of the width, long of the height, int of the
+ *             shape and bool if the colors are dithered
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sfillGradient(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    struct pyfb_gradient gradient;
+    Py_buffer offsets;
+    Py_buffer colors;
+    long int x;
+    long int y;
+    unsigned long int width;
+    unsigned long int height;
+    int shape;
+    int dither;
+
+    // cleared, so a recorded gradient has no undefined padding bytes
+    memset(&gradient, 0, sizeof(gradient));
+
+    if(!PyArg_ParseTuple(args,
+                         "bi(ddddd)y*y*llkkip",
+                         &fbnum_c,
+                         &gradient.type,
+                         &gradient.x0,
+                         &gradient.y0,
+                         &gradient.x1,
+                         &gradient.y1,
+                         &gradient.radius,
+                         &offsets,
+                         &colors,
+                         &x,
+                         &y,
+                         &width,
+                         &height,
+                         &shape,
+                         &dither)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "Expecting arguments of type (byte, int, tuple of 5 floats, buffer, buffer, long, long, long, "
+                        "long, int, bool)");
+        return NULL;
+    }
+
+    // copy the stops, the buffers may not be aligned
+    size_t stops = (size_t)offsets.len / sizeof(double);
+    int valid    = stops >= 1 && stops <= PYFB_GRADIENT_STOPS && (size_t)offsets.len == stops * sizeof(double) &&
+                   (size_t)colors.len == stops * sizeof(uint32_t);
+    if(valid) {
+        gradient.stops = (unsigned int)stops;
+        memcpy(gradient.offsets, offsets.buf, stops * sizeof(double));
+        memcpy(gradient.colors, colors.buf, stops * sizeof(uint32_t));
+    }
+    PyBuffer_Release(&offsets);
+    PyBuffer_Release(&colors);
+
+    if(!valid) {
+        PyErr_SetString(PyExc_ValueError, "A gradient must have 1 to 16 color stops");
+        return NULL;
+    }
+
+    // invoke the target function
+    PYFB_RECORD_BEGIN(record_start);
+    int exitcode = pyfb_sfillGradient((uint8_t)fbnum_c, &gradient, x, y, width, height, shape, dither);
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        const uint64_t record_args[] = {
+            (uint64_t)(int64_t)x, (uint64_t)(int64_t)y, width, height, (uint64_t)shape, (uint64_t)dither};
+        pyfb_recordCall(PYFB_RECORD_GRADIENT, (uint8_t)fbnum_c, record_start, record_args, 6, &gradient, sizeof(gradient));
+    }
+
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_ssetPalette function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and a buffer with the color values as native 32 bit integers
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_ssetPalette(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    Py_buffer buffer;
+
+    if(!PyArg_ParseTuple(args, "by*", &fbnum_c, &buffer)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, buffer)");
+        return NULL;
+    }
+
+    // copy the colors, the buffer may not be aligned
+    uint32_t colors[PYFB_PALETTE_SIZE];
+    size_t count = (size_t)buffer.len / sizeof(uint32_t);
+    memcpy(colors, buffer.buf, (count < PYFB_PALETTE_SIZE ? count : PYFB_PALETTE_SIZE) * sizeof(uint32_t));
+    PyBuffer_Release(&buffer);
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_ssetPalette((uint8_t)fbnum_c, colors, count > UINT_MAX ? UINT_MAX : (unsigned int)count) != 0) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        const uint64_t record_args[] = {count};
+        pyfb_recordCall(PYFB_RECORD_PALETTE, (uint8_t)fbnum_c, record_start, record_args, 1, colors, count * sizeof(uint32_t));
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sclearPalette function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sclearPalette(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_sclearPalette((uint8_t)fbnum_c) != 0) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        pyfb_recordCall(PYFB_RECORD_CLEARPALETTE, (uint8_t)fbnum_c, record_start, NULL, 0, NULL, 0);
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sblitTransformed function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, byte of the source fbnum, a tuple of the 6 matrix values
+ *             and int of the filter
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sblitTransformed(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned char srcnum_c;
+    double m[6];
+    int filter;
+
+    if(!PyArg_ParseTuple(args, "bb(dddddd)i", &fbnum_c, &srcnum_c, &m[0], &m[1], &m[2], &m[3], &m[4], &m[5], &filter)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, byte, (float * 6), int)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_sblitTransformed((uint8_t)fbnum_c, (uint8_t)srcnum_c, m, filter) != 0) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        const uint64_t record_args[] = {srcnum_c, (uint64_t)filter};
+        pyfb_recordCall(PYFB_RECORD_BLIT, (uint8_t)fbnum_c, record_start, record_args, 2, m, sizeof(m));
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_scapture function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, int of the capture source and a writable buffer for the
+ *             RGBA8888 pixels or None to allocate a new bytes object
+ *
+ * @return The new bytes object, or None if the pixels are written to the given buffer
+ */
+static PyObject* pyfunc_pyfb_scapture(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    int source;
+    PyObject* buffer_obj;
+
+    if(!PyArg_ParseTuple(args, "biO", &fbnum_c, &source, &buffer_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, int, writable buffer or None)");
+        return NULL;
+    }
+
+    if(buffer_obj != Py_None) {
+        Py_buffer buffer;
+        if(PyObject_GetBuffer(buffer_obj, &buffer, PyBUF_WRITABLE) != 0) {
+            return NULL;
+        }
+
+        int exitcode = pyfb_scapture((uint8_t)fbnum_c, source, (uint8_t*)buffer.buf, (size_t)buffer.len);
+        PyBuffer_Release(&buffer);
+
+        if(exitcode != 0) {
+            return NULL;
+        }
+
+        Py_RETURN_NONE;
+    }
+
+    // else allocate a bytes object of the screen size and fill it in place
+    struct pyfb_videomode_info info;
+    pyfb_svinfo((uint8_t)fbnum_c, &info);
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    Py_ssize_t len  = (Py_ssize_t)info.vinfo.xres * info.vinfo.yres * 4;
+    PyObject* bytes = PyBytes_FromStringAndSize(NULL, len);
+    if(bytes == NULL) {
+        return NULL;
+    }
+
+    if(pyfb_scapture((uint8_t)fbnum_c, source, (uint8_t*)PyBytes_AS_STRING(bytes), (size_t)len) != 0) {
+        Py_DECREF(bytes);
+        return NULL;
+    }
+
+    return bytes;
+}
+
+/**
+ * Python wrapper for the pyfb_sstreamStart function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, int of the file descriptor, int of the encoding and int of
+ *             the tile size
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sstreamStart(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    int fd;
+    int encoding;
+    unsigned int tile_size;
+
+    if(!PyArg_ParseTuple(args, "biiI", &fbnum_c, &fd, &encoding, &tile_size)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, int, int, int)");
+        return NULL;
+    }
+
+    if(pyfb_sstreamStart((uint8_t)fbnum_c, fd, encoding, tile_size) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sstreamStop function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sstreamStop(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    pyfb_sstreamStop((uint8_t)fbnum_c);
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sstreamStats function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return A python tuple of (frames, dropped, tiles, bytes, failed)
+ */
+static PyObject* pyfunc_pyfb_sstreamStats(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_streamstats stats;
+    if(pyfb_sstreamStats((uint8_t)fbnum_c, &stats) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("kkkKO", stats.frames, stats.dropped, stats.tiles, stats.bytes, stats.failed ? Py_True : Py_False);
+}
+
+/**
+ * Python wrapper for the pyfb_smirrorAdd function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the source fbnum and byte of the member fbnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_smirrorAdd(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned char member_c;
+
+    if(!PyArg_ParseTuple(args, "bb", &fbnum_c, &member_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, byte)");
+        return NULL;
+    }
+
+    if(pyfb_smirrorAdd((uint8_t)fbnum_c, (uint8_t)member_c) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_smirrorRemove function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the source fbnum and byte of the member fbnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_smirrorRemove(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned char member_c;
+
+    if(!PyArg_ParseTuple(args, "bb", &fbnum_c, &member_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, byte)");
+        return NULL;
+    }
+
+    if(pyfb_smirrorRemove((uint8_t)fbnum_c, (uint8_t)member_c) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_ssetStats function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and bool if the counters are enabled
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_ssetStats(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    int enabled;
+
+    if(!PyArg_ParseTuple(args, "bp", &fbnum_c, &enabled)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, bool)");
+        return NULL;
+    }
+
+    if(pyfb_ssetStats((uint8_t)fbnum_c, enabled) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sstats function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and bool if the counters are reset
+ *
+ * @return A python tuple of (tuple of calls per primitive, pixels, flushes, flush bytes, flush nanoseconds, tuple of
+ *         the flush latency histogram)
+ */
+static PyObject* pyfunc_pyfb_sstats(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    int reset;
+
+    if(!PyArg_ParseTuple(args, "bp", &fbnum_c, &reset)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, bool)");
+        return NULL;
+    }
+
+    struct pyfb_statsinfo info;
+    if(pyfb_sstats((uint8_t)fbnum_c, &info, reset) != 0) {
+        return NULL;
+    }
+
+    PyObject* calls = PyTuple_New(PYFB_STAT_PRIMITIVES);
+    PyObject* hist  = PyTuple_New(PYFB_STAT_BUCKETS);
+    if(calls == NULL || hist == NULL) {
+        Py_XDECREF(calls);
+        Py_XDECREF(hist);
+        return NULL;
+    }
+
+    for(int i = 0; i < PYFB_STAT_PRIMITIVES; i++) {
+        PyTuple_SET_ITEM(calls, i, PyLong_FromUnsignedLong(info.calls[i]));
+    }
+
+    for(int i = 0; i < PYFB_STAT_BUCKETS; i++) {
+        PyTuple_SET_ITEM(hist, i, PyLong_FromUnsignedLong(info.flush_hist[i]));
+    }
+
+    return Py_BuildValue("NkkKKN", calls, info.pixels, info.flushes, info.flush_bytes, info.flush_ns, hist);
+}
+
+/**
+ * Python wrapper for the pyfb_traceStart function.
+ *
+ * @param self The function
+ * @param args No arguments
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_traceStart(PyObject* self, PyObject* args) {
+    if(pyfb_traceStart() != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_traceStop function.
+ *
+ * @param self The function
+ * @param args No arguments
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_traceStop(PyObject* self, PyObject* args) {
+    pyfb_traceStop();
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_traceDump function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting int of the file descriptor
+ *
+ * @return The amount of written events
+ */
+static PyObject* pyfunc_pyfb_traceDump(PyObject* self, PyObject* args) {
+    int fd;
+
+    if(!PyArg_ParseTuple(args, "i", &fd)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (int)");
+        return NULL;
+    }
+
+    long int written = pyfb_traceDump(fd);
+    if(written < 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(written);
+}
+
+/**
+ * Python wrapper for the pyfb_recordStart function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting int of the file descriptor
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_recordStart(PyObject* self, PyObject* args) {
+    int fd;
+
+    if(!PyArg_ParseTuple(args, "i", &fd)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (int)");
+        return NULL;
+    }
+
+    if(pyfb_recordStart(fd) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_recordStop function.
+ *
+ * @param self The function
+ * @param args No arguments
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_recordStop(PyObject* self, PyObject* args) {
+    if(pyfb_recordStop() != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sreplay function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting int of the file descriptor and bool if the recorded pacing is kept
+ *
+ * @return A python tuple of (calls, flushes, errors, skipped, recorded nanoseconds, busy nanoseconds, replay
+ *         nanoseconds)
+ */
+static PyObject* pyfunc_pyfb_sreplay(PyObject* self, PyObject* args) {
+    int fd;
+    int paced;
+
+    if(!PyArg_ParseTuple(args, "ip", &fd, &paced)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (int, bool)");
+        return NULL;
+    }
+
+    struct pyfb_replaystats stats;
+    if(pyfb_sreplay(fd, paced, &stats) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("kkkkKKK",
+                         stats.calls,
+                         stats.flushes,
+                         stats.errors,
+                         stats.skipped,
+                         (unsigned long long)stats.recorded_ns,
+                         (unsigned long long)stats.busy_ns,
+                         (unsigned long long)stats.replay_ns);
+}
+
+/**
+ * Python wrapper for the pyfb_sclockOpen function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, float of the frame rate and bool if the clock waits for
+ *             the vertical blank
+ *
+ * @return The clock number
+ */
+static PyObject* pyfunc_pyfb_sclockOpen(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    double fps;
+    int vsync;
+
+    if(!PyArg_ParseTuple(args, "bdp", &fbnum_c, &fps, &vsync)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, float, bool)");
+        return NULL;
+    }
+
+    int clocknum = pyfb_sclockOpen((uint8_t)fbnum_c, fps, vsync);
+    if(clocknum < 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(clocknum);
+}
+
+/**
+ * Python wrapper for the pyfb_sclockClose function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the clock number
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sclockClose(PyObject* self, PyObject* args) {
+    unsigned char clocknum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &clocknum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    if(pyfb_sclockClose((uint8_t)clocknum_c) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sclockMode function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the clock number
+ *
+ * @return The clock mode
+ */
+static PyObject* pyfunc_pyfb_sclockMode(PyObject* self, PyObject* args) {
+    unsigned char clocknum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &clocknum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    int mode = pyfb_sclockMode((uint8_t)clocknum_c);
+    if(mode < 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(mode);
+}
+
+/**
+ * Python wrapper for the pyfb_clockWait function. Other Python threads run while waiting.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the clock number
+ *
+ * @return A python tuple of (frame, dropped, deadline nanoseconds, lateness nanoseconds)
+ */
+static PyObject* pyfunc_pyfb_clockWait(PyObject* self, PyObject* args) {
+    unsigned char clocknum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &clocknum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_clocktick tick;
+    int exitcode;
+
+    Py_BEGIN_ALLOW_THREADS;
+    exitcode = pyfb_clockWait((uint8_t)clocknum_c, &tick);
+    Py_END_ALLOW_THREADS;
+
+    if(exitcode != 0) {
+        if(errno == EINVAL) {
+            PyErr_SetString(PyExc_ValueError, "The frame clock number is not valid");
+        } else if(errno == EBADF) {
+            PyErr_SetString(PyExc_IOError, "The frame clock is not opened");
+        } else if(errno == EBUSY) {
+            PyErr_SetString(PyExc_IOError, "The frame clock is waited for by another thread");
+        } else {
+            PyErr_SetFromErrno(PyExc_IOError);
+        }
+
+        return NULL;
+    }
+
+    return Py_BuildValue("kkKK",
+                         tick.frame,
+                         tick.dropped,
+                         (unsigned long long)tick.deadline,
+                         (unsigned long long)tick.lateness);
+}
+
+/**
+ * Python wrapper for the pyfb_sclockStats function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the clock number
+ *
+ * @return A python tuple of (ticks, missed, dropped, period, jitter mean, jitter standard deviation, jitter
+ *         maximum), the times in nanoseconds
+ */
+static PyObject* pyfunc_pyfb_sclockStats(PyObject* self, PyObject* args) {
+    unsigned char clocknum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &clocknum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_clockstats stats;
+    if(pyfb_sclockStats((uint8_t)clocknum_c, &stats) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("kkkKKKK",
+                         stats.ticks,
+                         stats.missed,
+                         stats.dropped,
+                         (unsigned long long)stats.period_ns,
+                         (unsigned long long)stats.jitter_mean_ns,
+                         (unsigned long long)stats.jitter_stddev_ns,
+                         (unsigned long long)stats.jitter_max_ns);
+}
+
+/**
+ * Python wrapper for the pyfb_sasyncOpen function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return The eventfd of the async worker
+ */
+static PyObject* pyfunc_pyfb_sasyncOpen(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    int efd = pyfb_sasyncOpen((uint8_t)fbnum_c);
+    if(efd < 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(efd);
+}
+
+/**
+ * Python wrapper for the pyfb_sasyncClose function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sasyncClose(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    if(pyfb_sasyncClose((uint8_t)fbnum_c) != 0) {
+        return NULL;
+    }
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sasyncFlush function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return The ticket of the flush
+ */
+static PyObject* pyfunc_pyfb_sasyncFlush(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    unsigned long int ticket = pyfb_sasyncFlush((uint8_t)fbnum_c);
+    if(ticket == 0) {
+        return NULL;
+    }
+
+    // recorded as a flush at the time of the request
+    if(record_start != 0) {
+        pyfb_recordCall(PYFB_RECORD_FLUSH, (uint8_t)fbnum_c, record_start, NULL, 0, NULL, 0);
+    }
+
+    return PyLong_FromUnsignedLong(ticket);
+}
 
 /**
- * Module init function.
+ * Python wrapper for the pyfb_sasyncTick function.
  *
- * Initializes the module and defines the MAX_FRAMEBUFFERS macro as
- * constant in Python.
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum and byte of the clock number
  *
- * @return The module definition
+ * @return The ticket of the frame clock wait
  */
-PyMODINIT_FUNC PyInit__pyfb(void) {
-    PyObject* module = PyModule_Create(&module__pyfb);
+static PyObject* pyfunc_pyfb_sasyncTick(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned char clocknum_c;
+
+    if(!PyArg_ParseTuple(args, "bb", &fbnum_c, &clocknum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, byte)");
+        return NULL;
+    }
+
+    unsigned long int ticket = pyfb_sasyncTick((uint8_t)fbnum_c, (uint8_t)clocknum_c);
+    if(ticket == 0) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLong(ticket);
+}
+
+/**
+ * Python wrapper for the pyfb_sasyncPoll function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum
+ *
+ * @return A python tuple of (flush done, flush errno, tick done, tick errno, (frame, dropped, deadline, lateness))
+ */
+static PyObject* pyfunc_pyfb_sasyncPoll(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fbnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    struct pyfb_asyncstate state;
+    if(pyfb_sasyncPoll((uint8_t)fbnum_c, &state) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("kiki(kkKK)",
+                         state.flush_done,
+                         state.flush_error,
+                         state.tick_done,
+                         state.tick_error,
+                         state.tick.frame,
+                         state.tick.dropped,
+                         (unsigned long long)state.tick.deadline,
+                         (unsigned long long)state.tick.lateness);
+}
+
+/**
+ * Python wrapper for the pyfb_loadFont function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting bytes of the PSF font file content
+ *
+ * @return The font number
+ */
+static PyObject* pyfunc_pyfb_loadFont(PyObject* self, PyObject* args) {
+    const char* data;
+    Py_ssize_t len;
+
+    if(!PyArg_ParseTuple(args, "y#", &data, &len)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (bytes)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    int fontnum = pyfb_loadFont((const uint8_t*)data, (size_t)len);
+    if(fontnum < 0) {
+        return NULL;
+    }
+
+    if(record_start != 0) {
+        const uint64_t record_args[] = {(uint64_t)fontnum};
+        pyfb_recordCall(PYFB_RECORD_FONT, 0, record_start, record_args, 1, data, (size_t)len);
+    }
+
+    return PyLong_FromLong(fontnum);
+}
+
+/**
+ * Python wrapper for the pyfb_freeFont function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fontnum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_freeFont(PyObject* self, PyObject* args) {
+    unsigned char fontnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fontnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    pyfb_freeFont((uint8_t)fontnum_c);
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_FREEFONT, 0, record_start, fontnum_c);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Returns the glyph size of a font.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fontnum
+ *
+ * @return A python tuple of (width, height, glyphs)
+ */
+static PyObject* pyfunc_pyfb_fontInfo(PyObject* self, PyObject* args) {
+    unsigned char fontnum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &fontnum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int numglyphs;
+
+    if(pyfb_sfontInfo((uint8_t)fontnum_c, &width, &height, &numglyphs) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("III", width, height, numglyphs);
+}
+
+/**
+ * Python wrapper for the pyfb_smeasureText function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fontnum and the text string
+ *
+ * @return A python tuple of (width, height)
+ */
+static PyObject* pyfunc_pyfb_smeasureText(PyObject* self, PyObject* args) {
+    unsigned char fontnum_c;
+    PyObject* text;
+
+    if(!PyArg_ParseTuple(args, "bU", &fontnum_c, &text)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, str)");
+        return NULL;
+    }
+
+    Py_UCS4* codepoints = PyUnicode_AsUCS4Copy(text);
+    if(codepoints == NULL) {
+        return NULL;
+    }
+
+    unsigned long int width;
+    unsigned long int height;
+    int exitcode = pyfb_smeasureText((uint8_t)fontnum_c,
+                                     (const uint32_t*)codepoints,
+                                     (size_t)PyUnicode_GetLength(text),
+                                     &width,
+                                     &height);
+    PyMem_Free(codepoints);
+
+    if(exitcode != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("kk", width, height);
+}
+
+/**
+ * Python wrapper for the pyfb_sdrawText function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, long of the x, long of the y, the text string, byte of the
+ *             fontnum, long of the color and the background color or None for a transparent background
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sdrawText(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned long int x;
+    unsigned long int y;
+    PyObject* text;
+    unsigned char fontnum_c;
+    uint32_t color_val;
+    PyObject* background_obj;
+
+    if(!PyArg_ParseTuple(args, "bkkUbIO", &fbnum_c, &x, &y, &text, &fontnum_c, &color_val, &background_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, long, long, str, byte, long, long or None)");
+        return NULL;
+    }
+
+    // now parse the colors
+    struct pyfb_color color;
+    struct pyfb_color background;
+    pyfb_initcolor_u32(&color, color_val);
+
+    if(background_obj != Py_None) {
+        uint32_t background_val = (uint32_t)PyLong_AsUnsignedLong(background_obj);
+        if(PyErr_Occurred()) {
+            return NULL;
+        }
+        pyfb_initcolor_u32(&background, background_val);
+    }
+
+    Py_UCS4* codepoints = PyUnicode_AsUCS4Copy(text);
+    if(codepoints == NULL) {
+        return NULL;
+    }
+
+    // and invoke the target function
+    size_t len = (size_t)PyUnicode_GetLength(text);
+    PYFB_RECORD_BEGIN(record_start);
+    pyfb_sdrawText((uint8_t)fbnum_c,
+                   x,
+                   y,
+                   (const uint32_t*)codepoints,
+                   len,
+                   (uint8_t)fontnum_c,
+                   &color,
+                   background_obj != Py_None ? &background : NULL);
+
+    if(record_start != 0 && !PyErr_Occurred()) {
+        const uint64_t record_args[] = {
+            x, y, fontnum_c, color_val, background_obj != Py_None, background_obj != Py_None ? background.u32_color : 0};
+        pyfb_recordCall(PYFB_RECORD_TEXT, (uint8_t)fbnum_c, record_start, record_args, 6, codepoints, len * sizeof(Py_UCS4));
+    }
+
+    PyMem_Free(codepoints);
+
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    // and return just 0
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_loadSprite function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting a buffer with the RGBA8888 pixels, int of the width, int of the height, long of
+ *             the color key or None and int of the alpha threshold
+ *
+ * @return The sprite number
+ */
+static PyObject* pyfunc_pyfb_loadSprite(PyObject* self, PyObject* args) {
+    Py_buffer buffer;
+    unsigned int width;
+    unsigned int height;
+    PyObject* key_obj;
+    unsigned int threshold;
+
+    if(!PyArg_ParseTuple(args, "y*IIOI", &buffer, &width, &height, &key_obj, &threshold)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (buffer, int, int, long or None, int)");
+        return NULL;
+    }
+
+    uint32_t key = 0;
+    if(key_obj != Py_None) {
+        key = (uint32_t)PyLong_AsUnsignedLong(key_obj);
+        if(PyErr_Occurred()) {
+            PyBuffer_Release(&buffer);
+            return NULL;
+        }
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    int spritenum = pyfb_loadSprite((const uint8_t*)buffer.buf,
+                                    (size_t)buffer.len,
+                                    width,
+                                    height,
+                                    key_obj != Py_None ? &key : NULL,
+                                    threshold);
+
+    if(record_start != 0 && spritenum >= 0) {
+        const uint64_t record_args[] = {(uint64_t)spritenum, width, height, key_obj != Py_None, key, threshold};
+        pyfb_recordCall(PYFB_RECORD_LOADSPRITE, 0, record_start, record_args, 6, buffer.buf, (size_t)width * height * 4);
+    }
+
+    PyBuffer_Release(&buffer);
+
+    if(spritenum < 0) {
+        return NULL;
+    }
+
+    return PyLong_FromLong(spritenum);
+}
+
+/**
+ * Python wrapper for the pyfb_freeSprite function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the spritenum
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_freeSprite(PyObject* self, PyObject* args) {
+    unsigned char spritenum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &spritenum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    pyfb_freeSprite((uint8_t)spritenum_c);
+    if(PyErr_Occurred()) {
+        return NULL;
+    }
+
+    PYFB_RECORD(PYFB_RECORD_FREESPRITE, 0, record_start, spritenum_c);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+/**
+ * Python wrapper for the pyfb_sspriteInfo function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the spritenum
+ *
+ * @return A python tuple of (width, height, runs, opaque pixels)
+ */
+static PyObject* pyfunc_pyfb_sspriteInfo(PyObject* self, PyObject* args) {
+    unsigned char spritenum_c;
+
+    if(!PyArg_ParseTuple(args, "b", &spritenum_c)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte)");
+        return NULL;
+    }
+
+    unsigned int width;
+    unsigned int height;
+    unsigned long int runs;
+    unsigned long int opaque;
+
+    if(pyfb_sspriteInfo((uint8_t)spritenum_c, &width, &height, &runs, &opaque) != 0) {
+        return NULL;
+    }
+
+    return Py_BuildValue("IIkk", width, height, runs, opaque);
+}
+
+/**
+ * Python wrapper for the pyfb_sdrawSprite function.
+ *
+ * @param self The function
+ * @param args The arguments, expecting byte of the fbnum, byte of the spritenum, long of the x and long of the y
+ *
+ * @return Just 0
+ */
+static PyObject* pyfunc_pyfb_sdrawSprite(PyObject* self, PyObject* args) {
+    unsigned char fbnum_c;
+    unsigned char spritenum_c;
+    long int x;
+    long int y;
+
+    if(!PyArg_ParseTuple(args, "bbll", &fbnum_c, &spritenum_c, &x, &y)) {
+        PyErr_SetString(PyExc_TypeError, "Expecting arguments of type (byte, byte, long, long)");
+        return NULL;
+    }
+
+    PYFB_RECORD_BEGIN(record_start);
+    if(pyfb_sdrawSprite((uint8_t)fbnum_c, (uint8_t)spritenum_c, x, y) != 0) {
+        return NULL;
+    }
+
+    // the coordinates may be negative, so they are recorded in two's complement
+    PYFB_RECORD(PYFB_RECORD_SPRITE, (uint8_t)fbnum_c, record_start, spritenum_c, (uint64_t)(int64_t)x, (uint64_t)(int64_t)y);
+
+    int exitcode = 0;
+    return PyLong_FromLong(exitcode);
+}
+
+// The module def
+
+/**
+ * The method definitions.
+ */
+static PyMethodDef pyfb_methods[] = {
+    {"pyfb_open", pyfunc_pyfb_open, METH_VARARGS, "Framebuffer open function"},
+    {"pyfb_openVirtual", pyfunc_pyfb_openVirtual, METH_VARARGS, "Virtual framebuffer open function"},
+    {"pyfb_close", pyfunc_pyfb_close, METH_VARARGS, "Framebuffer close function"},
+    {"pyfb_setKeepAlive", pyfunc_pyfb_ssetKeepAlive, METH_VARARGS, "Set the keep-alive period of a framebuffer"},
+    {"pyfb_openShared", pyfunc_pyfb_sopenShared, METH_VARARGS, "Framebuffer open function with a shared offscreen buffer"},
+    {"pyfb_damage", pyfunc_pyfb_sdamage, METH_VARARGS, "Mark a rectangle to be written by the next flush"},
+    {"pyfb_waitDamage", pyfunc_pyfb_waitDamage, METH_VARARGS, "Wait for damage of a shared offscreen buffer"},
+    {"pyfb_setPixel", pyfunc_pyfb_ssetPixel, METH_VARARGS, "Draw a pixel on the framebuffer"},
+    {"pyfb_drawLine", pyfunc_pyfb_sdrawLine, METH_VARARGS, "Draw a line on the framebuffer"},
+    {"pyfb_drawHorizontalLine", pyfunc_pyfb_sdrawHorizontalLine, METH_VARARGS, "Draw a horizontal line on the framebuffer"},
+    {"pyfb_drawVerticalLine", pyfunc_pyfb_sdrawVerticalLine, METH_VARARGS, "Draw a vertical line on the framebuffer"},
+    {"pyfb_drawCircle", pyfunc_pyfb_sdrawCircle, METH_VARARGS, "Draw a circle on the framebuffer"},
+    {"pyfb_drawEllipse", pyfunc_pyfb_sdrawEllipse, METH_VARARGS, "Draw a ellipse on the framebuffer"},
+    {"pyfb_flushBuffer", pyfunc_pyfb_flushBuffer, METH_VARARGS, "Flush the offscreen buffer to the framebuffer"},
+    {"pyfb_getResolution", pyfunc_pyfb_getResolution, METH_VARARGS, "Returns a tupel of the framebuffer resolution"},
+    {"pyfb_copyArea", pyfunc_pyfb_scopyArea, METH_VARARGS, "Copy an area of the offscreen buffer to another position"},
+    {"pyfb_getCanvas", pyfunc_pyfb_getCanvas, METH_VARARGS, "Returns a tupel of the canvas size and viewport offset"},
+    {"pyfb_setCanvas", pyfunc_pyfb_ssetCanvas, METH_VARARGS, "Resize the canvas of the offscreen buffer"},
+    {"pyfb_setViewport", pyfunc_pyfb_ssetViewport, METH_VARARGS, "Move the viewport on the canvas"},
+    {"pyfb_setRotation", pyfunc_pyfb_ssetRotation, METH_VARARGS, "Rotate and mirror the canvas on the screen"},
+    {"pyfb_getRotation", pyfunc_pyfb_getRotation, METH_VARARGS, "Returns a tupel of the canvas rotation and flip"},
+    {"pyfb_getPixel", pyfunc_pyfb_sgetPixel, METH_VARARGS, "Returns the color value of a pixel of the offscreen buffer"},
+    {"pyfb_readRect", pyfunc_pyfb_sreadRect, METH_VARARGS, "Read an area of the offscreen buffer as RGBA8888 pixels"},
+    {"pyfb_writeRect", pyfunc_pyfb_suploadRect, METH_VARARGS, "Write RGBA8888 pixels to an area of the offscreen buffer"},
+    {"pyfb_blitTransformed", pyfunc_pyfb_sblitTransformed, METH_VARARGS, "Draw another framebuffer transformed by a matrix"},
+    {"pyfb_setPalette", pyfunc_pyfb_ssetPalette, METH_VARARGS, "Switch to an indexed canvas or change its palette"},
+    {"pyfb_clearPalette", pyfunc_pyfb_sclearPalette, METH_VARARGS, "Switch an indexed canvas back to the device format"},
+    {"pyfb_blitScalar", pyfunc_pyfb_sblitScalar, METH_VARARGS, "Draw an array of scalar values through a colormap"},
+    {"pyfb_drawPoints", pyfunc_pyfb_sdrawPoints, METH_VARARGS, "Draw the points of two coordinate arrays"},
+    {"pyfb_drawPolyline", pyfunc_pyfb_sdrawPolyline, METH_VARARGS, "Draw connected lines through a coordinate array"},
+    {"pyfb_fillTriangle", pyfunc_pyfb_sfillTriangle, METH_VARARGS, "Fill a flat or shaded triangle"},
+    {"pyfb_fillTriangles", pyfunc_pyfb_sfillTriangles, METH_VARARGS, "Fill a batch of flat or shaded triangles"},
+    {"pyfb_fillGradient", pyfunc_pyfb_sfillGradient, METH_VARARGS, "Fill a rectangle or an ellipse with a gradient"},
+    {"pyfb_capture", pyfunc_pyfb_scapture, METH_VARARGS, "Capture the screen as RGBA8888 pixels"},
+    {"pyfb_streamStart", pyfunc_pyfb_sstreamStart, METH_VARARGS, "Start streaming the flushed frames to a file descriptor"},
+    {"pyfb_streamStop", pyfunc_pyfb_sstreamStop, METH_VARARGS, "Stop streaming the flushed frames"},
+    {"pyfb_streamStats", pyfunc_pyfb_sstreamStats, METH_VARARGS, "Returns a tupel of the stream statistics"},
+    {"pyfb_mirrorAdd", pyfunc_pyfb_smirrorAdd, METH_VARARGS, "Add a framebuffer to the mirror group of a framebuffer"},
+    {"pyfb_mirrorRemove", pyfunc_pyfb_smirrorRemove, METH_VARARGS, "Remove a framebuffer from the mirror group of a framebuffer"},
+    {"pyfb_setStats", pyfunc_pyfb_ssetStats, METH_VARARGS, "Enable or disable the performance counters"},
+    {"pyfb_stats", pyfunc_pyfb_sstats, METH_VARARGS, "Returns a tupel of the performance counters"},
+    {"pyfb_traceStart", pyfunc_pyfb_traceStart, METH_NOARGS, "Start recording trace events"},
+    {"pyfb_traceStop", pyfunc_pyfb_traceStop, METH_NOARGS, "Stop recording trace events"},
+    {"pyfb_traceDump", pyfunc_pyfb_traceDump, METH_VARARGS, "Write the trace events as Chrome trace JSON"},
+    {"pyfb_recordStart", pyfunc_pyfb_recordStart, METH_VARARGS, "Start recording the draw calls to a file descriptor"},
+    {"pyfb_recordStop", pyfunc_pyfb_recordStop, METH_NOARGS, "Stop recording the draw calls"},
+    {"pyfb_replay", pyfunc_pyfb_sreplay, METH_VARARGS, "Replay a draw call recording on virtual framebuffers"},
+    {"pyfb_clockOpen", pyfunc_pyfb_sclockOpen, METH_VARARGS, "Open a frame clock for a framebuffer"},
+    {"pyfb_clockClose", pyfunc_pyfb_sclockClose, METH_VARARGS, "Close a frame clock"},
+    {"pyfb_clockMode", pyfunc_pyfb_sclockMode, METH_VARARGS, "Returns if a frame clock waits for vsync or a timer"},
+    {"pyfb_clockWait", pyfunc_pyfb_clockWait, METH_VARARGS, "Wait for the next frame of a frame clock"},
+    {"pyfb_clockStats", pyfunc_pyfb_sclockStats, METH_VARARGS, "Returns a tupel of the frame clock statistics"},
+    {"pyfb_asyncOpen", pyfunc_pyfb_sasyncOpen, METH_VARARGS, "Start the async worker of a framebuffer"},
+    {"pyfb_asyncClose", pyfunc_pyfb_sasyncClose, METH_VARARGS, "Stop the async worker of a framebuffer"},
+    {"pyfb_asyncFlush", pyfunc_pyfb_sasyncFlush, METH_VARARGS, "Request a flush from the async worker"},
+    {"pyfb_asyncTick", pyfunc_pyfb_sasyncTick, METH_VARARGS, "Request a frame clock wait from the async worker"},
+    {"pyfb_asyncPoll", pyfunc_pyfb_sasyncPoll, METH_VARARGS, "Returns the completion state of the async worker"},
+    {"pyfb_loadFont", pyfunc_pyfb_loadFont, METH_VARARGS, "Load a PSF1 or PSF2 font from the file content"},
+    {"pyfb_freeFont", pyfunc_pyfb_freeFont, METH_VARARGS, "Free a loaded font"},
+    {"pyfb_fontInfo", pyfunc_pyfb_fontInfo, METH_VARARGS, "Returns a tupel of the glyph size and count of a font"},
+    {"pyfb_measureText", pyfunc_pyfb_smeasureText, METH_VARARGS, "Returns a tupel of the size of a text"},
+    {"pyfb_drawText", pyfunc_pyfb_sdrawText, METH_VARARGS, "Draw a text on the framebuffer"},
+    {"pyfb_loadSprite", pyfunc_pyfb_loadSprite, METH_VARARGS, "Load a sprite from RGBA8888 pixels"},
+    {"pyfb_freeSprite", pyfunc_pyfb_freeSprite, METH_VARARGS, "Free a loaded sprite"},
+    {"pyfb_spriteInfo", pyfunc_pyfb_sspriteInfo, METH_VARARGS, "Returns a tupel of the size and runs of a sprite"},
+    {"pyfb_drawSprite", pyfunc_pyfb_sdrawSprite, METH_VARARGS, "Draw a sprite on the framebuffer"},
+    {NULL, NULL, 0, NULL}};
+
+/**
+ * Module exec function, callen for the module object of every interpreter.
+ *
+ * Initializes the shared structures once per process and defines the MAX_FRAMEBUFFERS,
+ * MAX_FONTS, MAX_CLOCKS, MAX_SPRITES, capture source, stream encoding, dump format, clock mode, flip, filter,
+ * palette size, colormap size, gradient and shape macros as constants in Python.
+ *
+ * @param module The module object
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+static int pyfb_moduleExec(PyObject* module) {
     pyfb_init();
 
     // Add the MAX_FRAMEBUFFERS macro to the constants
     PyModule_AddIntMacro(module, MAX_FRAMEBUFFERS);
+    PyModule_AddIntMacro(module, MAX_FONTS);
+    PyModule_AddIntMacro(module, MAX_CLOCKS);
+    PyModule_AddIntMacro(module, MAX_SPRITES);
+    PyModule_AddIntMacro(module, PYFB_CAPTURE_DEVICE);
+    PyModule_AddIntMacro(module, PYFB_CAPTURE_BUFFER);
+    PyModule_AddIntMacro(module, PYFB_STREAM_RAW);
+    PyModule_AddIntMacro(module, PYFB_STREAM_RLE);
+    PyModule_AddIntMacro(module, PYFB_STREAM_QOI);
+    PyModule_AddIntMacro(module, PYFB_STREAM_TILE);
+    PyModule_AddIntMacro(module, PYFB_DUMP_RAW);
+    PyModule_AddIntMacro(module, PYFB_DUMP_PPM);
+    PyModule_AddIntMacro(module, PYFB_CLOCK_VSYNC);
+    PyModule_AddIntMacro(module, PYFB_CLOCK_TIMER);
+    PyModule_AddIntMacro(module, PYFB_FLIP_X);
+    PyModule_AddIntMacro(module, PYFB_FLIP_Y);
+    PyModule_AddIntMacro(module, PYFB_FILTER_NEAREST);
+    PyModule_AddIntMacro(module, PYFB_FILTER_BILINEAR);
+    PyModule_AddIntMacro(module, PYFB_PALETTE_SIZE);
+    PyModule_AddIntMacro(module, PYFB_COLORMAP_SIZE);
+    PyModule_AddIntMacro(module, PYFB_GRADIENT_LINEAR);
+    PyModule_AddIntMacro(module, PYFB_GRADIENT_RADIAL);
+    PyModule_AddIntMacro(module, PYFB_GRADIENT_STOPS);
+    PyModule_AddIntMacro(module, PYFB_SHAPE_RECT);
+    PyModule_AddIntMacro(module, PYFB_SHAPE_ELLIPSE);
+
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+/**
+ * Module free function. Releases the references on the framebuffers which the
+ * interpreter did not close, e.g. if a subinterpreter ends while drawing.
+ *
+ * @param module The module object
+ */
+static void pyfb_moduleFree(void* module) {
+    if(pyfb_modstate((PyObject*)module) == NULL) {
+        return;
+    }
+
+    for(int i = 0; i < MAX_FRAMEBUFFERS; i++) {
+        while(pyfb_modrelease((PyObject*)module, (uint8_t)i)) {
+            pyfb_close((uint8_t)i);
+        }
+    }
+}
+
+/**
+ * Module slots. The framebuffers are shared by all interpreters and protected by
+ * their own locks, so the module supports subinterpreters with an own GIL and the
+ * free-threaded build.
+ */
+static PyModuleDef_Slot pyfb_slots[] = {{Py_mod_exec, pyfb_moduleExec},
+#if PY_VERSION_HEX >= 0x030C0000
+                                        {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+#if PY_VERSION_HEX >= 0x030D0000
+                                        {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+                                        {0, NULL}};
+
+static struct PyModuleDef module__pyfb = {PyModuleDef_HEAD_INIT,
+                                          "_pyfb",
+                                          "Native interface for the pyframebuffer C sources",
+                                          sizeof(struct pyfb_modulestate),
+                                          pyfb_methods,
+                                          pyfb_slots,
+                                          NULL,
+                                          NULL,
+                                          pyfb_moduleFree};
 
-    return module;
+/**
+ * Module init function, using the multi-phase initialization.
+ *
+ * @return The module definition
+ */
+PyMODINIT_FUNC PyInit__pyfb(void) {
+    return PyModuleDef_Init(&module__pyfb);
 }
\ No newline at end of file
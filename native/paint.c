@@ -79,6 +79,8 @@ void __APISTATUS_internal pyfb_drawLine(uint8_t fbnum,
     long int sy  = (li_y1 < li_y2) ? 1 : -1;
     long int err = dx - dy;
 
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), (dx > dy ? dx : dy) + 1);
+
     while(1) {
         pyfb_setPixel(fbnum, li_x1, li_y1, color);
 
@@ -105,6 +107,8 @@ void __APISTATUS_internal pyfb_sdrawLine(uint8_t fbnum,
                                          unsigned long int x2,
                                          unsigned long int y2,
                                          const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // first check if fbnum is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -123,10 +127,9 @@ void __APISTATUS_internal pyfb_sdrawLine(uint8_t fbnum,
     }
 
     // check if all values are valid
-    struct pyfb_videomode_info vinfo;
-    pyfb_vinfo(fbnum, &vinfo);
-    unsigned long int xres = vinfo.vinfo.xres;
-    unsigned long int yres = vinfo.vinfo.yres;
+    const struct pyfb_canvas* canvas = &pyfb_fbptr(fbnum)->canvas;
+    unsigned long int xres           = canvas->xres;
+    unsigned long int yres           = canvas->yres;
 
     if(x1 >= xres || y1 >= yres) {
         PyErr_SetString(PyExc_ValueError, "The x1y1 coordinate is not on the screen");
@@ -141,10 +144,12 @@ void __APISTATUS_internal pyfb_sdrawLine(uint8_t fbnum,
     }
 
     // all is valid, so draw the line
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_LINE);
     pyfb_drawLine(fbnum, x1, y1, x2, y2, color);
 
     // ready, so return
     pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawLine", fbnum, trace_start);
 }
 
 void __APISTATUS_internal pyfb_drawCircle(uint8_t fbnum,
@@ -162,17 +167,19 @@ void __APISTATUS_internal pyfb_drawCircle(uint8_t fbnum,
     long int x     = 0;
     long int y     = radius;
 
-    struct pyfb_videomode_info vinfo;
-    pyfb_vinfo(fbnum, &vinfo);
+    const struct pyfb_canvas* canvas = &pyfb_fbptr(fbnum)->canvas;
 
-    const long int xres = ULI_TO_LI(vinfo.vinfo.xres);
-    const long int yres = ULI_TO_LI(vinfo.vinfo.yres);
+    const long int xres = ULI_TO_LI(canvas->xres);
+    const long int yres = ULI_TO_LI(canvas->yres);
 
     SET_PIXEL_OR_IGNORE(fbnum, x0, y0 + rad, xres, yres, color);
     SET_PIXEL_OR_IGNORE(fbnum, x0, y0 - rad, xres, yres, color);
     SET_PIXEL_OR_IGNORE(fbnum, x0 + rad, y0, xres, yres, color);
     SET_PIXEL_OR_IGNORE(fbnum, x0 - rad, y0, xres, yres, color);
 
+    // the plotted points, including the clipped ones
+    unsigned long int points = 4;
+
     while(x < y) {
         if(f >= 0) {
             y -= 1;
@@ -192,7 +199,10 @@ void __APISTATUS_internal pyfb_drawCircle(uint8_t fbnum,
         SET_PIXEL_OR_IGNORE(fbnum, x0 - y, y0 + x, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, x0 + y, y0 - x, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, x0 - y, y0 - x, xres, yres, color);
+        points += 8;
     }
+
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), points);
 }
 
 void pyfb_sdrawCircle(uint8_t fbnum,
@@ -200,6 +210,8 @@ void pyfb_sdrawCircle(uint8_t fbnum,
                       unsigned long int ym,
                       unsigned long int radius,
                       struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // first check if fbnum is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -217,10 +229,12 @@ void pyfb_sdrawCircle(uint8_t fbnum,
         return;
     }
 
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_CIRCLE);
     pyfb_drawCircle(fbnum, xm, ym, radius, color);
 
     // ready, so return
     pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawCircle", fbnum, trace_start);
 }
 
 void __APISTATUS_internal pyfb_drawEllipse(uint8_t fbnum,
@@ -238,17 +252,20 @@ void __APISTATUS_internal pyfb_drawEllipse(uint8_t fbnum,
     long err    = b2 - (2 * bl - 1) * a2;
     long e2     = 0;
 
-    struct pyfb_videomode_info vinfo;
-    pyfb_vinfo(fbnum, &vinfo);
+    // the plotted points, including the clipped ones
+    unsigned long int points = 0;
+
+    const struct pyfb_canvas* canvas = &pyfb_fbptr(fbnum)->canvas;
 
-    const long int xres = ULI_TO_LI(vinfo.vinfo.xres);
-    const long int yres = ULI_TO_LI(vinfo.vinfo.yres);
+    const long int xres = ULI_TO_LI(canvas->xres);
+    const long int yres = ULI_TO_LI(canvas->yres);
 
     do {
         SET_PIXEL_OR_IGNORE(fbnum, xm + dx, ym + dy, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, xm - dx, ym + dy, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, xm - dx, ym - dy, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, xm + dx, ym - dy, xres, yres, color);
+        points += 4;
         e2 = 2 * err;
 
         if(e2 < (2 * dx + 1) * b2) {
@@ -265,7 +282,10 @@ void __APISTATUS_internal pyfb_drawEllipse(uint8_t fbnum,
     while(dx++ < a) {
         SET_PIXEL_OR_IGNORE(fbnum, xm + dx, ym, xres, yres, color);
         SET_PIXEL_OR_IGNORE(fbnum, xm - dx, ym, xres, yres, color);
+        points += 2;
     }
+
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), points);
 }
 
 void pyfb_sdrawEllipse(uint8_t fbnum,
@@ -274,6 +294,8 @@ void pyfb_sdrawEllipse(uint8_t fbnum,
                        unsigned long int a,
                        unsigned long int b,
                        struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
     // fist check if fbnum is valid
     if(fbnum >= MAX_FRAMEBUFFERS) {
         PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
@@ -291,8 +313,10 @@ void pyfb_sdrawEllipse(uint8_t fbnum,
         return;
     }
 
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_ELLIPSE);
     pyfb_drawEllipse(fbnum, xm, ym, a, b, color);
 
     // ready, so return
     pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawEllipse", fbnum, trace_start);
 }
\ No newline at end of file
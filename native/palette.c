@@ -0,0 +1,263 @@
+/**
+ * Indexed canvas sources.
+ */
+#include "pyframebuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The amount of rows a flush expands at once. The chunk of device rows stays in the
+ * cache until it is written.
+ */
+#define PYFB_PALETTE_ROWS 16
+
+/**
+ * The palette of an indexed canvas.
+ */
+struct pyfb_palette {
+    /**
+     * The color values in 32 bits, as set.
+     */
+    uint32_t colors[PYFB_PALETTE_SIZE];
+
+    /**
+     * The colors in the 32 bit pixel format.
+     */
+    uint32_t lut32[PYFB_PALETTE_SIZE];
+
+    /**
+     * The colors in the 16 bit pixel format.
+     */
+    uint16_t lut16[PYFB_PALETTE_SIZE];
+
+    /**
+     * The device rows of a chunk of the flush, @c PYFB_PALETTE_ROWS rows of the screen width,
+     * allocated behind the structure.
+     */
+    uint8_t* rows;
+};
+
+/**
+ * Expands palette indices to 32 bit pixels. The loop is a plain table gather, which the
+ * compiler vectorizes where the target has gather instructions.
+ *
+ * @param src The palette indices
+ * @param dst The destination pixels
+ * @param lut The colors in the pixel format
+ * @param count The amount of pixels
+ */
+static void pyfb_expand32(const uint8_t* restrict src, uint32_t* restrict dst, const uint32_t* restrict lut, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+/**
+ * Expands palette indices to 16 bit pixels. See pyfb_expand32.
+ */
+static void pyfb_expand16(const uint8_t* restrict src, uint16_t* restrict dst, const uint16_t* restrict lut, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+/**
+ * Sets the colors of a palette and rebuilds its lookup tables.
+ *
+ * @param palette The palette
+ * @param colors The color values in 32 bits
+ * @param count The amount of colors, the entries after them are black
+ */
+static void pyfb_paletteFill(struct pyfb_palette* palette, const uint32_t* colors, unsigned int count) {
+    for(unsigned int i = 0; i < PYFB_PALETTE_SIZE; i++) {
+        uint32_t value     = i < count ? colors[i] : 0;
+        palette->colors[i] = value;
+        palette->lut32[i]  = value;
+        palette->lut16[i]  = pyfb_rgb565(value);
+    }
+}
+
+const uint32_t* __APISTATUS_internal pyfb_paletteColors(uint8_t fbnum) {
+    return pyfb_fbptr(fbnum)->palette->colors;
+}
+
+void __APISTATUS_internal pyfb_expandIndexed(uint8_t fbnum, const uint8_t* src, void* dst, size_t count) {
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->fb_info.vinfo.bits_per_pixel == 16) {
+        pyfb_expand16(src, (uint16_t*)dst, fb->palette->lut16, count);
+    } else {
+        pyfb_expand32(src, (uint32_t*)dst, fb->palette->lut32, count);
+    }
+}
+
+ssize_t __APISTATUS_internal pyfb_writeIndexed(uint8_t fbnum, const struct pyfb_damage* damage) {
+    const struct pyfb_framebuffer* fb     = pyfb_fbptr(fbnum);
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+
+    size_t bytes           = vinfo->bits_per_pixel / 8;
+    size_t width           = damage->x1 - damage->x0;
+    size_t row_len         = width * bytes;
+    size_t line_length     = fb->fb_line_length;
+    unsigned long int rows = damage->y1 - damage->y0;
+    uint8_t* out           = fb->palette->rows;
+    const uint8_t* src     = fb->u8_buffer + (fb->canvas.yoffset + damage->y0) * fb->canvas.xres + fb->canvas.xoffset + damage->x0;
+    off_t offset           = (off_t)((vinfo->yoffset + damage->y0) * line_length + (vinfo->xoffset + damage->x0) * bytes);
+
+    for(unsigned long int row = 0; row < rows; row += PYFB_PALETTE_ROWS) {
+        unsigned long int count = rows - row < PYFB_PALETTE_ROWS ? rows - row : PYFB_PALETTE_ROWS;
+
+        for(unsigned long int i = 0; i < count; i++) {
+            pyfb_expandIndexed(fbnum, src + (row + i) * fb->canvas.xres, out + i * row_len, width);
+        }
+
+        off_t chunk = offset + (off_t)(row * line_length);
+
+        if(row_len == line_length) {
+            // the device rows are contiguous, so write the chunk at once
+            size_t len = row_len * count;
+            if(pwrite(fb->fb_fd, out, len, chunk) != (ssize_t)len) {
+                return -1;
+            }
+            continue;
+        }
+
+        for(unsigned long int i = 0; i < count; i++) {
+            if(pwrite(fb->fb_fd, out + i * row_len, row_len, chunk + (off_t)(i * line_length)) != (ssize_t)row_len) {
+                return -1;
+            }
+        }
+    }
+
+    return (ssize_t)(row_len * rows);
+}
+
+int pyfb_ssetPalette(uint8_t fbnum, const uint32_t* colors, unsigned int count) {
+    // first check if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(count == 0 || count > PYFB_PALETTE_SIZE) {
+        PyErr_SetString(PyExc_ValueError, "The palette must have 1 to 256 colors");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette != NULL) {
+        // only swap the colors, the next flush recolors the whole screen
+        pyfb_paletteFill(fb->palette, colors, count);
+
+        unsigned long int xres, yres;
+        pyfb_screenSize(fbnum, &xres, &yres);
+        struct pyfb_damage screen = {0, 0, xres, yres};
+        fb->damage                = screen;
+        PYFB_STAT_CALL(fb, PYFB_STAT_PALETTE);
+
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    const char* error = NULL;
+
+    if(fb->shared != NULL) {
+        error = "A shared offscreen buffer can not be indexed";
+    } else if(fb->stream != NULL || fb->mirror != NULL || fb->mirror_source != 0) {
+        error = "A streamed or mirrored framebuffer can not be indexed";
+    } else if(fb->canvas.rotation != 0 || fb->canvas.flip != 0) {
+        error = "A rotated canvas can not be indexed";
+    } else if(fb->canvas.panning) {
+        error = "A canvas panned by the driver can not be indexed";
+    }
+
+    if(error != NULL) {
+        PyErr_SetString(PyExc_IOError, error);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the palette with the chunk of device rows, and the canvas of one byte per pixel
+    size_t rows_len              = (size_t)fb->fb_info.vinfo.xres * (fb->fb_info.vinfo.bits_per_pixel / 8) * PYFB_PALETTE_ROWS;
+    unsigned long int fb_size_b  = fb->canvas.xres * fb->canvas.yres;
+    struct pyfb_palette* palette = (struct pyfb_palette*)malloc(sizeof(struct pyfb_palette) + rows_len);
+    uint8_t* buffer              = (uint8_t*)calloc(fb_size_b, 1);
+
+    if(palette == NULL || buffer == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
+        free(palette);
+        free(buffer);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    palette->rows = (uint8_t*)(palette + 1);
+    pyfb_paletteFill(palette, colors, count);
+
+    free(fb->u32_buffer);
+    fb->u8_buffer         = buffer;
+    fb->palette           = palette;
+    fb->fb_info.fb_size_b = fb_size_b;
+    memset((void*)&fb->damage, 0, sizeof(struct pyfb_damage));
+    PYFB_STAT_CALL(fb, PYFB_STAT_PALETTE);
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+int pyfb_sclearPalette(uint8_t fbnum) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette == NULL) {
+        PyErr_SetString(PyExc_IOError, "The canvas is not indexed");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // a fresh offscreen buffer in the pixel format of the device
+    unsigned long int fb_size_b = fb->canvas.xres * fb->canvas.yres * (fb->fb_info.vinfo.bits_per_pixel / 8);
+    void* buffer                = calloc(fb_size_b, 1);
+
+    if(buffer == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    free(fb->u8_buffer);
+    free(fb->palette);
+    fb->u32_buffer        = (uint32_t*)buffer;
+    fb->palette           = NULL;
+    fb->fb_info.fb_size_b = fb_size_b;
+    memset((void*)&fb->damage, 0, sizeof(struct pyfb_damage));
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
@@ -0,0 +1,444 @@
+/**
+ * Point and polyline sources, drawing coordinate arrays.
+ */
+#include "pyframebuffer.h"
+
+#include <math.h>
+
+/**
+ * The coordinates are clamped to this distance from the origin, so the differences of the
+ * line algorithm stay in the range of a 32 bit long.
+ */
+#define PYFB_PLOT_LIMIT (1L << 28)
+
+/**
+ * The canvas a coordinate array is drawn to.
+ */
+struct pyfb_plot {
+    /**
+     * The offscreen buffer.
+     */
+    uint8_t* buffer;
+
+    /**
+     * The bytes per pixel, 1 for an indexed canvas.
+     */
+    size_t bytes;
+
+    /**
+     * The canvas width, the stride of the buffer.
+     */
+    long int xres;
+
+    /**
+     * The canvas height.
+     */
+    long int yres;
+
+    /**
+     * The color in the pixel format.
+     */
+    uint32_t value;
+
+    /**
+     * The amount of written pixels.
+     */
+    unsigned long int pixels;
+};
+
+/**
+ * The state of a polyline while its points are drawn.
+ */
+struct pyfb_trace {
+    /**
+     * If 1 a line leads from the last point to the next group.
+     */
+    int connected;
+
+    /**
+     * The last drawn point.
+     */
+    long int px, py;
+
+    /**
+     * If 1 a group of points is open.
+     */
+    int open;
+
+    /**
+     * The column of the open group.
+     */
+    long int gx;
+
+    /**
+     * The first, the last, the minimum and the maximum row of the open group.
+     */
+    long int gfirst, glast, gmin, gmax;
+};
+
+/**
+ * Reads a coordinate of a coordinate array, rounded and clamped.
+ *
+ * @param data The coordinates
+ * @param type The type of the coordinates
+ * @param i The index of the coordinate
+ * @param value The coordinate
+ *
+ * @return 1 if the coordinate is valid, 0 if it is NaN
+ */
+static inline int pyfb_plotCoord(const void* data, int type, size_t i, long int* value) {
+    double v = pyfb_scalarValue(data, type, i);
+
+    if(isnan(v)) {
+        return 0;
+    }
+
+    v      = v > (double)-PYFB_PLOT_LIMIT ? v : (double)-PYFB_PLOT_LIMIT;
+    v      = v < (double)PYFB_PLOT_LIMIT ? v : (double)PYFB_PLOT_LIMIT;
+    *value = (long int)floor(v + 0.5);
+    return 1;
+}
+
+/**
+ * Writes a pixel on the canvas, without checking the coordinates.
+ */
+static inline void pyfb_plotPixel(struct pyfb_plot* plot, long int x, long int y) {
+    size_t offset = (size_t)y * (size_t)plot->xres + (size_t)x;
+
+    if(plot->bytes == 4) {
+        ((uint32_t*)plot->buffer)[offset] = plot->value;
+    } else if(plot->bytes == 2) {
+        ((uint16_t*)plot->buffer)[offset] = (uint16_t)plot->value;
+    } else {
+        plot->buffer[offset] = (uint8_t)plot->value;
+    }
+
+    plot->pixels++;
+}
+
+/**
+ * Writes a pixel on the canvas, if it is on the canvas.
+ */
+static inline void pyfb_plotPoint(struct pyfb_plot* plot, long int x, long int y) {
+    if(x >= 0 && y >= 0 && x < plot->xres && y < plot->yres) {
+        pyfb_plotPixel(plot, x, y);
+    }
+}
+
+/**
+ * Clips a line to the canvas with the Liang-Barsky algorithm. Only used for the lines
+ * much longer than the canvas, so the rounding of the clipped ends is not visible.
+ *
+ * @return 1 if a part of the line is on the canvas, else 0
+ */
+static int pyfb_plotClip(const struct pyfb_plot* plot, long int* x0, long int* y0, long int* x1, long int* y1) {
+    double dx   = (double)(*x1 - *x0);
+    double dy   = (double)(*y1 - *y0);
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {(double)*x0, (double)(plot->xres - 1 - *x0), (double)*y0, (double)(plot->yres - 1 - *y0)};
+    double t0   = 0.0;
+    double t1   = 1.0;
+
+    for(int i = 0; i < 4; i++) {
+        if(p[i] == 0.0) {
+            if(q[i] < 0.0) {
+                return 0;
+            }
+            continue;
+        }
+
+        double t = q[i] / p[i];
+        if(p[i] < 0.0) {
+            t0 = t > t0 ? t : t0;
+        } else {
+            t1 = t < t1 ? t : t1;
+        }
+    }
+
+    if(t0 > t1) {
+        return 0;
+    }
+
+    long int sx = *x0;
+    long int sy = *y0;
+    *x0         = sx + (long int)floor(t0 * dx + 0.5);
+    *y0         = sy + (long int)floor(t0 * dy + 0.5);
+    *x1         = sx + (long int)floor(t1 * dx + 0.5);
+    *y1         = sy + (long int)floor(t1 * dy + 0.5);
+    return 1;
+}
+
+/**
+ * Draws a line with the algorithm of pyfb_drawLine, clipped at the edges of the canvas.
+ *
+ * @param plot The canvas
+ * @param x0 The x coordinate of the start
+ * @param y0 The y coordinate of the start
+ * @param x1 The x coordinate of the end
+ * @param y1 The y coordinate of the end
+ * @param skip If 1 the start pixel is not written, as the previous line wrote it
+ */
+static void pyfb_plotLine(struct pyfb_plot* plot, long int x0, long int y0, long int x1, long int y1, int skip) {
+    long int xr = plot->xres;
+    long int yr = plot->yres;
+
+    // entirely beside the canvas
+    if((x0 < 0 && x1 < 0) || (y0 < 0 && y1 < 0) || (x0 >= xr && x1 >= xr) || (y0 >= yr && y1 >= yr)) {
+        return;
+    }
+
+    long int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    long int dy = y1 > y0 ? y1 - y0 : y0 - y1;
+
+    if((dx > dy ? dx : dy) > 2 * (xr + yr)) {
+        // stepping the parts off the canvas would cost more than the visible part
+        long int cx0 = x0, cy0 = y0;
+        if(!pyfb_plotClip(plot, &x0, &y0, &x1, &y1)) {
+            return;
+        }
+
+        skip = skip && cx0 == x0 && cy0 == y0;
+        dx   = x1 > x0 ? x1 - x0 : x0 - x1;
+        dy   = y1 > y0 ? y1 - y0 : y0 - y1;
+    }
+
+    long int sx  = x0 < x1 ? 1 : -1;
+    long int sy  = y0 < y1 ? 1 : -1;
+    long int err = dx - dy;
+
+    while(1) {
+        if(!skip) {
+            pyfb_plotPoint(plot, x0, y0);
+        }
+        skip = 0;
+
+        if(x0 == x1 && y0 == y1) {
+            break;
+        }
+
+        long int e2 = 2 * err;
+        if(e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+
+        if(e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+/**
+ * Draws a vertical line, clipped at the edges of the canvas.
+ *
+ * @param plot The canvas
+ * @param x The column
+ * @param y0 The first row
+ * @param y1 The last row, included
+ */
+static void pyfb_plotSpan(struct pyfb_plot* plot, long int x, long int y0, long int y1) {
+    if(x < 0 || x >= plot->xres) {
+        return;
+    }
+
+    y0 = y0 > 0 ? y0 : 0;
+    y1 = y1 < plot->yres - 1 ? y1 : plot->yres - 1;
+
+    for(long int y = y0; y <= y1; y++) {
+        pyfb_plotPixel(plot, x, y);
+    }
+}
+
+/**
+ * Draws the open group of a polyline: the line from the last point to its first point,
+ * and the rest of its column from its minimum to its maximum.
+ */
+static void pyfb_traceFlush(struct pyfb_plot* plot, struct pyfb_trace* trace) {
+    if(!trace->open) {
+        return;
+    }
+
+    if(trace->connected) {
+        pyfb_plotLine(plot, trace->px, trace->py, trace->gx, trace->gfirst, 1);
+    } else {
+        pyfb_plotPoint(plot, trace->gx, trace->gfirst);
+    }
+
+    pyfb_plotSpan(plot, trace->gx, trace->gmin, trace->gfirst - 1);
+    pyfb_plotSpan(plot, trace->gx, trace->gfirst + 1, trace->gmax);
+
+    trace->connected = 1;
+    trace->open      = 0;
+    trace->px        = trace->gx;
+    trace->py        = trace->glast;
+}
+
+/**
+ * Draws a polyline. See pyfb_sdrawPolyline.
+ */
+static void pyfb_plotPolyline(struct pyfb_plot* plot, const void* points, int type, size_t count, int decimate) {
+    struct pyfb_trace trace = {0};
+
+    for(size_t i = 0; i < count; i++) {
+        long int x, y;
+
+        if(!pyfb_plotCoord(points, type, 2 * i, &x) || !pyfb_plotCoord(points, type, 2 * i + 1, &y)) {
+            // a gap in the polyline
+            pyfb_traceFlush(plot, &trace);
+            trace.connected = 0;
+            continue;
+        }
+
+        if(decimate && trace.open && x == trace.gx) {
+            trace.gmin  = y < trace.gmin ? y : trace.gmin;
+            trace.gmax  = y > trace.gmax ? y : trace.gmax;
+            trace.glast = y;
+            continue;
+        }
+
+        pyfb_traceFlush(plot, &trace);
+        trace.open   = 1;
+        trace.gx     = x;
+        trace.gfirst = y;
+        trace.glast  = y;
+        trace.gmin   = y;
+        trace.gmax   = y;
+    }
+
+    pyfb_traceFlush(plot, &trace);
+}
+
+/**
+ * Locks an opened framebuffer and prepares the canvas of a coordinate array.
+ *
+ * @param fbnum The framebuffer number
+ * @param color The color
+ * @param plot The canvas to prepare
+ *
+ * @return 0 with the framebuffer locked, else -1 with a Python exception set
+ */
+static int pyfb_plotBegin(uint8_t fbnum, const struct pyfb_color* color, struct pyfb_plot* plot) {
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    plot->buffer = fb->u8_buffer;
+    plot->xres   = (long int)fb->canvas.xres;
+    plot->yres   = (long int)fb->canvas.yres;
+    plot->pixels = 0;
+
+    if(fb->palette != NULL) {
+        plot->bytes = 1;
+        plot->value = color->u32_color;
+    } else if(fb->fb_info.vinfo.bits_per_pixel == 16) {
+        plot->bytes = 2;
+        plot->value = color->u16_color;
+    } else {
+        plot->bytes = 4;
+        plot->value = color->u32_color;
+    }
+
+    return 0;
+}
+
+int pyfb_sdrawPoints(uint8_t fbnum,
+                     const void* xs,
+                     size_t xs_len,
+                     int xtype,
+                     const void* ys,
+                     size_t ys_len,
+                     int ytype,
+                     const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    size_t xitem = pyfb_scalarSize(xtype);
+    size_t yitem = pyfb_scalarSize(ytype);
+
+    if(xitem == 0 || yitem == 0) {
+        PyErr_SetString(PyExc_ValueError, "The coordinate type is not valid");
+        return -1;
+    }
+
+    size_t count = xs_len / xitem;
+    if(xs_len % xitem != 0 || ys_len % yitem != 0 || ys_len / yitem != count) {
+        PyErr_SetString(PyExc_ValueError, "The coordinate arrays must have the same length");
+        return -1;
+    }
+
+    struct pyfb_plot plot;
+    if(pyfb_plotBegin(fbnum, color, &plot) != 0) {
+        return -1;
+    }
+
+    // the arrays are held by the caller, so draw without the GIL
+    Py_BEGIN_ALLOW_THREADS;
+
+    for(size_t i = 0; i < count; i++) {
+        long int x, y;
+        if(pyfb_plotCoord(xs, xtype, i, &x) && pyfb_plotCoord(ys, ytype, i, &y)) {
+            pyfb_plotPoint(&plot, x, y);
+        }
+    }
+
+    Py_END_ALLOW_THREADS;
+
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_POINTS);
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), plot.pixels);
+
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawPoints", fbnum, trace_start);
+    return 0;
+}
+
+int pyfb_sdrawPolyline(uint8_t fbnum,
+                       const void* points,
+                       size_t points_len,
+                       int type,
+                       int decimate,
+                       const struct pyfb_color* color) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    size_t item = pyfb_scalarSize(type);
+
+    if(item == 0) {
+        PyErr_SetString(PyExc_ValueError, "The coordinate type is not valid");
+        return -1;
+    }
+
+    if(points_len % (2 * item) != 0) {
+        PyErr_SetString(PyExc_ValueError, "The coordinates must be pairs of x and y");
+        return -1;
+    }
+
+    struct pyfb_plot plot;
+    if(pyfb_plotBegin(fbnum, color, &plot) != 0) {
+        return -1;
+    }
+
+    // the array is held by the caller, so draw without the GIL
+    Py_BEGIN_ALLOW_THREADS;
+    pyfb_plotPolyline(&plot, points, type, points_len / (2 * item), decimate);
+    Py_END_ALLOW_THREADS;
+
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_POLYLINE);
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), plot.pixels);
+
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawPolyline", fbnum, trace_start);
+    return 0;
+}
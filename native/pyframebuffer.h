@@ -4,10 +4,12 @@
 #ifndef _pyframebuffer_included
 #define _pyframebuffer_included
 
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <linux/fb.h>
 #include <stdatomic.h>
 #include <stdint.h>
+#include <string.h>
 
 // decorators for marking functions and variables
 
@@ -73,6 +75,26 @@ typedef atomic_flag lock_t;
  */
 #define MAX_FRAMEBUFFERS 32
 
+/**
+ * The state of a frame stream, defined in the stream sources.
+ */
+struct pyfb_stream;
+
+/**
+ * The state of a framebuffer with a shared offscreen buffer, defined in the shared sources.
+ */
+struct pyfb_shared;
+
+/**
+ * The mirror group of a source framebuffer, defined in the mirror sources.
+ */
+struct pyfb_mirror;
+
+/**
+ * The palette of an indexed canvas, defined in the palette sources.
+ */
+struct pyfb_palette;
+
 /**
  * Used for storing the videomode information.
  */
@@ -83,11 +105,188 @@ struct pyfb_videomode_info {
     struct fb_var_screeninfo vinfo;
 
     /**
-     * The size of the framebuffer in bytes.
+     * The size of the offscreen buffer in bytes.
      */
     unsigned long int fb_size_b;
 };
 
+/**
+ * The canvas of a framebuffer. The offscreen buffer holds the canvas, which
+ * is at least as large as the visible screen. All drawing operations address
+ * the canvas, and the viewport at the canvas offset is what is visible on the
+ * screen.
+ */
+struct pyfb_canvas {
+    /**
+     * The canvas width in pixel, also the length of one offscreen buffer row.
+     */
+    unsigned long int xres;
+
+    /**
+     * The canvas height in pixel.
+     */
+    unsigned long int yres;
+
+    /**
+     * The x offset of the viewport on the canvas.
+     */
+    unsigned long int xoffset;
+
+    /**
+     * The y offset of the viewport on the canvas.
+     */
+    unsigned long int yoffset;
+
+    /**
+     * 1 if the canvas has the layout of the device memory and the viewport is
+     * moved by the driver with @c FBIOPAN_DISPLAY , else 0 if the viewport is
+     * copied to the device by the flush.
+     */
+    int panning;
+
+    /**
+     * The clockwise rotation of the canvas on the screen in quarter turns, 0 to 3. If it
+     * is odd, the canvas is drawn in portrait on a landscape screen or vice versa.
+     */
+    int rotation;
+
+    /**
+     * The mirroring of the canvas before the rotation, @c PYFB_FLIP_X and @c PYFB_FLIP_Y bits.
+     */
+    int flip;
+};
+
+/**
+ * A damaged rectangle of the screen, which the next flush must write. The rectangle
+ * is empty if x1 is not larger than x0.
+ */
+struct pyfb_damage {
+    /**
+     * The left edge.
+     */
+    unsigned long int x0;
+
+    /**
+     * The top edge.
+     */
+    unsigned long int y0;
+
+    /**
+     * The right edge, exclusive.
+     */
+    unsigned long int x1;
+
+    /**
+     * The bottom edge, exclusive.
+     */
+    unsigned long int y1;
+};
+
+/**
+ * The primitive types counted by the performance counters.
+ */
+enum pyfb_statprimitive {
+    PYFB_STAT_PIXEL,
+    PYFB_STAT_HLINE,
+    PYFB_STAT_VLINE,
+    PYFB_STAT_LINE,
+    PYFB_STAT_CIRCLE,
+    PYFB_STAT_ELLIPSE,
+    PYFB_STAT_COPYAREA,
+    PYFB_STAT_TEXT,
+    PYFB_STAT_WRITERECT,
+    PYFB_STAT_BLIT,
+    PYFB_STAT_SPRITE,
+    PYFB_STAT_PALETTE,
+    PYFB_STAT_SCALAR,
+    PYFB_STAT_POINTS,
+    PYFB_STAT_POLYLINE,
+    PYFB_STAT_TRIANGLE,
+    PYFB_STAT_GRADIENT,
+
+    /**
+     * The count of primitive types.
+     */
+    PYFB_STAT_PRIMITIVES
+};
+
+/**
+ * The count of buckets of the flush latency histogram. Bucket 0 counts the flushes
+ * faster than 1 microsecond, bucket i the flushes faster than 2^i microseconds, and
+ * the last bucket all slower flushes.
+ */
+#define PYFB_STAT_BUCKETS 24
+
+/**
+ * The performance counters of a framebuffer. The counters are only updated if they
+ * are enabled, with relaxed atomic operations, so they can be read at any time.
+ */
+struct pyfb_stats {
+    /**
+     * The draw calls per primitive type.
+     */
+    atomic_ulong calls[PYFB_STAT_PRIMITIVES];
+
+    /**
+     * The pixels written to the offscreen buffer.
+     */
+    atomic_ulong pixels;
+
+    /**
+     * The count of flushes.
+     */
+    atomic_ulong flushes;
+
+    /**
+     * The bytes written to the device by the flushes.
+     */
+    atomic_ullong flush_bytes;
+
+    /**
+     * The sum of the flush latencies in nanoseconds.
+     */
+    atomic_ullong flush_ns;
+
+    /**
+     * The flush latency histogram.
+     */
+    atomic_ulong flush_hist[PYFB_STAT_BUCKETS];
+};
+
+/**
+ * A snapshot of the performance counters, see pyfb_stats.
+ */
+struct pyfb_statsinfo {
+    unsigned long int calls[PYFB_STAT_PRIMITIVES];
+    unsigned long int pixels;
+    unsigned long int flushes;
+    unsigned long long int flush_bytes;
+    unsigned long long int flush_ns;
+    unsigned long int flush_hist[PYFB_STAT_BUCKETS];
+};
+
+/**
+ * Counts a draw call of a primitive type, if the counters of the framebuffer are enabled.
+ *
+ * @param fb The framebuffer structure
+ * @param primitive The primitive type
+ */
+#define PYFB_STAT_CALL(fb, primitive)                                                      \
+    if(__builtin_expect((fb)->stats_enabled, 0)) {                                         \
+        atomic_fetch_add_explicit(&(fb)->stats.calls[primitive], 1, memory_order_relaxed); \
+    }
+
+/**
+ * Counts written pixels, if the counters of the framebuffer are enabled.
+ *
+ * @param fb The framebuffer structure
+ * @param count The count of pixels
+ */
+#define PYFB_STAT_PIXELS(fb, count)                                                    \
+    if(__builtin_expect((fb)->stats_enabled, 0)) {                                     \
+        atomic_fetch_add_explicit(&(fb)->stats.pixels, (count), memory_order_relaxed); \
+    }
+
 /**
  * Used for store framebuffer information internally.
  */
@@ -101,10 +300,16 @@ struct pyfb_framebuffer {
     /**
      * The offscreen buffer for the framebuffer. The buffer to use of these
      * in this union depend on the framebuffer depth. To get the framebuffer
-     * depth, use the @c pyfb_videomode_info.vinfo.bits_per_pixel field.
+     * depth, use the @c pyfb_videomode_info.vinfo.bits_per_pixel field. An
+     * indexed canvas always uses @c u8_buffer .
      */
     union {
 
+        /**
+         * Used if the canvas is indexed, one palette index per pixel.
+         */
+        uint8_t* u8_buffer;
+
         /**
          * Used if the framebuffer depth (color bits) is 16bit.
          */
@@ -121,11 +326,112 @@ struct pyfb_framebuffer {
      */
     int fb_fd;
 
+    /**
+     * The length of one row of the device memory in bytes.
+     */
+    unsigned long int fb_line_length;
+
+    /**
+     * The length of the whole device memory in bytes.
+     */
+    unsigned long int fb_mem_len;
+
+    /**
+     * The read only mapping of the device memory, or NULL if not mapped yet.
+     */
+    void* fb_map;
+
+    /**
+     * The canvas of the offscreen buffer.
+     */
+    struct pyfb_canvas canvas;
+
+    /**
+     * The frame streaming stage, or NULL if the framebuffer is not streamed.
+     */
+    struct pyfb_stream* stream;
+
+    /**
+     * The shared offscreen buffer state, or NULL if the offscreen buffer is private.
+     */
+    struct pyfb_shared* shared;
+
+    /**
+     * The damage marked since the last flush. An empty damage flushes the whole viewport.
+     */
+    struct pyfb_damage damage;
+
+    /**
+     * The mirror group the flushes are converted to, or NULL if the framebuffer is not mirrored.
+     */
+    struct pyfb_mirror* mirror;
+
+    /**
+     * The number of the source framebuffer plus 1 if this framebuffer is a mirror member, else 0.
+     */
+    int mirror_source;
+
+    /**
+     * The buffer a rotated flush assembles the device rows in, or NULL if the canvas is not rotated.
+     */
+    void* rotate_buffer;
+
+    /**
+     * The palette of an indexed canvas, or NULL if the canvas has the pixel format of the device.
+     */
+    struct pyfb_palette* palette;
+
+    /**
+     * Set to 1 if the performance counters are enabled.
+     */
+    int stats_enabled;
+
+    /**
+     * The performance counters.
+     */
+    struct pyfb_stats stats;
+
+    /**
+     * Set to 1 if the framebuffer is a virtual framebuffer backed by memory.
+     */
+    int fb_virtual;
+
+    /**
+     * The file descriptor the flushed frames are dumped to, or -1.
+     */
+    int dump_fd;
+
+    /**
+     * The dump format, @c PYFB_DUMP_RAW or @c PYFB_DUMP_PPM.
+     */
+    int dump_format;
+
+    /**
+     * The buffer a PPM frame is assembled in, or NULL.
+     */
+    uint8_t* dump_buffer;
+
     /**
      * The count of users of this framebuffer.
      */
     unsigned long int users;
 
+    /**
+     * The keep-alive period after the last user closed the framebuffer in nanoseconds, or 0.
+     */
+    uint64_t keepalive_ns;
+
+    /**
+     * The time the framebuffer kept alive without users is released at.
+     */
+    uint64_t idle_until;
+
+    /**
+     * Not 0 if the offscreen buffer of a framebuffer kept alive still holds the frame of
+     * its previous user. The reaper thread clears it, else the next open does.
+     */
+    int stale;
+
     /**
      * The lock on this framebuffer.
      */
@@ -147,6 +453,147 @@ struct pyfb_color {
     uint16_t u16_color;
 };
 
+/**
+ * The maximum amount of fonts that can be loaded at the same time.
+ */
+#define MAX_FONTS 16
+
+/**
+ * The amount of colors for which the expanded glyphs of a font are cached.
+ * If a new color is requested and all slots are taken, the least recently
+ * used slot is reused.
+ */
+#define PYFB_GLYPHCACHE_SLOTS 4
+
+/**
+ * A cache slot holding the glyphs of a font expanded to the pixel format of
+ * a framebuffer for one specific color combination.
+ */
+struct pyfb_glyphcache {
+    /**
+     * The foreground color value in the pixel format of the cache.
+     */
+    uint32_t fg;
+
+    /**
+     * The background color value in the pixel format of the cache. Unused if
+     * the cache slot is transparent.
+     */
+    uint32_t bg;
+
+    /**
+     * 1 if the glyphs are painted with the background color, else 0 if the
+     * background is transparent.
+     */
+    int opaque;
+
+    /**
+     * The pixel depth of the cached glyphs, 16 or 32. If 0, this slot is unused.
+     */
+    unsigned int depth;
+
+    /**
+     * The expanded glyph pixels, @c width*height pixels per glyph.
+     */
+    void* pixels;
+
+    /**
+     * Marks per glyph if it has allready been expanded into @c pixels .
+     */
+    uint8_t* expanded;
+
+    /**
+     * The time of the last usage, used to find the least recently used slot.
+     */
+    unsigned long int stamp;
+};
+
+/**
+ * A loaded bitmap font in the PSF1 or PSF2 format.
+ */
+struct pyfb_font {
+    /**
+     * The glyph width in pixel.
+     */
+    unsigned int width;
+
+    /**
+     * The glyph height in pixel.
+     */
+    unsigned int height;
+
+    /**
+     * The amount of bytes of one glyph row in @c glyphs .
+     */
+    unsigned int bytes_per_row;
+
+    /**
+     * The amount of glyphs in the font.
+     */
+    unsigned int numglyphs;
+
+    /**
+     * The glyph to use for characters not available in the font.
+     */
+    unsigned int fallback;
+
+    /**
+     * The 1bpp glyph bitmaps, MSB first, @c bytes_per_row*height bytes per glyph.
+     */
+    uint8_t* glyphs;
+
+    /**
+     * Direct lookup table of the glyph for the codepoints 0-255, or @c 0xFFFF
+     * if the font has no glyph for it.
+     */
+    uint16_t latin1[256];
+
+    /**
+     * The sorted codepoints of the unicode table of the font.
+     */
+    uint32_t* unicode_cp;
+
+    /**
+     * The glyphs of the codepoints in @c unicode_cp .
+     */
+    uint16_t* unicode_glyph;
+
+    /**
+     * The amount of entries in the unicode table.
+     */
+    size_t unicode_len;
+
+    /**
+     * The glyph masks expanded to 16 bit pixels, lazily created.
+     */
+    uint16_t* mask16;
+
+    /**
+     * The glyph masks expanded to 32 bit pixels, lazily created.
+     */
+    uint32_t* mask32;
+
+    /**
+     * The glyph caches for the recently used colors.
+     */
+    struct pyfb_glyphcache cache[PYFB_GLYPHCACHE_SLOTS];
+
+    /**
+     * Counter used for the LRU stamps of the cache slots.
+     */
+    unsigned long int cache_clock;
+
+    /**
+     * 1 if this font slot is in use, else 0.
+     */
+    int used;
+
+    /**
+     * The lock on this font.
+     */
+    lock_t font_lock;
+};
+
 /**
  * Initializes a color with the 32bit color value.
  *
@@ -164,35 +611,158 @@ extern void pyfb_initcolor_u32(struct pyfb_color* cptr, uint32_t value);
 extern void pyfb_initcolor_u16(struct pyfb_color* cptr, uint16_t value);
 
 /**
- * Initializes the pyfb internal structures. This function is only callen
- * at the beginning of module initialization and should not be callen
- * at another way.
+ * Converts a 32 bit color value to RGB565, like pyfb_initcolor_u32 does, for the loops
+ * converting whole rows of pixels.
+ *
+ * @param value The color value in 32 bits
+ *
+ * @return The color value in 16 bits
  */
-extern void __APISTATUS_internal pyfb_init(void);
+static inline uint16_t pyfb_rgb565(uint32_t value) {
+    return (uint16_t)(((value >> 27) << 11) | (((value >> 18) & 0x3F) << 5) | ((value >> 11) & 0x1F));
+}
 
 /**
- * Opens a framebuffer. If it is allready opened, the implementation will remember
- * that the framebuffer is hold by multiple users and will free all resources to
- * this framebuffer only when the pyfb_close function is called the amount of times
- * this function has been called to be sure no user is using it.
+ * Converts a RGB565 color value to 32 bits with a full alpha channel. The channels are
+ * widened by replicating their high bits, so white stays white.
  *
- * @param fbnum The framebuffer number to open, usually a number between 0 and 31
+ * @param value The color value in 16 bits
  *
- * @return By success 0, else -1, -2 if invalid framebuffer number
+ * @return The color value in 32 bits
  */
-extern int pyfb_open(uint8_t fbnum);
+static inline uint32_t pyfb_rgba8888(uint16_t value) {
+    uint32_t r = (value >> 11) & 0x1F;
+    uint32_t g = (value >> 5) & 0x3F;
+    uint32_t b = value & 0x1F;
+    return ((r << 3 | r >> 2) << 24) | ((g << 2 | g >> 4) << 16) | ((b << 3 | b >> 2) << 8) | 0xFF;
+}
 
 /**
- * Closes a framebuffer. This function does not closes the framebuffer automaticly!
- * If multiple times the pyfb_open function has been called on the framebuffer to
- * close, then it will only decrement the amount of users currently using this
- * framebuffer. Only if no other user is marked using this framebuffer, then all
- * resources related to the framebuffer will be cleaned up.
- *
- * @param fbnum The framebuffer number to close
+ * Initializes the pyfb internal structures. This function is callen at the
+ * beginning of the module initialization of every interpreter and only
+ * initializes the structures once per process, so it is safe to call it
+ * from multiple threads.
+ */
+extern void __APISTATUS_internal pyfb_init(void);
+
+/**
+ * Initializes the font slots. This function is only callen by pyfb_init.
+ */
+extern void __APISTATUS_internal pyfb_fontinit(void);
+
+/**
+ * Initializes the frame clock slots. This function is only callen by pyfb_init.
+ */
+extern void __APISTATUS_internal pyfb_clockinit(void);
+
+/**
+ * Initializes the async worker slots. This function is only callen by pyfb_init.
+ */
+extern void __APISTATUS_internal pyfb_asyncinit(void);
+
+/**
+ * Initializes the sprite slots. This function is only callen by pyfb_init.
+ */
+extern void __APISTATUS_internal pyfb_spriteinit(void);
+
+/**
+ * Returns the internal structure of a framebuffer. This is used by the native
+ * sources outside of the framebuffer management to access the offscreen buffer
+ * directly. The caller must lock the framebuffer and check that it is in use
+ * before accessing the structure.
+ *
+ * @param fbnum The framebuffer number, must be valid
+ *
+ * @return The pointer to the framebuffer structure
+ */
+extern struct pyfb_framebuffer* __APISTATUS_internal pyfb_fbptr(uint8_t fbnum);
+
+/**
+ * Opens a framebuffer. If it is allready opened, the implementation will remember
+ * that the framebuffer is hold by multiple users and will free all resources to
+ * this framebuffer only when the pyfb_close function is called the amount of times
+ * this function has been called to be sure no user is using it.
+ *
+ * @param fbnum The framebuffer number to open, usually a number between 0 and 31
+ *
+ * @return By success 0, else -1, -2 if invalid framebuffer number
+ */
+extern int pyfb_open(uint8_t fbnum);
+
+/**
+ * The maximum X and Y resolution of a virtual framebuffer.
+ */
+#define PYFB_VIRTUAL_MAXRES 16384
+
+/**
+ * Dump the frames of a virtual framebuffer as raw pixels in the offscreen buffer format.
+ */
+#define PYFB_DUMP_RAW 0
+
+/**
+ * Dump the frames of a virtual framebuffer as binary PPM images.
+ */
+#define PYFB_DUMP_PPM 1
+
+/**
+ * Opens a virtual framebuffer backed by memory instead of a device file, e.g. to render
+ * without a display. The memory is a memory file, so all drawing and flush operations
+ * run the same code as for a real device. Every flushed frame can be dumped to a file or
+ * pipe. Like pyfb_open, the same virtual framebuffer can be opened multiple times.
+ *
+ * @param fbnum The framebuffer number to use, must not be used by a real device
+ * @param xres The X resolution
+ * @param yres The Y resolution
+ * @param depth The color depth, 16 or 32
+ * @param dump_fd The file descriptor to dump the flushed frames to, or -1. The file
+ *                descriptor is duplicated, so the caller keeps the ownership.
+ * @param dump_format The dump format, @c PYFB_DUMP_RAW or @c PYFB_DUMP_PPM
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_openVirtual(uint8_t fbnum,
+                            unsigned long int xres,
+                            unsigned long int yres,
+                            unsigned int depth,
+                            int dump_fd,
+                            int dump_format);
+
+/**
+ * Closes a framebuffer. This function does not closes the framebuffer automaticly!
+ * If multiple times the pyfb_open function has been called on the framebuffer to
+ * close, then it will only decrement the amount of users currently using this
+ * framebuffer. Only if no other user is marked using this framebuffer, then all
+ * resources related to the framebuffer will be cleaned up, or kept alive for the
+ * keep-alive period of the framebuffer, see pyfb_ssetKeepAlive.
+ *
+ * @param fbnum The framebuffer number to close
  */
 extern void pyfb_close(uint8_t fbnum);
 
+/**
+ * The maximum keep-alive period in seconds.
+ */
+#define PYFB_KEEPALIVE_MAX 86400
+
+/**
+ * Sets the keep-alive period of a framebuffer number. If the last user of a device
+ * framebuffer, or of a virtual framebuffer which is not dumped, closes it, the device
+ * file, the screen info and the offscreen buffer are kept for this period, so opening
+ * it again with the same resolution only increments the user count. The next user gets
+ * a cleared offscreen buffer, and the rotation, flip, damage and counters of the previous
+ * user are reset. A framebuffer with a resized canvas is not kept alive. A background
+ * thread, started by the first period set, clears the offscreen buffers after the close
+ * and releases the framebuffers when their period ends. The period persists while the
+ * framebuffer is closed.
+ *
+ * @param fbnum The framebuffer number
+ * @param seconds The idle period in seconds, 0 to disable the keep-alive and release
+ *                a framebuffer kept alive now
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_ssetKeepAlive(uint8_t fbnum, double seconds);
+
 /**
  * Returns the videomode info of a specific framebuffer. If the framebuffer is not
  * opened, then the @c pyfb_videomode_info.fb_size_b field will be @c 0 . If it is
@@ -219,6 +789,55 @@ extern void pyfb_svinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr);
  */
 extern void __APISTATUS_internal pyfb_vinfo(uint8_t fbnum, struct pyfb_videomode_info* info_ptr);
 
+/**
+ * Returns the canvas of a specific framebuffer. If the framebuffer is not opened, the
+ * @c pyfb_canvas.xres field will be @c 0 .
+ *
+ * This function locks the framebuffer before collecting the data.
+ *
+ * @param fbnum The framebuffer number to get the canvas of
+ * @param canvas_ptr The pointer to copy the canvas to
+ */
+extern void pyfb_scanvas(uint8_t fbnum, struct pyfb_canvas* canvas_ptr);
+
+/**
+ * Returns the size of the screen in canvas coordinates, means the resolution with X and
+ * Y swapped if the canvas is rotated by a quarter turn. Please lock the framebuffer before
+ * invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened
+ * @param xres The pointer to store the width to
+ * @param yres The pointer to store the height to
+ */
+extern void __APISTATUS_internal pyfb_screenSize(uint8_t fbnum, unsigned long int* xres, unsigned long int* yres);
+
+/**
+ * Resizes the canvas of a framebuffer. The canvas must be at least as large as the
+ * screen. The content of the offscreen buffer is cleared and the viewport is moved
+ * to the upper left corner. If the canvas has the layout of the device memory, the
+ * viewport will be moved by the driver, else the flush copies the viewport.
+ *
+ * @param fbnum The framebuffer number
+ * @param xres The canvas width
+ * @param yres The canvas height
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_ssetCanvas(uint8_t fbnum, unsigned long int xres, unsigned long int yres);
+
+/**
+ * Moves the viewport of a framebuffer on its canvas. If the driver pans the display,
+ * the viewport is visible immediately, else it becomes visible with the next flush.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x offset of the viewport on the canvas
+ * @param y The y offset of the viewport on the canvas
+ *
+ * @return 1 if the display has been panned by the driver, 0 if a flush is required,
+ *         -1 on error with a Python exception set
+ */
+extern int pyfb_ssetViewport(uint8_t fbnum, unsigned long int x, unsigned long int y);
+
 /**
  * Paints a single pixel to the framebuffer. This function is secure because before
  * painting, it validates the arguments.
@@ -271,6 +890,17 @@ extern void __APISTATUS_internal pyfb_fblock(uint8_t fbnum);
  */
 extern void __APISTATUS_internal pyfb_fbunlock(uint8_t fbnum);
 
+/**
+ * Returns the read only mapping of the device memory of a framebuffer. The device memory
+ * is mapped on the first call and unmapped when the framebuffer is closed. Please lock the
+ * framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened
+ *
+ * @return The mapping, or NULL if the device can not be mapped
+ */
+extern const uint8_t* __APISTATUS_internal pyfb_fbmap(uint8_t fbnum);
+
 /**
  * Checks if the framebuffer is really opened. This is only used internally as checking function before
  * executing a draw operation to prevent NULL pointer access.
@@ -476,12 +1106,240 @@ extern void __APISTATUS_internal pyfb_drawEllipse(uint8_t fbnum,
                                                   unsigned long int b,
                                                   struct pyfb_color* color);
 
+/**
+ * Capture the screen from the device memory.
+ */
+#define PYFB_CAPTURE_DEVICE 0
+
+/**
+ * Capture the screen from the viewport of the offscreen buffer.
+ */
+#define PYFB_CAPTURE_BUFFER 1
+
+/**
+ * Converts pixels of the offscreen buffer format to RGBA8888, means the bytes red, green,
+ * blue and alpha per pixel. 16 bit pixels are RGB565 and get an opaque alpha channel.
+ *
+ * @param src The source pixels
+ * @param depth The source pixel depth, 16 or 32
+ * @param dst The destination, 4 bytes per pixel
+ * @param count The amount of pixels
+ */
+extern void __APISTATUS_internal pyfb_convertRGBA(const void* src, unsigned int depth, uint8_t* dst, size_t count);
+
+/**
+ * Reads a single pixel of the offscreen buffer. This function is secure, because it
+ * validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate
+ * @param y The y coordinate
+ * @param value The pointer to store the 32 bit color value to
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sgetPixel(uint8_t fbnum, unsigned long int x, unsigned long int y, uint32_t* value);
+
+/**
+ * Reads a rectangular area of the offscreen buffer as RGBA8888 pixels. This function is
+ * secure, because it validates the arguments. The area must be on the canvas.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate of the upper left corner
+ * @param y The y coordinate of the upper left corner
+ * @param width The width of the area
+ * @param height The height of the area
+ * @param dst The destination buffer
+ * @param dst_len The length of the destination buffer, at least @c width*height*4 bytes
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sreadRect(uint8_t fbnum,
+                          unsigned long int x,
+                          unsigned long int y,
+                          unsigned long int width,
+                          unsigned long int height,
+                          uint8_t* dst,
+                          size_t dst_len);
+
+/**
+ * Captures the visible screen as RGBA8888 pixels. With @c PYFB_CAPTURE_DEVICE the pixels
+ * are read from the device memory, mapped if the driver supports it, else read from the
+ * device file. With @c PYFB_CAPTURE_BUFFER the viewport of the offscreen buffer is read.
+ *
+ * @param fbnum The framebuffer number
+ * @param source The capture source, @c PYFB_CAPTURE_DEVICE or @c PYFB_CAPTURE_BUFFER
+ * @param dst The destination buffer
+ * @param dst_len The length of the destination buffer, at least @c xres*yres*4 bytes
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_scapture(uint8_t fbnum, int source, uint8_t* dst, size_t dst_len);
+
+/**
+ * Stream tiles with the pixels in the offscreen buffer format.
+ */
+#define PYFB_STREAM_RAW 0
+
+/**
+ * Stream tiles run length encoded, as pairs of the run length - 1 in one byte and one
+ * pixel in the offscreen buffer format.
+ */
+#define PYFB_STREAM_RLE 1
+
+/**
+ * Stream tiles encoded like the chunks of the QOI image format, decoding to RGBA8888.
+ */
+#define PYFB_STREAM_QOI 2
+
+/**
+ * The default edge length of the stream tiles in pixels.
+ */
+#define PYFB_STREAM_TILE 64
+
+/**
+ * The statistics of a frame stream.
+ */
+struct pyfb_streamstats {
+    /**
+     * The count of frames written to the stream.
+     */
+    unsigned long int frames;
+
+    /**
+     * The count of flushed frames that were replaced by a newer frame before being encoded.
+     */
+    unsigned long int dropped;
+
+    /**
+     * The count of changed tiles written to the stream.
+     */
+    unsigned long int tiles;
+
+    /**
+     * The count of bytes written to the stream.
+     */
+    unsigned long long int bytes;
+
+    /**
+     * Set to 1 if the stream stopped because writing to the file descriptor failed.
+     */
+    int failed;
+};
+
+/**
+ * Starts streaming the flushed frames of a framebuffer to a file descriptor, e.g. a pipe
+ * or a unix socket. Each flush hands a copy of the visible area to the stream thread,
+ * which writes only the tiles changed since the last frame. If the thread is still busy,
+ * the pending frame is replaced by the newer one. The file descriptor is duplicated, so
+ * the caller keeps the ownership of the passed one. This function is secure, because it
+ * validates the arguments.
+ *
+ * Every frame starts with a 20 byte header of the magic "PFBS", the frame number (u32),
+ * the width and height (u16), the tile size (u16), the depth (u8), the flags (u8, bit 0
+ * set on key frames) and the tile count (u32). Every tile starts with a 13 byte header of
+ * the x, y, width and height (u16), the encoding (u8) and the payload length (u32). All
+ * values are little endian.
+ *
+ * @param fbnum The framebuffer number
+ * @param fd The file descriptor to stream to
+ * @param encoding The preferred tile encoding, tiles are sent raw if that is smaller
+ * @param tile_size The edge length of the tiles, between 8 and 256
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sstreamStart(uint8_t fbnum, int fd, int encoding, unsigned int tile_size);
+
+/**
+ * Stops streaming a framebuffer and closes the duplicated file descriptor. Does nothing if
+ * the framebuffer is not streamed. This function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ */
+extern void pyfb_sstreamStop(uint8_t fbnum);
+
+/**
+ * Reads the statistics of the stream of a framebuffer. This function is secure, because it
+ * validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param stats The pointer to store the statistics to
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sstreamStats(uint8_t fbnum, struct pyfb_streamstats* stats);
+
+/**
+ * Stops the stream of a framebuffer if it is streamed. Please lock the framebuffer before
+ * invoking this function.
+ *
+ * @param fbnum The framebuffer number
+ */
+extern void __APISTATUS_internal pyfb_streamStop(uint8_t fbnum);
+
+/**
+ * Hands a copy of the visible area to the stream thread. Called by the flush if the
+ * framebuffer is streamed. Please lock the framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be streamed
+ */
+extern void __APISTATUS_internal pyfb_streamFrame(uint8_t fbnum);
+
+/**
+ * Copies a rectangular area of the offscreen buffer to another position, like the
+ * copyarea operation of the linux framebuffer drivers. Source and destination may
+ * overlap. This function is the insecure way because due to performance increase, the
+ * arguments will not be checked. Please make sure both areas are on the screen.
+ *
+ * This function by itself does not handle the locking of the framebuffer. The caller must
+ * care of locking the framebuffer before calling this function.
+ *
+ * @param fbnum The framebuffer number
+ * @param sx The x coordinate of the upper left corner of the source area
+ * @param sy The y coordinate of the upper left corner of the source area
+ * @param width The width of the area
+ * @param height The height of the area
+ * @param dx The x coordinate of the upper left corner of the destination
+ * @param dy The y coordinate of the upper left corner of the destination
+ */
+extern void __APISTATUS_internal pyfb_copyArea(uint8_t fbnum,
+                                               unsigned long int sx,
+                                               unsigned long int sy,
+                                               unsigned long int width,
+                                               unsigned long int height,
+                                               unsigned long int dx,
+                                               unsigned long int dy);
+
+/**
+ * Copies a rectangular area of the offscreen buffer to another position. This function
+ * is secure, because it validates the arguments. The upper left corners of the source
+ * area and the destination must be on the screen, the rest of the area is clipped.
+ *
+ * @param fbnum The framebuffer number
+ * @param sx The x coordinate of the upper left corner of the source area
+ * @param sy The y coordinate of the upper left corner of the source area
+ * @param width The width of the area
+ * @param height The height of the area
+ * @param dx The x coordinate of the upper left corner of the destination
+ * @param dy The y coordinate of the upper left corner of the destination
+ */
+extern void pyfb_scopyArea(uint8_t fbnum,
+                           unsigned long int sx,
+                           unsigned long int sy,
+                           unsigned long int width,
+                           unsigned long int height,
+                           unsigned long int dx,
+                           unsigned long int dy);
+
 /**
  * Paints the content of the offscreen buffer to the framebuffer. This function must be callen
  * because this is the only operation that is required to paint the content of the offscreen
  * buffer to the framebuffer. All other paint operations are only for painting to the offscreen
  * buffer, that must be flushed to the framebuffer with this function to display all content.
  *
+ * If the driver pans the canvas, the whole canvas is written to the device memory. Else only
+ * the viewport of the canvas is copied to the visible screen.
+ *
  * This function will block until the buffer content is fully transfered to the framebuffer.
  * As this operation must be transfered via DMA, this still can take a while. In the internet,
  * it says that it can take something between 20 and 100 milliseconds.
@@ -492,4 +1350,1298 @@ extern void __APISTATUS_internal pyfb_drawEllipse(uint8_t fbnum,
  */
 extern int pyfb_flushBuffer(uint8_t fbnum);
 
+/**
+ * Enables or disables the performance counters of a framebuffer. The counters keep
+ * their values while disabled. This function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param enabled 1 to enable, 0 to disable the counters
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_ssetStats(uint8_t fbnum, int enabled);
+
+/**
+ * Reads the performance counters of a framebuffer. This function is secure, because it
+ * validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param info The pointer to store the snapshot of the counters to
+ * @param reset 1 to reset the counters after reading them
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sstats(uint8_t fbnum, struct pyfb_statsinfo* info, int reset);
+
+/**
+ * Loads a PSF1 or PSF2 bitmap font from its file content. Compressed fonts must be
+ * decompressed by the caller.
+ *
+ * @param data The content of the font file
+ * @param len The length of the content in bytes
+ *
+ * @return The font number by success, else -1 with a Python exception set
+ */
+extern int pyfb_loadFont(const uint8_t* data, size_t len);
+
+/**
+ * Frees a font and all its glyph caches.
+ *
+ * @param fontnum The font number to free
+ */
+extern void pyfb_freeFont(uint8_t fontnum);
+
+/**
+ * Returns the glyph size and amount of glyphs of a font.
+ *
+ * @param fontnum The font number
+ * @param width The pointer to store the glyph width to
+ * @param height The pointer to store the glyph height to
+ * @param numglyphs The pointer to store the amount of glyphs to
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sfontInfo(uint8_t fontnum, unsigned int* width, unsigned int* height, unsigned int* numglyphs);
+
+/**
+ * Measures the size of a text. Lines are separated by @c '\n' , so the width is the
+ * width of the longest line and the height is the amount of lines times the glyph height.
+ *
+ * @param fontnum The font number
+ * @param text The text as unicode codepoints
+ * @param len The amount of codepoints
+ * @param width The pointer to store the text width to
+ * @param height The pointer to store the text height to
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_smeasureText(uint8_t fontnum,
+                             const uint32_t* text,
+                             size_t len,
+                             unsigned long int* width,
+                             unsigned long int* height);
+
+/**
+ * Draws a text to the offscreen buffer. This function is the insecure way because due to
+ * performance increase, the arguments will not be checked. The text is clipped on the right
+ * and bottom edge of the screen, but the starting point must be on the screen.
+ *
+ * This function by itself does not handle the locking of the framebuffer and the font. The
+ * caller must care of locking both before calling this function.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate of the upper left corner of the text
+ * @param y The y coordinate of the upper left corner of the text
+ * @param text The text as unicode codepoints
+ * @param len The amount of codepoints
+ * @param fontnum The font number
+ * @param color The foreground color
+ * @param background The background color, or NULL for a transparent background
+ */
+extern void __APISTATUS_internal pyfb_drawText(uint8_t fbnum,
+                                               unsigned long int x,
+                                               unsigned long int y,
+                                               const uint32_t* text,
+                                               size_t len,
+                                               uint8_t fontnum,
+                                               const struct pyfb_color* color,
+                                               const struct pyfb_color* background);
+
+/**
+ * Draws a text to the offscreen buffer. This function is secure, because before painting,
+ * it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate of the upper left corner of the text
+ * @param y The y coordinate of the upper left corner of the text
+ * @param text The text as unicode codepoints
+ * @param len The amount of codepoints
+ * @param fontnum The font number
+ * @param color The foreground color
+ * @param background The background color, or NULL for a transparent background
+ */
+extern void pyfb_sdrawText(uint8_t fbnum,
+                           unsigned long int x,
+                           unsigned long int y,
+                           const uint32_t* text,
+                           size_t len,
+                           uint8_t fontnum,
+                           const struct pyfb_color* color,
+                           const struct pyfb_color* background);
+
+/**
+ * The maximum amount of threads that can record trace events at the same time. The events
+ * of further threads are dropped. The ring buffer of an exited thread is kept for the dump
+ * until a new thread needs it.
+ */
+#define PYFB_TRACE_THREADS 16
+
+/**
+ * The capacity of the trace event ring buffer of a thread. Must be a power of two.
+ */
+#define PYFB_TRACE_EVENTS 32768
+
+/**
+ * Not 0 if the tracer records events. Use the PYFB_TRACE_BEGIN macro instead of reading it.
+ */
+extern atomic_int pyfb_trace_enabled;
+
+/**
+ * Starts a traced span: declares the variable with the start timestamp, which is 0 if the
+ * tracer is disabled, so the disabled tracer costs one relaxed load.
+ *
+ * @param start The name of the variable to declare
+ */
+#define PYFB_TRACE_BEGIN(start)                                                                           \
+    uint64_t start = __builtin_expect(atomic_load_explicit(&pyfb_trace_enabled, memory_order_relaxed), 0) \
+                         ? pyfb_traceNow()                                                                \
+                         : 0
+
+/**
+ * Ends a traced span started with PYFB_TRACE_BEGIN and records it.
+ *
+ * @param name The name of the span, must be a string literal
+ * @param fbnum The framebuffer number
+ * @param start The variable declared by PYFB_TRACE_BEGIN
+ */
+#define PYFB_TRACE_END(name, fbnum, start)         \
+    if(__builtin_expect((start) != 0, 0)) {        \
+        pyfb_traceEvent((name), (fbnum), (start)); \
+    }
+
+/**
+ * Returns the monotonic time in nanoseconds for the tracer.
+ *
+ * @return The timestamp, never 0
+ */
+extern uint64_t __APISTATUS_internal pyfb_traceNow(void);
+
+/**
+ * Records a span that ends now into the ring buffer of the calling thread. The ring buffer
+ * is preallocated by pyfb_traceStart, so this function does not allocate. If the ring buffer
+ * is full, the oldest events are overwritten.
+ *
+ * @param name The name of the span, must be a string literal
+ * @param fbnum The framebuffer number
+ * @param start The start timestamp from pyfb_traceNow
+ */
+extern void __APISTATUS_internal pyfb_traceEvent(const char* name, uint8_t fbnum, uint64_t start);
+
+/**
+ * Starts the tracer. The ring buffers are allocated on the first start and the events of
+ * a previous run are discarded.
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_traceStart(void);
+
+/**
+ * Stops the tracer. The recorded events are kept until the next start.
+ */
+extern void pyfb_traceStop(void);
+
+/**
+ * Writes the recorded events as Chrome trace event JSON, which can be opened with
+ * chrome://tracing or the Perfetto UI. The tracer may still be running: every ring buffer
+ * is copied before it is written, and the events overwritten while copying are dropped.
+ *
+ * @param fd The file descriptor to write to
+ *
+ * @return The amount of written events, or -1 with a Python exception set
+ */
+extern long int pyfb_traceDump(int fd);
+
+/**
+ * The call types of a draw call recording.
+ */
+enum pyfb_recordop {
+    PYFB_RECORD_OPEN = 1,
+    PYFB_RECORD_CLOSE,
+    PYFB_RECORD_PIXEL,
+    PYFB_RECORD_HLINE,
+    PYFB_RECORD_VLINE,
+    PYFB_RECORD_LINE,
+    PYFB_RECORD_CIRCLE,
+    PYFB_RECORD_ELLIPSE,
+    PYFB_RECORD_COPYAREA,
+    PYFB_RECORD_FLUSH,
+    PYFB_RECORD_CANVAS,
+    PYFB_RECORD_VIEWPORT,
+    PYFB_RECORD_FONT,
+    PYFB_RECORD_FREEFONT,
+    PYFB_RECORD_TEXT,
+    PYFB_RECORD_DAMAGE,
+    PYFB_RECORD_ROTATION,
+    PYFB_RECORD_WRITERECT,
+    PYFB_RECORD_BLIT,
+    PYFB_RECORD_LOADSPRITE,
+    PYFB_RECORD_FREESPRITE,
+    PYFB_RECORD_SPRITE,
+    PYFB_RECORD_PALETTE,
+    PYFB_RECORD_CLEARPALETTE,
+    PYFB_RECORD_SCALAR,
+    PYFB_RECORD_POINTS,
+    PYFB_RECORD_POLYLINE,
+    PYFB_RECORD_TRIANGLE,
+    PYFB_RECORD_TRIANGLES,
+    PYFB_RECORD_GRADIENT
+};
+
+/**
+ * The version of the recording file format.
+ */
+#define PYFB_RECORD_VERSION 1
+
+/**
+ * The maximum amount of arguments of a recorded call.
+ */
+#define PYFB_RECORD_MAXARGS 8
+
+/**
+ * Not 0 if the draw calls are recorded. Use the PYFB_RECORD_BEGIN macro instead of reading it.
+ */
+extern atomic_int pyfb_record_enabled;
+
+/**
+ * Starts a recorded call: declares the variable with the start timestamp, which is 0 if the
+ * recorder is disabled.
+ *
+ * @param start The name of the variable to declare
+ */
+#define PYFB_RECORD_BEGIN(start)                                                                           \
+    uint64_t start = __builtin_expect(atomic_load_explicit(&pyfb_record_enabled, memory_order_relaxed), 0) \
+                         ? pyfb_traceNow()                                                                 \
+                         : 0
+
+/**
+ * Records a call started with PYFB_RECORD_BEGIN, if it did not fail.
+ *
+ * @param op The call type, see pyfb_recordop
+ * @param fbnum The framebuffer number
+ * @param start The variable declared by PYFB_RECORD_BEGIN
+ * @param ... The integer arguments of the call, at least one
+ */
+#define PYFB_RECORD(op, fbnum, start, ...)                                                                     \
+    if(__builtin_expect((start) != 0, 0) && !PyErr_Occurred()) {                                               \
+        const uint64_t record_args[] = {__VA_ARGS__};                                                          \
+        pyfb_recordCall((op), (fbnum), (start), record_args, sizeof(record_args) / sizeof(uint64_t), NULL, 0); \
+    }
+
+/**
+ * Returns the bits of a double for a recorded integer argument.
+ *
+ * @param value The double
+ *
+ * @return The bits of the double
+ */
+static inline uint64_t pyfb_recordDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * The statistics of a replayed recording.
+ */
+struct pyfb_replaystats {
+    /**
+     * The count of replayed calls.
+     */
+    unsigned long int calls;
+
+    /**
+     * The count of replayed flushes.
+     */
+    unsigned long int flushes;
+
+    /**
+     * The count of calls which failed in the replay.
+     */
+    unsigned long int errors;
+
+    /**
+     * The count of skipped calls, of unknown types or using fonts or sprites loaded before the recording started.
+     */
+    unsigned long int skipped;
+
+    /**
+     * The time from the first to the end of the last recorded call in nanoseconds.
+     */
+    uint64_t recorded_ns;
+
+    /**
+     * The sum of the recorded call durations in nanoseconds.
+     */
+    uint64_t busy_ns;
+
+    /**
+     * The time of the replay in nanoseconds.
+     */
+    uint64_t replay_ns;
+};
+
+/**
+ * Starts recording the draw calls of the Python module to a file. The framebuffers which
+ * are open are recorded as opened at the start. Fonts and sprites must be loaded after the
+ * start to be replayable.
+ *
+ * @param fd The file descriptor to write to, it is duplicated
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_recordStart(int fd);
+
+/**
+ * Stops the recording and writes the buffered calls.
+ *
+ * @return 0 on success, else -1 with a Python exception set if writing the recording failed
+ */
+extern int pyfb_recordStop(void);
+
+/**
+ * Writes a call to the recording.
+ *
+ * @param op The call type, see pyfb_recordop
+ * @param fbnum The framebuffer number
+ * @param start The start timestamp from pyfb_traceNow
+ * @param args The integer arguments
+ * @param nargs The amount of arguments, at most PYFB_RECORD_MAXARGS
+ * @param data The data of the call, or NULL
+ * @param data_len The length of the data
+ */
+extern void __APISTATUS_internal pyfb_recordCall(uint8_t op,
+                                                 uint8_t fbnum,
+                                                 uint64_t start,
+                                                 const uint64_t* args,
+                                                 size_t nargs,
+                                                 const void* data,
+                                                 size_t data_len);
+
+/**
+ * Writes the opening of a framebuffer to the recording, with its resolution, depth, canvas
+ * and viewport.
+ *
+ * @param fbnum The framebuffer number
+ * @param start The start timestamp from pyfb_traceNow
+ */
+extern void __APISTATUS_internal pyfb_recordOpen(uint8_t fbnum, uint64_t start);
+
+/**
+ * Replays a recording on virtual framebuffers. Every recorded framebuffer is opened as
+ * virtual framebuffer of the recorded resolution under its number, and closed at the end.
+ * Failing calls are counted and do not stop the replay.
+ *
+ * @param fd The file descriptor to read the recording from
+ * @param paced Not 0 to replay with the recorded pacing, else as fast as possible
+ * @param stats The pointer to write the statistics to
+ *
+ * @return 0 on success, else -1 with a Python exception set if the file is not a recording
+ */
+extern int pyfb_sreplay(int fd, int paced, struct pyfb_replaystats* stats);
+
+/**
+ * The maximum amount of frame clocks that can be opened at the same time.
+ */
+#define MAX_CLOCKS 16
+
+/**
+ * The frame clock waits for the vertical blank of the display with FBIO_WAITFORVSYNC.
+ */
+#define PYFB_CLOCK_VSYNC 0
+
+/**
+ * The frame clock waits for the deadlines of the target frame rate with a timerfd.
+ */
+#define PYFB_CLOCK_TIMER 1
+
+/**
+ * A tick of a frame clock.
+ */
+struct pyfb_clocktick {
+    /**
+     * The number of the frame since the clock was opened, including the dropped frames.
+     */
+    unsigned long int frame;
+
+    /**
+     * The frames dropped since the previous tick, because the previous frame took too long.
+     */
+    unsigned long int dropped;
+
+    /**
+     * The deadline of the frame on the monotonic clock in nanoseconds.
+     */
+    uint64_t deadline;
+
+    /**
+     * The time the waiting thread woke up after the deadline in nanoseconds.
+     */
+    uint64_t lateness;
+};
+
+/**
+ * The statistics of a frame clock.
+ */
+struct pyfb_clockstats {
+    /**
+     * The count of ticks.
+     */
+    unsigned long int ticks;
+
+    /**
+     * The count of ticks which missed at least one deadline, because the previous frame took too long.
+     */
+    unsigned long int missed;
+
+    /**
+     * The count of dropped frames.
+     */
+    unsigned long int dropped;
+
+    /**
+     * The frame period in nanoseconds, measured for the vsync mode.
+     */
+    uint64_t period_ns;
+
+    /**
+     * The mean wake up lateness in nanoseconds.
+     */
+    uint64_t jitter_mean_ns;
+
+    /**
+     * The standard deviation of the wake up lateness in nanoseconds.
+     */
+    uint64_t jitter_stddev_ns;
+
+    /**
+     * The maximum wake up lateness in nanoseconds.
+     */
+    uint64_t jitter_max_ns;
+};
+
+/**
+ * Opens a frame clock for a framebuffer. The clock waits for the vertical blank of the
+ * display if requested and supported by the driver, else it waits for the deadlines of the
+ * target frame rate. The vsync mode measures the display period with two vertical blanks,
+ * without holding the framebuffer lock or the global interpreter lock.
+ *
+ * @param fbnum The framebuffer number
+ * @param fps The target frame rate, for the vsync mode the display rate is divided to the
+ *            closest rate, 0 to use the display rate
+ * @param vsync Not 0 to wait for the vertical blank if the driver supports it
+ *
+ * @return The clock number, or -1 with a Python exception set
+ */
+extern int pyfb_sclockOpen(uint8_t fbnum, double fps, int vsync);
+
+/**
+ * Closes a frame clock.
+ *
+ * @param clocknum The clock number
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_sclockClose(uint8_t clocknum);
+
+/**
+ * Returns the mode of a frame clock.
+ *
+ * @param clocknum The clock number
+ *
+ * @return PYFB_CLOCK_VSYNC or PYFB_CLOCK_TIMER, or -1 with a Python exception set
+ */
+extern int pyfb_sclockMode(uint8_t clocknum);
+
+/**
+ * Waits for the next frame deadline of a frame clock. If the deadline of the next frame
+ * has passed already because the previous frame took too long, the missed frames are
+ * dropped and it waits for the next deadline in the future, so a slow frame does not
+ * make the following frames late. This function must be called without holding the
+ * global interpreter lock and a clock must only be waited for by one thread at once.
+ *
+ * @param clocknum The clock number
+ * @param tick The pointer to write the tick to
+ *
+ * @return 0 on success, else -1 with errno set
+ */
+extern int pyfb_clockWait(uint8_t clocknum, struct pyfb_clocktick* tick);
+
+/**
+ * Returns the statistics of a frame clock.
+ *
+ * @param clocknum The clock number
+ * @param stats The pointer to write the statistics to
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_sclockStats(uint8_t clocknum, struct pyfb_clockstats* stats);
+
+/**
+ * The completion state of the async worker of a framebuffer.
+ */
+struct pyfb_asyncstate {
+    /**
+     * The ticket of the last completed flush.
+     */
+    unsigned long int flush_done;
+
+    /**
+     * 0 if the last completed flush succeeded, else the errno of it.
+     */
+    int flush_error;
+
+    /**
+     * The ticket of the last completed frame clock wait.
+     */
+    unsigned long int tick_done;
+
+    /**
+     * 0 if the last completed frame clock wait succeeded, else the errno of it.
+     */
+    int tick_error;
+
+    /**
+     * The tick of the last completed frame clock wait.
+     */
+    struct pyfb_clocktick tick;
+};
+
+/**
+ * Starts the async worker of a framebuffer. The worker thread flushes the offscreen
+ * buffer and waits for frame clocks on request, and signals every completion on an
+ * eventfd, so an event loop can wait for it without blocking.
+ *
+ * @param fbnum The framebuffer number
+ *
+ * @return The non-blocking eventfd, owned by the worker, or -1 with a Python exception set
+ */
+extern int pyfb_sasyncOpen(uint8_t fbnum);
+
+/**
+ * Stops the async worker of a framebuffer, waiting for a running flush or frame clock
+ * wait, and closes its eventfd. Stopping a stopped worker does nothing.
+ *
+ * @param fbnum The framebuffer number
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_sasyncClose(uint8_t fbnum);
+
+/**
+ * Requests a flush from the async worker. A flush requested while another one is still
+ * waiting to start is merged into it, so both requests get the same ticket. A flush
+ * requested while one is running waits for it, as the running flush may have missed
+ * the latest drawing.
+ *
+ * @param fbnum The framebuffer number
+ *
+ * @return The ticket of the flush, completed once pyfb_sasyncPoll reports a flush_done
+ *         of at least the ticket, or 0 with a Python exception set
+ */
+extern unsigned long int pyfb_sasyncFlush(uint8_t fbnum);
+
+/**
+ * Requests a frame clock wait from the async worker. Requests while a wait is still
+ * waiting to start are merged, like flushes.
+ *
+ * @param fbnum The framebuffer number
+ * @param clocknum The clock number, a clock must not be waited for by two workers
+ *
+ * @return The ticket of the wait, completed once pyfb_sasyncPoll reports a tick_done of
+ *         at least the ticket, or 0 with a Python exception set
+ */
+extern unsigned long int pyfb_sasyncTick(uint8_t fbnum, uint8_t clocknum);
+
+/**
+ * Clears the eventfd of the async worker and returns the completion state.
+ *
+ * @param fbnum The framebuffer number
+ * @param state The pointer to write the state to
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_sasyncPoll(uint8_t fbnum, struct pyfb_asyncstate* state);
+
+/**
+ * Marks a rectangle of the screen as damaged. If a framebuffer with a canvas of the
+ * screen size has damage, the next flush only writes the bounding box of the damage,
+ * else it writes the whole viewport. The rectangle is clipped to the screen.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate of the rectangle
+ * @param y The y coordinate of the rectangle
+ * @param w The width of the rectangle
+ * @param h The height of the rectangle
+ *
+ * @return 0 on success, else -1 with a Python exception set
+ */
+extern int pyfb_sdamage(uint8_t fbnum, unsigned long int x, unsigned long int y, unsigned long int w, unsigned long int h);
+
+/**
+ * Writes a rectangle of the viewport to the device.
+ *
+ * @param fbnum The framebuffer number, must be opened and locked
+ * @param damage The rectangle, not empty and within the screen
+ *
+ * @return By success 0, else -1
+ */
+extern int __APISTATUS_internal pyfb_writeRect(uint8_t fbnum, const struct pyfb_damage* damage);
+
+/**
+ * The magic number at the beginning of a shared offscreen buffer segment, "PFBS".
+ */
+#define PYFB_SHARED_MAGIC 0x53424650u
+
+/**
+ * The maximum length of the name of a shared offscreen buffer segment.
+ */
+#define PYFB_SHARED_NAME_MAX 64
+
+/**
+ * Opens a framebuffer with its offscreen buffer in a named POSIX shared memory
+ * segment, so several processes draw into one offscreen buffer. The owner opens the
+ * device file, or a virtual framebuffer, and creates the segment, the other processes
+ * attach to the segment as a virtual framebuffer of the same resolution. A flush of
+ * another process only merges its damage into the damage of the segment and wakes the
+ * owner, a flush of the owner writes the merged damage of all processes to the device.
+ * The damage is guarded by a futex lock in the segment.
+ *
+ * @param fbnum The framebuffer number
+ * @param name The name of the segment, e.g. "/pyfb-status"
+ * @param owner Not 0 to open the device file and create the segment, else 0 to attach
+ *              to the segment of the owner
+ * @param xres The X resolution of a virtual framebuffer for the owner, or 0 for the device file
+ * @param yres The Y resolution of the virtual framebuffer of the owner
+ * @param depth The color depth of the virtual framebuffer of the owner
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sopenShared(uint8_t fbnum,
+                            const char* name,
+                            int owner,
+                            unsigned long int xres,
+                            unsigned long int yres,
+                            unsigned int depth);
+
+/**
+ * Flushes a framebuffer with a shared offscreen buffer, see pyfb_sopenShared.
+ *
+ * @param fbnum The framebuffer number, must be opened and locked
+ * @param bytes The pointer to add the count of bytes written to the device to
+ *
+ * @return By success 0, else -1
+ */
+extern int __APISTATUS_internal pyfb_sharedFlush(uint8_t fbnum, size_t* bytes);
+
+/**
+ * Detaches a framebuffer from its shared offscreen buffer, the owner also removes
+ * the segment. The offscreen buffer pointer of the framebuffer is cleared.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ */
+extern void __APISTATUS_internal pyfb_sharedClose(uint8_t fbnum);
+
+/**
+ * Waits until another process flushed damage to the shared offscreen buffer since
+ * the last flush of the owner. This function must be called without holding the
+ * global interpreter lock.
+ *
+ * @param fbnum The framebuffer number
+ * @param timeout_ms The timeout in milliseconds, or -1 to wait without a timeout
+ *
+ * @return 1 if there is damage, 0 on timeout, else -1 with errno set, EINVAL for an
+ *         invalid framebuffer number and EBADF if the framebuffer is not opened shared
+ */
+extern int pyfb_waitDamage(uint8_t fbnum, int timeout_ms);
+
+/**
+ * Adds a framebuffer to the mirror group of a source framebuffer. Every flush of the
+ * source scales the damaged area of its viewport to the resolution of each member and
+ * converts it to the depth of the member, e.g. a 32bpp HDMI display mirrored to a 16bpp
+ * SPI panel. Each member converts and flushes on its own thread, so the members are
+ * written in parallel, and the flush of the source returns after all of them. A member
+ * must not be drawn to directly, and it leaves the group if it is closed. This function
+ * is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number of the source
+ * @param member_fbnum The framebuffer number of the member, must be opened
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_smirrorAdd(uint8_t fbnum, uint8_t member_fbnum);
+
+/**
+ * Removes a framebuffer from the mirror group of a source framebuffer. This function is
+ * secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number of the source
+ * @param member_fbnum The framebuffer number of the member
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_smirrorRemove(uint8_t fbnum, uint8_t member_fbnum);
+
+/**
+ * Stops the mirror group of a framebuffer if it is mirrored. Please lock the framebuffer
+ * before invoking this function.
+ *
+ * @param fbnum The framebuffer number
+ */
+extern void __APISTATUS_internal pyfb_mirrorStop(uint8_t fbnum);
+
+/**
+ * Converts a damaged area of a source framebuffer to all members of its mirror group
+ * and flushes them, see pyfb_smirrorAdd. Please lock the framebuffer before invoking
+ * this function.
+ *
+ * @param fbnum The framebuffer number, must be mirrored
+ * @param rect The damaged area in screen coordinates
+ *
+ * @return By success 0, else -1 if the flush of a member failed
+ */
+extern int __APISTATUS_internal pyfb_mirrorFlush(uint8_t fbnum, const struct pyfb_damage* rect);
+
+/**
+ * Mirror the canvas horizontally before rotating it.
+ */
+#define PYFB_FLIP_X 1
+
+/**
+ * Mirror the canvas vertically before rotating it.
+ */
+#define PYFB_FLIP_Y 2
+
+/**
+ * Rotates and mirrors the canvas of a framebuffer on the screen, e.g. for a panel mounted
+ * in portrait while the driver reports landscape. All drawing operations address the
+ * canvas in its own orientation, so they cost nothing extra, and the flush rotates the
+ * damaged area in cache sized blocks while copying it to the device. A quarter turn swaps
+ * the width and the height of the canvas. This clears the offscreen buffer and resets the
+ * canvas to the screen size. A shared, streamed, panned or mirrored framebuffer can not be
+ * rotated. This function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param degrees The clockwise rotation, 0, 90, 180 or 270
+ * @param flip The mirroring before the rotation, a combination of @c PYFB_FLIP_X and
+ *             @c PYFB_FLIP_Y , or 0
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_ssetRotation(uint8_t fbnum, unsigned int degrees, int flip);
+
+/**
+ * Writes a damaged area of a rotated canvas to the device, see pyfb_ssetRotation. Please
+ * lock the framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened and rotated
+ * @param damage The damaged area in canvas coordinates of the viewport, must not be empty
+ *
+ * @return By success the count of bytes written, else -1
+ */
+extern ssize_t __APISTATUS_internal pyfb_writeRotated(uint8_t fbnum, const struct pyfb_damage* damage);
+
+/**
+ * Sample the source pixel nearest to the sample point.
+ */
+#define PYFB_FILTER_NEAREST 0
+
+/**
+ * Interpolate the four source pixels around the sample point.
+ */
+#define PYFB_FILTER_BILINEAR 1
+
+/**
+ * Draws the canvas of a source framebuffer transformed by an affine matrix, e.g. a scaled
+ * or rotated sprite, a gauge needle or a low resolution render target upscaled to the
+ * screen. The matrix maps a source point (x, y) to the destination point
+ * (m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5]). Every destination pixel of the
+ * transformed source inside the canvas is sampled at its center, stepping the source
+ * coordinates in 16.16 fixed point. A 32 bit source pixel with an alpha below 128 is
+ * transparent, a 16 bit source is opaque. The source is copied first, so it may be the
+ * destination too. This function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number to draw to
+ * @param srcnum The framebuffer number of the source
+ * @param matrix The 6 values of the matrix
+ * @param filter The sampling, @c PYFB_FILTER_NEAREST or @c PYFB_FILTER_BILINEAR
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sblitTransformed(uint8_t fbnum, uint8_t srcnum, const double* matrix, int filter);
+
+/**
+ * Writes RGBA8888 pixels to a rectangular area of the offscreen buffer, the counterpart of
+ * pyfb_sreadRect, e.g. to load a sprite into a virtual framebuffer. This function is secure,
+ * because it validates the arguments. The area must be on the canvas.
+ *
+ * @param fbnum The framebuffer number
+ * @param x The x coordinate of the upper left corner
+ * @param y The y coordinate of the upper left corner
+ * @param width The width of the area
+ * @param height The height of the area
+ * @param src The source pixels, 4 bytes per pixel in the order red, green, blue and alpha
+ * @param src_len The length of the source buffer, at least @c width*height*4 bytes
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_suploadRect(uint8_t fbnum,
+                            unsigned long int x,
+                            unsigned long int y,
+                            unsigned long int width,
+                            unsigned long int height,
+                            const uint8_t* src,
+                            size_t src_len);
+
+/**
+ * The maximum amount of sprites that can be loaded at the same time.
+ */
+#define MAX_SPRITES 64
+
+/**
+ * Loads a sprite from RGBA8888 pixels. The transparent pixels are dropped at load time:
+ * every row is encoded as a list of runs of opaque pixels, kept in the pixel format of the
+ * framebuffers, so drawing a sprite copies the runs and skips the gaps. A pixel is
+ * transparent if its color equals the color key, ignoring the alpha, or without a color
+ * key if its alpha is below the threshold.
+ *
+ * @param data The pixels, 4 bytes per pixel in the order red, green, blue and alpha
+ * @param len The length of the pixel data, at least @c width*height*4 bytes
+ * @param width The width of the sprite, at most 65535
+ * @param height The height of the sprite, at most 65535
+ * @param key The pointer to the color key value in 32 bits, or NULL to use the alpha threshold
+ * @param threshold The alpha from which on a pixel is opaque, 0 to 255
+ *
+ * @return The sprite number by success, else -1 with a Python exception set
+ */
+extern int pyfb_loadSprite(const uint8_t* data,
+                           size_t len,
+                           unsigned int width,
+                           unsigned int height,
+                           const uint32_t* key,
+                           unsigned int threshold);
+
+/**
+ * Frees a sprite.
+ *
+ * @param spritenum The sprite number to free
+ */
+extern void pyfb_freeSprite(uint8_t spritenum);
+
+/**
+ * Returns the size of a sprite and the count of its opaque runs and pixels.
+ *
+ * @param spritenum The sprite number
+ * @param width The pointer to store the width to
+ * @param height The pointer to store the height to
+ * @param runs The pointer to store the count of runs to
+ * @param opaque The pointer to store the count of opaque pixels to
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sspriteInfo(uint8_t spritenum,
+                            unsigned int* width,
+                            unsigned int* height,
+                            unsigned long int* runs,
+                            unsigned long int* opaque);
+
+/**
+ * Draws a sprite on the offscreen buffer. The sprite is clipped at all edges of the canvas,
+ * so it may start left of or above the canvas. This function is secure, because it
+ * validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param spritenum The sprite number
+ * @param x The x coordinate of the upper left corner, may be negative
+ * @param y The y coordinate of the upper left corner, may be negative
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sdrawSprite(uint8_t fbnum, uint8_t spritenum, long int x, long int y);
+
+/**
+ * The amount of colors of the palette of an indexed canvas.
+ */
+#define PYFB_PALETTE_SIZE 256
+
+/**
+ * Switches a framebuffer to an indexed canvas of the same size, or changes the palette of
+ * an indexed canvas. The offscreen buffer of an indexed canvas holds one palette index per
+ * pixel instead of the pixel format of the device, and the flush expands the indices
+ * through a lookup table of the palette in the pixel format of the device. The color
+ * value of the draw calls is the palette index then. Switching clears the canvas to index
+ * 0, changing the palette keeps the canvas and damages the whole screen, so the next flush
+ * recolors it without redrawing. The features working on the pixel format of the canvas
+ * (rotation, streams, mirrors, shared buffers and drawing pixels or sprites) are not
+ * available on an indexed canvas. This function is secure, because it validates the
+ * arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param colors The color values in 32 bits, the entries after them are black
+ * @param count The amount of colors, 1 to @c PYFB_PALETTE_SIZE
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_ssetPalette(uint8_t fbnum, const uint32_t* colors, unsigned int count);
+
+/**
+ * Switches an indexed canvas back to the pixel format of the device. The canvas keeps
+ * its size and is cleared. This function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sclearPalette(uint8_t fbnum);
+
+/**
+ * Returns the palette of an indexed canvas.
+ *
+ * Please lock the framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened and indexed
+ *
+ * @return The @c PYFB_PALETTE_SIZE color values in 32 bits
+ */
+extern const uint32_t* __APISTATUS_internal pyfb_paletteColors(uint8_t fbnum);
+
+/**
+ * Expands palette indices of an indexed canvas to the pixel format of the device.
+ *
+ * Please lock the framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened and indexed
+ * @param src The palette indices
+ * @param dst The destination pixels in the pixel format of the device
+ * @param count The amount of pixels
+ */
+extern void __APISTATUS_internal pyfb_expandIndexed(uint8_t fbnum, const uint8_t* src, void* dst, size_t count);
+
+/**
+ * Writes a rectangle of the viewport of an indexed canvas to the device, expanding the
+ * rows through the palette in chunks.
+ *
+ * Please lock the framebuffer before invoking this function.
+ *
+ * @param fbnum The framebuffer number, must be opened and indexed
+ * @param damage The area to write in coordinates of the viewport, must not be empty
+ *
+ * @return By success the count of bytes written, else -1
+ */
+extern ssize_t __APISTATUS_internal pyfb_writeIndexed(uint8_t fbnum, const struct pyfb_damage* damage);
+
+/**
+ * The values of a scalar array are unsigned 8 bit integers.
+ */
+#define PYFB_SCALAR_U8 0
+
+/**
+ * The values of a scalar array are unsigned 16 bit integers.
+ */
+#define PYFB_SCALAR_U16 1
+
+/**
+ * The values of a scalar array are 32 bit floats.
+ */
+#define PYFB_SCALAR_F32 2
+
+/**
+ * The values of a scalar array are signed 16 bit integers.
+ */
+#define PYFB_SCALAR_I16 3
+
+/**
+ * The values of a scalar array are signed 32 bit integers.
+ */
+#define PYFB_SCALAR_I32 4
+
+/**
+ * The values of a scalar array are 64 bit floats.
+ */
+#define PYFB_SCALAR_F64 5
+
+/**
+ * The values of a scalar array are signed 64 bit integers.
+ */
+#define PYFB_SCALAR_I64 6
+
+/**
+ * Returns the size of a value of a scalar array.
+ *
+ * @param type The type of the values, one of the @c PYFB_SCALAR_ macros
+ *
+ * @return The size in bytes, or 0 if the type is not valid
+ */
+static inline size_t pyfb_scalarSize(int type) {
+    switch(type) {
+    case PYFB_SCALAR_U8:
+        return 1;
+    case PYFB_SCALAR_U16:
+    case PYFB_SCALAR_I16:
+        return 2;
+    case PYFB_SCALAR_F32:
+    case PYFB_SCALAR_I32:
+        return 4;
+    case PYFB_SCALAR_F64:
+    case PYFB_SCALAR_I64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Reads a value of a scalar array.
+ *
+ * @param data The values
+ * @param type The type of the values, one of the @c PYFB_SCALAR_ macros
+ * @param i The index of the value
+ *
+ * @return The value
+ */
+static inline double pyfb_scalarValue(const void* data, int type, size_t i) {
+    switch(type) {
+    case PYFB_SCALAR_U8:
+        return ((const uint8_t*)data)[i];
+    case PYFB_SCALAR_U16:
+        return ((const uint16_t*)data)[i];
+    case PYFB_SCALAR_I16:
+        return ((const int16_t*)data)[i];
+    case PYFB_SCALAR_I32:
+        return ((const int32_t*)data)[i];
+    case PYFB_SCALAR_I64:
+        return (double)((const int64_t*)data)[i];
+    case PYFB_SCALAR_F32:
+        return ((const float*)data)[i];
+    default:
+        return ((const double*)data)[i];
+    }
+}
+
+/**
+ * The amount of colors of a colormap.
+ */
+#define PYFB_COLORMAP_SIZE 256
+
+/**
+ * Draws a two dimensional array of scalar values through a colormap, e.g. a thermal camera
+ * frame or a spectrogram. The range from vmin to vmax is mapped linearly to the colors of
+ * the colormap, values outside are clamped and NaN takes the first color. The colormap is
+ * converted to the pixel format of the device once per call, and every array pixel may be
+ * zoomed to a square of pixels. The array is clipped at all edges of the canvas. The
+ * validation runs with the GIL, the drawing without it. This function is secure, because
+ * it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param data The values, row by row without padding
+ * @param data_len The length of the values in bytes
+ * @param type The type of the values, @c PYFB_SCALAR_U8, @c PYFB_SCALAR_U16 or @c PYFB_SCALAR_F32
+ * @param width The amount of values per row
+ * @param height The amount of rows
+ * @param x The x coordinate of the upper left corner, may be negative
+ * @param y The y coordinate of the upper left corner, may be negative
+ * @param colormap The @c PYFB_COLORMAP_SIZE color values in 32 bits
+ * @param vmin The value mapped to the first color
+ * @param vmax The value mapped to the last color, must differ from vmin
+ * @param zoom The edge length of the square drawn for a value, 1 to 256
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sblitScalar(uint8_t fbnum,
+                            const void* data,
+                            size_t data_len,
+                            int type,
+                            unsigned long int width,
+                            unsigned long int height,
+                            long int x,
+                            long int y,
+                            const uint32_t* colormap,
+                            double vmin,
+                            double vmax,
+                            unsigned int zoom);
+
+/**
+ * Draws single pixels at the points of two coordinate arrays, e.g. a scatter plot. Float
+ * coordinates are rounded, points off the canvas or with a NaN coordinate are skipped.
+ * The validation runs with the GIL, the drawing without it. This function is secure,
+ * because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param xs The x coordinates
+ * @param xs_len The length of the x coordinates in bytes
+ * @param xtype The type of the x coordinates, one of the @c PYFB_SCALAR_ macros
+ * @param ys The y coordinates, as many as x coordinates
+ * @param ys_len The length of the y coordinates in bytes
+ * @param ytype The type of the y coordinates, one of the @c PYFB_SCALAR_ macros
+ * @param color The color value
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sdrawPoints(uint8_t fbnum,
+                            const void* xs,
+                            size_t xs_len,
+                            int xtype,
+                            const void* ys,
+                            size_t ys_len,
+                            int ytype,
+                            const struct pyfb_color* color);
+
+/**
+ * Draws connected lines through the points of a coordinate array, e.g. the trace of a time
+ * series. Every pixel shared by two lines is written once, a point with a NaN coordinate
+ * breaks the polyline and the lines are clipped at the edges of the canvas. With decimation,
+ * the consecutive points that round to the same column are drawn as one vertical line from
+ * their minimum to their maximum, so a trace of far more points than columns costs one line
+ * per column. The validation runs with the GIL, the drawing without it. This function is
+ * secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param points The coordinates as pairs of x and y
+ * @param points_len The length of the coordinates in bytes
+ * @param type The type of the coordinates, one of the @c PYFB_SCALAR_ macros
+ * @param decimate If 1 the points of a column are decimated to their minimum and maximum
+ * @param color The color value
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sdrawPolyline(uint8_t fbnum,
+                              const void* points,
+                              size_t points_len,
+                              int type,
+                              int decimate,
+                              const struct pyfb_color* color);
+
+/**
+ * Fills a triangle, flat if the three colors are equal, else shaded by interpolating the
+ * colors of the vertices. The coordinates have a precision of a sixteenth pixel, a pixel
+ * is filled if its center is in the triangle, or on a top or left edge of it, so triangles
+ * sharing an edge fill every pixel once. The triangle is clipped at the edges of the
+ * canvas. An indexed canvas is only filled flat, with the color as palette index. This
+ * function is secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param coords The coordinates x1, y1, x2, y2, x3 and y3 of the vertices
+ * @param colors The three color values of the vertices in 32 bits
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sfillTriangle(uint8_t fbnum, const double* coords, const uint32_t* colors);
+
+/**
+ * Fills a batch of triangles, see pyfb_sfillTriangle. A triangle with a NaN coordinate
+ * is skipped. The validation runs with the GIL, the filling without it. This function is
+ * secure, because it validates the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param vertices The coordinates, three pairs of x and y per triangle
+ * @param vertices_len The length of the coordinates in bytes
+ * @param type The type of the coordinates, one of the @c PYFB_SCALAR_ macros
+ * @param colors The color values in 32 bits, one for all triangles, one per triangle or
+ *               one per vertex, may be unaligned
+ * @param colors_len The length of the color values in bytes
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sfillTriangles(uint8_t fbnum,
+                               const void* vertices,
+                               size_t vertices_len,
+                               int type,
+                               const void* colors,
+                               size_t colors_len);
+
+/**
+ * The colors of a gradient change along the line between two points.
+ */
+#define PYFB_GRADIENT_LINEAR 0
+
+/**
+ * The colors of a gradient change with the distance from a center.
+ */
+#define PYFB_GRADIENT_RADIAL 1
+
+/**
+ * The maximum amount of color stops of a gradient.
+ */
+#define PYFB_GRADIENT_STOPS 16
+
+/**
+ * A gradient fills the whole rectangle.
+ */
+#define PYFB_SHAPE_RECT 0
+
+/**
+ * A gradient fills the ellipse inscribed in the rectangle.
+ */
+#define PYFB_SHAPE_ELLIPSE 1
+
+/**
+ * The description of a gradient. The positions are canvas coordinates, so the shapes filled
+ * with the same gradient continue each other.
+ */
+struct pyfb_gradient {
+    /**
+     * The type, @c PYFB_GRADIENT_LINEAR or @c PYFB_GRADIENT_RADIAL.
+     */
+    int type;
+
+    /**
+     * The point of the offset 0 of a linear gradient, or the center of a radial gradient.
+     */
+    double x0, y0;
+
+    /**
+     * The point of the offset 1 of a linear gradient, unused by a radial gradient.
+     */
+    double x1, y1;
+
+    /**
+     * The distance of the offset 1 from the center of a radial gradient, unused by a
+     * linear gradient.
+     */
+    double radius;
+
+    /**
+     * The amount of color stops.
+     */
+    unsigned int stops;
+
+    /**
+     * The offsets of the color stops from 0 to 1, in rising order.
+     */
+    double offsets[PYFB_GRADIENT_STOPS];
+
+    /**
+     * The color values of the color stops in 32 bits.
+     */
+    uint32_t colors[PYFB_GRADIENT_STOPS];
+};
+
+/**
+ * Fills a rectangle, or the ellipse inscribed in it, with a gradient. The colors between
+ * the stops are blended linearly, before the first stop the first color and after the last
+ * stop the last color is used. The gradient is sampled at the centers of the pixels. On a
+ * 16 bit framebuffer the colors may be dithered with an ordered 4x4 pattern, so smooth
+ * gradients show no bands. The shape is clipped at the edges of the canvas. The validation
+ * runs with the GIL, the filling without it. This function is secure, because it validates
+ * the arguments.
+ *
+ * @param fbnum The framebuffer number
+ * @param gradient The gradient
+ * @param x The x coordinate of the upper left corner, may be negative
+ * @param y The y coordinate of the upper left corner, may be negative
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param shape @c PYFB_SHAPE_RECT or @c PYFB_SHAPE_ELLIPSE
+ * @param dither If 1 the colors are dithered on a 16 bit framebuffer
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+extern int pyfb_sfillGradient(uint8_t fbnum,
+                              const struct pyfb_gradient* gradient,
+                              long int x,
+                              long int y,
+                              unsigned long int width,
+                              unsigned long int height,
+                              int shape,
+                              int dither);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+/**
+ * Readback and screen capture sources.
+ */
+#include "pyframebuffer.h"
+
+#include <endian.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Converts 32 bit pixels to RGBA8888. The 32 bit color value has the red channel in the
+ * highest byte, so this is a byte swap on little endian machines, which the compiler
+ * turns into vector shuffles.
+ *
+ * @param src The source pixels
+ * @param dst The destination, 4 bytes per pixel
+ * @param count The amount of pixels
+ */
+static void pyfb_convertRGBA32(const uint32_t* restrict src, uint8_t* restrict dst, size_t count) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    for(size_t i = 0; i < count; i++) {
+        uint32_t px = __builtin_bswap32(src[i]);
+        memcpy(dst + i * 4, &px, 4);
+    }
+#else
+    memcpy(dst, src, count * 4);
+#endif
+}
+
+/**
+ * Converts 16 bit RGB565 pixels to RGBA8888 with an opaque alpha channel. The channels
+ * are widened by replicating their high bits, so white stays white.
+ *
+ * @param src The source pixels
+ * @param dst The destination, 4 bytes per pixel
+ * @param count The amount of pixels
+ */
+static void pyfb_convertRGBA16(const uint16_t* restrict src, uint8_t* restrict dst, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        uint32_t v = src[i];
+        uint32_t r = (v >> 11) & 0x1F;
+        uint32_t g = (v >> 5) & 0x3F;
+        uint32_t b = v & 0x1F;
+        r          = (r << 3) | (r >> 2);
+        g          = (g << 2) | (g >> 4);
+        b          = (b << 3) | (b >> 2);
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        uint32_t px = r | (g << 8) | (b << 16) | 0xFF000000u;
+#else
+        uint32_t px = (r << 24) | (g << 16) | (b << 8) | 0x000000FFu;
+#endif
+        memcpy(dst + i * 4, &px, 4);
+    }
+}
+
+void __APISTATUS_internal pyfb_convertRGBA(const void* src, unsigned int depth, uint8_t* dst, size_t count) {
+    if(depth == 16) {
+        pyfb_convertRGBA16((const uint16_t*)src, dst, count);
+    } else {
+        pyfb_convertRGBA32((const uint32_t*)src, dst, count);
+    }
+}
+
+/**
+ * Converts rows of the canvas to RGBA8888, expanding the indices of an indexed canvas
+ * through the palette first.
+ *
+ * @param fbnum The framebuffer number, must be locked
+ * @param src The first pixel of the first row
+ * @param stride The canvas row length in pixels
+ * @param dst The destination, 4 bytes per pixel, packed rows
+ * @param width The amount of pixels per row
+ * @param height The amount of rows
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+static int pyfb_convertCanvas(uint8_t fbnum,
+                              const uint8_t* src,
+                              size_t stride,
+                              uint8_t* dst,
+                              unsigned long int width,
+                              unsigned long int height) {
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    unsigned int depth                = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+    size_t bytes                      = depth / 8;
+
+    if(fb->palette == NULL) {
+        for(unsigned long int row = 0; row < height; row++) {
+            pyfb_convertRGBA(src + row * stride * bytes, depth, dst + row * width * 4, width);
+        }
+        return 0;
+    }
+
+    void* row_buffer = malloc(width * bytes + 1);
+    if(row_buffer == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the row buffer");
+        return -1;
+    }
+
+    for(unsigned long int row = 0; row < height; row++) {
+        pyfb_expandIndexed(fbnum, src + row * stride, row_buffer, width);
+        pyfb_convertRGBA(row_buffer, depth, dst + row * width * 4, width);
+    }
+
+    free(row_buffer);
+    return 0;
+}
+
+int pyfb_sgetPixel(uint8_t fbnum, unsigned long int x, unsigned long int y, uint32_t* value) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(x >= fb->canvas.xres || y >= fb->canvas.yres) {
+        PyErr_SetString(PyExc_ValueError, "The coordinates are not on the screen");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(fb->palette != NULL) {
+        // the color value of an indexed canvas is the palette index
+        *value = fb->u8_buffer[y * fb->canvas.xres + x];
+    } else if(fb->fb_info.vinfo.bits_per_pixel == 16) {
+        // widen to the 32 bit color value
+        uint8_t rgba[4];
+        pyfb_convertRGBA16(fb->u16_buffer + y * fb->canvas.xres + x, rgba, 1);
+        *value = ((uint32_t)rgba[0] << 24) | ((uint32_t)rgba[1] << 16) | ((uint32_t)rgba[2] << 8) | rgba[3];
+    } else {
+        *value = fb->u32_buffer[y * fb->canvas.xres + x];
+    }
+
+    // ready, so return
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+int pyfb_sreadRect(uint8_t fbnum,
+                   unsigned long int x,
+                   unsigned long int y,
+                   unsigned long int width,
+                   unsigned long int height,
+                   uint8_t* dst,
+                   size_t dst_len) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    unsigned long int xres            = fb->canvas.xres;
+    unsigned long int yres            = fb->canvas.yres;
+
+    if(x >= xres || y >= yres || width > xres - x || height > yres - y) {
+        PyErr_SetString(PyExc_ValueError, "The area is not on the screen");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(dst_len < width * height * 4) {
+        PyErr_SetString(PyExc_ValueError, "The buffer is too small for the area");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // all data is valid, so convert row by row
+    size_t bytes       = fb->palette != NULL ? 1 : fb->fb_info.vinfo.bits_per_pixel / 8;
+    const uint8_t* src = (const uint8_t*)fb->u32_buffer + (y * xres + x) * bytes;
+    int exitcode       = pyfb_convertCanvas(fbnum, src, xres, dst, width, height);
+
+    // ready, so return
+    pyfb_fbunlock(fbnum);
+    return exitcode;
+}
+
+int pyfb_scapture(uint8_t fbnum, int source, uint8_t* dst, size_t dst_len) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(source != PYFB_CAPTURE_DEVICE && source != PYFB_CAPTURE_BUFFER) {
+        PyErr_SetString(PyExc_ValueError, "The capture source is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const struct pyfb_framebuffer* fb     = pyfb_fbptr(fbnum);
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+    unsigned int depth                    = vinfo->bits_per_pixel == 16 ? 16 : 32;
+    size_t bytes                          = depth / 8;
+    size_t row_px                         = vinfo->xres;
+
+    if(dst_len < row_px * vinfo->yres * 4) {
+        PyErr_SetString(PyExc_ValueError, "The buffer is too small for the screen");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(source == PYFB_CAPTURE_BUFFER) {
+        // read the viewport of the canvas, in the orientation of the canvas
+        unsigned long int xres, yres;
+        pyfb_screenSize(fbnum, &xres, &yres);
+
+        size_t canvas_bytes = fb->palette != NULL ? 1 : bytes;
+        size_t stride       = fb->canvas.xres * canvas_bytes;
+        const uint8_t* src  = (const uint8_t*)fb->u32_buffer + fb->canvas.yoffset * stride + fb->canvas.xoffset * canvas_bytes;
+        int exitcode        = pyfb_convertCanvas(fbnum, src, fb->canvas.xres, dst, xres, yres);
+
+        pyfb_fbunlock(fbnum);
+        return exitcode;
+    }
+
+    // else read the visible area of the device memory
+    size_t line_length = fb->fb_line_length;
+    size_t offset      = vinfo->yoffset * line_length + vinfo->xoffset * bytes;
+
+    if(offset + (vinfo->yres - 1) * line_length + row_px * bytes > fb->fb_mem_len) {
+        PyErr_SetString(PyExc_IOError, "The visible area is not in the device memory");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const uint8_t* map = pyfb_fbmap(fbnum);
+
+    if(map != NULL) {
+        for(unsigned long int row = 0; row < vinfo->yres; row++) {
+            pyfb_convertRGBA(map + offset + row * line_length, depth, dst + row * row_px * 4, row_px);
+        }
+
+        pyfb_fbunlock(fbnum);
+        return 0;
+    }
+
+    // the driver can not be mapped, so read the device file row by row
+    void* row_buffer = malloc(row_px * bytes);
+    if(row_buffer == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the capture row buffer");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    for(unsigned long int row = 0; row < vinfo->yres; row++) {
+        off_t row_offset = (off_t)(offset + row * line_length);
+
+        if(pread(fb->fb_fd, row_buffer, row_px * bytes, row_offset) != (ssize_t)(row_px * bytes)) {
+            PyErr_SetString(PyExc_IOError, "Could not read the framebuffer device file");
+            free(row_buffer);
+            pyfb_fbunlock(fbnum);
+            return -1;
+        }
+
+        pyfb_convertRGBA(row_buffer, depth, dst + row * row_px * 4, row_px);
+    }
+
+    free(row_buffer);
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
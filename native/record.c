@@ -0,0 +1,851 @@
+/**
+ * Draw call recording and replay sources.
+ *
+ * A recording starts with the 8 byte header "PFBR", the 16 bit little endian format version and
+ * 2 reserved bytes. Every call follows as the byte of the call type, the byte of the framebuffer
+ * number, the microseconds since the start of the previous call, the duration in microseconds,
+ * the count of arguments, the arguments, the length of the data and the data bytes. All numbers
+ * except the two bytes are LEB128 variable length integers, so a typical call takes 10 to 20 bytes.
+ * The data of a font call is the font file content, the data of a write call and of a sprite load
+ * are the RGBA8888 pixels. All other data are in the byte order of the host: the 32 bit codepoints
+ * of a text call, the 6 doubles of the matrix of a transformed blit, the 32 bit colors of a palette
+ * call, the 256 colors of the colormap followed by the values of a scalar blit, the x coordinates
+ * followed by the y coordinates of a points call, the coordinate pairs of a polyline call, the 6
+ * double coordinates followed by the 3 colors of a triangle, the coordinates followed by the
+ * colors of a triangles call and the struct pyfb_gradient of a gradient fill.
+ */
+#include "pyframebuffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The size of the recording and replay buffers.
+ */
+#define PYFB_RECORD_BUFFER 65536
+
+/**
+ * The maximum encoded size of a call without its data.
+ */
+#define PYFB_RECORD_MAXCALL (2 + 10 * (4 + PYFB_RECORD_MAXARGS))
+
+/**
+ * The maximum data length of a call in a recording to replay.
+ */
+#define PYFB_RECORD_MAXDATA (64 * 1024 * 1024)
+
+atomic_int pyfb_record_enabled = 0;
+
+/**
+ * The state of the recorder, only accessed with the lock.
+ */
+static struct {
+    /**
+     * The lock of the recorder.
+     */
+    lock_t lock;
+
+    /**
+     * The file descriptor of the recording, -1 if not recording.
+     */
+    int fd;
+
+    /**
+     * Not 0 if writing the recording failed.
+     */
+    int failed;
+
+    /**
+     * The start timestamp of the previous call.
+     */
+    uint64_t last;
+
+    /**
+     * The used length of the buffer.
+     */
+    size_t len;
+
+    /**
+     * The buffered calls.
+     */
+    uint8_t buffer[PYFB_RECORD_BUFFER];
+} pyfb_recorder = {ATOMIC_FLAG_INIT, -1, 0, 0, 0, {0}};
+
+/**
+ * Writes the buffered calls to the recording file.
+ */
+static void pyfb_recordFlush(void) {
+    size_t done = 0;
+
+    while(done < pyfb_recorder.len && !pyfb_recorder.failed) {
+        ssize_t written = write(pyfb_recorder.fd, pyfb_recorder.buffer + done, pyfb_recorder.len - done);
+
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if(written <= 0) {
+            pyfb_recorder.failed = 1;
+            break;
+        }
+
+        done += (size_t)written;
+    }
+
+    pyfb_recorder.len = 0;
+}
+
+/**
+ * Encodes a LEB128 variable length integer.
+ *
+ * @param dst The destination, with space for 10 bytes
+ * @param value The value
+ *
+ * @return The count of written bytes
+ */
+static inline size_t pyfb_putVarint(uint8_t* dst, uint64_t value) {
+    size_t len = 0;
+
+    while(value >= 0x80) {
+        dst[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    dst[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * Appends bytes to the buffer, flushing it when it is full.
+ */
+static void pyfb_recordAppend(const void* data, size_t len) {
+    const uint8_t* src = (const uint8_t*)data;
+
+    while(len > 0) {
+        if(pyfb_recorder.len == PYFB_RECORD_BUFFER) {
+            pyfb_recordFlush();
+        }
+
+        size_t chunk = PYFB_RECORD_BUFFER - pyfb_recorder.len;
+        chunk        = chunk < len ? chunk : len;
+        memcpy(pyfb_recorder.buffer + pyfb_recorder.len, src, chunk);
+        pyfb_recorder.len += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * Writes a call, the recorder must be locked.
+ */
+static void pyfb_recordWrite(uint8_t op,
+                             uint8_t fbnum,
+                             uint64_t start,
+                             uint64_t end,
+                             const uint64_t* args,
+                             size_t nargs,
+                             const void* data,
+                             size_t data_len) {
+    uint8_t call[PYFB_RECORD_MAXCALL];
+    size_t len = 0;
+
+    // the first call of a recording has no previous call
+    uint64_t delta     = pyfb_recorder.last == 0 || start < pyfb_recorder.last ? 0 : start - pyfb_recorder.last;
+    pyfb_recorder.last = start;
+
+    call[len++] = op;
+    call[len++] = fbnum;
+    len += pyfb_putVarint(call + len, delta / 1000);
+    len += pyfb_putVarint(call + len, (end - start) / 1000);
+    len += pyfb_putVarint(call + len, nargs);
+
+    for(size_t i = 0; i < nargs; i++) {
+        len += pyfb_putVarint(call + len, args[i]);
+    }
+
+    len += pyfb_putVarint(call + len, data_len);
+
+    if(pyfb_recorder.len + len > PYFB_RECORD_BUFFER) {
+        pyfb_recordFlush();
+    }
+
+    memcpy(pyfb_recorder.buffer + pyfb_recorder.len, call, len);
+    pyfb_recorder.len += len;
+
+    if(data_len > 0) {
+        pyfb_recordAppend(data, data_len);
+    }
+}
+
+void __APISTATUS_internal pyfb_recordCall(uint8_t op,
+                                          uint8_t fbnum,
+                                          uint64_t start,
+                                          const uint64_t* args,
+                                          size_t nargs,
+                                          const void* data,
+                                          size_t data_len) {
+    uint64_t end = pyfb_traceNow();
+    nargs        = nargs < PYFB_RECORD_MAXARGS ? nargs : PYFB_RECORD_MAXARGS;
+
+    lock(pyfb_recorder.lock);
+
+    if(pyfb_recorder.fd != -1) {
+        pyfb_recordWrite(op, fbnum, start, end, args, nargs, data, data_len);
+    }
+
+    unlock(pyfb_recorder.lock);
+}
+
+/**
+ * Writes the opening of a framebuffer and its canvas, the recorder must be locked.
+ */
+static void pyfb_recordOpenLocked(uint8_t fbnum, uint64_t start, uint64_t end) {
+    struct pyfb_videomode_info info;
+    struct pyfb_canvas canvas;
+    pyfb_svinfo(fbnum, &info);
+    pyfb_scanvas(fbnum, &canvas);
+
+    if(info.fb_size_b == 0 || canvas.xres == 0) {
+        // closed in between
+        return;
+    }
+
+    uint64_t open_args[] = {info.vinfo.xres, info.vinfo.yres, info.vinfo.bits_per_pixel};
+    pyfb_recordWrite(PYFB_RECORD_OPEN, fbnum, start, end, open_args, 3, NULL, 0);
+
+    // the rotation resets the canvas, so it is replayed first
+    unsigned long int xres = info.vinfo.xres;
+    unsigned long int yres = info.vinfo.yres;
+    if(canvas.rotation != 0 || canvas.flip != 0) {
+        uint64_t rotation_args[] = {(uint64_t)canvas.rotation * 90, (uint64_t)canvas.flip};
+        pyfb_recordWrite(PYFB_RECORD_ROTATION, fbnum, end, end, rotation_args, 2, NULL, 0);
+
+        if(canvas.rotation & 1) {
+            xres = info.vinfo.yres;
+            yres = info.vinfo.xres;
+        }
+    }
+
+    if(canvas.xres != xres || canvas.yres != yres) {
+        uint64_t canvas_args[] = {canvas.xres, canvas.yres};
+        pyfb_recordWrite(PYFB_RECORD_CANVAS, fbnum, end, end, canvas_args, 2, NULL, 0);
+    }
+
+    if(canvas.xoffset != 0 || canvas.yoffset != 0) {
+        uint64_t viewport_args[] = {canvas.xoffset, canvas.yoffset};
+        pyfb_recordWrite(PYFB_RECORD_VIEWPORT, fbnum, end, end, viewport_args, 2, NULL, 0);
+    }
+}
+
+void __APISTATUS_internal pyfb_recordOpen(uint8_t fbnum, uint64_t start) {
+    uint64_t end = pyfb_traceNow();
+
+    lock(pyfb_recorder.lock);
+
+    if(pyfb_recorder.fd != -1) {
+        pyfb_recordOpenLocked(fbnum, start, end);
+    }
+
+    unlock(pyfb_recorder.lock);
+}
+
+int pyfb_recordStart(int fd) {
+    int record_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if(record_fd == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not use the file descriptor for the recording");
+        return -1;
+    }
+
+    lock(pyfb_recorder.lock);
+
+    if(pyfb_recorder.fd != -1) {
+        PyErr_SetString(PyExc_ValueError, "The draw calls are already recorded");
+        unlock(pyfb_recorder.lock);
+        close(record_fd);
+        return -1;
+    }
+
+    pyfb_recorder.fd     = record_fd;
+    pyfb_recorder.failed = 0;
+    pyfb_recorder.last   = 0;
+    pyfb_recorder.len    = 0;
+
+    const uint8_t header[8] = {'P', 'F', 'B', 'R', PYFB_RECORD_VERSION & 0xFF, PYFB_RECORD_VERSION >> 8, 0, 0};
+    pyfb_recordAppend(header, sizeof(header));
+
+    // the framebuffers opened before are opened at the start of the recording
+    uint64_t now = pyfb_traceNow();
+    for(int i = 0; i < MAX_FRAMEBUFFERS; i++) {
+        pyfb_recordOpenLocked((uint8_t)i, now, now);
+    }
+
+    atomic_store_explicit(&pyfb_record_enabled, 1, memory_order_relaxed);
+    unlock(pyfb_recorder.lock);
+    return 0;
+}
+
+int pyfb_recordStop(void) {
+    lock(pyfb_recorder.lock);
+
+    if(pyfb_recorder.fd == -1) {
+        unlock(pyfb_recorder.lock);
+        return 0;
+    }
+
+    atomic_store_explicit(&pyfb_record_enabled, 0, memory_order_relaxed);
+    pyfb_recordFlush();
+
+    int failed       = pyfb_recorder.failed;
+    failed           = close(pyfb_recorder.fd) != 0 || failed;
+    pyfb_recorder.fd = -1;
+
+    unlock(pyfb_recorder.lock);
+
+    if(failed) {
+        PyErr_SetString(PyExc_IOError, "Could not write the recording");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * The buffered reader of a recording to replay.
+ */
+struct pyfb_replayreader {
+    /**
+     * The file descriptor.
+     */
+    int fd;
+
+    /**
+     * The read position in the buffer.
+     */
+    size_t pos;
+
+    /**
+     * The filled length of the buffer.
+     */
+    size_t len;
+
+    /**
+     * Not 0 at the end of the file or on a read error.
+     */
+    int eof;
+
+    /**
+     * The buffer.
+     */
+    uint8_t buffer[PYFB_RECORD_BUFFER];
+};
+
+/**
+ * Refills the buffer of the reader if it is read completely.
+ *
+ * @return 0 if there are bytes in the buffer, else -1 at the end of the file
+ */
+static int pyfb_replayFill(struct pyfb_replayreader* reader) {
+    if(reader->pos < reader->len) {
+        return 0;
+    }
+
+    ssize_t len = 0;
+
+    do {
+        len = reader->eof ? 0 : read(reader->fd, reader->buffer, PYFB_RECORD_BUFFER);
+    } while(len < 0 && errno == EINTR);
+
+    if(len <= 0) {
+        reader->eof = 1;
+        return -1;
+    }
+
+    reader->pos = 0;
+    reader->len = (size_t)len;
+    return 0;
+}
+
+/**
+ * Reads the next byte of a recording.
+ *
+ * @return The byte, or -1 at the end of the file
+ */
+static int pyfb_replayByte(struct pyfb_replayreader* reader) {
+    if(pyfb_replayFill(reader) != 0) {
+        return -1;
+    }
+
+    return reader->buffer[reader->pos++];
+}
+
+/**
+ * Reads a LEB128 variable length integer of a recording.
+ *
+ * @return 0 on success, else -1 at the end of the file or if the integer is too long
+ */
+static int pyfb_replayVarint(struct pyfb_replayreader* reader, uint64_t* value) {
+    *value = 0;
+
+    for(int shift = 0; shift < 64; shift += 7) {
+        int byte = pyfb_replayByte(reader);
+        if(byte < 0) {
+            return -1;
+        }
+
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Reads data bytes of a recording.
+ *
+ * @return 0 on success, else -1 at the end of the file
+ */
+static int pyfb_replayData(struct pyfb_replayreader* reader, uint8_t* dst, size_t len) {
+    while(len > 0) {
+        if(pyfb_replayFill(reader) != 0) {
+            return -1;
+        }
+
+        size_t chunk = reader->len - reader->pos;
+        chunk        = chunk < len ? chunk : len;
+        memcpy(dst, reader->buffer + reader->pos, chunk);
+        reader->pos += chunk;
+        dst += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * The state of a replay.
+ */
+struct pyfb_replay {
+    /**
+     * The replayed opens per framebuffer, closed at the end.
+     */
+    unsigned int opened[MAX_FRAMEBUFFERS];
+
+    /**
+     * The loaded font per recorded font number, -1 if not loaded.
+     */
+    int fonts[MAX_FONTS];
+
+    /**
+     * The loaded sprite per recorded sprite number, -1 if not loaded.
+     */
+    int sprites[MAX_SPRITES];
+};
+
+/**
+ * Returns the double of a recorded integer argument, see pyfb_recordDouble.
+ *
+ * @param bits The bits of the double
+ *
+ * @return The double
+ */
+static double pyfb_replayDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Executes a recorded call.
+ *
+ * @param replay The state of the replay
+ * @param op The call type
+ * @param fbnum The framebuffer number
+ * @param args The arguments
+ * @param nargs The amount of arguments
+ * @param data The data
+ * @param data_len The length of the data
+ *
+ * @return 0 if the call was executed, 1 if it is skipped
+ */
+static int pyfb_replayCall(struct pyfb_replay* replay,
+                           uint8_t op,
+                           uint8_t fbnum,
+                           const uint64_t* args,
+                           size_t nargs,
+                           const uint8_t* data,
+                           size_t data_len) {
+    // the expected argument count of every call type
+    static const uint8_t arg_count[] = {0, 3, 0, 3, 4, 4, 5, 4, 5, 6, 0, 2, 2, 1, 1, 6, 4, 2, 4, 2, 6, 1, 3, 1, 0, 7, 4, 3, 0,
+                                        2, 6};
+
+    if(op == 0 || op >= sizeof(arg_count) || nargs < arg_count[op]) {
+        return 1;
+    }
+
+    struct pyfb_color color;
+    struct pyfb_color background;
+    double matrix[6];
+    uint32_t colors[PYFB_PALETTE_SIZE];
+    uint32_t colormap[PYFB_COLORMAP_SIZE];
+    double coords[6];
+    uint32_t corners[3];
+    struct pyfb_gradient gradient;
+
+    switch(op) {
+    case PYFB_RECORD_OPEN:
+        if(pyfb_openVirtual(fbnum, args[0], args[1], (unsigned int)args[2], -1, PYFB_DUMP_RAW) == 0 &&
+           fbnum < MAX_FRAMEBUFFERS) {
+            replay->opened[fbnum]++;
+        }
+        break;
+    case PYFB_RECORD_CLOSE:
+        if(fbnum < MAX_FRAMEBUFFERS && replay->opened[fbnum] > 0) {
+            replay->opened[fbnum]--;
+            pyfb_close(fbnum);
+        }
+        break;
+    case PYFB_RECORD_PIXEL:
+        pyfb_initcolor_u32(&color, (uint32_t)args[2]);
+        pyfb_ssetPixel(fbnum, args[0], args[1], &color);
+        break;
+    case PYFB_RECORD_HLINE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[3]);
+        pyfb_sdrawHorizontalLine(fbnum, args[0], args[1], args[2], &color);
+        break;
+    case PYFB_RECORD_VLINE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[3]);
+        pyfb_sdrawVerticalLine(fbnum, args[0], args[1], args[2], &color);
+        break;
+    case PYFB_RECORD_LINE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[4]);
+        pyfb_sdrawLine(fbnum, args[0], args[1], args[2], args[3], &color);
+        break;
+    case PYFB_RECORD_CIRCLE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[3]);
+        pyfb_sdrawCircle(fbnum, args[0], args[1], args[2], &color);
+        break;
+    case PYFB_RECORD_ELLIPSE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[4]);
+        pyfb_sdrawEllipse(fbnum, args[0], args[1], args[2], args[3], &color);
+        break;
+    case PYFB_RECORD_COPYAREA:
+        pyfb_scopyArea(fbnum, args[0], args[1], args[2], args[3], args[4], args[5]);
+        break;
+    case PYFB_RECORD_FLUSH:
+        pyfb_flushBuffer(fbnum);
+        break;
+    case PYFB_RECORD_CANVAS:
+        pyfb_ssetCanvas(fbnum, args[0], args[1]);
+        break;
+    case PYFB_RECORD_VIEWPORT:
+        pyfb_ssetViewport(fbnum, args[0], args[1]);
+        break;
+    case PYFB_RECORD_FONT:
+        if(args[0] < MAX_FONTS && replay->fonts[args[0]] < 0) {
+            replay->fonts[args[0]] = pyfb_loadFont(data, data_len);
+        }
+        break;
+    case PYFB_RECORD_FREEFONT:
+        if(args[0] >= MAX_FONTS || replay->fonts[args[0]] < 0) {
+            return 1;
+        }
+
+        pyfb_freeFont((uint8_t)replay->fonts[args[0]]);
+        replay->fonts[args[0]] = -1;
+        break;
+    case PYFB_RECORD_TEXT:
+        // the font must have been loaded while recording
+        if(args[2] >= MAX_FONTS || replay->fonts[args[2]] < 0) {
+            return 1;
+        }
+
+        pyfb_initcolor_u32(&color, (uint32_t)args[3]);
+        pyfb_initcolor_u32(&background, (uint32_t)args[5]);
+        pyfb_sdrawText(fbnum,
+                       args[0],
+                       args[1],
+                       (const uint32_t*)data,
+                       data_len / sizeof(uint32_t),
+                       (uint8_t)replay->fonts[args[2]],
+                       &color,
+                       args[4] ? &background : NULL);
+        break;
+    case PYFB_RECORD_DAMAGE:
+        pyfb_sdamage(fbnum, args[0], args[1], args[2], args[3]);
+        break;
+    case PYFB_RECORD_ROTATION:
+        pyfb_ssetRotation(fbnum, (unsigned int)args[0], (int)args[1]);
+        break;
+    case PYFB_RECORD_WRITERECT:
+        pyfb_suploadRect(fbnum, args[0], args[1], args[2], args[3], data, data_len);
+        break;
+    case PYFB_RECORD_BLIT:
+        if(data_len != 6 * sizeof(double) || args[0] >= MAX_FRAMEBUFFERS) {
+            return 1;
+        }
+
+        memcpy(matrix, data, sizeof(matrix));
+        pyfb_sblitTransformed(fbnum, (uint8_t)args[0], matrix, (int)args[1]);
+        break;
+    case PYFB_RECORD_LOADSPRITE:
+        if(args[0] < MAX_SPRITES && replay->sprites[args[0]] < 0) {
+            uint32_t key             = (uint32_t)args[4];
+            replay->sprites[args[0]] = pyfb_loadSprite(data,
+                                                       data_len,
+                                                       (unsigned int)args[1],
+                                                       (unsigned int)args[2],
+                                                       args[3] ? &key : NULL,
+                                                       (unsigned int)args[5]);
+        }
+        break;
+    case PYFB_RECORD_FREESPRITE:
+        if(args[0] >= MAX_SPRITES || replay->sprites[args[0]] < 0) {
+            return 1;
+        }
+
+        pyfb_freeSprite((uint8_t)replay->sprites[args[0]]);
+        replay->sprites[args[0]] = -1;
+        break;
+    case PYFB_RECORD_SPRITE:
+        // the sprite must have been loaded while recording
+        if(args[0] >= MAX_SPRITES || replay->sprites[args[0]] < 0) {
+            return 1;
+        }
+
+        pyfb_sdrawSprite(fbnum, (uint8_t)replay->sprites[args[0]], (long int)(int64_t)args[1], (long int)(int64_t)args[2]);
+        break;
+    case PYFB_RECORD_PALETTE:
+        if(args[0] > PYFB_PALETTE_SIZE || data_len != args[0] * sizeof(uint32_t)) {
+            return 1;
+        }
+
+        memcpy(colors, data, data_len);
+        pyfb_ssetPalette(fbnum, colors, (unsigned int)args[0]);
+        break;
+    case PYFB_RECORD_CLEARPALETTE:
+        pyfb_sclearPalette(fbnum);
+        break;
+    case PYFB_RECORD_SCALAR:
+        if(data_len < sizeof(colormap) || args[1] == 0 || pyfb_scalarSize((int)args[0]) == 0) {
+            return 1;
+        }
+
+        memcpy(colormap, data, sizeof(colormap));
+        pyfb_sblitScalar(fbnum,
+                         data + sizeof(colormap),
+                         data_len - sizeof(colormap),
+                         (int)args[0],
+                         args[1],
+                         (data_len - sizeof(colormap)) / pyfb_scalarSize((int)args[0]) / args[1],
+                         (long int)(int64_t)args[2],
+                         (long int)(int64_t)args[3],
+                         colormap,
+                         pyfb_replayDouble(args[5]),
+                         pyfb_replayDouble(args[6]),
+                         (unsigned int)args[4]);
+        break;
+    case PYFB_RECORD_POINTS:
+        if(args[2] > data_len) {
+            return 1;
+        }
+
+        pyfb_initcolor_u32(&color, (uint32_t)args[3]);
+        pyfb_sdrawPoints(fbnum, data, args[2], (int)args[0], data + args[2], data_len - args[2], (int)args[1], &color);
+        break;
+    case PYFB_RECORD_POLYLINE:
+        pyfb_initcolor_u32(&color, (uint32_t)args[2]);
+        pyfb_sdrawPolyline(fbnum, data, data_len, (int)args[0], (int)args[1], &color);
+        break;
+    case PYFB_RECORD_TRIANGLE:
+        if(data_len != sizeof(coords) + sizeof(corners)) {
+            return 1;
+        }
+
+        memcpy(coords, data, sizeof(coords));
+        memcpy(corners, data + sizeof(coords), sizeof(corners));
+        pyfb_sfillTriangle(fbnum, coords, corners);
+        break;
+    case PYFB_RECORD_TRIANGLES:
+        if(args[1] > data_len) {
+            return 1;
+        }
+
+        pyfb_sfillTriangles(fbnum, data, args[1], (int)args[0], data + args[1], data_len - args[1]);
+        break;
+    case PYFB_RECORD_GRADIENT:
+        if(data_len != sizeof(gradient)) {
+            return 1;
+        }
+
+        memcpy(&gradient, data, sizeof(gradient));
+        pyfb_sfillGradient(fbnum,
+                           &gradient,
+                           (long int)(int64_t)args[0],
+                           (long int)(int64_t)args[1],
+                           args[2],
+                           args[3],
+                           (int)args[4],
+                           (int)args[5]);
+        break;
+    default:
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Waits until a time of the monotonic clock, without holding the global interpreter lock.
+ *
+ * @param ns The time in nanoseconds
+ */
+static void pyfb_replayWait(uint64_t ns) {
+    if(pyfb_traceNow() >= ns) {
+        // the replay is behind the recording, so do not sleep at all
+        return;
+    }
+
+    struct timespec ts = {(time_t)(ns / 1000000000u), (long)(ns % 1000000000u)};
+
+    Py_BEGIN_ALLOW_THREADS
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+    Py_END_ALLOW_THREADS
+}
+
+int pyfb_sreplay(int fd, int paced, struct pyfb_replaystats* stats) {
+    struct pyfb_replayreader* reader = malloc(sizeof(struct pyfb_replayreader));
+    if(reader == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the replay buffer");
+        return -1;
+    }
+
+    reader->fd  = fd;
+    reader->pos = 0;
+    reader->len = 0;
+    reader->eof = 0;
+
+    uint8_t header[8];
+    if(pyfb_replayData(reader, header, sizeof(header)) != 0 || memcmp(header, "PFBR", 4) != 0) {
+        PyErr_SetString(PyExc_ValueError, "The file is not a pyframebuffer recording");
+        free(reader);
+        return -1;
+    }
+
+    if((header[4] | (header[5] << 8)) != PYFB_RECORD_VERSION) {
+        PyErr_SetString(PyExc_ValueError, "The version of the recording is not supported");
+        free(reader);
+        return -1;
+    }
+
+    struct pyfb_replay replay;
+    memset(replay.opened, 0, sizeof(replay.opened));
+    for(int i = 0; i < MAX_FONTS; i++) {
+        replay.fonts[i] = -1;
+    }
+
+    for(int i = 0; i < MAX_SPRITES; i++) {
+        replay.sprites[i] = -1;
+    }
+
+    memset(stats, 0, sizeof(struct pyfb_replaystats));
+
+    uint8_t* data        = NULL;
+    size_t data_cap      = 0;
+    uint64_t begin       = pyfb_traceNow();
+    uint64_t offset      = 0;
+    uint64_t recorded_us = 0;
+
+    while(1) {
+        int op    = pyfb_replayByte(reader);
+        int fbnum = pyfb_replayByte(reader);
+        uint64_t delta;
+        uint64_t duration;
+        uint64_t nargs;
+        uint64_t args[PYFB_RECORD_MAXARGS];
+        uint64_t data_len;
+
+        if(op < 0 || fbnum < 0 || pyfb_replayVarint(reader, &delta) != 0 || pyfb_replayVarint(reader, &duration) != 0 ||
+           pyfb_replayVarint(reader, &nargs) != 0 || nargs > PYFB_RECORD_MAXARGS) {
+            break;
+        }
+
+        int truncated = 0;
+        for(uint64_t i = 0; i < nargs && !truncated; i++) {
+            truncated = pyfb_replayVarint(reader, &args[i]) != 0;
+        }
+
+        if(truncated || pyfb_replayVarint(reader, &data_len) != 0 || data_len > PYFB_RECORD_MAXDATA) {
+            break;
+        }
+
+        if(data_len > data_cap) {
+            uint8_t* grown = realloc(data, data_len);
+            if(grown == NULL) {
+                break;
+            }
+
+            data     = grown;
+            data_cap = data_len;
+        }
+
+        if(pyfb_replayData(reader, data, data_len) != 0) {
+            break;
+        }
+
+        offset += delta;
+        recorded_us = offset + duration > recorded_us ? offset + duration : recorded_us;
+        stats->busy_ns += duration * 1000;
+
+        if(paced) {
+            pyfb_replayWait(begin + offset * 1000);
+        }
+
+        if(pyfb_replayCall(&replay, (uint8_t)op, (uint8_t)fbnum, args, nargs, data, data_len) != 0) {
+            stats->skipped++;
+            continue;
+        }
+
+        stats->calls++;
+        stats->flushes += op == PYFB_RECORD_FLUSH;
+
+        if(PyErr_Occurred()) {
+            PyErr_Clear();
+            stats->errors++;
+        }
+    }
+
+    stats->replay_ns   = pyfb_traceNow() - begin;
+    stats->recorded_ns = recorded_us * 1000;
+
+    // close the framebuffers and free the fonts and sprites of the replay
+    for(int i = 0; i < MAX_FRAMEBUFFERS; i++) {
+        while(replay.opened[i] > 0) {
+            pyfb_close((uint8_t)i);
+            replay.opened[i]--;
+        }
+    }
+
+    for(int i = 0; i < MAX_FONTS; i++) {
+        if(replay.fonts[i] >= 0) {
+            pyfb_freeFont((uint8_t)replay.fonts[i]);
+        }
+    }
+
+    for(int i = 0; i < MAX_SPRITES; i++) {
+        if(replay.sprites[i] >= 0) {
+            pyfb_freeSprite((uint8_t)replay.sprites[i]);
+        }
+    }
+
+    PyErr_Clear();
+    free(data);
+    free(reader);
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * Canvas rotation sources.
+ */
+#include "pyframebuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The edge length of the blocks rotated at once in pixels. A block of the canvas and of
+ * the device rows fit into the L1 cache together, so the columns read by a quarter turn
+ * hit the cache lines fetched for the previous row.
+ */
+#define PYFB_ROTATE_BLOCK 32
+
+/**
+ * Maps a pixel of the screen to the canvas, the inverse of pyfb_rotateToScreen.
+ *
+ * @param canvas The canvas
+ * @param xres The width of the screen in canvas coordinates
+ * @param yres The height of the screen in canvas coordinates
+ * @param px The x coordinate on the screen
+ * @param py The y coordinate on the screen
+ * @param lx The pointer to store the x coordinate on the canvas viewport to
+ * @param ly The pointer to store the y coordinate on the canvas viewport to
+ */
+static void pyfb_rotateToCanvas(const struct pyfb_canvas* canvas,
+                                long int xres,
+                                long int yres,
+                                long int px,
+                                long int py,
+                                long int* lx,
+                                long int* ly) {
+    long int fx, fy;
+
+    // undo the clockwise rotation
+    switch(canvas->rotation) {
+        case 1:
+            fx = py;
+            fy = yres - 1 - px;
+            break;
+        case 2:
+            fx = xres - 1 - px;
+            fy = yres - 1 - py;
+            break;
+        case 3:
+            fx = xres - 1 - py;
+            fy = px;
+            break;
+        default:
+            fx = px;
+            fy = py;
+            break;
+    }
+
+    // then undo the mirroring
+    *lx = canvas->flip & PYFB_FLIP_X ? xres - 1 - fx : fx;
+    *ly = canvas->flip & PYFB_FLIP_Y ? yres - 1 - fy : fy;
+}
+
+/**
+ * Maps a pixel of the canvas to the screen, mirroring first and rotating clockwise after.
+ *
+ * @param canvas The canvas
+ * @param xres The width of the screen in canvas coordinates
+ * @param yres The height of the screen in canvas coordinates
+ * @param lx The x coordinate on the canvas viewport
+ * @param ly The y coordinate on the canvas viewport
+ * @param px The pointer to store the x coordinate on the screen to
+ * @param py The pointer to store the y coordinate on the screen to
+ */
+static void pyfb_rotateToScreen(const struct pyfb_canvas* canvas,
+                                long int xres,
+                                long int yres,
+                                long int lx,
+                                long int ly,
+                                long int* px,
+                                long int* py) {
+    long int fx = canvas->flip & PYFB_FLIP_X ? xres - 1 - lx : lx;
+    long int fy = canvas->flip & PYFB_FLIP_Y ? yres - 1 - ly : ly;
+
+    switch(canvas->rotation) {
+        case 1:
+            *px = yres - 1 - fy;
+            *py = fx;
+            break;
+        case 2:
+            *px = xres - 1 - fx;
+            *py = yres - 1 - fy;
+            break;
+        case 3:
+            *px = fy;
+            *py = xres - 1 - fx;
+            break;
+        default:
+            *px = fx;
+            *py = fy;
+            break;
+    }
+}
+
+/**
+ * Copies a rectangle of the screen from the canvas of a 32 bit framebuffer in blocks. The
+ * canvas pixel of a screen pixel is at origin + x * step_x + y * step_y, so the inner loop
+ * is a plain strided copy the compiler can vectorize where the steps allow it.
+ *
+ * @param dst The rows of the rectangle, packed
+ * @param src The offscreen buffer
+ * @param origin The canvas index of the upper left pixel of the rectangle
+ * @param step_x The canvas index step of one screen column
+ * @param step_y The canvas index step of one screen row
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ */
+static void pyfb_rotate32(uint32_t* dst,
+                          const uint32_t* src,
+                          long int origin,
+                          long int step_x,
+                          long int step_y,
+                          unsigned long int width,
+                          unsigned long int height) {
+    for(unsigned long int by = 0; by < height; by += PYFB_ROTATE_BLOCK) {
+        unsigned long int ey = by + PYFB_ROTATE_BLOCK < height ? by + PYFB_ROTATE_BLOCK : height;
+
+        for(unsigned long int bx = 0; bx < width; bx += PYFB_ROTATE_BLOCK) {
+            unsigned long int ex = bx + PYFB_ROTATE_BLOCK < width ? bx + PYFB_ROTATE_BLOCK : width;
+
+            for(unsigned long int y = by; y < ey; y++) {
+                const uint32_t* in = src + origin + (long int)y * step_y;
+                uint32_t* out      = dst + y * width;
+
+                for(unsigned long int x = bx; x < ex; x++) {
+                    out[x] = in[(long int)x * step_x];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Copies a rectangle of the screen from the canvas of a 16 bit framebuffer in blocks, see
+ * pyfb_rotate32.
+ */
+static void pyfb_rotate16(uint16_t* dst,
+                          const uint16_t* src,
+                          long int origin,
+                          long int step_x,
+                          long int step_y,
+                          unsigned long int width,
+                          unsigned long int height) {
+    for(unsigned long int by = 0; by < height; by += PYFB_ROTATE_BLOCK) {
+        unsigned long int ey = by + PYFB_ROTATE_BLOCK < height ? by + PYFB_ROTATE_BLOCK : height;
+
+        for(unsigned long int bx = 0; bx < width; bx += PYFB_ROTATE_BLOCK) {
+            unsigned long int ex = bx + PYFB_ROTATE_BLOCK < width ? bx + PYFB_ROTATE_BLOCK : width;
+
+            for(unsigned long int y = by; y < ey; y++) {
+                const uint16_t* in = src + origin + (long int)y * step_y;
+                uint16_t* out      = dst + y * width;
+
+                for(unsigned long int x = bx; x < ex; x++) {
+                    out[x] = in[(long int)x * step_x];
+                }
+            }
+        }
+    }
+}
+
+ssize_t __APISTATUS_internal pyfb_writeRotated(uint8_t fbnum, const struct pyfb_damage* damage) {
+    const struct pyfb_framebuffer* fb     = pyfb_fbptr(fbnum);
+    const struct pyfb_canvas* canvas      = &fb->canvas;
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
+
+    // the damage is a rectangle on the screen too, spanned by its corners
+    long int ax, ay, bx, by;
+    pyfb_rotateToScreen(canvas, (long int)xres, (long int)yres, (long int)damage->x0, (long int)damage->y0, &ax, &ay);
+    pyfb_rotateToScreen(canvas, (long int)xres, (long int)yres, (long int)damage->x1 - 1, (long int)damage->y1 - 1, &bx, &by);
+
+    long int x0              = ax < bx ? ax : bx;
+    long int y0              = ay < by ? ay : by;
+    unsigned long int width  = (unsigned long int)((ax < bx ? bx : ax) - x0 + 1);
+    unsigned long int height = (unsigned long int)((ay < by ? by : ay) - y0 + 1);
+
+    // the canvas index is linear in the screen coordinates
+    long int ox, oy, sx, sy, tx, ty;
+    pyfb_rotateToCanvas(canvas, (long int)xres, (long int)yres, x0, y0, &ox, &oy);
+    pyfb_rotateToCanvas(canvas, (long int)xres, (long int)yres, x0 + 1, y0, &sx, &sy);
+    pyfb_rotateToCanvas(canvas, (long int)xres, (long int)yres, x0, y0 + 1, &tx, &ty);
+
+    long int stride = (long int)canvas->xres;
+    long int origin = ((long int)canvas->yoffset + oy) * stride + (long int)canvas->xoffset + ox;
+    long int step_x = (sx - ox) + (sy - oy) * stride;
+    long int step_y = (tx - ox) + (ty - oy) * stride;
+
+    size_t bytes = vinfo->bits_per_pixel / 8;
+
+    if(bytes == 4) {
+        pyfb_rotate32((uint32_t*)fb->rotate_buffer, fb->u32_buffer, origin, step_x, step_y, width, height);
+    } else {
+        pyfb_rotate16((uint16_t*)fb->rotate_buffer, fb->u16_buffer, origin, step_x, step_y, width, height);
+    }
+
+    // now write the packed rows
+    size_t row_len     = width * bytes;
+    size_t line_length = fb->fb_line_length;
+    const uint8_t* src = (const uint8_t*)fb->rotate_buffer;
+    off_t offset       = (off_t)((vinfo->yoffset + y0) * line_length + (vinfo->xoffset + x0) * bytes);
+
+    if(row_len == line_length) {
+        size_t len = row_len * height;
+        return pwrite(fb->fb_fd, src, len, offset) == (ssize_t)len ? (ssize_t)len : -1;
+    }
+
+    for(unsigned long int row = 0; row < height; row++) {
+        if(pwrite(fb->fb_fd, src + row * row_len, row_len, offset + (off_t)(row * line_length)) != (ssize_t)row_len) {
+            return -1;
+        }
+    }
+
+    return (ssize_t)(row_len * height);
+}
+
+int pyfb_ssetRotation(uint8_t fbnum, unsigned int degrees, int flip) {
+    // first check if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(degrees % 90 != 0 || degrees > 270) {
+        PyErr_SetString(PyExc_ValueError, "The rotation must be 0, 90, 180 or 270 degrees");
+        return -1;
+    }
+
+    if((flip & ~(PYFB_FLIP_X | PYFB_FLIP_Y)) != 0) {
+        PyErr_SetString(PyExc_ValueError, "The flip is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    const char* error           = NULL;
+
+    if(fb->shared != NULL) {
+        error = "A shared offscreen buffer can not be rotated";
+    } else if(fb->stream != NULL || fb->mirror != NULL || fb->mirror_source != 0) {
+        error = "A streamed or mirrored framebuffer can not be rotated";
+    } else if(fb->canvas.panning) {
+        error = "A canvas panned by the driver can not be rotated";
+    } else if(fb->palette != NULL) {
+        error = "An indexed canvas can not be rotated";
+    }
+
+    if(error != NULL) {
+        PyErr_SetString(PyExc_IOError, error);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // a fresh offscreen buffer of the screen size, and the device rows of a flush
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+    int rotation                          = (int)(degrees / 90);
+    unsigned long int fb_size_b           = vinfo->xres * vinfo->yres * (vinfo->bits_per_pixel / 8);
+    void* buffer                          = calloc(fb_size_b, 1);
+    void* rotate_buffer                   = rotation != 0 || flip != 0 ? malloc(fb_size_b) : NULL;
+
+    if(buffer == NULL || (rotate_buffer == NULL && (rotation != 0 || flip != 0))) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate offscreen buffer.");
+        free(buffer);
+        free(rotate_buffer);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    free(fb->u32_buffer);
+    free(fb->rotate_buffer);
+    fb->u32_buffer        = (uint32_t*)buffer;
+    fb->rotate_buffer     = rotate_buffer;
+    fb->fb_info.fb_size_b = fb_size_b;
+
+    // a quarter turn swaps the sides of the canvas
+    unsigned long int xres    = rotation & 1 ? vinfo->yres : vinfo->xres;
+    unsigned long int yres    = rotation & 1 ? vinfo->xres : vinfo->yres;
+    struct pyfb_canvas canvas = {xres, yres, 0, 0, 0, rotation, flip};
+    fb->canvas                = canvas;
+    memset((void*)&fb->damage, 0, sizeof(struct pyfb_damage));
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
@@ -0,0 +1,489 @@
+/**
+ * Shared offscreen buffer sources.
+ */
+#include "pyframebuffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * The offset of the offscreen buffer in the segment, the header is in the first page.
+ */
+#define PYFB_SHARED_DATA 4096
+
+/**
+ * The version of the segment layout.
+ */
+#define PYFB_SHARED_VERSION 1
+
+/**
+ * The header at the beginning of a shared offscreen buffer segment.
+ */
+struct pyfb_sharedheader {
+    /**
+     * PYFB_SHARED_MAGIC, written last by the owner.
+     */
+    atomic_uint magic;
+
+    /**
+     * PYFB_SHARED_VERSION.
+     */
+    uint32_t version;
+
+    /**
+     * The X resolution.
+     */
+    uint32_t xres;
+
+    /**
+     * The Y resolution.
+     */
+    uint32_t yres;
+
+    /**
+     * The color depth, 16 or 32.
+     */
+    uint32_t depth;
+
+    /**
+     * The futex lock of the damage, 0 unlocked, 1 locked, 2 locked with waiters.
+     */
+    atomic_uint lock;
+
+    /**
+     * Incremented under the lock by every flush of another process, the owner waits on it.
+     */
+    atomic_uint seq;
+
+    /**
+     * The damage merged by the processes since the last flush of the owner, guarded by the lock.
+     */
+    uint32_t damage[4];
+};
+
+/**
+ * The state of a framebuffer with a shared offscreen buffer in this process.
+ */
+struct pyfb_shared {
+    /**
+     * The mapped segment.
+     */
+    struct pyfb_sharedheader* header;
+
+    /**
+     * The length of the mapping.
+     */
+    size_t map_len;
+
+    /**
+     * Not 0 if this process owns the segment and flushes it to the device.
+     */
+    int owner;
+
+    /**
+     * The sequence number of the segment at the last flush of the owner.
+     */
+    unsigned int seen;
+
+    /**
+     * The count of threads waiting for damage.
+     */
+    atomic_int waiting;
+
+    /**
+     * Set when the framebuffer is closed, so waiting threads return.
+     */
+    atomic_int closing;
+
+    /**
+     * The name of the segment.
+     */
+    char name[PYFB_SHARED_NAME_MAX];
+};
+
+/**
+ * Waits on a futex word in shared memory while it has a value.
+ */
+static int pyfb_futexWait(atomic_uint* word, unsigned int value, const struct timespec* timeout) {
+    return (int)syscall(SYS_futex, (unsigned int*)word, FUTEX_WAIT, value, timeout, NULL, 0);
+}
+
+/**
+ * Wakes the waiters on a futex word in shared memory.
+ */
+static void pyfb_futexWake(atomic_uint* word, int count) {
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+/**
+ * Locks a futex lock shared between processes.
+ */
+static void pyfb_futexLock(atomic_uint* word) {
+    unsigned int state = 0;
+    if(atomic_compare_exchange_strong(word, &state, 1)) {
+        return;
+    }
+
+    // mark the lock as contended and sleep until it is released
+    if(state != 2) {
+        state = atomic_exchange(word, 2);
+    }
+
+    while(state != 0) {
+        pyfb_futexWait(word, 2, NULL);
+        state = atomic_exchange(word, 2);
+    }
+}
+
+/**
+ * Unlocks a futex lock shared between processes.
+ */
+static void pyfb_futexUnlock(atomic_uint* word) {
+    if(atomic_fetch_sub(word, 1) != 1) {
+        atomic_store(word, 0);
+        pyfb_futexWake(word, 1);
+    }
+}
+
+/**
+ * Merges a rectangle into the damage of the segment. The lock must be held.
+ */
+static void pyfb_sharedMerge(struct pyfb_sharedheader* header, const struct pyfb_damage* damage) {
+    uint32_t* rect = header->damage;
+
+    if(rect[2] <= rect[0]) {
+        rect[0] = (uint32_t)damage->x0;
+        rect[1] = (uint32_t)damage->y0;
+        rect[2] = (uint32_t)damage->x1;
+        rect[3] = (uint32_t)damage->y1;
+        return;
+    }
+
+    rect[0] = damage->x0 < rect[0] ? (uint32_t)damage->x0 : rect[0];
+    rect[1] = damage->y0 < rect[1] ? (uint32_t)damage->y0 : rect[1];
+    rect[2] = damage->x1 > rect[2] ? (uint32_t)damage->x1 : rect[2];
+    rect[3] = damage->y1 > rect[3] ? (uint32_t)damage->y1 : rect[3];
+}
+
+/**
+ * Creates the segment of the owner, with the current offscreen buffer as content.
+ *
+ * @return The mapped segment, or NULL with a Python exception set
+ */
+static struct pyfb_sharedheader* pyfb_sharedCreate(struct pyfb_framebuffer* fb, const char* name, size_t* map_len) {
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+    size_t len                            = PYFB_SHARED_DATA + (size_t)fb->fb_info.fb_size_b;
+
+    // the owner reinitializes a segment left over by a crashed owner
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(fd == -1 || ftruncate(fd, (off_t)len) == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not create the shared offscreen buffer");
+        if(fd != -1) {
+            close(fd);
+            shm_unlink(name);
+        }
+        return NULL;
+    }
+
+    void* map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        PyErr_SetString(PyExc_IOError, "Could not map the shared offscreen buffer");
+        shm_unlink(name);
+        return NULL;
+    }
+
+    struct pyfb_sharedheader* header = (struct pyfb_sharedheader*)map;
+    memset((void*)header, 0, sizeof(struct pyfb_sharedheader));
+    header->version = PYFB_SHARED_VERSION;
+    header->xres    = vinfo->xres;
+    header->yres    = vinfo->yres;
+    header->depth   = vinfo->bits_per_pixel;
+
+    memcpy((uint8_t*)map + PYFB_SHARED_DATA, (void*)fb->u32_buffer, (size_t)fb->fb_info.fb_size_b);
+
+    // publish the header for the other processes
+    atomic_store(&header->magic, PYFB_SHARED_MAGIC);
+
+    *map_len = len;
+    return header;
+}
+
+/**
+ * Maps the segment of an owner.
+ *
+ * @return The mapped segment, or NULL with a Python exception set
+ */
+static struct pyfb_sharedheader* pyfb_sharedAttach(const char* name, size_t* map_len) {
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if(fd == -1) {
+        PyErr_SetString(PyExc_IOError, "Could not open the shared offscreen buffer");
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) == -1 || st.st_size < PYFB_SHARED_DATA) {
+        PyErr_SetString(PyExc_IOError, "The shared offscreen buffer is not valid");
+        close(fd);
+        return NULL;
+    }
+
+    size_t len = (size_t)st.st_size;
+    void* map  = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        PyErr_SetString(PyExc_IOError, "Could not map the shared offscreen buffer");
+        return NULL;
+    }
+
+    struct pyfb_sharedheader* header = (struct pyfb_sharedheader*)map;
+
+    if(atomic_load(&header->magic) != PYFB_SHARED_MAGIC || header->version != PYFB_SHARED_VERSION ||
+       (header->depth != 16 && header->depth != 32) || header->xres == 0 || header->yres == 0 ||
+       header->xres > PYFB_VIRTUAL_MAXRES || header->yres > PYFB_VIRTUAL_MAXRES ||
+       PYFB_SHARED_DATA + (size_t)header->xres * header->yres * (header->depth / 8) > len) {
+        PyErr_SetString(PyExc_IOError, "The shared offscreen buffer is not valid");
+        munmap(map, len);
+        return NULL;
+    }
+
+    *map_len = len;
+    return header;
+}
+
+int pyfb_sopenShared(uint8_t fbnum,
+                     const char* name,
+                     int owner,
+                     unsigned long int xres,
+                     unsigned long int yres,
+                     unsigned int depth) {
+    // first test if the arguments are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(name[0] != '/' || strlen(name) >= PYFB_SHARED_NAME_MAX || strchr(name + 1, '/') != NULL || name[1] == '\0') {
+        PyErr_SetString(PyExc_ValueError, "The name of the shared offscreen buffer is not valid");
+        return -1;
+    }
+
+    struct pyfb_sharedheader* header = NULL;
+    size_t map_len                   = 0;
+
+    // the owner opens the device or its virtual framebuffer, the others a virtual
+    // framebuffer of the segment resolution
+    if(owner) {
+        int exitcode = xres != 0 ? pyfb_openVirtual(fbnum, xres, yres, depth, -1, PYFB_DUMP_RAW) : pyfb_open(fbnum);
+        if(exitcode != 0) {
+            return -1;
+        }
+    } else {
+        header = pyfb_sharedAttach(name, &map_len);
+        if(header == NULL) {
+            return -1;
+        }
+
+        if(pyfb_openVirtual(fbnum, header->xres, header->yres, header->depth, -1, PYFB_DUMP_RAW) != 0) {
+            munmap((void*)header, map_len);
+            return -1;
+        }
+    }
+
+    pyfb_fblock(fbnum);
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    // opened again by this process, the open incremented the users
+    if(fb->shared != NULL && fb->shared->owner == (owner != 0) && strcmp(fb->shared->name, name) == 0) {
+        pyfb_fbunlock(fbnum);
+        if(header != NULL) {
+            munmap((void*)header, map_len);
+        }
+        return 0;
+    }
+
+    if(fb->users != 1 || fb->shared != NULL || fb->canvas.panning) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is allready in use by another offscreen buffer");
+        pyfb_fbunlock(fbnum);
+        pyfb_close(fbnum);
+        if(header != NULL) {
+            munmap((void*)header, map_len);
+        }
+        return -1;
+    }
+
+    struct pyfb_shared* shared = (struct pyfb_shared*)calloc(1, sizeof(struct pyfb_shared));
+    if(shared == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the shared offscreen buffer state");
+    } else if(owner) {
+        header = pyfb_sharedCreate(fb, name, &map_len);
+    }
+
+    if(header == NULL || shared == NULL) {
+        pyfb_fbunlock(fbnum);
+        pyfb_close(fbnum);
+        if(header != NULL) {
+            munmap((void*)header, map_len);
+        }
+        free(shared);
+        return -1;
+    }
+
+    shared->header  = header;
+    shared->map_len = map_len;
+    shared->owner   = owner != 0;
+    shared->seen    = atomic_load(&header->seq);
+    atomic_init(&shared->waiting, 0);
+    atomic_init(&shared->closing, 0);
+    strcpy(shared->name, name);
+
+    // draw into the segment instead of the private offscreen buffer
+    free((void*)fb->u32_buffer);
+    fb->u32_buffer = (uint32_t*)((uint8_t*)header + PYFB_SHARED_DATA);
+    fb->shared     = shared;
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+int __APISTATUS_internal pyfb_sharedFlush(uint8_t fbnum, size_t* bytes) {
+    struct pyfb_framebuffer* fb           = pyfb_fbptr(fbnum);
+    struct pyfb_shared* shared            = fb->shared;
+    struct pyfb_sharedheader* header      = shared->header;
+    const struct fb_var_screeninfo* vinfo = &fb->fb_info.vinfo;
+    struct pyfb_damage screen             = {0, 0, vinfo->xres, vinfo->yres};
+    int damaged                           = fb->damage.x1 > fb->damage.x0;
+
+    pyfb_futexLock(&header->lock);
+
+    if(!shared->owner) {
+        // without marked damage the whole screen may have changed
+        pyfb_sharedMerge(header, damaged ? &fb->damage : &screen);
+        atomic_fetch_add(&header->seq, 1);
+        pyfb_futexUnlock(&header->lock);
+        pyfb_futexWake(&header->seq, INT_MAX);
+        return 0;
+    }
+
+    if(damaged) {
+        pyfb_sharedMerge(header, &fb->damage);
+    }
+
+    // take the damage of all processes
+    struct pyfb_damage rect = {header->damage[0], header->damage[1], header->damage[2], header->damage[3]};
+    memset(header->damage, 0, sizeof(header->damage));
+    shared->seen = atomic_load(&header->seq);
+
+    pyfb_futexUnlock(&header->lock);
+
+    // nothing marked anywhere, so write the whole screen like a private offscreen buffer
+    if(rect.x1 <= rect.x0) {
+        rect = screen;
+    }
+
+    *bytes = (rect.x1 - rect.x0) * (rect.y1 - rect.y0) * (vinfo->bits_per_pixel / 8);
+    return pyfb_writeRect(fbnum, &rect);
+}
+
+void __APISTATUS_internal pyfb_sharedClose(uint8_t fbnum) {
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    struct pyfb_shared* shared  = fb->shared;
+
+    if(shared->owner) {
+        // wake the threads waiting for damage, only the owner waits on the sequence number
+        atomic_store(&shared->closing, 1);
+        atomic_fetch_add(&shared->header->seq, 1);
+        pyfb_futexWake(&shared->header->seq, INT_MAX);
+
+        while(atomic_load(&shared->waiting) > 0) {
+            sched_yield();
+        }
+
+        shm_unlink(shared->name);
+    }
+
+    munmap((void*)shared->header, shared->map_len);
+    free(shared);
+    fb->u32_buffer = NULL;
+    fb->shared     = NULL;
+}
+
+int pyfb_waitDamage(uint8_t fbnum, int timeout_ms) {
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    struct pyfb_shared* shared  = fb->shared;
+
+    if(!pyfb_fbused(fbnum) || shared == NULL || !shared->owner) {
+        pyfb_fbunlock(fbnum);
+        errno = EBADF;
+        return -1;
+    }
+
+    // the waiting count keeps the segment mapped without the lock
+    atomic_fetch_add(&shared->waiting, 1);
+    atomic_uint* seq  = &shared->header->seq;
+    unsigned int seen = shared->seen;
+    pyfb_fbunlock(fbnum);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    int result = 0;
+
+    while(1) {
+        if(atomic_load(&shared->closing)) {
+            errno  = EBADF;
+            result = -1;
+            break;
+        }
+
+        if(atomic_load(seq) != seen) {
+            result = 1;
+            break;
+        }
+
+        struct timespec remaining;
+        if(timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec  = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if(remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += 1000000000;
+            }
+
+            if(remaining.tv_sec < 0) {
+                break;
+            }
+        }
+
+        pyfb_futexWait(seq, seen, timeout_ms >= 0 ? &remaining : NULL);
+    }
+
+    atomic_fetch_sub(&shared->waiting, 1);
+    return result;
+}
@@ -0,0 +1,435 @@
+/**
+ * Run length encoded sprite sources.
+ */
+#include "pyframebuffer.h"
+
+#include <endian.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A run of opaque pixels in a row of a sprite.
+ */
+struct pyfb_spriterun {
+    /**
+     * The x coordinate of the first pixel of the run in the sprite.
+     */
+    uint16_t x;
+
+    /**
+     * The amount of pixels of the run.
+     */
+    uint16_t len;
+
+    /**
+     * The index of the first pixel of the run in the packed pixels.
+     */
+    uint32_t offset;
+};
+
+/**
+ * A loaded sprite.
+ */
+struct pyfb_sprite {
+    /**
+     * The lock of the sprite.
+     */
+    lock_t lock;
+
+    /**
+     * Not 0 if the sprite is loaded.
+     */
+    int used;
+
+    /**
+     * The width of the sprite in pixel.
+     */
+    unsigned int width;
+
+    /**
+     * The height of the sprite in pixel.
+     */
+    unsigned int height;
+
+    /**
+     * The index of the first run of every row in @c runs , and the count of runs at index @c height .
+     */
+    uint32_t* rows;
+
+    /**
+     * The runs of all rows, ordered by the row and the x coordinate.
+     */
+    struct pyfb_spriterun* runs;
+
+    /**
+     * The amount of opaque pixels.
+     */
+    size_t opaque;
+
+    /**
+     * The opaque pixels of all runs, packed, in the 32 bit pixel format.
+     */
+    uint32_t* pixels32;
+
+    /**
+     * The opaque pixels converted to the 16 bit pixel format, lazily created.
+     */
+    uint16_t* pixels16;
+};
+
+/**
+ * The array with the sprites.
+ */
+static struct pyfb_sprite sprites[MAX_SPRITES];
+
+/**
+ * Releases all memory of a sprite and marks the slot as unused.
+ *
+ * @param sprite The sprite to release
+ */
+static void pyfb_spriterelease(struct pyfb_sprite* sprite) {
+    free(sprite->rows);
+    free(sprite->runs);
+    free(sprite->pixels32);
+    free(sprite->pixels16);
+
+    lock_t sprite_lock = sprite->lock;
+    memset((void*)sprite, 0, sizeof(struct pyfb_sprite));
+    sprite->lock = sprite_lock;
+}
+
+/**
+ * Loads a pixel of the RGBA8888 input.
+ *
+ * @param data The pixels
+ * @param index The index of the pixel
+ *
+ * @return The color value in 32 bits
+ */
+static inline uint32_t pyfb_spritePixel(const uint8_t* data, size_t index) {
+    uint32_t value;
+    memcpy(&value, data + index * 4, 4);
+    return be32toh(value);
+}
+
+/**
+ * Tests if a pixel of the input is opaque.
+ *
+ * @param value The color value in 32 bits
+ * @param key The pointer to the color key, or NULL to use the alpha threshold
+ * @param threshold The alpha from which on a pixel is opaque
+ *
+ * @return Not 0 if the pixel is opaque
+ */
+static inline int pyfb_spriteOpaque(uint32_t value, const uint32_t* key, unsigned int threshold) {
+    if(key != NULL) {
+        return (value | 0xFF) != (*key | 0xFF);
+    }
+
+    return (value & 0xFF) >= threshold;
+}
+
+/**
+ * Encodes the pixels into a free sprite slot. The input is scanned twice, first to count
+ * the runs and opaque pixels for the allocations, then to fill them.
+ *
+ * @return By success 0, else -1 with a Python exception set
+ */
+static int pyfb_spriteEncode(struct pyfb_sprite* sprite,
+                             const uint8_t* data,
+                             unsigned int width,
+                             unsigned int height,
+                             const uint32_t* key,
+                             unsigned int threshold) {
+    size_t count  = 0;
+    size_t opaque = 0;
+
+    for(unsigned int row = 0; row < height; row++) {
+        int inside = 0;
+        for(unsigned int i = 0; i < width; i++) {
+            int pixel = pyfb_spriteOpaque(pyfb_spritePixel(data, (size_t)row * width + i), key, threshold);
+            count += pixel && !inside;
+            opaque += pixel;
+            inside = pixel;
+        }
+    }
+
+    if(opaque > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "The sprite is too large");
+        return -1;
+    }
+
+    sprite->rows     = malloc(((size_t)height + 1) * sizeof(uint32_t));
+    sprite->runs     = malloc(count * sizeof(struct pyfb_spriterun) + 1);
+    sprite->pixels32 = malloc(opaque * sizeof(uint32_t) + 1);
+    if(sprite->rows == NULL || sprite->runs == NULL || sprite->pixels32 == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the sprite");
+        return -1;
+    }
+
+    struct pyfb_spriterun* run = sprite->runs;
+    uint32_t* out              = sprite->pixels32;
+
+    for(unsigned int row = 0; row < height; row++) {
+        sprite->rows[row] = (uint32_t)(run - sprite->runs);
+
+        unsigned int i = 0;
+        while(i < width) {
+            // skip the transparent gap
+            while(i < width && !pyfb_spriteOpaque(pyfb_spritePixel(data, (size_t)row * width + i), key, threshold)) {
+                i++;
+            }
+
+            if(i == width) {
+                break;
+            }
+
+            // and pack the opaque run
+            run->x      = (uint16_t)i;
+            run->offset = (uint32_t)(out - sprite->pixels32);
+
+            uint32_t value;
+            while(i < width && pyfb_spriteOpaque(value = pyfb_spritePixel(data, (size_t)row * width + i), key, threshold)) {
+                *out++ = value;
+                i++;
+            }
+
+            run->len = (uint16_t)(i - run->x);
+            run++;
+        }
+    }
+
+    sprite->rows[height] = (uint32_t)count;
+    sprite->width        = width;
+    sprite->height       = height;
+    sprite->opaque       = opaque;
+    return 0;
+}
+
+/**
+ * Returns the opaque pixels of a sprite in the pixel format of a framebuffer, converting
+ * them on the first use of a 16 bit framebuffer.
+ *
+ * @param sprite The locked sprite
+ * @param depth The pixel depth, 16 or 32
+ *
+ * @return The packed pixels, or NULL if the conversion could not be allocated
+ */
+static const void* pyfb_spritePixels(struct pyfb_sprite* sprite, unsigned int depth) {
+    if(depth == 32) {
+        return sprite->pixels32;
+    }
+
+    if(sprite->pixels16 == NULL) {
+        uint16_t* pixels = malloc(sprite->opaque * sizeof(uint16_t) + 1);
+        if(pixels == NULL) {
+            return NULL;
+        }
+
+        for(size_t i = 0; i < sprite->opaque; i++) {
+            pixels[i] = pyfb_rgb565(sprite->pixels32[i]);
+        }
+        sprite->pixels16 = pixels;
+    }
+
+    return sprite->pixels16;
+}
+
+void __APISTATUS_internal pyfb_spriteinit(void) {
+    for(int i = 0; i < MAX_SPRITES; i++) {
+        memset((void*)&sprites[i], 0, sizeof(struct pyfb_sprite));
+        atomic_flag flag = ATOMIC_FLAG_INIT;
+        sprites[i].lock  = flag;
+    }
+}
+
+int pyfb_loadSprite(const uint8_t* data,
+                    size_t len,
+                    unsigned int width,
+                    unsigned int height,
+                    const uint32_t* key,
+                    unsigned int threshold) {
+    if(width == 0 || height == 0 || width > UINT16_MAX || height > UINT16_MAX) {
+        PyErr_SetString(PyExc_ValueError, "The sprite size is not valid");
+        return -1;
+    }
+
+    if(len < (size_t)width * height * 4) {
+        PyErr_SetString(PyExc_ValueError, "The buffer is too small for the sprite");
+        return -1;
+    }
+
+    if(threshold > 255) {
+        PyErr_SetString(PyExc_ValueError, "The alpha threshold is not valid");
+        return -1;
+    }
+
+    for(int i = 0; i < MAX_SPRITES; i++) {
+        lock(sprites[i].lock);
+
+        if(sprites[i].used) {
+            unlock(sprites[i].lock);
+            continue;
+        }
+
+        // found a free slot, so encode the sprite into it
+        if(pyfb_spriteEncode(&sprites[i], data, width, height, key, threshold) != 0) {
+            pyfb_spriterelease(&sprites[i]);
+            unlock(sprites[i].lock);
+            return -1;
+        }
+
+        sprites[i].used = 1;
+        unlock(sprites[i].lock);
+        return i;
+    }
+
+    PyErr_SetString(PyExc_MemoryError, "No free sprite slot available");
+    return -1;
+}
+
+void pyfb_freeSprite(uint8_t spritenum) {
+    if(spritenum >= MAX_SPRITES) {
+        PyErr_SetString(PyExc_ValueError, "The sprite number is not valid");
+        return;
+    }
+
+    lock(sprites[spritenum].lock);
+
+    if(!sprites[spritenum].used) {
+        PyErr_SetString(PyExc_IOError, "The sprite is allready freed");
+        unlock(sprites[spritenum].lock);
+        return;
+    }
+
+    pyfb_spriterelease(&sprites[spritenum]);
+    unlock(sprites[spritenum].lock);
+}
+
+int pyfb_sspriteInfo(uint8_t spritenum,
+                     unsigned int* width,
+                     unsigned int* height,
+                     unsigned long int* runs,
+                     unsigned long int* opaque) {
+    if(spritenum >= MAX_SPRITES) {
+        PyErr_SetString(PyExc_ValueError, "The sprite number is not valid");
+        return -1;
+    }
+
+    lock(sprites[spritenum].lock);
+
+    if(!sprites[spritenum].used) {
+        PyErr_SetString(PyExc_IOError, "The sprite is not loaded");
+        unlock(sprites[spritenum].lock);
+        return -1;
+    }
+
+    *width  = sprites[spritenum].width;
+    *height = sprites[spritenum].height;
+    *runs   = sprites[spritenum].rows[sprites[spritenum].height];
+    *opaque = sprites[spritenum].opaque;
+
+    unlock(sprites[spritenum].lock);
+    return 0;
+}
+
+int pyfb_sdrawSprite(uint8_t fbnum, uint8_t spritenum, long int x, long int y) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if fbnum and spritenum are valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(spritenum >= MAX_SPRITES) {
+        PyErr_SetString(PyExc_ValueError, "The sprite number is not valid");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // and lock the sprite
+    struct pyfb_sprite* sprite = &sprites[spritenum];
+    lock(sprite->lock);
+
+    if(!sprite->used) {
+        PyErr_SetString(PyExc_IOError, "The sprite is not loaded");
+        unlock(sprite->lock);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    const unsigned int depth    = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "Sprites can not be drawn on an indexed canvas");
+        unlock(sprite->lock);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    const uint8_t* pixels = pyfb_spritePixels(sprite, depth);
+
+    if(pixels == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the sprite");
+        unlock(sprite->lock);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the rows of the sprite on the canvas
+    const long int xres  = (long int)fb->canvas.xres;
+    const long int yres  = (long int)fb->canvas.yres;
+    const size_t bytes   = depth / 8;
+    long int row0        = y < 0 ? -y : 0;
+    long int row1        = y + (long int)sprite->height > yres ? yres - y : (long int)sprite->height;
+    uint8_t* buffer      = (uint8_t*)fb->u32_buffer;
+    unsigned long int px = 0;
+
+    for(long int row = row0; row < row1; row++) {
+        uint8_t* dst                     = buffer + (size_t)((y + row) * xres) * bytes;
+        const struct pyfb_spriterun* run = sprite->runs + sprite->rows[row];
+        const struct pyfb_spriterun* end = sprite->runs + sprite->rows[row + 1];
+
+        for(; run < end; run++) {
+            long int x0 = x + run->x;
+            long int x1 = x0 + run->len;
+
+            // the runs are ordered, so the rest of the row is right of the canvas
+            if(x0 >= xres) {
+                break;
+            }
+
+            long int skip = x0 < 0 ? -x0 : 0;
+            if(x1 > xres) {
+                x1 = xres;
+            }
+
+            if(x0 + skip < x1) {
+                memcpy(dst + (size_t)(x0 + skip) * bytes,
+                       pixels + ((size_t)run->offset + (size_t)skip) * bytes,
+                       (size_t)(x1 - x0 - skip) * bytes);
+                px += (unsigned long int)(x1 - x0 - skip);
+            }
+        }
+    }
+
+    PYFB_STAT_CALL(fb, PYFB_STAT_SPRITE);
+    PYFB_STAT_PIXELS(fb, px);
+
+    // ready, so return
+    unlock(sprite->lock);
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("drawSprite", fbnum, trace_start);
+    return 0;
+}
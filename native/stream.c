@@ -0,0 +1,765 @@
+/**
+ * Frame streaming sources.
+ */
+#include "pyframebuffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * The length of the frame header in bytes.
+ */
+#define PYFB_STREAM_FRAME_HEADER 20
+
+/**
+ * The length of the tile header in bytes.
+ */
+#define PYFB_STREAM_TILE_HEADER 13
+
+/**
+ * The flag of the frame header marking a key frame, means a frame containing all tiles.
+ */
+#define PYFB_STREAM_KEYFRAME 1
+
+/**
+ * The interval in milliseconds the stream thread checks for a stop while the consumer is
+ * not reading.
+ */
+#define PYFB_STREAM_POLL_MS 100
+
+/**
+ * The state of a frame stream.
+ */
+struct pyfb_stream {
+    /**
+     * The duplicated file descriptor to write to.
+     */
+    int fd;
+
+    /**
+     * Set to 1 if the file descriptor is a socket.
+     */
+    int socket;
+
+    /**
+     * The preferred tile encoding.
+     */
+    int encoding;
+
+    /**
+     * The edge length of the tiles.
+     */
+    unsigned int tile_size;
+
+    /**
+     * The size of the visible area.
+     */
+    unsigned int width;
+    unsigned int height;
+
+    /**
+     * The pixel depth, 16 or 32.
+     */
+    unsigned int depth;
+
+    /**
+     * The count of tiles per row and per column.
+     */
+    unsigned int tiles_x;
+    unsigned int tiles_y;
+
+    /**
+     * The frame handed over by the flush, valid if has_pending is set.
+     */
+    uint8_t* pending;
+
+    /**
+     * Set to 1 if a frame is pending.
+     */
+    int has_pending;
+
+    /**
+     * The frame being encoded by the stream thread.
+     */
+    uint8_t* work;
+
+    /**
+     * The hashes of the tiles of the last written frame.
+     */
+    uint64_t* hashes;
+
+    /**
+     * Set to 1 if the next frame must contain all tiles.
+     */
+    int keyframe;
+
+    /**
+     * The number of the next frame.
+     */
+    uint32_t frame;
+
+    /**
+     * The encoded frame.
+     */
+    uint8_t* out;
+
+    /**
+     * The RGBA8888 copy of a tile for the QOI encoding.
+     */
+    uint8_t* rgba;
+
+    /**
+     * The statistics, protected by the mutex.
+     */
+    struct pyfb_streamstats stats;
+
+    /**
+     * Cleared to stop the stream thread.
+     */
+    atomic_int running;
+
+    /**
+     * The stream thread.
+     */
+    pthread_t thread;
+
+    /**
+     * The mutex protecting the pending frame and the statistics.
+     */
+    pthread_mutex_t mutex;
+
+    /**
+     * Signaled if a frame is pending or the stream is stopped.
+     */
+    pthread_cond_t cond;
+};
+
+/**
+ * Stores a 16 bit value little endian.
+ */
+static inline void pyfb_put16(uint8_t* dst, uint32_t value) {
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * Stores a 32 bit value little endian.
+ */
+static inline void pyfb_put32(uint8_t* dst, uint32_t value) {
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * Hashes the pixels of a tile. Four independent lanes are used, so the multiplications
+ * do not wait for each other.
+ *
+ * @param src The upper left pixel of the tile
+ * @param stride The length of a frame row in bytes
+ * @param row_len The length of a tile row in bytes
+ * @param rows The height of the tile
+ *
+ * @return The hash of the tile
+ */
+static uint64_t pyfb_hashTile(const uint8_t* src, size_t stride, size_t row_len, unsigned int rows) {
+    const uint64_t k = 0x9FB21C651E98DF25ull;
+    uint64_t h[4]    = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x27D4EB2F165667C5ull};
+
+    for(unsigned int row = 0; row < rows; row++) {
+        const uint8_t* p = src + row * stride;
+        size_t i         = 0;
+
+        for(; i + 32 <= row_len; i += 32) {
+            for(int lane = 0; lane < 4; lane++) {
+                uint64_t word;
+                memcpy(&word, p + i + lane * 8, 8);
+                h[lane] = (h[lane] ^ word) * k;
+            }
+        }
+
+        for(; i < row_len; i++) {
+            h[0] = (h[0] ^ p[i]) * k;
+        }
+    }
+
+    uint64_t hash = h[0] ^ (h[1] >> 7) ^ (h[2] >> 13) ^ (h[3] >> 29) ^ (h[1] << 11) ^ (h[3] << 5);
+    hash ^= hash >> 32;
+    return hash * k;
+}
+
+/**
+ * Reads one pixel of a frame as integer.
+ */
+static inline uint32_t pyfb_streamPixel(const uint8_t* p, size_t bytes) {
+    return bytes == 4 ? *(const uint32_t*)p : *(const uint16_t*)p;
+}
+
+/**
+ * Run length encodes a tile as pairs of the run length - 1 and one pixel. Runs continue
+ * over the end of the tile rows.
+ *
+ * @param src The upper left pixel of the tile
+ * @param stride The length of a frame row in bytes
+ * @param width The width of the tile
+ * @param height The height of the tile
+ * @param bytes The bytes per pixel
+ * @param dst The destination of the encoded tile
+ * @param limit The maximum length of the encoded tile
+ *
+ * @return The length of the encoded tile, or 0 if it exceeds the limit
+ */
+static size_t pyfb_encodeRLE(const uint8_t* src,
+                             size_t stride,
+                             unsigned int width,
+                             unsigned int height,
+                             size_t bytes,
+                             uint8_t* dst,
+                             size_t limit) {
+    size_t len             = 0;
+    unsigned int run       = 0;
+    uint32_t run_px        = 0;
+    const uint8_t* run_ptr = src;
+
+    for(unsigned int y = 0; y < height; y++) {
+        const uint8_t* row = src + y * stride;
+
+        for(unsigned int x = 0; x < width; x++) {
+            uint32_t px = pyfb_streamPixel(row + x * bytes, bytes);
+
+            if(run > 0 && px == run_px && run < 256) {
+                run++;
+                continue;
+            }
+
+            if(run > 0) {
+                if(len + 1 + bytes > limit) {
+                    return 0;
+                }
+
+                dst[len] = (uint8_t)(run - 1);
+                memcpy(dst + len + 1, run_ptr, bytes);
+                len += 1 + bytes;
+            }
+
+            run_px  = px;
+            run_ptr = row + x * bytes;
+            run     = 1;
+        }
+    }
+
+    if(run > 0) {
+        if(len + 1 + bytes > limit) {
+            return 0;
+        }
+
+        dst[len] = (uint8_t)(run - 1);
+        memcpy(dst + len + 1, run_ptr, bytes);
+        len += 1 + bytes;
+    }
+
+    return len;
+}
+
+/**
+ * Encodes RGBA8888 pixels with the chunks of the QOI image format, without the QOI header
+ * and end marker. The encoder state starts fresh for every tile.
+ *
+ * @param rgba The pixels
+ * @param count The amount of pixels
+ * @param dst The destination of the encoded tile
+ * @param limit The maximum length of the encoded tile
+ *
+ * @return The length of the encoded tile, or 0 if it exceeds the limit
+ */
+static size_t pyfb_encodeQOI(const uint8_t* rgba, size_t count, uint8_t* dst, size_t limit) {
+    uint32_t index[64];
+    uint8_t prev[4]  = {0, 0, 0, 255};
+    uint32_t prev_px = 0;
+    unsigned int run = 0;
+    size_t len       = 0;
+
+    memset(index, 0, sizeof(index));
+    memcpy(&prev_px, prev, 4);
+
+    for(size_t i = 0; i < count; i++) {
+        // a run and the longest chunk may be emitted below
+        if(len + 6 > limit) {
+            return 0;
+        }
+
+        const uint8_t* p = rgba + i * 4;
+        uint32_t px;
+        memcpy(&px, p, 4);
+
+        if(px == prev_px) {
+            run++;
+            if(run == 62) {
+                dst[len++] = (uint8_t)(0xC0 | (run - 1));
+                run        = 0;
+            }
+            continue;
+        }
+
+        if(run > 0) {
+            dst[len++] = (uint8_t)(0xC0 | (run - 1));
+            run        = 0;
+        }
+
+        unsigned int slot = (p[0] * 3 + p[1] * 5 + p[2] * 7 + p[3] * 11) % 64;
+
+        if(index[slot] == px) {
+            dst[len++] = (uint8_t)slot;
+        } else {
+            index[slot] = px;
+
+            if(p[3] == prev[3]) {
+                int8_t dr    = (int8_t)(p[0] - prev[0]);
+                int8_t dg    = (int8_t)(p[1] - prev[1]);
+                int8_t db    = (int8_t)(p[2] - prev[2]);
+                int8_t dr_dg = (int8_t)(dr - dg);
+                int8_t db_dg = (int8_t)(db - dg);
+
+                if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    dst[len++] = (uint8_t)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                } else if(dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                    dst[len++] = (uint8_t)(0x80 | (dg + 32));
+                    dst[len++] = (uint8_t)((dr_dg + 8) << 4 | (db_dg + 8));
+                } else {
+                    dst[len++] = 0xFE;
+                    memcpy(dst + len, p, 3);
+                    len += 3;
+                }
+            } else {
+                dst[len++] = 0xFF;
+                memcpy(dst + len, p, 4);
+                len += 4;
+            }
+        }
+
+        memcpy(prev, p, 4);
+        prev_px = px;
+    }
+
+    if(run > 0) {
+        dst[len++] = (uint8_t)(0xC0 | (run - 1));
+    }
+
+    return len;
+}
+
+/**
+ * Encodes the changed tiles of the work frame.
+ *
+ * @param stream The stream
+ * @param tiles The pointer to store the count of encoded tiles to
+ *
+ * @return The length of the encoded frame
+ */
+static size_t pyfb_streamEncode(struct pyfb_stream* stream, uint32_t* tiles) {
+    size_t bytes   = stream->depth / 8;
+    size_t stride  = stream->width * bytes;
+    size_t len     = PYFB_STREAM_FRAME_HEADER;
+    uint32_t count = 0;
+
+    for(unsigned int ty = 0; ty < stream->tiles_y; ty++) {
+        for(unsigned int tx = 0; tx < stream->tiles_x; tx++) {
+            unsigned int x0 = tx * stream->tile_size;
+            unsigned int y0 = ty * stream->tile_size;
+            unsigned int tw = stream->width - x0 < stream->tile_size ? stream->width - x0 : stream->tile_size;
+            unsigned int th = stream->height - y0 < stream->tile_size ? stream->height - y0 : stream->tile_size;
+
+            const uint8_t* src = stream->work + y0 * stride + x0 * bytes;
+            uint64_t hash      = pyfb_hashTile(src, stride, tw * bytes, th);
+            size_t slot        = (size_t)ty * stream->tiles_x + tx;
+
+            if(!stream->keyframe && stream->hashes[slot] == hash) {
+                continue;
+            }
+
+            stream->hashes[slot] = hash;
+
+            // encode the tile, and fall back to raw if that is not smaller
+            uint8_t* header  = stream->out + len;
+            uint8_t* payload = header + PYFB_STREAM_TILE_HEADER;
+            size_t raw_len   = (size_t)tw * th * bytes;
+            size_t enc_len   = 0;
+            int encoding     = stream->encoding;
+
+            if(encoding == PYFB_STREAM_RLE) {
+                enc_len = pyfb_encodeRLE(src, stride, tw, th, bytes, payload, raw_len - 1);
+            } else if(encoding == PYFB_STREAM_QOI) {
+                for(unsigned int row = 0; row < th; row++) {
+                    pyfb_convertRGBA(src + row * stride, stream->depth, stream->rgba + (size_t)row * tw * 4, tw);
+                }
+
+                enc_len = pyfb_encodeQOI(stream->rgba, (size_t)tw * th, payload, raw_len - 1);
+            }
+
+            if(enc_len == 0) {
+                for(unsigned int row = 0; row < th; row++) {
+                    memcpy(payload + row * tw * bytes, src + row * stride, tw * bytes);
+                }
+
+                enc_len  = raw_len;
+                encoding = PYFB_STREAM_RAW;
+            }
+
+            pyfb_put16(header, x0);
+            pyfb_put16(header + 2, y0);
+            pyfb_put16(header + 4, tw);
+            pyfb_put16(header + 6, th);
+            header[8] = (uint8_t)encoding;
+            pyfb_put32(header + 9, (uint32_t)enc_len);
+
+            len += PYFB_STREAM_TILE_HEADER + enc_len;
+            count++;
+        }
+    }
+
+    // and now the frame header
+    uint8_t* header = stream->out;
+    memcpy(header, "PFBS", 4);
+    pyfb_put32(header + 4, stream->frame);
+    pyfb_put16(header + 8, stream->width);
+    pyfb_put16(header + 10, stream->height);
+    pyfb_put16(header + 12, stream->tile_size);
+    header[14] = (uint8_t)stream->depth;
+    header[15] = stream->keyframe ? PYFB_STREAM_KEYFRAME : 0;
+    pyfb_put32(header + 16, count);
+
+    stream->keyframe = 0;
+    stream->frame++;
+    *tiles = count;
+    return len;
+}
+
+/**
+ * Writes data to the stream file descriptor. The writes never block longer than the poll
+ * interval, so a stop is noticed even if the consumer is not reading.
+ *
+ * @param stream The stream
+ * @param data The data to write
+ * @param len The length of the data
+ *
+ * @return By success 0, else -1 if writing failed or the stream is stopped
+ */
+static int pyfb_streamWrite(struct pyfb_stream* stream, const uint8_t* data, size_t len) {
+    while(len > 0) {
+        struct pollfd pfd = {stream->fd, POLLOUT, 0};
+        int ready         = poll(&pfd, 1, PYFB_STREAM_POLL_MS);
+
+        if(!atomic_load(&stream->running)) {
+            return -1;
+        }
+
+        if(ready < 0 && errno != EINTR) {
+            return -1;
+        }
+
+        if(ready <= 0) {
+            continue;
+        }
+
+        if(pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            return -1;
+        }
+
+        // a pipe with free space accepts PIPE_BUF bytes without blocking
+        ssize_t written;
+        if(stream->socket) {
+            written = send(stream->fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } else {
+            written = write(stream->fd, data, len < PIPE_BUF ? len : PIPE_BUF);
+        }
+
+        if(written < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        data += written;
+        len -= (size_t)written;
+    }
+
+    return 0;
+}
+
+/**
+ * The stream thread. Waits for pending frames, encodes and writes them.
+ *
+ * @param arg The stream
+ *
+ * @return Always NULL
+ */
+static void* pyfb_streamThread(void* arg) {
+    struct pyfb_stream* stream = (struct pyfb_stream*)arg;
+
+    for(;;) {
+        pthread_mutex_lock(&stream->mutex);
+
+        while(atomic_load(&stream->running) && !stream->has_pending) {
+            pthread_cond_wait(&stream->cond, &stream->mutex);
+        }
+
+        if(!atomic_load(&stream->running)) {
+            pthread_mutex_unlock(&stream->mutex);
+            break;
+        }
+
+        // take the pending frame, so the flush can fill the other buffer
+        uint8_t* frame      = stream->pending;
+        stream->pending     = stream->work;
+        stream->work        = frame;
+        stream->has_pending = 0;
+        pthread_mutex_unlock(&stream->mutex);
+
+        uint32_t tiles;
+        size_t len   = pyfb_streamEncode(stream, &tiles);
+        int exitcode = pyfb_streamWrite(stream, stream->out, len);
+
+        pthread_mutex_lock(&stream->mutex);
+
+        if(exitcode != 0) {
+            // a stop is not a failure
+            stream->stats.failed = atomic_load(&stream->running) ? 1 : 0;
+            pthread_mutex_unlock(&stream->mutex);
+            break;
+        }
+
+        stream->stats.frames++;
+        stream->stats.tiles += tiles;
+        stream->stats.bytes += len;
+        pthread_mutex_unlock(&stream->mutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * Frees a stream and closes its file descriptor. The stream thread must not run.
+ *
+ * @param stream The stream
+ */
+static void pyfb_streamFree(struct pyfb_stream* stream) {
+    if(stream->fd >= 0) {
+        close(stream->fd);
+    }
+
+    free(stream->pending);
+    free(stream->work);
+    free(stream->hashes);
+    free(stream->out);
+    free(stream->rgba);
+    free(stream);
+}
+
+int pyfb_sstreamStart(uint8_t fbnum, int fd, int encoding, unsigned int tile_size) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    if(encoding != PYFB_STREAM_RAW && encoding != PYFB_STREAM_RLE && encoding != PYFB_STREAM_QOI) {
+        PyErr_SetString(PyExc_ValueError, "The stream encoding is not valid");
+        return -1;
+    }
+
+    if(tile_size < 8 || tile_size > 256) {
+        PyErr_SetString(PyExc_ValueError, "The tile size must be between 8 and 256");
+        return -1;
+    }
+
+    // Ok, then lock
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->stream != NULL) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer is already streamed");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    if(fb->palette != NULL) {
+        PyErr_SetString(PyExc_IOError, "An indexed canvas can not be streamed");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_stream* stream = (struct pyfb_stream*)calloc(1, sizeof(struct pyfb_stream));
+    if(stream == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the stream buffers");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    stream->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if(stream->fd < 0) {
+        PyErr_SetString(PyExc_IOError, "Could not duplicate the file descriptor");
+        pyfb_streamFree(stream);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    // the frames are streamed in the orientation of the canvas
+    unsigned long int xres, yres;
+    pyfb_screenSize(fbnum, &xres, &yres);
+
+    struct stat st;
+    stream->socket    = fstat(stream->fd, &st) == 0 && S_ISSOCK(st.st_mode);
+    stream->encoding  = encoding;
+    stream->tile_size = tile_size;
+    stream->width     = xres;
+    stream->height    = yres;
+    stream->depth     = fb->fb_info.vinfo.bits_per_pixel == 16 ? 16 : 32;
+    stream->tiles_x   = (stream->width + tile_size - 1) / tile_size;
+    stream->tiles_y   = (stream->height + tile_size - 1) / tile_size;
+    stream->keyframe  = 1;
+
+    // the encoded frame is never larger than all tiles sent raw
+    size_t tiles     = (size_t)stream->tiles_x * stream->tiles_y;
+    size_t frame_len = (size_t)stream->width * stream->height * (stream->depth / 8);
+    stream->pending  = (uint8_t*)malloc(frame_len);
+    stream->work     = (uint8_t*)malloc(frame_len);
+    stream->hashes   = (uint64_t*)calloc(tiles, sizeof(uint64_t));
+    stream->out      = (uint8_t*)malloc(PYFB_STREAM_FRAME_HEADER + tiles * PYFB_STREAM_TILE_HEADER + frame_len);
+    stream->rgba     = (uint8_t*)malloc((size_t)tile_size * tile_size * 4);
+
+    if(stream->pending == NULL || stream->work == NULL || stream->hashes == NULL || stream->out == NULL ||
+       stream->rgba == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the stream buffers");
+        pyfb_streamFree(stream);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+    atomic_init(&stream->running, 1);
+
+    if(pthread_create(&stream->thread, NULL, pyfb_streamThread, stream) != 0) {
+        PyErr_SetString(PyExc_IOError, "Could not start the stream thread");
+        pthread_cond_destroy(&stream->cond);
+        pthread_mutex_destroy(&stream->mutex);
+        pyfb_streamFree(stream);
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    fb->stream = stream;
+
+    // ready, so return
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+void __APISTATUS_internal pyfb_streamStop(uint8_t fbnum) {
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    struct pyfb_stream* stream  = fb->stream;
+
+    if(stream == NULL) {
+        return;
+    }
+
+    // wake the thread, a blocked write returns within the poll interval
+    pthread_mutex_lock(&stream->mutex);
+    atomic_store(&stream->running, 0);
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->mutex);
+    pthread_join(stream->thread, NULL);
+
+    pthread_cond_destroy(&stream->cond);
+    pthread_mutex_destroy(&stream->mutex);
+    pyfb_streamFree(stream);
+    fb->stream = NULL;
+}
+
+void pyfb_sstreamStop(uint8_t fbnum) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return;
+    }
+
+    pyfb_fblock(fbnum);
+    pyfb_streamStop(fbnum);
+    pyfb_fbunlock(fbnum);
+}
+
+int pyfb_sstreamStats(uint8_t fbnum, struct pyfb_streamstats* stats) {
+    // first check if fbnum is valid
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    struct pyfb_stream* stream = pyfb_fbptr(fbnum)->stream;
+    if(stream == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer is not streamed");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+    *stats = stream->stats;
+    pthread_mutex_unlock(&stream->mutex);
+
+    pyfb_fbunlock(fbnum);
+    return 0;
+}
+
+void __APISTATUS_internal pyfb_streamFrame(uint8_t fbnum) {
+    const struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+    struct pyfb_stream* stream        = fb->stream;
+
+    size_t bytes       = stream->depth / 8;
+    size_t row_len     = stream->width * bytes;
+    size_t stride      = fb->canvas.xres * bytes;
+    const uint8_t* src = (const uint8_t*)fb->u32_buffer + fb->canvas.yoffset * stride + fb->canvas.xoffset * bytes;
+
+    pthread_mutex_lock(&stream->mutex);
+
+    if(stream->stats.failed) {
+        pthread_mutex_unlock(&stream->mutex);
+        return;
+    }
+
+    if(stream->has_pending) {
+        stream->stats.dropped++;
+    }
+
+    // copy the visible area, so drawing can go on while the frame is encoded
+    if(row_len == stride) {
+        memcpy(stream->pending, src, row_len * stream->height);
+    } else {
+        for(unsigned int row = 0; row < stream->height; row++) {
+            memcpy(stream->pending + row * row_len, src + row * stride, row_len);
+        }
+    }
+
+    stream->has_pending = 1;
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->mutex);
+}
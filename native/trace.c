@@ -0,0 +1,356 @@
+/**
+ * Frame timeline tracer sources.
+ */
+#include "pyframebuffer.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * A recorded span.
+ */
+struct pyfb_traceevent {
+    /**
+     * The start timestamp in nanoseconds.
+     */
+    uint64_t start;
+
+    /**
+     * The duration in nanoseconds.
+     */
+    uint64_t duration;
+
+    /**
+     * The name of the span, a string literal.
+     */
+    const char* name;
+
+    /**
+     * The framebuffer number.
+     */
+    uint32_t fbnum;
+};
+
+/**
+ * The state of a ring buffer not claimed by a thread.
+ */
+#define PYFB_TRACERING_FREE 0
+
+/**
+ * The state of a ring buffer claimed by a running thread.
+ */
+#define PYFB_TRACERING_OWNED 1
+
+/**
+ * The state of a ring buffer of an exited thread. Its events are dumped until another
+ * thread claims it.
+ */
+#define PYFB_TRACERING_ORPHANED 2
+
+/**
+ * The ring buffer of the events of one thread. Only the owning thread writes it.
+ */
+struct pyfb_tracering {
+    /**
+     * The events, PYFB_TRACE_EVENTS entries.
+     */
+    struct pyfb_traceevent* events;
+
+    /**
+     * The count of recorded events, the next event is written at head % PYFB_TRACE_EVENTS.
+     */
+    atomic_ulong head;
+
+    /**
+     * The thread id of the owner.
+     */
+    long int tid;
+
+    /**
+     * The state, one of the PYFB_TRACERING_ macros.
+     */
+    atomic_int state;
+};
+
+atomic_int pyfb_trace_enabled = 0;
+
+/**
+ * The ring buffers, one per recording thread.
+ */
+static struct pyfb_tracering pyfb_tracerings[PYFB_TRACE_THREADS];
+
+/**
+ * The memory of all ring buffers, allocated on the first start and never freed, as a
+ * thread may still record into it after the tracer is stopped.
+ */
+static struct pyfb_traceevent* pyfb_traceevents = NULL;
+
+/**
+ * The number of the current run, so threads claim a new ring buffer after a restart.
+ */
+static atomic_uint pyfb_tracerun = 0;
+
+/**
+ * The lock of the start and dump functions.
+ */
+static lock_t pyfb_tracelock = ATOMIC_FLAG_INIT;
+
+/**
+ * The ring buffer of the calling thread, or NULL if there are no free ring buffers.
+ */
+static __thread struct pyfb_tracering* pyfb_traceself = NULL;
+
+/**
+ * The run in which the calling thread claimed its ring buffer.
+ */
+static __thread unsigned int pyfb_traceselfrun = 0;
+
+/**
+ * The thread specific key of the claimed ring buffer, to release it when the thread exits.
+ */
+static pthread_key_t pyfb_tracekey;
+
+/**
+ * Creates the key of the claimed ring buffers once.
+ */
+static pthread_once_t pyfb_tracekeyonce = PTHREAD_ONCE_INIT;
+
+/**
+ * Releases the ring buffer of an exiting thread, keeping its events for the dump.
+ *
+ * @param value The claimed ring buffer
+ */
+static void pyfb_traceThreadExit(void* value) {
+    struct pyfb_tracering* ring = (struct pyfb_tracering*)value;
+
+    // after a restart, the ring buffer may belong to another thread
+    if(pyfb_traceselfrun == atomic_load_explicit(&pyfb_tracerun, memory_order_acquire)) {
+        int owned = PYFB_TRACERING_OWNED;
+        atomic_compare_exchange_strong(&ring->state, &owned, PYFB_TRACERING_ORPHANED);
+    }
+}
+
+/**
+ * Creates the key of the claimed ring buffers.
+ */
+static void pyfb_traceCreateKey(void) {
+    pthread_key_create(&pyfb_tracekey, pyfb_traceThreadExit);
+}
+
+/**
+ * Claims a ring buffer for the calling thread. A free ring buffer is preferred, so the
+ * events of exited threads are kept as long as possible.
+ *
+ * @return The ring buffer, or NULL if all ring buffers are claimed by running threads
+ */
+static struct pyfb_tracering* pyfb_traceClaim(void) {
+    for(int i = 0; i < PYFB_TRACE_THREADS; i++) {
+        int expected = PYFB_TRACERING_FREE;
+        if(atomic_compare_exchange_strong(&pyfb_tracerings[i].state, &expected, PYFB_TRACERING_OWNED)) {
+            return &pyfb_tracerings[i];
+        }
+    }
+
+    // the events of an exited thread are discarded, but not while they are dumped
+    if(atomic_flag_test_and_set(&pyfb_tracelock)) {
+        return NULL;
+    }
+
+    struct pyfb_tracering* ring = NULL;
+
+    for(int i = 0; i < PYFB_TRACE_THREADS && ring == NULL; i++) {
+        int expected = PYFB_TRACERING_ORPHANED;
+        if(atomic_compare_exchange_strong(&pyfb_tracerings[i].state, &expected, PYFB_TRACERING_OWNED)) {
+            ring = &pyfb_tracerings[i];
+            atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+        }
+    }
+
+    unlock(pyfb_tracelock);
+    return ring;
+}
+
+uint64_t __APISTATUS_internal pyfb_traceNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec + 1;
+}
+
+void __APISTATUS_internal pyfb_traceEvent(const char* name, uint8_t fbnum, uint64_t start) {
+    uint64_t end     = pyfb_traceNow();
+    unsigned int run = atomic_load_explicit(&pyfb_tracerun, memory_order_acquire);
+
+    if(pyfb_traceselfrun != run) {
+        // first event of this thread in this run, so claim a ring buffer, else drop the
+        // event and try again with the next one
+        struct pyfb_tracering* claimed = pyfb_traceClaim();
+        if(claimed == NULL) {
+            return;
+        }
+
+        claimed->tid      = syscall(SYS_gettid);
+        pyfb_traceself    = claimed;
+        pyfb_traceselfrun = run;
+        pthread_setspecific(pyfb_tracekey, claimed);
+    }
+
+    struct pyfb_tracering* ring = pyfb_traceself;
+
+    unsigned long int head        = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    struct pyfb_traceevent* event = &ring->events[head & (PYFB_TRACE_EVENTS - 1)];
+    event->start                  = start;
+    event->duration               = end - start;
+    event->name                   = name;
+    event->fbnum                  = fbnum;
+
+    // publish the event for the dump
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int pyfb_traceStart(void) {
+    pthread_once(&pyfb_tracekeyonce, pyfb_traceCreateKey);
+    lock(pyfb_tracelock);
+
+    if(pyfb_traceevents == NULL) {
+        pyfb_traceevents = malloc(sizeof(struct pyfb_traceevent) * PYFB_TRACE_EVENTS * PYFB_TRACE_THREADS);
+        if(pyfb_traceevents == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Could not allocate the trace buffers");
+            unlock(pyfb_tracelock);
+            return -1;
+        }
+
+        for(int i = 0; i < PYFB_TRACE_THREADS; i++) {
+            pyfb_tracerings[i].events = pyfb_traceevents + (size_t)i * PYFB_TRACE_EVENTS;
+        }
+    }
+
+    // discard the events of the previous run
+    atomic_store_explicit(&pyfb_trace_enabled, 0, memory_order_relaxed);
+    for(int i = 0; i < PYFB_TRACE_THREADS; i++) {
+        atomic_store_explicit(&pyfb_tracerings[i].head, 0, memory_order_relaxed);
+        atomic_store_explicit(&pyfb_tracerings[i].state, PYFB_TRACERING_FREE, memory_order_relaxed);
+        pyfb_tracerings[i].tid = 0;
+    }
+
+    // the run number is never 0, which is the run of a new thread
+    unsigned int run = atomic_load_explicit(&pyfb_tracerun, memory_order_relaxed) + 1;
+    atomic_store_explicit(&pyfb_tracerun, run == 0 ? 1 : run, memory_order_release);
+    atomic_store_explicit(&pyfb_trace_enabled, 1, memory_order_relaxed);
+
+    unlock(pyfb_tracelock);
+    return 0;
+}
+
+void pyfb_traceStop(void) {
+    atomic_store_explicit(&pyfb_trace_enabled, 0, memory_order_relaxed);
+}
+
+/**
+ * Copies the events of a ring buffer, which may be written at the same time. The head index
+ * is read again after copying: the owner may be overwriting the slot of the event
+ * PYFB_TRACE_EVENTS before its head, so that event and the older ones may be torn and are
+ * dropped.
+ *
+ * @param ring The ring buffer
+ * @param copy The destination of PYFB_TRACE_EVENTS events, indexed like the ring buffer
+ * @param first The pointer to store the index of the first valid event to
+ *
+ * @return The index after the last copied event
+ */
+static unsigned long int pyfb_traceSnapshot(const struct pyfb_tracering* ring,
+                                            struct pyfb_traceevent* copy,
+                                            unsigned long int* first) {
+    unsigned long int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned long int from = head > PYFB_TRACE_EVENTS ? head - PYFB_TRACE_EVENTS : 0;
+
+    for(unsigned long int e = from; e < head; e++) {
+        copy[e & (PYFB_TRACE_EVENTS - 1)] = ring->events[e & (PYFB_TRACE_EVENTS - 1)];
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    unsigned long int now = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if(now + 1 > from + PYFB_TRACE_EVENTS) {
+        from = now + 1 - PYFB_TRACE_EVENTS;
+    }
+
+    *first = from;
+    return head;
+}
+
+long int pyfb_traceDump(int fd) {
+    struct pyfb_traceevent* copy = malloc(sizeof(struct pyfb_traceevent) * PYFB_TRACE_EVENTS);
+    if(copy == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the trace dump buffer");
+        return -1;
+    }
+
+    int dup_fd = dup(fd);
+    FILE* file = dup_fd == -1 ? NULL : fdopen(dup_fd, "w");
+
+    if(file == NULL) {
+        if(dup_fd != -1) {
+            close(dup_fd);
+        }
+
+        free(copy);
+        PyErr_SetString(PyExc_IOError, "Could not open the trace file");
+        return -1;
+    }
+
+    lock(pyfb_tracelock);
+
+    long int written = 0;
+    long int pid     = (long int)getpid();
+    int rings        = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for(unsigned int i = 0; i < PYFB_TRACE_THREADS && pyfb_traceevents != NULL; i++) {
+        struct pyfb_tracering* ring = &pyfb_tracerings[i];
+        if(atomic_load_explicit(&ring->state, memory_order_acquire) == PYFB_TRACERING_FREE) {
+            continue;
+        }
+
+        unsigned long int first;
+        unsigned long int head = pyfb_traceSnapshot(ring, copy, &first);
+
+        fprintf(file,
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"pyfb thread %u\"}}",
+                rings++ == 0 ? "" : ",",
+                pid,
+                ring->tid,
+                i);
+
+        for(unsigned long int e = first; e < head; e++) {
+            const struct pyfb_traceevent* event = &copy[e & (PYFB_TRACE_EVENTS - 1)];
+
+            // complete events, begin timestamp and duration in microseconds
+            fprintf(file,
+                    ",\n{\"name\":\"%s\",\"cat\":\"pyfb\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld,"
+                    "\"args\":{\"fb\":%u}}",
+                    event->name,
+                    (double)event->start / 1000.0,
+                    (double)event->duration / 1000.0,
+                    pid,
+                    ring->tid,
+                    event->fbnum);
+            written++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    unlock(pyfb_tracelock);
+    free(copy);
+
+    if(fclose(file) != 0) {
+        PyErr_SetString(PyExc_IOError, "Could not write the trace file");
+        return -1;
+    }
+
+    return written;
+}
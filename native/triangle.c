@@ -0,0 +1,480 @@
+/**
+ * Triangle sources, filling flat and shaded triangles.
+ */
+#include "pyframebuffer.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * The subpixel bits of the vertex coordinates.
+ */
+#define PYFB_TRIANGLE_SUBPIXEL 4
+
+/**
+ * The vertex coordinates are clamped to this distance from the origin in pixels, so the
+ * edge functions of the subpixel coordinates stay in the range of 64 bits.
+ */
+#define PYFB_TRIANGLE_LIMIT (1 << 16)
+
+/**
+ * The fraction bits of the interpolated color channels.
+ */
+#define PYFB_TRIANGLE_FRACTION 16
+
+/**
+ * A vertex of a triangle.
+ */
+struct pyfb_vertex {
+    /**
+     * The coordinates in subpixels.
+     */
+    int64_t x, y;
+
+    /**
+     * The color value in 32 bits.
+     */
+    uint32_t color;
+};
+
+/**
+ * The canvas triangles are filled on.
+ */
+struct pyfb_raster {
+    /**
+     * The offscreen buffer.
+     */
+    uint8_t* buffer;
+
+    /**
+     * The bytes per pixel, 1 for an indexed canvas.
+     */
+    size_t bytes;
+
+    /**
+     * The canvas width, the stride of the buffer.
+     */
+    long int xres;
+
+    /**
+     * The canvas height.
+     */
+    long int yres;
+
+    /**
+     * The amount of filled pixels.
+     */
+    unsigned long int pixels;
+};
+
+/**
+ * An edge function of a triangle, positive on the inner side of the edge.
+ */
+struct pyfb_edge {
+    /**
+     * The step of the function from a pixel to the next in a row.
+     */
+    int64_t a;
+
+    /**
+     * The step of the function from a row to the next.
+     */
+    int64_t b;
+
+    /**
+     * The function at the center of the pixel (0, 0).
+     */
+    int64_t c;
+
+    /**
+     * The fill rule bias, 0 for a top or left edge, else -1 to exclude the pixels on the edge.
+     */
+    int64_t bias;
+};
+
+/**
+ * Divides and rounds towards negative infinity.
+ */
+static inline int64_t pyfb_floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/**
+ * Sets up the edge function of the edge from a to b. The pixels exactly on an edge belong
+ * to the triangle only if the edge is a top or a left edge, so triangles sharing an edge
+ * fill every pixel once.
+ */
+static void pyfb_edgeSetup(struct pyfb_edge* edge, const struct pyfb_vertex* a, const struct pyfb_vertex* b) {
+    const int64_t one  = 1 << PYFB_TRIANGLE_SUBPIXEL;
+    const int64_t half = one / 2;
+    int64_t dx         = b->x - a->x;
+    int64_t dy         = b->y - a->y;
+    int top_left       = dy < 0 || (dy == 0 && dx > 0);
+
+    edge->a    = -dy * one;
+    edge->b    = dx * one;
+    edge->c    = dx * (half - a->y) - dy * (half - a->x);
+    edge->bias = top_left ? 0 : -1;
+}
+
+/**
+ * Narrows a span of a row to the pixels on the inner side of an edge.
+ *
+ * @param edge The edge
+ * @param row The row
+ * @param x0 The first pixel of the span
+ * @param x1 The last pixel of the span, included
+ */
+static inline void pyfb_edgeSpan(const struct pyfb_edge* edge, long int row, long int* x0, long int* x1) {
+    int64_t k = edge->c + edge->bias + edge->b * row;
+
+    if(edge->a > 0) {
+        int64_t first = -pyfb_floorDiv(k, edge->a);
+        if(first > *x0) {
+            *x0 = first > *x1 ? *x1 + 1 : (long int)first;
+        }
+    } else if(edge->a < 0) {
+        int64_t last = pyfb_floorDiv(k, -edge->a);
+        if(last < *x1) {
+            *x1 = last < *x0 ? *x0 - 1 : (long int)last;
+        }
+    } else if(k < 0) {
+        *x1 = *x0 - 1;
+    }
+}
+
+/**
+ * Converts an interpolated color channel to fixed point. The channels of the pixels in a
+ * triangle are in the range of the vertex colors, only the steps of the spans of a single
+ * pixel may be arbitrarily large, so the range is clamped to keep the stepping in 32 bits.
+ */
+static inline int32_t pyfb_fixedChannel(double value) {
+    const double limit = (double)(256 << PYFB_TRIANGLE_FRACTION);
+    value              = value > -limit ? value : -limit;
+    value              = value < limit ? value : limit;
+    return (int32_t)lrint(value);
+}
+
+/**
+ * Fills a span of 32 bit pixels with a color.
+ */
+static void pyfb_fillSpan32(uint32_t* restrict out, uint32_t value, long int count) {
+    for(long int i = 0; i < count; i++) {
+        out[i] = value;
+    }
+}
+
+/**
+ * Fills a span of 16 bit pixels with a color.
+ */
+static void pyfb_fillSpan16(uint16_t* restrict out, uint16_t value, long int count) {
+    for(long int i = 0; i < count; i++) {
+        out[i] = value;
+    }
+}
+
+/**
+ * Fills a span of 32 bit pixels with interpolated colors. The channels are computed from
+ * the index instead of accumulated, so the iterations are independent and the compiler
+ * vectorizes the loop.
+ *
+ * @param out The first pixel
+ * @param start The red, green, blue and alpha of the first pixel in fixed point
+ * @param step The change of the channels from a pixel to the next
+ * @param count The amount of pixels
+ */
+static void pyfb_shadeSpan32(uint32_t* restrict out, const int32_t* start, const int32_t* step, long int count) {
+    const int32_t max = 255 << PYFB_TRIANGLE_FRACTION;
+
+    int32_t r0 = start[0], g0 = start[1], b0 = start[2], a0 = start[3];
+    int32_t dr = step[0], dg = step[1], db = step[2], da = step[3];
+
+    for(int32_t i = 0; i < (int32_t)count; i++) {
+        int32_t r = r0 + i * dr;
+        int32_t g = g0 + i * dg;
+        int32_t b = b0 + i * db;
+        int32_t a = a0 + i * da;
+        r         = r < 0 ? 0 : (r > max ? max : r);
+        g         = g < 0 ? 0 : (g > max ? max : g);
+        b         = b < 0 ? 0 : (b > max ? max : b);
+        a         = a < 0 ? 0 : (a > max ? max : a);
+
+        out[i] = ((uint32_t)r >> PYFB_TRIANGLE_FRACTION) << 24 | ((uint32_t)g >> PYFB_TRIANGLE_FRACTION) << 16 |
+                 ((uint32_t)b >> PYFB_TRIANGLE_FRACTION) << 8 | ((uint32_t)a >> PYFB_TRIANGLE_FRACTION);
+    }
+}
+
+/**
+ * Fills a span of 16 bit pixels with interpolated colors. See pyfb_shadeSpan32.
+ */
+static void pyfb_shadeSpan16(uint16_t* restrict out, const int32_t* start, const int32_t* step, long int count) {
+    const int32_t max = 255 << PYFB_TRIANGLE_FRACTION;
+
+    int32_t r0 = start[0], g0 = start[1], b0 = start[2];
+    int32_t dr = step[0], dg = step[1], db = step[2];
+
+    for(int32_t i = 0; i < (int32_t)count; i++) {
+        int32_t r = r0 + i * dr;
+        int32_t g = g0 + i * dg;
+        int32_t b = b0 + i * db;
+        r         = r < 0 ? 0 : (r > max ? max : r);
+        g         = g < 0 ? 0 : (g > max ? max : g);
+        b         = b < 0 ? 0 : (b > max ? max : b);
+
+        out[i] = (uint16_t)(((uint32_t)r >> (PYFB_TRIANGLE_FRACTION + 3)) << 11 |
+                            ((uint32_t)g >> (PYFB_TRIANGLE_FRACTION + 2)) << 5 |
+                            ((uint32_t)b >> (PYFB_TRIANGLE_FRACTION + 3)));
+    }
+}
+
+/**
+ * Fills a triangle.
+ *
+ * @param raster The canvas
+ * @param vertices The three vertices
+ * @param shaded If 1 the colors of the vertices are interpolated, else the first color fills the triangle
+ */
+static void pyfb_rasterTriangle(struct pyfb_raster* raster, const struct pyfb_vertex* vertices, int shaded) {
+    const struct pyfb_vertex* v0 = &vertices[0];
+    const struct pyfb_vertex* v1 = &vertices[1];
+    const struct pyfb_vertex* v2 = &vertices[2];
+
+    // twice the area, the winding is made clockwise on the screen
+    int64_t area = (v1->x - v0->x) * (v2->y - v0->y) - (v1->y - v0->y) * (v2->x - v0->x);
+    if(area == 0) {
+        return;
+    }
+
+    if(area < 0) {
+        const struct pyfb_vertex* swap = v1;
+        v1                             = v2;
+        v2                             = swap;
+        area                           = -area;
+    }
+
+    // the edge opposite of every vertex
+    struct pyfb_edge edges[3];
+    pyfb_edgeSetup(&edges[0], v1, v2);
+    pyfb_edgeSetup(&edges[1], v2, v0);
+    pyfb_edgeSetup(&edges[2], v0, v1);
+
+    // the rows of the pixel centers in the bounding box
+    const int64_t one  = 1 << PYFB_TRIANGLE_SUBPIXEL;
+    const int64_t half = one / 2;
+    int64_t miny       = v0->y < v1->y ? (v0->y < v2->y ? v0->y : v2->y) : (v1->y < v2->y ? v1->y : v2->y);
+    int64_t maxy       = v0->y > v1->y ? (v0->y > v2->y ? v0->y : v2->y) : (v1->y > v2->y ? v1->y : v2->y);
+    int64_t row0       = -pyfb_floorDiv(half - miny, one);
+    int64_t row1       = pyfb_floorDiv(maxy - half, one);
+    long int y0        = row0 > 0 ? (long int)row0 : 0;
+    long int y1        = row1 < raster->yres - 1 ? (long int)row1 : raster->yres - 1;
+
+    // the planes of the color channels over the pixels, from the barycentric weights
+    double plane[4][3];
+    if(shaded) {
+        for(int ch = 0; ch < 4; ch++) {
+            int shift  = 24 - ch * 8;
+            double c0  = (double)((v0->color >> shift) & 0xFF);
+            double c1  = (double)((v1->color >> shift) & 0xFF);
+            double c2  = (double)((v2->color >> shift) & 0xFF);
+            double inv = (double)(1 << PYFB_TRIANGLE_FRACTION) / (double)area;
+
+            plane[ch][0] = (edges[0].a * c0 + edges[1].a * c1 + edges[2].a * c2) * inv;
+            plane[ch][1] = (edges[0].b * c0 + edges[1].b * c1 + edges[2].b * c2) * inv;
+            plane[ch][2] = (edges[0].c * c0 + edges[1].c * c1 + edges[2].c * c2) * inv;
+        }
+    }
+
+    uint32_t flat32 = v0->color;
+    uint16_t flat16 = pyfb_rgb565(v0->color);
+
+    for(long int y = y0; y <= y1; y++) {
+        long int x0 = 0;
+        long int x1 = raster->xres - 1;
+        pyfb_edgeSpan(&edges[0], y, &x0, &x1);
+        pyfb_edgeSpan(&edges[1], y, &x0, &x1);
+        pyfb_edgeSpan(&edges[2], y, &x0, &x1);
+
+        if(x0 > x1) {
+            continue;
+        }
+
+        long int count = x1 - x0 + 1;
+        uint8_t* out   = raster->buffer + ((size_t)y * (size_t)raster->xres + (size_t)x0) * raster->bytes;
+        raster->pixels += (unsigned long int)count;
+
+        if(!shaded) {
+            if(raster->bytes == 4) {
+                pyfb_fillSpan32((uint32_t*)out, flat32, count);
+            } else if(raster->bytes == 2) {
+                pyfb_fillSpan16((uint16_t*)out, flat16, count);
+            } else {
+                memset(out, (uint8_t)flat32, (size_t)count);
+            }
+            continue;
+        }
+
+        int32_t start[4];
+        int32_t step[4];
+        for(int ch = 0; ch < 4; ch++) {
+            start[ch] = pyfb_fixedChannel(plane[ch][0] * x0 + plane[ch][1] * y + plane[ch][2]);
+            step[ch]  = pyfb_fixedChannel(plane[ch][0]);
+        }
+
+        if(raster->bytes == 4) {
+            pyfb_shadeSpan32((uint32_t*)out, start, step, count);
+        } else {
+            pyfb_shadeSpan16((uint16_t*)out, start, step, count);
+        }
+    }
+}
+
+/**
+ * Converts a vertex coordinate to subpixels.
+ *
+ * @return 1 if the coordinate is valid, 0 if it is NaN
+ */
+static inline int pyfb_vertexCoord(double value, int64_t* coord) {
+    if(isnan(value)) {
+        return 0;
+    }
+
+    value  = value > -PYFB_TRIANGLE_LIMIT ? value : -PYFB_TRIANGLE_LIMIT;
+    value  = value < PYFB_TRIANGLE_LIMIT ? value : PYFB_TRIANGLE_LIMIT;
+    *coord = (int64_t)llrint(value * (1 << PYFB_TRIANGLE_SUBPIXEL));
+    return 1;
+}
+
+/**
+ * Locks an opened framebuffer and prepares the canvas to fill triangles on.
+ *
+ * @param fbnum The framebuffer number
+ * @param shaded If 1 the triangles are shaded
+ * @param raster The canvas to prepare
+ *
+ * @return 0 with the framebuffer locked, else -1 with a Python exception set
+ */
+static int pyfb_rasterBegin(uint8_t fbnum, int shaded, struct pyfb_raster* raster) {
+    if(fbnum >= MAX_FRAMEBUFFERS) {
+        PyErr_SetString(PyExc_ValueError, "The framebuffer number is not valid");
+        return -1;
+    }
+
+    pyfb_fblock(fbnum);
+
+    // next test if the device is really in use
+    if(!pyfb_fbused(fbnum)) {
+        PyErr_SetString(PyExc_IOError, "The framebuffer is not opened");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    struct pyfb_framebuffer* fb = pyfb_fbptr(fbnum);
+
+    if(fb->palette != NULL && shaded) {
+        PyErr_SetString(PyExc_IOError, "An indexed canvas can not be shaded");
+        pyfb_fbunlock(fbnum);
+        return -1;
+    }
+
+    raster->buffer = fb->u8_buffer;
+    raster->bytes  = fb->palette != NULL ? 1 : (fb->fb_info.vinfo.bits_per_pixel == 16 ? 2 : 4);
+    raster->xres   = (long int)fb->canvas.xres;
+    raster->yres   = (long int)fb->canvas.yres;
+    raster->pixels = 0;
+    return 0;
+}
+
+int pyfb_sfillTriangle(uint8_t fbnum, const double* coords, const uint32_t* colors) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    struct pyfb_vertex vertices[3];
+    for(int i = 0; i < 3; i++) {
+        if(!pyfb_vertexCoord(coords[2 * i], &vertices[i].x) || !pyfb_vertexCoord(coords[2 * i + 1], &vertices[i].y)) {
+            PyErr_SetString(PyExc_ValueError, "The coordinates are not valid");
+            return -1;
+        }
+        vertices[i].color = colors[i];
+    }
+
+    int shaded = colors[0] != colors[1] || colors[0] != colors[2];
+
+    struct pyfb_raster raster;
+    if(pyfb_rasterBegin(fbnum, shaded, &raster) != 0) {
+        return -1;
+    }
+
+    pyfb_rasterTriangle(&raster, vertices, shaded);
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_TRIANGLE);
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), raster.pixels);
+
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("fillTriangle", fbnum, trace_start);
+    return 0;
+}
+
+int pyfb_sfillTriangles(uint8_t fbnum,
+                        const void* vertices,
+                        size_t vertices_len,
+                        int type,
+                        const void* colors,
+                        size_t colors_len) {
+    PYFB_TRACE_BEGIN(trace_start);
+
+    // first check if the arguments are valid
+    size_t item = pyfb_scalarSize(type);
+
+    if(item == 0) {
+        PyErr_SetString(PyExc_ValueError, "The coordinate type is not valid");
+        return -1;
+    }
+
+    if(vertices_len % (6 * item) != 0) {
+        PyErr_SetString(PyExc_ValueError, "The coordinates must be three pairs of x and y per triangle");
+        return -1;
+    }
+
+    size_t count   = vertices_len / (6 * item);
+    size_t ncolors = colors_len / sizeof(uint32_t);
+
+    if(colors_len % sizeof(uint32_t) != 0 || (ncolors != 1 && ncolors != count && ncolors != 3 * count)) {
+        PyErr_SetString(PyExc_ValueError, "The colors must be one for all, one per triangle or one per vertex");
+        return -1;
+    }
+
+    struct pyfb_raster raster;
+    if(pyfb_rasterBegin(fbnum, ncolors == 3 * count && count > 0, &raster) != 0) {
+        return -1;
+    }
+
+    // the arrays are held by the caller, so fill without the GIL
+    Py_BEGIN_ALLOW_THREADS;
+
+    for(size_t t = 0; t < count; t++) {
+        struct pyfb_vertex tri[3];
+        int valid = 1;
+
+        for(size_t i = 0; i < 3; i++) {
+            size_t index = ncolors == 1 ? 0 : (ncolors == count ? t : 3 * t + i);
+            memcpy(&tri[i].color, (const uint8_t*)colors + index * sizeof(uint32_t), sizeof(uint32_t));
+
+            valid = valid && pyfb_vertexCoord(pyfb_scalarValue(vertices, type, 6 * t + 2 * i), &tri[i].x) &&
+                    pyfb_vertexCoord(pyfb_scalarValue(vertices, type, 6 * t + 2 * i + 1), &tri[i].y);
+        }
+
+        // a triangle with a NaN coordinate is skipped
+        if(valid) {
+            pyfb_rasterTriangle(&raster, tri, tri[0].color != tri[1].color || tri[0].color != tri[2].color);
+        }
+    }
+
+    Py_END_ALLOW_THREADS;
+
+    PYFB_STAT_CALL(pyfb_fbptr(fbnum), PYFB_STAT_TRIANGLE);
+    PYFB_STAT_PIXELS(pyfb_fbptr(fbnum), raster.pixels);
+
+    pyfb_fbunlock(fbnum);
+    PYFB_TRACE_END("fillTriangles", fbnum, trace_start);
+    return 0;
+}
@@ -2,13 +2,47 @@
 Core Python sources of the pyframebuffer module.
 """
 from pyframebuffer.color import getColorValue
+from pyframebuffer import aio
 import _pyfb as fb  # type: ignore
 
 import functools
 import inspect
+import math
+import struct
 
-__all__ = ["openfb", "MAX_FRAMEBUFFERS", "fbuser"]
+__all__ = ["openfb", "openheadless", "openshared", "setKeepAlive", "MAX_FRAMEBUFFERS", "DUMP_RAW", "DUMP_PPM",
+           "FILTER_NEAREST", "FILTER_BILINEAR", "PALETTE_SIZE", "SHAPE_RECT", "SHAPE_ELLIPSE", "fbuser"]
 MAX_FRAMEBUFFERS = fb.MAX_FRAMEBUFFERS
+DUMP_RAW = fb.PYFB_DUMP_RAW
+DUMP_PPM = fb.PYFB_DUMP_PPM
+FILTER_NEAREST = fb.PYFB_FILTER_NEAREST
+FILTER_BILINEAR = fb.PYFB_FILTER_BILINEAR
+PALETTE_SIZE = fb.PYFB_PALETTE_SIZE
+SHAPE_RECT = fb.PYFB_SHAPE_RECT
+SHAPE_ELLIPSE = fb.PYFB_SHAPE_ELLIPSE
+
+# the names of the primitives in the order of the native call counters
+_STAT_PRIMITIVES = ("pixel", "horizontalLine", "verticalLine", "line", "circle", "ellipse", "copyArea", "text", "writeRect",
+                    "blitTransformed", "sprite", "palette",
+                    "blitScalar", "points", "polyline", "triangle",
+                    "gradient")
+
+
+def _gradientStops(stops):
+    """
+    Packs the color stops of a gradient for the native sources.
+
+    @param stops A list of colors spread evenly, or of tuples (offset, color)
+    @return The tuple (offsets, colors) of the packed offsets and color values
+    """
+    stops = list(stops)
+    if len(stops) == 1 and not isinstance(stops[0], tuple):
+        stops = [(0.0, stops[0])]
+    elif stops and not isinstance(stops[0], tuple):
+        stops = [(i / (len(stops) - 1), color) for (i, color) in enumerate(stops)]
+    offsets = [float(offset) for (offset, _) in stops]
+    values = [getColorValue(color) for (_, color) in stops]
+    return (struct.pack("=%dd" % len(offsets), *offsets), struct.pack("=%dI" % len(values), *values))
 
 
 class Framebuffer:
@@ -44,26 +78,40 @@ class Framebuffer:
     @endcode
     """
 
-    def __init__(self, fbnum):
+    def __init__(self, fbnum, headless=None, shared=None):
         """
         Constructor for the Framebuffer object. Note that the constructor
         does not openes the framebuffer. It only assigns all data. To open
         the framebuffer, use it instead in a context.
 
         @param fbnum The framebuffer number
+        @param headless None for the device file, else a tuple of (xres, yres, depth,
+                        dump, dumpFormat) for a virtual framebuffer, see openheadless()
+        @param shared None for a private offscreen buffer, else a tuple of (name, owner, headless)
+                      for a shared offscreen buffer, see openshared()
         """
         self.fbnum = fbnum
+        self.headless = headless
+        self.shared = shared
         self.xres = None
         self.yres = None
         self.depth = None
         self.opened = False
+        self._asyncWorker = None
 
     def __enter__(self):
         """
         The enter function for a context. This function openes a framebuffer
         device file and fills the resolution informations.
         """
-        exitcode = fb.pyfb_open(self.fbnum)
+        if self.headless is not None:
+            exitcode = self._openHeadless()
+        elif self.shared is not None:
+            (name, owner, headless) = self.shared
+            (xres, yres, depth) = (0, 0, 32) if headless is None else headless
+            exitcode = fb.pyfb_openShared(self.fbnum, name, owner, xres, yres, depth)
+        else:
+            exitcode = fb.pyfb_open(self.fbnum)
         if exitcode != 0:
             return  # not getting here because native sources throw an error
 
@@ -80,6 +128,22 @@ class Framebuffer:
         # Ready
         return self
 
+    def _openHeadless(self):
+        """
+        Opens the virtual framebuffer. A dump path is opened only for the native
+        sources to duplicate the file descriptor.
+
+        @return The exitstatus
+        """
+        (xres, yres, depth, dump, dumpFormat) = self.headless
+        if dump is None:
+            return fb.pyfb_openVirtual(self.fbnum, xres, yres, depth, -1, dumpFormat)
+        if isinstance(dump, str):
+            with open(dump, "wb") as dumpFile:
+                return fb.pyfb_openVirtual(self.fbnum, xres, yres, depth, dumpFile.fileno(), dumpFormat)
+        fd = dump if isinstance(dump, int) else dump.fileno()
+        return fb.pyfb_openVirtual(self.fbnum, xres, yres, depth, fd, dumpFormat)
+
     def __exit__(self, exc_type, exc_value, traceback):
         """
         Exits a context and closes the framebuffer device file
@@ -89,6 +153,10 @@ class Framebuffer:
         @param exc_value Ignored
         @param traceback Ignored
         """
+        if self._asyncWorker is not None:
+            self._asyncWorker.close()
+            self._asyncWorker = None
+
         if self.opened is True:
             fb.pyfb_close(self.fbnum)
 
@@ -135,6 +203,171 @@ class Framebuffer:
         """
         return (self.xres, self.yres, self.depth)
 
+    def getCanvasSize(self):
+        """
+        Returns the size of the canvas in a tuple of structure (width, height). The canvas
+        is the area all drawing operations address. It is at least as large as the screen.
+
+        @return The tuple with the canvas size
+        """
+        (width, height, _, _, _) = fb.pyfb_getCanvas(self.fbnum)
+        return (width, height)
+
+    def setCanvas(self, width, height):
+        """
+        Resizes the canvas to draw once into an area larger than the screen, and scroll
+        over it by moving the viewport with setViewport(). This clears the offscreen buffer
+        and moves the viewport to the upper left corner of the canvas.
+
+        @param width The canvas width, at least the X resolution
+        @param height The canvas height, at least the Y resolution
+        """
+        fb.pyfb_setCanvas(self.fbnum, width, height)
+
+    def getViewport(self):
+        """
+        Returns the offset of the visible area on the canvas in a tuple of structure (x, y).
+
+        @return The tuple with the viewport offset
+        """
+        (_, _, x, y, _) = fb.pyfb_getCanvas(self.fbnum)
+        return (x, y)
+
+    def setViewport(self, x, y):
+        """
+        Moves the visible area on the canvas. If the driver supports panning the display,
+        the viewport is moved by the driver without writing any pixel. Else the viewport
+        is copied to the framebuffer by flushing the offscreen buffer. On a panned canvas
+        update() writes only the marked rectangles of the viewport, or the whole canvas
+        if nothing has been marked, so draw once, update() and scroll for free.
+
+        @param x The x offset of the viewport on the canvas
+        @param y The y offset of the viewport on the canvas
+        """
+        if fb.pyfb_setViewport(self.fbnum, x, y) == 0:
+            fb.pyfb_flushBuffer(self.fbnum)
+
+    def setRotation(self, degrees, flipX=False, flipY=False):
+        """
+        Rotates and mirrors the screen, e.g. for a panel mounted in portrait while the
+        driver reports landscape. Drawing uses the coordinates of the rotated screen and
+        costs nothing extra, update() rotates while copying to the framebuffer. A quarter
+        turn swaps the X and the Y resolution. This clears the offscreen buffer and resets
+        the canvas to the screen size. A streamed framebuffer can not be rotated, because
+        the frame size of a stream is fixed at its start, so stop the stream before.
+
+        @code{.py}
+        import pyframebuffer as fb
+
+        with fb.openfb(0) as framebuffer:
+            framebuffer.setRotation(90)
+            (width, height, _) = framebuffer.getResolution()  # portrait now
+            framebuffer.drawHorizontalLine(0, 0, width, 0xFF0000FF)
+            framebuffer.update()
+        @endcode
+
+        @param degrees The clockwise rotation, 0, 90, 180 or 270
+        @param flipX True to mirror the screen horizontally before rotating it
+        @param flipY True to mirror the screen vertically before rotating it
+        """
+        flip = (fb.PYFB_FLIP_X if flipX else 0) | (fb.PYFB_FLIP_Y if flipY else 0)
+        fb.pyfb_setRotation(self.fbnum, degrees, flip)
+        (self.xres, self.yres, self.depth) = fb.pyfb_getResolution(self.fbnum)
+
+    def getRotation(self):
+        """
+        Returns the rotation of the screen in a tuple of structure (degrees, flipX, flipY),
+        see setRotation().
+
+        @return The tuple with the rotation
+        """
+        (degrees, flip) = fb.pyfb_getRotation(self.fbnum)
+        return (degrees, bool(flip & fb.PYFB_FLIP_X), bool(flip & fb.PYFB_FLIP_Y))
+
+    def setPalette(self, colors):
+        """
+        Switches to an indexed canvas, or changes the palette of the indexed canvas. The
+        offscreen buffer of an indexed canvas holds one palette index per pixel, a quarter
+        of the memory of a 32 bit canvas, and update() expands the indices to the colors.
+        The color of all drawing calls is the palette index then. Switching clears the
+        canvas to index 0, changing the palette keeps it and the next update() recolors
+        the whole screen without redrawing. Pixels, lines, shapes and text are drawn as
+        before. A rotated, panned, shared, streamed or mirrored framebuffer can not be
+        indexed, and an indexed canvas can not be rotated, streamed or mirrored. Sprites,
+        writeRect(), blitTransformed(), blitScalar(), gradients and shaded triangles need
+        colors instead of indices, so they are not available on an indexed canvas either.
+
+        @code{.py}
+        from pyframebuffer.color import rgb
+        import pyframebuffer as fb
+
+        BACKGROUND, TEXT = 0, 1
+
+        with fb.openfb(0) as framebuffer:
+            framebuffer.setPalette([rgb(255, 255, 255), rgb(0, 0, 0)])
+            framebuffer.drawText(10, 10, "Hello World", TEXT, font)
+            framebuffer.update()
+            # -- the dark theme, without redrawing
+            framebuffer.setPalette([rgb(0, 0, 0), rgb(255, 255, 255)])
+            framebuffer.update()
+        @endcode
+
+        @param colors The list of color values or Color objects, 1 to PALETTE_SIZE colors,
+                      the indices after them are black
+        """
+        values = [getColorValue(color) for color in colors]
+        fb.pyfb_setPalette(self.fbnum, struct.pack("=%dI" % len(values), *values))
+
+    def clearPalette(self):
+        """
+        Switches an indexed canvas back to the colors of the framebuffer, see setPalette().
+        This clears the offscreen buffer.
+        """
+        fb.pyfb_clearPalette(self.fbnum)
+
+    def damage(self, x, y, width, height):
+        """
+        Marks a rectangle as changed, so the next update() only writes the bounding
+        box of the marked rectangles instead of the whole screen. Without marked
+        rectangles update() writes the whole screen.
+
+        @param x The x coordinate of the rectangle
+        @param y The y coordinate of the rectangle
+        @param width The width of the rectangle
+        @param height The height of the rectangle
+        """
+        fb.pyfb_damage(self.fbnum, x, y, width, height)
+
+    def waitDamage(self, timeout=None):
+        """
+        Waits until another process updated the shared offscreen buffer, only for
+        the owner of a shared offscreen buffer, see openshared(). Other Python
+        threads run while waiting.
+
+        @param timeout The timeout in seconds, or None to wait without a timeout
+
+        @return True if there are updates to flush, else False on timeout
+        """
+        return fb.pyfb_waitDamage(self.fbnum, -1.0 if timeout is None else float(timeout))
+
+    async def updateAsync(self):
+        """
+        Updates the framebuffer like update(), but the flush runs on a native worker
+        thread, so other coroutines continue meanwhile. Updates requested while a flush
+        is still waiting to start are merged into it. Drawing while a flush runs waits
+        for it, so await the update before drawing the next frame.
+
+        The usage in a coroutine is as following:
+
+        @code{.py}
+        async def compositor(framebuffer):
+            async for tick in FrameClock(framebuffer, 30):
+                drawFrame(framebuffer, tick.frame)
+                await framebuffer.updateAsync()
+        @endcode
+        """
+        await aio.getWorker(self).flush()
+
     def update(self):
         """
         Updates the framebuffer by flushing the offscreen buffer to the framebuffer. This method
@@ -143,6 +376,100 @@ class Framebuffer:
         """
         fb.pyfb_flushBuffer(self.fbnum)
 
+    def startStream(self, target, encoding=fb.PYFB_STREAM_RLE, tileSize=fb.PYFB_STREAM_TILE):
+        """
+        Starts streaming every flushed frame to a pipe or socket, e.g. to mirror the
+        screen to a remote viewer. A native thread encodes and writes only the tiles
+        that changed since the last frame, so update() does not wait for the stream. Use
+        pyframebuffer.stream.StreamReader on the other side to decode the frames.
+
+        @param target The file descriptor or an object with a fileno() method, like a socket
+        @param encoding The tile encoding, STREAM_RAW, STREAM_RLE or STREAM_QOI of
+                        pyframebuffer.stream
+        @param tileSize The edge length of the tiles in pixels
+        """
+        fd = target if isinstance(target, int) else target.fileno()
+        fb.pyfb_streamStart(self.fbnum, fd, encoding, tileSize)
+
+    def stopStream(self):
+        """
+        Stops streaming the flushed frames. The stream is also stopped when the
+        framebuffer is closed.
+        """
+        fb.pyfb_streamStop(self.fbnum)
+
+    def getStreamStats(self):
+        """
+        Returns the statistics of the stream in a dictionary with the keys frames,
+        dropped (frames replaced by a newer one before being encoded), tiles, bytes and
+        failed (True if writing to the stream failed).
+
+        @return The dictionary with the stream statistics
+        """
+        (frames, dropped, tiles, bytes, failed) = fb.pyfb_streamStats(self.fbnum)
+        return {"frames": frames, "dropped": dropped, "tiles": tiles, "bytes": bytes, "failed": failed}
+
+    def addMirror(self, framebuffer):
+        """
+        Mirrors this framebuffer to another opened framebuffer. Every update() scales the
+        changed area to the resolution of the other framebuffer, converts it to its depth
+        and flushes it, e.g. to show the same frame on a 32bpp HDMI display and a 16bpp
+        SPI panel. All mirrors are converted in parallel on native threads. Draw only to
+        this framebuffer, a mirror leaves the group when it is closed.
+
+        @code{.py}
+        import pyframebuffer as fb
+
+        with fb.openfb(0) as hdmi, fb.openfb(1) as panel:
+            hdmi.addMirror(panel)
+            hdmi.fill(0xFF0000FF)
+            hdmi.update()  # writes both displays
+        @endcode
+
+        @param framebuffer The opened Framebuffer object to mirror to
+        """
+        fb.pyfb_mirrorAdd(self.fbnum, framebuffer.fbnum)
+
+    def removeMirror(self, framebuffer):
+        """
+        Stops mirroring this framebuffer to another framebuffer, see addMirror().
+
+        @param framebuffer The Framebuffer object mirrored to
+        """
+        fb.pyfb_mirrorRemove(self.fbnum, framebuffer.fbnum)
+
+    def setStats(self, enabled=True):
+        """
+        Enables or disables the performance counters of this framebuffer. The counters
+        are disabled by default, so they cost nothing when they are not used.
+
+        @param enabled True to enable the counters, False to disable them
+        """
+        fb.pyfb_setStats(self.fbnum, enabled)
+
+    def getStats(self, reset=False):
+        """
+        Returns the performance counters in a dictionary with the keys calls (a
+        dictionary of the call count per primitive), pixels (the pixels written to
+        the offscreen buffer), flushes, flushBytes (the bytes written to the device),
+        flushNs (the total flush time in nanoseconds) and flushHistogram (a list of
+        the flush counts, index 0 counts the flushes below 1 microsecond, index i the
+        flushes below 2^i microseconds and the last index all slower flushes).
+
+        @param reset True to reset the counters after reading them
+
+        @return The dictionary with the performance counters
+        """
+        (calls, pixels, flushes, flushBytes, flushNs, histogram) = fb.pyfb_stats(self.fbnum, reset)
+        return {
+            "calls": dict(zip(_STAT_PRIMITIVES, calls)),
+            "pixels": pixels,
+            "flushes": flushes,
+            "flushBytes": flushBytes,
+            "flushNs": flushNs,
+            "flushHistogram": list(histogram),
+        }
+
     def drawPixel(self, x, y, color):
         """
         Draws a pixel on the offscreen buffer.
@@ -156,15 +483,16 @@ class Framebuffer:
 
     def fill(self, color):
         """
-        Fills the complete framebuffer with one color. Using as color 0x00000000
+        Fills the complete canvas with one color. Using as color 0x00000000
         or rgba(0, 0, 0, 0) is equivalent to clear the framebuffer (fill the
         framebuffer with black).
 
         @param color The color value or Color object
         """
         color = getColorValue(color)
-        for i in range(0, self.yres):
-            fb.pyfb_drawHorizontalLine(0, 0, i, self.xres, color)
+        (width, height) = self.getCanvasSize()
+        for i in range(0, height):
+            fb.pyfb_drawHorizontalLine(self.fbnum, 0, i, width, color)
 
     def drawLine(self, x1, y1, x2, y2, color):
         """
@@ -180,6 +508,170 @@ class Framebuffer:
         color = getColorValue(color)
         fb.pyfb_drawLine(self.fbnum, x1, y1, x2, y2, color)
 
+    def drawPoints(self, xs, ys, color):
+        """
+        Draws a pixel at every point of two coordinate arrays in one call, e.g. a scatter
+        plot. The coordinates may be integers or floats, floats are rounded. Points off the
+        screen or with a NaN coordinate are skipped.
+
+        @param xs A C contiguous buffer of the x coordinates (e.g. array.array or a numpy array)
+        @param ys A C contiguous buffer of as many y coordinates
+        @param color The color value or Color object
+        """
+        color = getColorValue(color)
+        fb.pyfb_drawPoints(self.fbnum, xs, ys, color)
+
+    def drawPolyline(self, points, color, decimate=False):
+        """
+        Draws connected lines through the points of a coordinate array in one call, e.g. the
+        trace of a time series. The pixel shared by two lines is drawn once, the lines are
+        clipped at the screen edges and a point with a NaN coordinate leaves a gap. With
+        decimate, the consecutive points in the same column are drawn as one vertical line
+        from their minimum to their maximum, so a trace of far more samples than columns
+        costs one line per column. The other Python threads keep running while it draws.
+
+        @code{.py}
+        from pyframebuffer.color import rgb
+        import pyframebuffer as fb
+        import numpy as np
+
+        with fb.openfb(0) as framebuffer:
+            (xres, yres, _) = framebuffer.getResolution()
+            # 100000 samples over the width of the screen
+            xs = np.linspace(0, xres - 1, len(samples))
+            points = np.column_stack((xs, yres / 2 - samples * 100))
+            framebuffer.drawPolyline(points, rgb(0, 255, 0), decimate=True)
+            framebuffer.update()
+        @endcode
+
+        @param points A C contiguous buffer of the coordinates as pairs of x and y, integers
+                      or floats, e.g. a numpy array of the shape (count, 2)
+        @param color The color value or Color object
+        @param decimate True to draw the points of a column as their minimum and maximum
+        """
+        color = getColorValue(color)
+        fb.pyfb_drawPolyline(self.fbnum, points, decimate, color)
+
+    def fillTriangle(self, x1, y1, x2, y2, x3, y3, color):
+        """
+        Fills a triangle. With one color the triangle is flat, with a color per vertex the
+        colors are blended over the triangle (Gouraud shading). The coordinates may be
+        floats, a pixel is filled if its center is in the triangle, so triangles sharing an
+        edge fill every pixel once. Parts off the screen are clipped.
+
+        @param x1 The x coordinate of the first vertex
+        @param y1 The y coordinate of the first vertex
+        @param x2 The x coordinate of the second vertex
+        @param y2 The y coordinate of the second vertex
+        @param x3 The x coordinate of the third vertex
+        @param y3 The y coordinate of the third vertex
+        @param color The color value or Color object, or a tuple of the three colors of the vertices
+        """
+        if isinstance(color, (tuple, list)):
+            colors = tuple(getColorValue(c) for c in color)
+        else:
+            colors = (getColorValue(color),) * 3
+        fb.pyfb_fillTriangle(self.fbnum, (x1, y1, x2, y2, x3, y3), colors)
+
+    def fillTriangles(self, vertices, colors):
+        """
+        Fills a batch of triangles in one call, e.g. a mesh or the slices of a pie chart, see
+        fillTriangle(). The other Python threads keep running while it fills.
+
+        @code{.py}
+        from pyframebuffer.color import rgb
+        import pyframebuffer as fb
+        import array
+
+        red, green, blue = rgb(255, 0, 0), rgb(0, 255, 0), rgb(0, 0, 255)
+        with fb.openfb(0) as framebuffer:
+            # two shaded triangles forming a quad
+            quad = array.array("f", [10, 10, 200, 10, 10, 100, 200, 10, 200, 100, 10, 100])
+            framebuffer.fillTriangles(quad, [red, green, blue, green, red, blue])
+            framebuffer.update()
+        @endcode
+
+        @param vertices A C contiguous buffer of the coordinates, three pairs of x and y per
+                        triangle, integers or floats, e.g. a numpy array of the shape (count, 3, 2)
+        @param colors A color value or Color object for all triangles, or a list of one color
+                      per triangle or one per vertex, or a buffer of them as native 32 bit integers
+        """
+        if isinstance(colors, (tuple, list)):
+            values = [getColorValue(color) for color in colors]
+            colors = struct.pack("=%dI" % len(values), *values)
+        elif not isinstance(colors, (bytes, bytearray, memoryview)):
+            colors = struct.pack("=I", getColorValue(colors))
+        fb.pyfb_fillTriangles(self.fbnum, vertices, colors)
+
+    def fillLinearGradient(self, x, y, width, height, stops, angle=0, shape=SHAPE_RECT, dither=False):
+        """
+        Fills a rectangle, or the ellipse inscribed in it, with a linear gradient, e.g. a
+        background or a bar. The gradient runs through the center of the rectangle at the
+        angle, from the corner it leaves first to the opposite corner.
+
+        @code{.py}
+        from pyframebuffer.color import rgb
+        import pyframebuffer as fb
+
+        with fb.openfb(0) as framebuffer:
+            # from dark blue at the top to light blue at the bottom
+            framebuffer.fillLinearGradient(0, 0, 800, 480, [rgb(0, 0, 64), rgb(96, 160, 255)], angle=90)
+            # a bar from green over yellow to red
+            framebuffer.fillLinearGradient(20, 20, 300, 24, [(0, rgb(0, 255, 0)), (0.7, rgb(255, 255, 0)),
+                                                             (1, rgb(255, 0, 0))])
+            framebuffer.update()
+        @endcode
+
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param width The width of the rectangle
+        @param height The height of the rectangle
+        @param stops A list of colors spread evenly, or of tuples (offset, color) with the offsets
+                     rising from 0 to 1, at most 16
+        @param angle The direction in degrees, 0 from left to right, 90 from top to bottom
+        @param shape SHAPE_RECT or SHAPE_ELLIPSE
+        @param dither True to dither the colors on a 16 bit framebuffer, so they show no bands
+        """
+        if width <= 0 or height <= 0:
+            return
+        rad = math.radians(angle)
+        (dx, dy) = (math.cos(rad), math.sin(rad))
+        half = (abs(width * dx) + abs(height * dy)) / 2
+        (cx, cy) = (x + width / 2, y + height / 2)
+        points = (cx - dx * half, cy - dy * half, cx + dx * half, cy + dy * half, 0.0)
+        (offsets, colors) = _gradientStops(stops)
+        fb.pyfb_fillGradient(self.fbnum, fb.PYFB_GRADIENT_LINEAR, points, offsets, colors, x, y, width, height, shape,
+                             dither)
+
+    def fillRadialGradient(self, x, y, width, height, stops, center=None, radius=None, shape=SHAPE_RECT,
+                           dither=False):
+        """
+        Fills a rectangle, or the ellipse inscribed in it, with a radial gradient, the colors
+        changing with the distance from the center. See fillLinearGradient().
+
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param width The width of the rectangle
+        @param height The height of the rectangle
+        @param stops A list of colors spread evenly, or of tuples (offset, color) with the offsets
+                     rising from 0 to 1, at most 16
+        @param center The tuple (x, y) of the center, or None for the center of the rectangle
+        @param radius The distance of the last color from the center, or None for the distance
+                      to the corners of the rectangle
+        @param shape SHAPE_RECT or SHAPE_ELLIPSE
+        @param dither True to dither the colors on a 16 bit framebuffer, so they show no bands
+        """
+        if width <= 0 or height <= 0:
+            return
+        if center is None:
+            center = (x + width / 2, y + height / 2)
+        if radius is None:
+            radius = max(math.hypot(cx - center[0], cy - center[1]) for cx in (x, x + width) for cy in (y, y + height))
+        points = (center[0], center[1], 0.0, 0.0, radius)
+        (offsets, colors) = _gradientStops(stops)
+        fb.pyfb_fillGradient(self.fbnum, fb.PYFB_GRADIENT_RADIAL, points, offsets, colors, x, y, width, height, shape,
+                             dither)
+
     def drawHorizontalLine(self, x, y, len, color):
         """
         Draws a horizontal line on the offscreen buffer.
@@ -229,6 +721,169 @@ class Framebuffer:
         color = getColorValue(color)
         fb.pyfb_drawEllipse(self.fbnum, xm, ym, a, b, color)
 
+    def getPixel(self, x, y):
+        """
+        Reads a pixel of the offscreen buffer. On 16 bit framebuffers the channels
+        are widened to 8 bit and the alpha channel is opaque.
+
+        @param x The x coordinate
+        @param y The y coordinate
+
+        @return The 32 bit color value of the pixel, or the palette index on an indexed canvas
+        """
+        return fb.pyfb_getPixel(self.fbnum, x, y)
+
+    def readRect(self, x, y, width, height, buffer):
+        """
+        Reads a rectangular area of the offscreen buffer into a caller owned buffer, as
+        4 bytes per pixel in the order red, green, blue and alpha, row by row.
+
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param width The width of the area
+        @param height The height of the area
+        @param buffer A writable buffer (e.g. a bytearray) of at least width * height * 4 bytes
+        """
+        fb.pyfb_readRect(self.fbnum, x, y, width, height, buffer)
+
+    def writeRect(self, x, y, width, height, buffer):
+        """
+        Writes pixels to a rectangular area of the offscreen buffer, the counterpart of
+        readRect(), e.g. to load a sprite into a headless framebuffer.
+
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param width The width of the area
+        @param height The height of the area
+        @param buffer A buffer (e.g. bytes) of at least width * height * 4 bytes, 4 bytes per
+                      pixel in the order red, green, blue and alpha, row by row
+        """
+        fb.pyfb_writeRect(self.fbnum, x, y, width, height, buffer)
+
+    def blitTransformed(self, source, matrix, filter=FILTER_NEAREST):
+        """
+        Draws the canvas of another framebuffer scaled, rotated or sheared by an affine
+        matrix, e.g. a sprite, a gauge needle or a low resolution render target upscaled
+        to the screen. Pixels of a 32 bit source with an alpha below 128 are transparent.
+        Build the matrix with the pyframebuffer.transform functions.
+
+        @code{.py}
+        from pyframebuffer import transform
+        import pyframebuffer as fb
+
+        with fb.openfb(0) as framebuffer, fb.openheadless(1, 8, 64) as needle:
+            needle.writeRect(0, 0, 8, 64, needlePixels)
+            # rotate the needle around its bottom center to the gauge center
+            matrix = transform.multiply(transform.translate(240, 160),
+                                        transform.rotate(angle),
+                                        transform.translate(-4, -64))
+            framebuffer.blitTransformed(needle, matrix, fb.FILTER_BILINEAR)
+            framebuffer.update()
+        @endcode
+
+        @param source The opened Framebuffer object to draw, may be this one
+        @param matrix The tuple (a, b, c, d, e, f) mapping a source point (x, y) to the
+                      point (a * x + b * y + c, d * x + e * y + f)
+        @param filter FILTER_NEAREST or FILTER_BILINEAR
+        """
+        fb.pyfb_blitTransformed(self.fbnum, source.fbnum, tuple(matrix), filter)
+
+    def blitScalar(self, array, x, y, colormap, vmin, vmax, zoom=1, width=0):
+        """
+        Draws an array of scalar values, like a heatmap or a spectrogram, mapping every
+        value through a colormap. vmin maps to the first and vmax to the last color, the
+        values outside of the range are clamped. Every value is drawn as a square of
+        zoom * zoom pixels. The array is held while it is drawn, so other Python threads
+        keep running.
+
+        @code{.py}
+        from pyframebuffer import colormap
+        import pyframebuffer as fb
+        import array
+
+        cmap = colormap.hot()
+        with fb.openfb(0) as framebuffer:
+            # 256 frequency bins per column, the rows are the time steps
+            values = array.array("f", spectrum)
+            framebuffer.blitScalar(values, 0, 0, cmap, -90.0, 0.0, zoom=2, width=256)
+            framebuffer.update()
+        @endcode
+
+        @param array A C contiguous buffer of uint8, uint16 or float32 values (e.g.
+                     array.array with the type "B", "H" or "f", or a numpy array), row by row
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param colormap A tuple of COLORMAP_SIZE color values, see pyframebuffer.colormap, or
+                        a buffer of them as native 32 bit integers
+        @param vmin The value of the first color
+        @param vmax The value of the last color
+        @param zoom The edge length of the square of a value, 1 to 256
+        @param width The amount of values per row, or 0 for the second dimension of a two
+                     dimensional array
+        """
+        if not isinstance(colormap, (bytes, bytearray, memoryview)):
+            values = [getColorValue(color) for color in colormap]
+            colormap = struct.pack("=%dI" % len(values), *values)
+        fb.pyfb_blitScalar(self.fbnum, array, width, x, y, colormap, vmin, vmax, zoom)
+
+    def capture(self, buffer=None, device=True):
+        """
+        Captures the visible screen as 4 bytes per pixel in the order red, green, blue
+        and alpha, row by row.
+
+        @param buffer A writable buffer of at least xres * yres * 4 bytes to capture into,
+                      or None to return a new bytes object
+        @param device True to read what the device currently shows, False to read the
+                      viewport of the offscreen buffer
+
+        @return The bytes object with the pixels, or None if a buffer was given
+        """
+        source = fb.PYFB_CAPTURE_DEVICE if device else fb.PYFB_CAPTURE_BUFFER
+        return fb.pyfb_capture(self.fbnum, source, buffer)
+
+    def copyArea(self, x, y, width, height, dx, dy):
+        """
+        Copies a rectangular area of the offscreen buffer to another position. The
+        areas may overlap, so this can be used to scroll a part of the screen without
+        redrawing it. Parts of the area that are not on the screen are clipped.
+
+        @param x The x coordinate of the upper left corner of the source area
+        @param y The y coordinate of the upper left corner of the source area
+        @param width The width of the area
+        @param height The height of the area
+        @param dx The x coordinate of the upper left corner of the destination
+        @param dy The y coordinate of the upper left corner of the destination
+        """
+        fb.pyfb_copyArea(self.fbnum, x, y, width, height, dx, dy)
+
+    def drawText(self, x, y, text, color, font, background=None):
+        """
+        Draws a text on the offscreen buffer. Lines are separated by a newline
+        character. The text is clipped at the right and bottom edge of the screen.
+
+        @param x The x coordinate of the upper left corner
+        @param y The y coordinate of the upper left corner
+        @param text The text to draw
+        @param color The color value or Color object
+        @param font The Font object to draw the text with
+        @param background The background color value or Color object, or None for a transparent background
+        """
+        color = getColorValue(color)
+        if background is not None:
+            background = getColorValue(background)
+        fb.pyfb_drawText(self.fbnum, x, y, text, font.fontnum, color, background)
+
+    def drawSprite(self, x, y, sprite):
+        """
+        Draws a sprite on the offscreen buffer, copying its opaque pixels. The sprite
+        is clipped at all edges of the screen, so it may be partially off the screen.
+
+        @param x The x coordinate of the upper left corner, may be negative
+        @param y The y coordinate of the upper left corner, may be negative
+        @param sprite The Sprite object to draw
+        """
+        fb.pyfb_drawSprite(self.fbnum, sprite.spritenum, x, y)
+
 
 def openfb(num):
     """
@@ -244,6 +899,101 @@ def openfb(num):
     return Framebuffer(fbnum=num)
 
 
+def openheadless(num, xres, yres, depth=32, dump=None, dumpFormat=DUMP_PPM):
+    """
+    Opens a virtual framebuffer backed by memory instead of a device file, to render
+    without a display, e.g. in a CI pipeline or to generate frames offline. All drawing
+    runs the same native code as for a device file. The framebuffer number must not be
+    in use by a device file.
+
+    @code{.py}
+    import pyframebuffer as fb
+
+    # every update() appends a PPM image, e.g. for "ffmpeg -f image2pipe -i frames.ppm"
+    with fb.openheadless(31, 800, 480, dump="frames.ppm") as framebuffer:
+        framebuffer.drawLine(0, 0, 799, 479, 0xFFFFFFFF)
+        framebuffer.update()
+    @endcode
+
+    @param num The framebuffer number to use
+    @param xres The X resolution
+    @param yres The Y resolution
+    @param depth The color depth, 16 or 32
+    @param dump None, or a path, file descriptor or file object to dump every flushed frame to
+    @param dumpFormat The dump format, DUMP_PPM or DUMP_RAW
+
+    @return The Framebuffer object
+    """
+    return Framebuffer(fbnum=num, headless=(xres, yres, depth, dump, dumpFormat))
+
+
+def openshared(num, name, owner=False, headless=None):
+    """
+    Opens a framebuffer with its offscreen buffer in a named shared memory segment,
+    so several processes draw into regions of one offscreen buffer. The owner opens
+    the device file /dev/fbN, or a virtual framebuffer to composite without a display,
+    and creates the segment, the other processes attach to it. An update() of another
+    process only hands its damage over to the owner, an update() of the owner writes
+    the damage of all processes to the device. Mark the drawn regions with damage(),
+    else every update() damages the whole screen.
+
+    @code{.py}
+    import pyframebuffer as fb
+
+    # the compositor process owns /dev/fb0 and flushes
+    with fb.openshared(0, "/pyfb-screen", owner=True) as framebuffer:
+        while True:
+            framebuffer.waitDamage()
+            framebuffer.update()
+
+    # a status process draws into the top rows
+    with fb.openshared(0, "/pyfb-screen") as framebuffer:
+        framebuffer.drawHorizontalLine(0, 10, 200, 0xFFFFFFFF)
+        framebuffer.damage(0, 10, 200, 1)
+        framebuffer.update()
+    @endcode
+
+    @param num The framebuffer number, for the other processes only the number of the framebuffer
+               object in this process
+    @param name The name of the segment, starting with a slash, e.g. "/pyfb-screen"
+    @param owner True to open the device file and create the segment
+    @param headless None for the owner to open the device file, else a tuple of (xres, yres,
+                    depth) for the owner to open a virtual framebuffer instead, see openheadless()
+
+    @return The Framebuffer object
+    """
+    return Framebuffer(fbnum=num, shared=(name, bool(owner), headless))
+
+
+def setKeepAlive(seconds, num=None):
+    """
+    Keeps framebuffer devices opened for an idle period after the last user closed
+    them, so entering a context or a framebuffer user function again does not reopen
+    the device and allocate the offscreen buffer. A framebuffer reopened within the
+    period starts with a cleared offscreen buffer, like a freshly opened one.
+
+    @code{.py}
+    import pyframebuffer as fb
+
+    fb.setKeepAlive(2.0)
+
+    @fb.fbuser
+    def handler(framebuffer, text):
+        ...
+
+    # only the first call opens /dev/fb0
+    for request in requests:
+        handler(0, request)
+    @endcode
+
+    @param seconds The idle period in seconds, 0 disables the keep-alive and closes
+                   framebuffers kept alive
+    @param num The framebuffer number, or None for all framebuffer numbers
+    """
+    for fbnum in range(MAX_FRAMEBUFFERS) if num is None else (num,):
+        fb.pyfb_setKeepAlive(fbnum, float(seconds))
+
+
 def fbuser(fn):
     """
     Decorator to open a framebuffer via the Decorator API.
@@ -252,12 +1002,12 @@ def fbuser(fn):
 
     @return The wrapper function
     """
+    # the signature is inspected once, as the wrapper may be called very often
+    signature = inspect.signature(fn)
+    first_param = next(iter(signature.parameters), None)
+
     @functools.wraps(fn)
     def wrapper(*args, **kwargs):
-        # first check the function signature
-        signature = inspect.signature(fn)
-        first_param = next(iter(signature.parameters), None)
-
         # declare the return value variable
         ret_val = None
 
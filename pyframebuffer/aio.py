@@ -0,0 +1,132 @@
+"""asyncio integration of the flushes and frame clocks"""
+
+import asyncio
+import errno
+import os
+
+import _pyfb as fb  # type: ignore
+
+__all__ = ["AsyncWorker", "getWorker"]
+
+
+def _clockError(code):
+    """
+    Returns the exception of a failed frame clock wait, like the synchronous wait raises it.
+    """
+    if code == errno.EBADF:
+        return OSError("The frame clock is not opened")
+    if code == errno.EBUSY:
+        return OSError("The frame clock is waited for by another thread")
+    return OSError(code, os.strerror(code))
+
+
+class AsyncWorker:
+    """
+    The native worker thread of a framebuffer, serving one event loop. The worker
+    flushes the offscreen buffer and waits for frame clocks on request, and signals
+    the completions on an eventfd watched by the loop, so neither blocks other
+    coroutines. Use getWorker() instead of creating it directly.
+    """
+
+    def __init__(self, fbnum, loop):
+        """
+        Starts the worker of a framebuffer.
+
+        @param fbnum The number of the opened framebuffer
+        @param loop The event loop to complete the requests on
+        """
+        self.fbnum = fbnum
+        self.loop = loop
+        self.fd = fb.pyfb_asyncOpen(fbnum)
+        self.flushes = []
+        self.ticks = []
+        loop.add_reader(self.fd, self._poll)
+
+    def flush(self):
+        """
+        Requests a flush. A flush requested while the previous one has not started
+        yet is merged into it.
+
+        @return The future completed after the flush
+        """
+        return self._request(self.flushes, fb.pyfb_asyncFlush(self.fbnum))
+
+    def tick(self, clocknum):
+        """
+        Requests a wait for the next frame of a frame clock.
+
+        @param clocknum The clock number
+        @return The future completed with the tuple of (frame, dropped, deadline, lateness)
+        """
+        return self._request(self.ticks, fb.pyfb_asyncTick(self.fbnum, clocknum))
+
+    def _request(self, waiters, ticket):
+        """
+        Returns a new future for a ticket.
+        """
+        future = self.loop.create_future()
+        waiters.append((ticket, future))
+        return future
+
+    def _poll(self):
+        """
+        Completes the futures of the finished requests, called by the loop if the
+        eventfd is readable.
+        """
+        (flushDone, flushError, tickDone, tickError, tick) = fb.pyfb_asyncPoll(self.fbnum)
+
+        pending = []
+        for (ticket, future) in self.flushes:
+            if ticket > flushDone:
+                pending.append((ticket, future))
+            elif not future.done() and flushError != 0:
+                future.set_exception(OSError(flushError, os.strerror(flushError)))
+            elif not future.done():
+                future.set_result(None)
+        self.flushes = pending
+
+        pending = []
+        for (ticket, future) in self.ticks:
+            if ticket > tickDone:
+                pending.append((ticket, future))
+            elif not future.done() and tickError != 0:
+                future.set_exception(_clockError(tickError))
+            elif not future.done():
+                future.set_result(tick)
+        self.ticks = pending
+
+    def close(self):
+        """
+        Stops the worker, waiting for a running flush or frame clock wait. The
+        futures of unfinished requests are cancelled.
+        """
+        if self.fd is None:
+            return
+
+        self.loop.remove_reader(self.fd)
+        fb.pyfb_asyncClose(self.fbnum)
+        self.fd = None
+
+        for (ticket, future) in self.flushes + self.ticks:
+            future.cancel()
+        self.flushes = []
+        self.ticks = []
+
+
+def getWorker(framebuffer):
+    """
+    Returns the worker of a framebuffer for the running event loop, and starts it
+    on the first use. A worker of another loop is stopped first.
+
+    @param framebuffer The opened Framebuffer object
+    @return The AsyncWorker object
+    """
+    loop = asyncio.get_running_loop()
+    worker = framebuffer._asyncWorker
+    if worker is not None and worker.loop is loop and worker.fd is not None:
+        return worker
+
+    if worker is not None:
+        worker.close()
+    framebuffer._asyncWorker = AsyncWorker(framebuffer.fbnum, loop)
+    return framebuffer._asyncWorker
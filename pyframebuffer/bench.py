@@ -0,0 +1,363 @@
+"""
+Scene benchmarks measuring the end-to-end frame rate through the Python API.
+
+Every scene draws complete frames through the Framebuffer methods, so the
+measured time includes the method dispatch, the color conversion, the argument
+parsing of the native functions and the flush. Run it from the command line with:
+
+@code{.sh}
+# on a virtual framebuffer of 800x480 at 32 bit
+python3 -m pyframebuffer.bench --headless 800x480x32
+
+# on /dev/fb0, as JSON
+python3 -m pyframebuffer.bench --device 0 --json
+
+# with a trace of the native calls for chrome://tracing or ui.perfetto.dev
+python3 -m pyframebuffer.bench --scene dashboard --frames 5 --trace dashboard.json
+@endcode
+"""
+
+import argparse
+import json
+import math
+import random
+import struct
+import time
+
+import pyframebuffer
+from pyframebuffer.color import rgb
+from pyframebuffer.font import Font
+from pyframebuffer import trace
+import _pyfb as fb  # type: ignore
+
+__all__ = ["Scene", "SCENES", "runScene", "runScenes", "main"]
+
+
+def _syntheticFont():
+    """
+    Builds a 8x16 PSF2 font with a distinct pattern per glyph, so the text scene
+    does not depend on the console fonts of the host.
+
+    @return The Font object
+    """
+    header = struct.pack("<IIIIIIII", 0x864AB572, 0, 32, 0, 256, 16, 16, 8)
+    glyphs = bytearray()
+    for code in range(256):
+        for row in range(16):
+            glyphs.append(0 if row in (0, 15) else ((code * 0x9E37) >> (row % 8)) & 0x7E)
+    return Font(fb.pyfb_loadFont(header + bytes(glyphs)))
+
+
+class Scene:
+    """
+    Base class of a benchmark scene. A scene prepares its data in setup() and
+    draws one complete frame per call of draw(), without flushing it.
+    """
+
+    name = "scene"
+
+    def setup(self, framebuffer):
+        """
+        Prepares the scene for a framebuffer.
+
+        @param framebuffer The opened Framebuffer object
+        """
+        (self.width, self.height) = (framebuffer.xres, framebuffer.yres)
+
+    def draw(self, framebuffer, frame):
+        """
+        Draws one frame on the offscreen buffer.
+
+        @param framebuffer The opened Framebuffer object
+        @param frame The frame number
+        """
+        raise NotImplementedError
+
+    def teardown(self):
+        """
+        Frees the resources of the scene.
+        """
+        pass
+
+
+class ClearScene(Scene):
+    """
+    Fills the whole screen with a changing color.
+    """
+
+    name = "clear"
+
+    def draw(self, framebuffer, frame):
+        framebuffer.fill(rgb(frame & 0xFF, 0x40, 0x80))
+
+
+class DashboardScene(Scene):
+    """
+    Draws 1000 shapes, lines, circles and framed boxes, like a dashboard with many
+    small widgets.
+    """
+
+    name = "dashboard"
+
+    def setup(self, framebuffer):
+        super().setup(framebuffer)
+        rnd = random.Random(1)
+        (w, h) = (self.width, self.height)
+        self.shapes = []
+        for i in range(1000):
+            kind = i % 3
+            if kind == 0:
+                shape = (rnd.randrange(w), rnd.randrange(h), rnd.randrange(w), rnd.randrange(h))
+            elif kind == 1:
+                r = rnd.randrange(2, max(3, min(w, h) // 16))
+                shape = (rnd.randrange(r, w - r), rnd.randrange(r, h - r), r)
+            else:
+                bw = rnd.randrange(4, max(5, w // 8))
+                bh = rnd.randrange(4, max(5, h // 8))
+                shape = (rnd.randrange(w - bw), rnd.randrange(h - bh), bw, bh)
+            self.shapes.append((kind, shape, rgb(rnd.randrange(256), rnd.randrange(256), rnd.randrange(256))))
+
+    def draw(self, framebuffer, frame):
+        framebuffer.fill(rgb(0, 0, 0))
+        for (kind, shape, color) in self.shapes:
+            if kind == 0:
+                framebuffer.drawLine(shape[0], shape[1], shape[2], shape[3], color)
+            elif kind == 1:
+                framebuffer.drawCircle(shape[0], shape[1], shape[2], color)
+            else:
+                (x, y, bw, bh) = shape
+                framebuffer.drawHorizontalLine(x, y, bw, color)
+                framebuffer.drawHorizontalLine(x, y + bh - 1, bw, color)
+                framebuffer.drawVerticalLine(x, y, bh, color)
+                framebuffer.drawVerticalLine(x + bw - 1, y, bh, color)
+
+
+class StatusScene(Scene):
+    """
+    Fills the screen with lines of status text with an opaque background, with
+    changing values every frame.
+    """
+
+    name = "status"
+
+    def __init__(self, font=None):
+        """
+        @param font The Font object to draw with, or None for a built-in 8x16 font
+        """
+        self.font = font
+        self.ownFont = font is None
+
+    def setup(self, framebuffer):
+        super().setup(framebuffer)
+        if self.font is None:
+            self.font = _syntheticFont()
+        (gw, gh) = self.font.getGlyphSize()
+        self.columns = max(1, self.width // gw - 1)
+        self.lines = self.height // gh
+        self.lineHeight = gh
+
+    def draw(self, framebuffer, frame):
+        fg = rgb(0xE0, 0xE0, 0xE0)
+        bg = rgb(0x10, 0x20, 0x30)
+        for line in range(self.lines):
+            state = "OK" if line % 5 else "WARN"
+            text = "sensor %03d: %8.2f  state %s  frame %d" % (line, (frame * 7 + line) * 0.37, state, frame)
+            framebuffer.drawText(0, line * self.lineHeight, text[:self.columns], fg, self.font, bg)
+
+    def teardown(self):
+        if self.ownFont and self.font is not None:
+            self.font.close()
+            self.font = None
+
+
+class PlotScene(Scene):
+    """
+    A scrolling line plot: the plot is moved left by a few pixels with copyArea and
+    only the new segment is drawn.
+    """
+
+    name = "plot"
+    step = 4
+
+    def setup(self, framebuffer):
+        super().setup(framebuffer)
+        self.last = self.height // 2
+        framebuffer.fill(rgb(0, 0, 0))
+
+    def draw(self, framebuffer, frame):
+        (w, h, step) = (self.width, self.height, self.step)
+        framebuffer.copyArea(step, 0, w - step, h, 0, 0)
+        for x in range(w - step, w):
+            framebuffer.drawVerticalLine(x, 0, h, rgb(0, 0, 0))
+        for y in range(0, h, h // 4 or 1):
+            framebuffer.drawHorizontalLine(w - step, y, step, rgb(0x30, 0x30, 0x30))
+
+        value = (h // 2) + int((h // 3) * ((frame * 37 % 200) - 100) / 100)
+        framebuffer.drawLine(w - step - 1, self.last, w - 1, value, rgb(0x40, 0xFF, 0x40))
+        self.last = value
+
+
+class ImageScene(Scene):
+    """
+    Copies a full-frame image to the screen with one writeRect() call, as a picture
+    viewer or video player would do.
+    """
+
+    name = "image"
+
+    def setup(self, framebuffer):
+        super().setup(framebuffer)
+        (w, h) = (self.width, self.height)
+        image = bytearray(w * h * 4)
+        for y in range(h):
+            for x in range(w):
+                image[(y * w + x) * 4:(y * w + x + 1) * 4] = bytes((x * 255 // w, y * 255 // h, (x ^ y) & 0xFF, 0xFF))
+        self.image = bytes(image)
+
+    def draw(self, framebuffer, frame):
+        framebuffer.writeRect(0, 0, self.width, self.height, self.image)
+
+    def teardown(self):
+        self.image = None
+
+
+class PixelScene(Scene):
+    """
+    Copies the same image as the image scene with one drawPixel() call per pixel, to
+    compare the Python call overhead with the bulk copy.
+    """
+
+    name = "pixels"
+
+    def setup(self, framebuffer):
+        super().setup(framebuffer)
+        (w, h) = (self.width, self.height)
+        self.image = [[rgb(x * 255 // w, y * 255 // h, (x ^ y) & 0xFF).getColorValue() for x in range(w)] for y in range(h)]
+
+    def draw(self, framebuffer, frame):
+        drawPixel = framebuffer.drawPixel
+        for (y, row) in enumerate(self.image):
+            for (x, color) in enumerate(row):
+                drawPixel(x, y, color)
+
+    def teardown(self):
+        self.image = None
+
+
+SCENES = [ClearScene, DashboardScene, StatusScene, PlotScene, ImageScene, PixelScene]
+
+
+def _percentile(values, percent):
+    """
+    Returns the percentile of a sorted list by the nearest rank.
+    """
+    rank = math.ceil(percent / 100.0 * len(values))
+    return values[min(len(values), max(1, rank)) - 1]
+
+
+def runScene(framebuffer, scene, frames=60, maxTime=10.0):
+    """
+    Runs a scene and measures every frame.
+
+    @param framebuffer The opened Framebuffer object
+    @param scene The Scene object
+    @param frames The amount of frames to draw
+    @param maxTime The time in seconds after which the scene is stopped early, at least 3 frames are drawn
+
+    @return A dictionary with the scene name, frames, fps, the p50 and p99 frame time and the mean draw
+            and flush time, all times in milliseconds
+    """
+    scene.setup(framebuffer)
+    drawTimes = []
+    flushTimes = []
+    start = time.perf_counter()
+    try:
+        for frame in range(frames):
+            t0 = time.perf_counter()
+            scene.draw(framebuffer, frame)
+            t1 = time.perf_counter()
+            framebuffer.update()
+            t2 = time.perf_counter()
+            drawTimes.append(t1 - t0)
+            flushTimes.append(t2 - t1)
+            if frame >= 2 and t2 - start > maxTime:
+                break
+    finally:
+        scene.teardown()
+
+    total = sorted(d + f for (d, f) in zip(drawTimes, flushTimes))
+    count = len(total)
+    return {
+        "scene": scene.name,
+        "frames": count,
+        "fps": count / sum(total),
+        "p50_ms": _percentile(total, 50) * 1000,
+        "p99_ms": _percentile(total, 99) * 1000,
+        "draw_ms": sum(drawTimes) / count * 1000,
+        "flush_ms": sum(flushTimes) / count * 1000,
+    }
+
+
+def runScenes(framebuffer, scenes=None, frames=60, maxTime=10.0):
+    """
+    Runs several scenes one after another.
+
+    @param framebuffer The opened Framebuffer object
+    @param scenes The list of Scene objects, or None for all built-in scenes
+    @param frames The amount of frames per scene
+    @param maxTime The maximum time per scene in seconds
+
+    @return The list of the result dictionaries, see runScene()
+    """
+    if scenes is None:
+        scenes = [cls() for cls in SCENES]
+    return [runScene(framebuffer, scene, frames, maxTime) for scene in scenes]
+
+
+def _openTarget(args):
+    """
+    Returns the Framebuffer object selected by the command line arguments.
+    """
+    if args.device is not None:
+        return pyframebuffer.openfb(args.device)
+    (xres, yres, depth) = (int(v) for v in args.headless.split("x"))
+    return pyframebuffer.openheadless(pyframebuffer.MAX_FRAMEBUFFERS - 1, xres, yres, depth)
+
+
+def main(argv=None):
+    """
+    Command line entry point of the scene benchmarks.
+
+    @param argv The arguments, or None for the arguments of the process
+    """
+    parser = argparse.ArgumentParser(prog="python3 -m pyframebuffer.bench", description=__doc__.splitlines()[1])
+    parser.add_argument("--device", type=int, help="benchmark on /dev/fbN instead of a virtual framebuffer")
+    parser.add_argument("--headless", default="800x480x32", help="virtual framebuffer as WIDTHxHEIGHTxDEPTH")
+    parser.add_argument("--scene", action="append", choices=[cls.name for cls in SCENES], help="scene to run, repeatable")
+    parser.add_argument("--frames", type=int, default=60, help="frames per scene")
+    parser.add_argument("--max-time", type=float, default=10.0, help="maximum seconds per scene")
+    parser.add_argument("--json", action="store_true", help="print the results as JSON")
+    parser.add_argument("--trace", help="write a Chrome trace of the native calls to this file")
+    args = parser.parse_args(argv)
+
+    scenes = [cls() for cls in SCENES if args.scene is None or cls.name in args.scene]
+    if args.trace:
+        trace.start()
+    with _openTarget(args) as framebuffer:
+        results = runScenes(framebuffer, scenes, args.frames, args.max_time)
+    if args.trace:
+        trace.stop()
+        trace.dump(args.trace)
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+        return
+
+    print("%-10s %7s %9s %9s %9s %9s %9s" % ("scene", "frames", "fps", "p50 ms", "p99 ms", "draw ms", "flush ms"))
+    for r in results:
+        print("%-10s %7d %9.1f %9.2f %9.2f %9.2f %9.2f"
+              % (r["scene"], r["frames"], r["fps"], r["p50_ms"], r["p99_ms"], r["draw_ms"], r["flush_ms"]))
+
+
+if __name__ == "__main__":
+    main()
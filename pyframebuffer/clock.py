@@ -0,0 +1,131 @@
+"""Frame clock pacing the drawing to the display"""
+
+import collections
+
+from pyframebuffer import aio
+import _pyfb as fb  # type: ignore
+
+__all__ = ["FrameClock", "Tick", "CLOCK_VSYNC", "CLOCK_TIMER"]
+CLOCK_VSYNC = fb.PYFB_CLOCK_VSYNC
+CLOCK_TIMER = fb.PYFB_CLOCK_TIMER
+
+# a frame of the clock, deadline and lateness in nanoseconds of the monotonic clock
+Tick = collections.namedtuple("Tick", ["frame", "dropped", "deadline", "lateness"])
+
+
+class FrameClock:
+    """
+    A clock waking up once per frame of an opened framebuffer. The clock waits for
+    the vertical blank of the display if the driver supports it, else it waits for
+    the deadlines of the target frame rate on a timer. A frame drawn too slow drops
+    the frames it missed instead of queuing them, so the clock never runs behind.
+
+    The usage to draw at 30 frames per second is as following:
+
+    @code{.py}
+    from pyframebuffer.clock import FrameClock
+    import pyframebuffer as fb
+
+    with fb.openfb(0) as framebuffer, FrameClock(framebuffer, 30) as clock:
+        # -- With the iterator
+        for tick in clock:
+            drawFrame(framebuffer, tick.frame)
+            framebuffer.update()
+
+        # -- With a callback, returning False stops the clock
+        clock.run(lambda tick: drawFrame(framebuffer, tick.frame), frames=300)
+
+    # -- With the async iterator in a coroutine
+    async def compositor(framebuffer, clock):
+        async for tick in clock:
+            drawFrame(framebuffer, tick.frame)
+            await framebuffer.updateAsync()
+    @endcode
+    """
+
+    def __init__(self, framebuffer, fps=60, vsync=True):
+        """
+        Opens a frame clock. The framebuffer must stay opened while the clock is used.
+
+        @param framebuffer The opened Framebuffer object
+        @param fps The target frame rate, in vsync mode the display rate is divided to
+                   the closest rate, 0 for the display rate
+        @param vsync True to wait for the vertical blank if the driver supports it, else
+                     the clock always uses a timer
+        """
+        self.framebuffer = framebuffer
+        self.clocknum = fb.pyfb_clockOpen(framebuffer.fbnum, float(fps), bool(vsync))
+        self.mode = fb.pyfb_clockMode(self.clocknum)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __iter__(self):
+        """
+        Iterates the ticks of the clock endlessly, see wait().
+        """
+        while True:
+            yield self.wait()
+
+    async def __aiter__(self):
+        """
+        Iterates the ticks of the clock endlessly in a coroutine, see waitAsync().
+        """
+        while True:
+            yield await self.waitAsync()
+
+    def wait(self):
+        """
+        Waits for the next frame. Other Python threads run while waiting.
+
+        @return The Tick of the frame, with the frame number, the amount of frames
+                dropped since the previous tick, the deadline and the lateness of the
+                wake up in nanoseconds
+        """
+        return Tick(*fb.pyfb_clockWait(self.clocknum))
+
+    async def waitAsync(self):
+        """
+        Waits for the next frame on the native worker of the framebuffer, so other
+        coroutines continue meanwhile.
+
+        @return The Tick of the frame, see wait()
+        """
+        return Tick(*await aio.getWorker(self.framebuffer).tick(self.clocknum))
+
+    def run(self, callback, frames=None):
+        """
+        Calls a function once per frame.
+
+        @param callback The function, called with the Tick, returning False stops the clock
+        @param frames The maximum amount of frames, or None to run until the callback stops it
+        """
+        count = 0
+        while frames is None or count < frames:
+            if callback(self.wait()) is False:
+                return
+            count += 1
+
+    def getStats(self):
+        """
+        Returns the statistics of the clock in a dictionary with the keys ticks,
+        missed (the ticks after a missed deadline), dropped (the dropped frames),
+        period_ns (the frame period), jitter_mean_ns, jitter_stddev_ns and
+        jitter_max_ns (the lateness of the wake ups).
+
+        @return The dictionary
+        """
+        values = fb.pyfb_clockStats(self.clocknum)
+        keys = ("ticks", "missed", "dropped", "period_ns", "jitter_mean_ns", "jitter_stddev_ns", "jitter_max_ns")
+        return dict(zip(keys, values))
+
+    def close(self):
+        """
+        Closes the clock. Closing a closed clock does nothing.
+        """
+        if self.clocknum is not None:
+            fb.pyfb_clockClose(self.clocknum)
+            self.clocknum = None
@@ -0,0 +1,62 @@
+"""Colormaps for Framebuffer.blitScalar()"""
+
+from pyframebuffer.color import getColorValue
+import _pyfb as fb  # type: ignore
+
+__all__ = ["gradient", "gray", "hot", "jet", "COLORMAP_SIZE"]
+COLORMAP_SIZE = fb.PYFB_COLORMAP_SIZE
+
+
+def gradient(*colors):
+    """
+    Returns the colormap blending linearly between colors spread evenly over the
+    value range, from the color of vmin to the color of vmax.
+
+    @param colors The color values or Color objects, at least 2
+    @return The colormap as tuple of COLORMAP_SIZE color values
+    """
+    if len(colors) < 2:
+        raise ValueError("A gradient needs at least 2 colors")
+
+    stops = [getColorValue(color) for color in colors]
+    segments = len(stops) - 1
+    result = []
+    for i in range(COLORMAP_SIZE):
+        pos = i * segments / (COLORMAP_SIZE - 1)
+        n = min(int(pos), segments - 1)
+        t = pos - n
+        value = 0
+        for shift in (24, 16, 8, 0):
+            a = (stops[n] >> shift) & 0xFF
+            b = (stops[n + 1] >> shift) & 0xFF
+            value |= int(a + (b - a) * t + 0.5) << shift
+        result.append(value)
+    return tuple(result)
+
+
+def gray():
+    """
+    Returns the colormap from black to white.
+
+    @return The colormap
+    """
+    return gradient(0x000000FF, 0xFFFFFFFF)
+
+
+def hot():
+    """
+    Returns the colormap from black over red and yellow to white, e.g. for heatmaps.
+
+    @return The colormap
+    """
+    return gradient(0x000000FF, 0xFF0000FF, 0xFFFF00FF, 0xFFFFFFFF)
+
+
+def jet():
+    """
+    Returns the colormap from dark blue over cyan, yellow and red to dark red, e.g. for
+    spectrograms.
+
+    @return The colormap
+    """
+    return gradient(0x000080FF, 0x0000FFFF, 0x00FFFFFF, 0xFFFF00FF, 0xFF0000FF, 0x800000FF)
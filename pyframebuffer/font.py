@@ -0,0 +1,96 @@
+"""Bitmap font utilities"""
+
+import gzip
+import _pyfb as fb  # type: ignore
+
+__all__ = ["Font", "loadFont", "MAX_FONTS"]
+MAX_FONTS = fb.MAX_FONTS
+
+
+class Font:
+    """
+    Class for a loaded bitmap font. Use the loadFont() function to
+    build an instance of this class.
+
+    The usage to draw a text is as following:
+
+    @code{.py}
+    from pyframebuffer.color import rgb
+    from pyframebuffer.font import loadFont
+    import pyframebuffer as fb
+
+    font = loadFont("/usr/share/consolefonts/Lat15-Terminus16.psf.gz")
+
+    with fb.openfb(0) as framebuffer:
+        framebuffer.drawText(10, 10, "Hello World", rgb(255, 255, 255), font)
+        framebuffer.update()
+    @endcode
+    """
+
+    def __init__(self, fontnum):
+        """
+        Initializes the font object from the native font number.
+
+        @param fontnum The native font number
+        """
+        self.fontnum = fontnum
+        (width, height, glyphs) = fb.pyfb_fontInfo(fontnum)
+        self.width = width
+        self.height = height
+        self.glyphs = glyphs
+
+    def __del__(self):
+        """
+        Frees the native font if it is still loaded.
+        """
+        try:
+            self.close()
+        except:
+            pass
+
+    def close(self):
+        """
+        Frees the native font. The font can not be used for drawing
+        after calling this method.
+        """
+        if self.fontnum is not None:
+            fontnum = self.fontnum
+            self.fontnum = None
+            fb.pyfb_freeFont(fontnum)
+
+    def getGlyphSize(self):
+        """
+        Returns the size of one glyph in a tuple of structure (width, height).
+
+        @return The tuple with the glyph size in pixel
+        """
+        return (self.width, self.height)
+
+    def measureText(self, text):
+        """
+        Measures the size a text takes on the screen. Lines are separated
+        by a newline character.
+
+        @param text The text to measure
+
+        @return The tuple with the text size of structure (width, height)
+        """
+        return fb.pyfb_measureText(self.fontnum, text)
+
+
+def loadFont(path):
+    """
+    Loads a PSF1 or PSF2 console font, like the ones in /usr/share/consolefonts.
+    Gzip compressed fonts (*.psf.gz) are decompressed automaticly.
+
+    @param path The path to the font file
+
+    @return The Font object
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:2] == b"\x1f\x8b":
+        data = gzip.decompress(data)
+
+    return Font(fb.pyfb_loadFont(data))
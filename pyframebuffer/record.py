@@ -0,0 +1,125 @@
+"""
+Recording of the native draw calls and their deterministic replay.
+
+A recording contains every draw, text, canvas and flush call of the module with
+its arguments and timing. Replaying it on virtual framebuffers reproduces the
+workload of a real screen without the device, as benchmark or to bisect a
+performance regression:
+
+@code{.sh}
+# replay as fast as possible
+python3 -m pyframebuffer.record frames.pfbr
+
+# replay with the recorded pacing, three times, as JSON
+python3 -m pyframebuffer.record frames.pfbr --paced --repeat 3 --json
+@endcode
+"""
+
+import argparse
+import json
+
+import _pyfb as fb  # type: ignore
+
+__all__ = ["start", "stop", "replay", "main"]
+
+
+def start(target):
+    """
+    Starts recording the draw calls of all framebuffers. The framebuffers which
+    are already opened are recorded as opened at the start. Load the fonts and
+    sprites after the start, else the calls drawing them are skipped in the replay.
+
+    The usage to record a session is as following:
+
+    @code{.py}
+    from pyframebuffer import record
+
+    record.start("session.pfbr")
+    runApplication()
+    record.stop()
+    @endcode
+
+    @param target A file path or a binary file object to write the recording to
+    """
+    if isinstance(target, str):
+        file = open(target, "wb")
+        try:
+            fb.pyfb_recordStart(file.fileno())
+        finally:
+            # the recorder writes to its own duplicate of the file descriptor
+            file.close()
+        return
+
+    target.flush()
+    fb.pyfb_recordStart(target.fileno())
+
+
+def stop():
+    """
+    Stops the recording and writes the remaining buffered calls.
+    """
+    fb.pyfb_recordStop()
+
+
+def replay(source, paced=False):
+    """
+    Replays a recording on virtual framebuffers of the recorded resolutions. The
+    framebuffer numbers of the recording must not be opened with another resolution.
+
+    @param source A file path or a binary file object to read the recording from
+    @param paced True to wait for the recorded start time of every call, False to
+                 replay as fast as possible
+
+    @return A dictionary with the keys calls, flushes, errors (calls which failed
+            in the replay), skipped (calls which could not be replayed),
+            recordedSeconds (the duration of the recording), busySeconds (the time
+            spent in the recorded calls) and replaySeconds (the duration of the
+            replay)
+    """
+    if isinstance(source, str):
+        with open(source, "rb") as file:
+            return replay(file, paced)
+
+    (calls, flushes, errors, skipped, recordedNs, busyNs, replayNs) = fb.pyfb_replay(source.fileno(), paced)
+    return {
+        "calls": calls,
+        "flushes": flushes,
+        "errors": errors,
+        "skipped": skipped,
+        "recordedSeconds": recordedNs / 1e9,
+        "busySeconds": busyNs / 1e9,
+        "replaySeconds": replayNs / 1e9,
+    }
+
+
+def main(argv=None):
+    """
+    Command line entry point of the replay tool.
+
+    @param argv The arguments, or None for the arguments of the process
+    """
+    parser = argparse.ArgumentParser(prog="python3 -m pyframebuffer.record",
+                                     description="Replays a draw call recording on virtual framebuffers.")
+    parser.add_argument("recording", help="the recording file")
+    parser.add_argument("--paced", action="store_true", help="keep the recorded pacing")
+    parser.add_argument("--repeat", type=int, default=1, help="replay the recording several times")
+    parser.add_argument("--json", action="store_true", help="print the results as JSON")
+    args = parser.parse_args(argv)
+
+    results = [replay(args.recording, args.paced) for _ in range(args.repeat)]
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+        return
+
+    print("%8s %8s %7s %8s %12s %10s %12s %9s"
+          % ("calls", "flushes", "errors", "skipped", "recorded s", "busy s", "replay s", "fps"))
+    for r in results:
+        fps = r["flushes"] / r["replaySeconds"] if r["replaySeconds"] > 0 else 0.0
+        print("%8d %8d %7d %8d %12.3f %10.3f %12.3f %9.1f"
+              % (r["calls"], r["flushes"], r["errors"], r["skipped"], r["recordedSeconds"], r["busySeconds"],
+                 r["replaySeconds"], fps))
+
+
+if __name__ == "__main__":
+    main()
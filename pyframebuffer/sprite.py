@@ -0,0 +1,95 @@
+"""Run length encoded sprites"""
+
+from pyframebuffer.color import getColorValue
+import _pyfb as fb  # type: ignore
+
+__all__ = ["Sprite", "loadSprite", "MAX_SPRITES"]
+MAX_SPRITES = fb.MAX_SPRITES
+
+
+class Sprite:
+    """
+    Class for a loaded sprite, like an icon or a cursor. The transparent pixels are
+    dropped at load time, every row keeps only its runs of opaque pixels, so drawing
+    copies the runs and skips the gaps. Use the loadSprite() function to build an
+    instance of this class.
+
+    The usage to draw an icon is as following:
+
+    @code{.py}
+    from pyframebuffer.color import rgb
+    from pyframebuffer.sprite import loadSprite
+    import pyframebuffer as fb
+
+    # 4 bytes per pixel in the order red, green, blue and alpha
+    icon = loadSprite(32, 32, iconPixels)
+    cursor = loadSprite(16, 16, cursorPixels, colorKey=rgb(255, 0, 255))
+
+    with fb.openfb(0) as framebuffer:
+        framebuffer.drawSprite(10, 10, icon)
+        framebuffer.drawSprite(mouseX, mouseY, cursor)
+        framebuffer.update()
+    @endcode
+    """
+
+    def __init__(self, spritenum):
+        """
+        Initializes the sprite object from the native sprite number.
+
+        @param spritenum The native sprite number
+        """
+        self.spritenum = spritenum
+        (width, height, runs, opaque) = fb.pyfb_spriteInfo(spritenum)
+        self.width = width
+        self.height = height
+        self.runs = runs
+        self.opaque = opaque
+
+    def __del__(self):
+        """
+        Frees the native sprite if it is still loaded.
+        """
+        try:
+            self.close()
+        except:
+            pass
+
+    def close(self):
+        """
+        Frees the native sprite. The sprite can not be used for drawing
+        after calling this method.
+        """
+        if self.spritenum is not None:
+            spritenum = self.spritenum
+            self.spritenum = None
+            fb.pyfb_freeSprite(spritenum)
+
+    def getSize(self):
+        """
+        Returns the size of the sprite in a tuple of structure (width, height).
+
+        @return The tuple with the sprite size in pixel
+        """
+        return (self.width, self.height)
+
+
+def loadSprite(width, height, pixels, colorKey=None, alphaThreshold=128):
+    """
+    Loads a sprite from pixels, e.g. read with Framebuffer.readRect() from a
+    headless framebuffer. A pixel is transparent if its color equals the color
+    key, ignoring the alpha, or without a color key if its alpha is below the
+    threshold.
+
+    @param width The width of the sprite, at most 65535
+    @param height The height of the sprite, at most 65535
+    @param pixels A buffer (e.g. bytes) of at least width * height * 4 bytes, 4 bytes
+                  per pixel in the order red, green, blue and alpha, row by row
+    @param colorKey The color value or Color object of the transparent pixels, or None
+                    to use the alpha threshold
+    @param alphaThreshold The alpha from which on a pixel is opaque, 0 to 255
+
+    @return The Sprite object
+    """
+    if colorKey is not None:
+        colorKey = getColorValue(colorKey)
+    return Sprite(fb.pyfb_loadSprite(pixels, width, height, colorKey, alphaThreshold))
@@ -0,0 +1,210 @@
+"""Frame stream utilities"""
+
+import struct
+import array
+import _pyfb as fb  # type: ignore
+
+__all__ = ["StreamReader", "STREAM_RAW", "STREAM_RLE", "STREAM_QOI", "STREAM_TILE"]
+STREAM_RAW = fb.PYFB_STREAM_RAW
+STREAM_RLE = fb.PYFB_STREAM_RLE
+STREAM_QOI = fb.PYFB_STREAM_QOI
+STREAM_TILE = fb.PYFB_STREAM_TILE
+
+_FRAME_HEADER = struct.Struct("<4sIHHHBBI")
+_TILE_HEADER = struct.Struct("<HHHHBI")
+
+
+def _convertRaw(raw, depth):
+    """
+    Converts pixels in the offscreen buffer format of a little endian host to RGBA8888.
+
+    @param raw The pixel bytes
+    @param depth The pixel depth, 16 or 32
+
+    @return The bytearray with the RGBA8888 pixels
+    """
+    if depth == 32:
+        rgba = bytearray(len(raw))
+        rgba[0::4] = raw[3::4]
+        rgba[1::4] = raw[2::4]
+        rgba[2::4] = raw[1::4]
+        rgba[3::4] = raw[0::4]
+        return rgba
+
+    pixels = array.array("H")
+    pixels.frombytes(bytes(raw))
+    rgba = bytearray(len(pixels) * 4)
+    for i, px in enumerate(pixels):
+        r = (px >> 11) & 0x1F
+        g = (px >> 5) & 0x3F
+        b = px & 0x1F
+        rgba[i * 4:i * 4 + 4] = bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255))
+    return rgba
+
+
+def _decodeRLE(payload, depth):
+    """
+    Expands a run length encoded tile to the pixel bytes.
+
+    @param payload The encoded tile
+    @param depth The pixel depth, 16 or 32
+
+    @return The pixel bytes
+    """
+    step = depth // 8 + 1
+    raw = bytearray()
+    for i in range(0, len(payload), step):
+        raw += payload[i + 1:i + step] * (payload[i] + 1)
+    return raw
+
+
+def _decodeQOI(payload, count):
+    """
+    Decodes a tile encoded with the chunks of the QOI image format.
+
+    @param payload The encoded tile
+    @param count The amount of pixels
+
+    @return The bytearray with the RGBA8888 pixels
+    """
+    index = [bytes(4)] * 64
+    px = bytes((0, 0, 0, 255))
+    rgba = bytearray()
+    i = 0
+    while len(rgba) < count * 4:
+        (px, run, i) = _decodeQOIChunk(payload, i, px, index)
+        index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px
+        rgba += px * run
+    return rgba
+
+
+def _decodeQOIChunk(payload, i, px, index):
+    """
+    Decodes one QOI chunk.
+
+    @return A tuple of (pixel, run length, position of the next chunk)
+    """
+    op = payload[i]
+    if op == 0xFE:
+        return (bytes(payload[i + 1:i + 4]) + px[3:4], 1, i + 4)
+    if op == 0xFF:
+        return (bytes(payload[i + 1:i + 5]), 1, i + 5)
+
+    tag = op & 0xC0
+    if tag == 0x00:
+        return (index[op], 1, i + 1)
+    if tag == 0xC0:
+        return (px, (op & 0x3F) + 1, i + 1)
+    if tag == 0x40:
+        diff = ((op >> 4 & 3) - 2, (op >> 2 & 3) - 2, (op & 3) - 2)
+        return (bytes(((px[c] + diff[c]) & 0xFF for c in range(3))) + px[3:4], 1, i + 1)
+
+    dg = (op & 0x3F) - 32
+    dr = (payload[i + 1] >> 4) - 8 + dg
+    db = (payload[i + 1] & 0x0F) - 8 + dg
+    return (bytes(((px[0] + dr) & 0xFF, (px[1] + dg) & 0xFF, (px[2] + db) & 0xFF, px[3])), 1, i + 2)
+
+
+class StreamReader:
+    """
+    Consumer of a frame stream started with Framebuffer.startStream(). The reader
+    applies the changed tiles of every frame to an RGBA8888 copy of the screen.
+
+    The usage to view a stream is as following:
+
+    @code{.py}
+    import socket
+    from pyframebuffer.stream import StreamReader
+
+    # the other side called framebuffer.startStream(sock)
+    reader = StreamReader(sock)
+    while reader.readFrame() is not None:
+        show(reader.width, reader.height, reader.frame)
+    @endcode
+    """
+
+    def __init__(self, source):
+        """
+        Initializes the reader.
+
+        @param source A socket or a binary file object to read the stream from
+        """
+        self.source = source
+        self.width = 0
+        self.height = 0
+        self.depth = 0
+        self.frame = bytearray()
+
+    def _read(self, length):
+        """
+        Reads exactly length bytes, or returns None at the end of the stream.
+        """
+        data = bytearray()
+        while len(data) < length:
+            if hasattr(self.source, "recv"):
+                chunk = self.source.recv(length - len(data))
+            else:
+                chunk = self.source.read(length - len(data))
+            if not chunk:
+                return None
+            data += chunk
+        return data
+
+    def readFrame(self):
+        """
+        Reads the next frame and applies its tiles to the frame attribute.
+
+        @return A tuple of (frame number, key frame, list of the changed (x, y, width, height)
+                areas), or None at the end of the stream
+        """
+        header = self._read(_FRAME_HEADER.size)
+        if header is None:
+            return None
+
+        (magic, number, width, height, _, depth, flags, count) = _FRAME_HEADER.unpack(header)
+        if magic != b"PFBS":
+            raise ValueError("The stream is not a pyframebuffer frame stream")
+
+        if (width, height) != (self.width, self.height):
+            self.width = width
+            self.height = height
+            self.frame = bytearray(width * height * 4)
+        self.depth = depth
+
+        areas = []
+        for _ in range(count):
+            tile = self._readTile()
+            if tile is None:
+                return None
+            areas.append(tile)
+
+        return (number, bool(flags & 1), areas)
+
+    def _readTile(self):
+        """
+        Reads one tile and copies its pixels into the frame.
+
+        @return The tuple of (x, y, width, height) of the tile, or None at the end of the stream
+        """
+        header = self._read(_TILE_HEADER.size)
+        if header is None:
+            return None
+
+        (x, y, width, height, encoding, length) = _TILE_HEADER.unpack(header)
+        payload = self._read(length)
+        if payload is None:
+            return None
+
+        if encoding == STREAM_QOI:
+            rgba = _decodeQOI(payload, width * height)
+        elif encoding == STREAM_RLE:
+            rgba = _convertRaw(_decodeRLE(payload, self.depth), self.depth)
+        else:
+            rgba = _convertRaw(payload, self.depth)
+
+        row = width * 4
+        for i in range(height):
+            offset = ((y + i) * self.width + x) * 4
+            self.frame[offset:offset + row] = rgba[i * row:(i + 1) * row]
+
+        return (x, y, width, height)
@@ -0,0 +1,49 @@
+"""Frame timeline tracing"""
+
+import _pyfb as fb  # type: ignore
+
+__all__ = ["start", "stop", "dump"]
+
+
+def start():
+    """
+    Starts recording trace events of the drawing and flush calls of all
+    framebuffers, including the time spent waiting for a framebuffer lock. The
+    events of a previous recording are discarded.
+
+    The usage to trace a few frames is as following:
+
+    @code{.py}
+    from pyframebuffer import trace
+
+    trace.start()
+    drawFrames()
+    trace.stop()
+    trace.dump("frames.json")  # open in chrome://tracing or ui.perfetto.dev
+    @endcode
+    """
+    fb.pyfb_traceStart()
+
+
+def stop():
+    """
+    Stops recording trace events. The recorded events are kept for dump().
+    """
+    fb.pyfb_traceStop()
+
+
+def dump(target):
+    """
+    Writes the recorded events in the Chrome trace event format. Every thread
+    keeps its latest events, older events are overwritten.
+
+    @param target A file path or a binary file object to write to
+
+    @return The amount of written events
+    """
+    if isinstance(target, str):
+        with open(target, "wb") as file:
+            return fb.pyfb_traceDump(file.fileno())
+
+    target.flush()
+    return fb.pyfb_traceDump(target.fileno())
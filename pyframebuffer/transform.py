@@ -0,0 +1,66 @@
+"""Affine matrices for Framebuffer.blitTransformed()"""
+
+import math
+
+__all__ = ["identity", "translate", "scale", "rotate", "multiply"]
+
+
+def identity():
+    """
+    Returns the matrix keeping every point.
+
+    @return The matrix as tuple (a, b, c, d, e, f)
+    """
+    return (1.0, 0.0, 0.0, 0.0, 1.0, 0.0)
+
+
+def translate(x, y):
+    """
+    Returns the matrix moving every point.
+
+    @param x The distance in X direction
+    @param y The distance in Y direction
+    @return The matrix
+    """
+    return (1.0, 0.0, float(x), 0.0, 1.0, float(y))
+
+
+def scale(x, y=None):
+    """
+    Returns the matrix scaling every point from the origin.
+
+    @param x The factor in X direction
+    @param y The factor in Y direction, or None for the X factor
+    @return The matrix
+    """
+    y = x if y is None else y
+    return (float(x), 0.0, 0.0, 0.0, float(y), 0.0)
+
+
+def rotate(degrees):
+    """
+    Returns the matrix rotating every point clockwise around the origin, as the Y axis
+    of the screen points down.
+
+    @param degrees The angle in degrees
+    @return The matrix
+    """
+    rad = math.radians(degrees)
+    (cos, sin) = (math.cos(rad), math.sin(rad))
+    return (cos, -sin, 0.0, sin, cos, 0.0)
+
+
+def multiply(*matrices):
+    """
+    Returns the matrix applying the given matrices from the last to the first, like
+    the product of the matrices.
+
+    @param matrices The matrices
+    @return The matrix
+    """
+    result = identity()
+    for (a, b, c, d, e, f) in matrices:
+        (ra, rb, rc, rd, re, rf) = result
+        result = (ra * a + rb * d, ra * b + rb * e, ra * c + rb * f + rc,
+                  rd * a + re * d, rd * b + re * e, rd * c + re * f + rf)
+    return result
@@ -1,7 +1,8 @@
 #!/usr/bin/env python3
-from setuptools import setup, Extension
+from setuptools import setup, Extension, Command
 import platform
 import pathlib
+import sysconfig
 
 
 def check_platform():
@@ -18,6 +19,44 @@ src = []
 for i in source_paths:
     src.append(str(i))
 
+
+class BuildBench(Command):
+    """
+    Builds the native benchmark harness build/pyfb_bench. The harness links the native
+    sources directly, and embeds Python only for the error reporting of the sources.
+    """
+    description = "build the native benchmark harness build/pyfb_bench"
+    user_options = []
+
+    def initialize_options(self):
+        pass
+
+    def finalize_options(self):
+        pass
+
+    def run(self):
+        from distutils.ccompiler import new_compiler
+        from distutils.sysconfig import customize_compiler
+
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        compiler.add_include_dir(sysconfig.get_paths()["include"])
+        compiler.add_include_dir("native")
+
+        objects = compiler.compile(src + ["bench/pyfb_bench.c"], output_dir="build/bench")
+
+        libdirs = [sysconfig.get_config_var("LIBDIR"), sysconfig.get_config_var("LIBPL")]
+        pylib = "python" + sysconfig.get_config_var("VERSION") + (sysconfig.get_config_var("ABIFLAGS") or "")
+        syslibs = ((sysconfig.get_config_var("LIBS") or "") + " " + (sysconfig.get_config_var("SYSLIBS") or "")).split()
+
+        compiler.link_executable(objects,
+                                 "pyfb_bench",
+                                 output_dir="build",
+                                 libraries=[pylib, "m", "rt"],
+                                 library_dirs=libdirs,
+                                 runtime_library_dirs=[sysconfig.get_config_var("LIBDIR")],
+                                 extra_postargs=syslibs)
+
 setup(name="pyframebuffer",
       version="0.0.1",
       author="Adrian Roß",
@@ -30,4 +69,5 @@ setup(name="pyframebuffer",
       maintainer_email="adrian.ross@ross-agentur.de",
       url="https://github.com/RossAdrian/pyframebuffer",
       packages=["pyframebuffer"],
-      ext_modules=[Extension("_pyfb", src)])
+      ext_modules=[Extension("_pyfb", src, libraries=["m", "rt"])],
+      cmdclass={"build_bench": BuildBench})
@@ -0,0 +1,77 @@
+"""
+Helpers shared by the tests.
+"""
+from pyframebuffer import record
+import pyframebuffer as pfb
+
+import gzip
+import struct
+import tempfile
+
+
+def recordAndReplay(fbnum, xres, yres, draw, depth=32):
+    """
+    Records the calls of a draw function on a headless framebuffer, and replays them
+    into a cleared headless framebuffer of the same number, which stays opened for the
+    replay to draw into it.
+
+    @param fbnum The framebuffer number
+    @param xres The X resolution
+    @param yres The Y resolution
+    @param draw The function drawing to the Framebuffer object it is called with
+    @param depth The color depth
+
+    @return A tuple of (the capture of the recorded frame, the capture of the replayed frame,
+            the result dictionary of the replay)
+    """
+    with tempfile.TemporaryFile() as recording:
+        record.start(recording)
+        try:
+            with pfb.openheadless(fbnum, xres, yres, depth) as fb:
+                draw(fb)
+                fb.update()
+                recorded = fb.capture()
+        finally:
+            record.stop()
+
+        recording.seek(0)
+        with pfb.openheadless(fbnum, xres, yres, depth) as fb:
+            result = record.replay(recording)
+            replayed = fb.capture()
+
+    return (recorded, replayed, result)
+
+
+def writePSF2(path, width, height, unicode=True):
+    """
+    Writes a PSF2 font of 256 empty glyphs, except "A" as a full box and "B" as a
+    single pixel in the upper left corner, which is also mapped to the euro sign.
+
+    @param path The path, gzip compressed if it ends with .gz
+    @param width The glyph width
+    @param height The glyph height
+    @param unicode True to add a unicode table
+    """
+    rowBytes = (width + 7) // 8
+    glyphs = bytearray(256 * rowBytes * height)
+    glyphs[65 * rowBytes * height:66 * rowBytes * height] = b"\xff" * rowBytes * height
+    glyphs[66 * rowBytes * height] = 0x80
+    header = struct.pack("<IIIIIIII", 0x864AB572, 0, 32, 1 if unicode else 0, 256, rowBytes * height, height, width)
+    table = b""
+    if unicode:
+        table = b"".join((chr(g) + ("€" if g == 66 else "")).encode() + b"\xff" for g in range(256))
+    data = header + bytes(glyphs) + table
+    with open(path, "wb") as f:
+        f.write(gzip.compress(data) if path.endswith(".gz") else data)
+
+
+def writePSF1(path):
+    """
+    Writes a PSF1 font of 256 glyphs of 8x16 pixels, "A" as a full box.
+
+    @param path The path
+    """
+    glyphs = bytearray(256 * 16)
+    glyphs[65 * 16:66 * 16] = b"\xff" * 16
+    with open(path, "wb") as f:
+        f.write(bytes([0x36, 0x04, 0, 16]) + bytes(glyphs))
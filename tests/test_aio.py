@@ -0,0 +1,100 @@
+"""
+Tests of the asyncio integration of the flushes and frame clocks.
+"""
+from pyframebuffer.clock import FrameClock
+import pyframebuffer as pfb
+
+import asyncio
+import unittest
+
+FBNUM = 12
+XRES = 64
+YRES = 32
+RED = 0xFF0000FF
+
+
+class AsyncTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def testUpdateAsync(self):
+        async def main():
+            self.fb.fill(RED)
+            await self.fb.updateAsync()
+            return self.fb.capture(device=True)
+
+        self.assertEqual(asyncio.run(main()), bytes([0xFF, 0, 0, 0xFF]) * XRES * YRES)
+
+    def testMergedUpdates(self):
+        async def main(fb):
+            fb.setStats()
+            await asyncio.gather(*[fb.updateAsync() for _ in range(10)])
+            return fb.getStats()["flushes"]
+
+        # a large screen, so the updates are requested while the first flush runs
+        self.fb.__exit__(None, None, None)
+        with pfb.openheadless(FBNUM, 1920, 1080) as fb:
+            flushes = asyncio.run(main(fb))
+        self.assertGreaterEqual(flushes, 1)
+        self.assertLess(flushes, 10)
+
+    def testClock(self):
+        async def main(clock):
+            ticks = []
+            async for tick in clock:
+                ticks.append(tick)
+                if len(ticks) == 3:
+                    break
+            return ticks
+
+        with FrameClock(self.fb, 100) as clock:
+            ticks = asyncio.run(main(clock))
+        self.assertEqual(len(ticks), 3)
+        for (previous, tick) in zip(ticks, ticks[1:]):
+            self.assertEqual(tick.frame, previous.frame + 1 + tick.dropped)
+
+    def testConcurrent(self):
+        async def other(done):
+            count = 0
+            while not done.is_set():
+                await asyncio.sleep(0)
+                count += 1
+            return count
+
+        async def main(clock):
+            done = asyncio.Event()
+            task = asyncio.ensure_future(other(done))
+            for _ in range(3):
+                await clock.waitAsync()
+                await self.fb.updateAsync()
+            done.set()
+            return await task
+
+        # the other coroutine runs while waiting for the clock and the flushes
+        with FrameClock(self.fb, 100) as clock:
+            self.assertGreater(asyncio.run(main(clock)), 3)
+
+    def testClosedClock(self):
+        async def main(clock):
+            await clock.waitAsync()
+
+        clock = FrameClock(self.fb, 100)
+        clocknum = clock.clocknum
+        clock.close()
+        clock.clocknum = clocknum
+        with self.assertRaises(OSError):
+            asyncio.run(main(clock))
+        clock.clocknum = None
+
+    def testLoops(self):
+        # a new event loop starts a new worker
+        for _ in range(2):
+            self.fb.drawPixel(0, 0, RED)
+            asyncio.run(self.fb.updateAsync())
+        self.assertEqual(self.fb.capture(device=True)[:4], bytes([0xFF, 0, 0, 0xFF]))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,76 @@
+"""
+Tests of the native benchmark harness and the scene benchmark suite.
+"""
+from pyframebuffer import bench
+import pyframebuffer as pfb
+
+import contextlib
+import io
+import json
+import os
+import subprocess
+import sys
+import unittest
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HARNESS = os.path.join(ROOT, "build", "pyfb_bench")
+FBNUM = 7
+
+
+class NativeBenchTest(unittest.TestCase):
+    """
+    Builds the harness with "setup.py build_bench", which only compiles the changed sources.
+    """
+
+    @classmethod
+    def setUpClass(cls):
+        if not os.path.exists(os.path.join(ROOT, "setup.py")):
+            raise unittest.SkipTest("the sources are not available")
+        result = subprocess.run([sys.executable, "setup.py", "build_bench"], cwd=ROOT, capture_output=True)
+        if result.returncode != 0:
+            raise unittest.SkipTest("the harness can not be built")
+
+    def testCases(self):
+        output = subprocess.run([HARNESS, "--json", "--time", "0.001", "--resolution", "256x128", "--depth", "16", "--depth",
+                                 "32"], capture_output=True, check=True).stdout
+        results = json.loads(output)
+        cases = {result["case"] for result in results}
+        self.assertTrue({"pixels", "lines", "text", "copyArea", "flush", "triangles", "gradient"} <= cases)
+        for depth in (16, 32):
+            self.assertEqual({result["case"] for result in results if result["depth"] == depth}, cases)
+        for result in results:
+            self.assertEqual((result["width"], result["height"]), (256, 128))
+            self.assertGreater(result["ops"], 0)
+            self.assertGreater(result["ops_per_s"], 0)
+        flush = [result for result in results if result["case"] == "flush"]
+        self.assertTrue(all(result["bytes_per_s"] > 0 for result in flush))
+
+    def testUsage(self):
+        result = subprocess.run([HARNESS, "--resolution", "8x8"], capture_output=True)
+        self.assertEqual(result.returncode, 2)
+        self.assertIn(b"Usage", result.stderr)
+
+
+class SceneBenchTest(unittest.TestCase):
+
+    def testScenes(self):
+        with pfb.openheadless(FBNUM, 320, 240) as fb:
+            for scene in bench.SCENES:
+                with self.subTest(scene=scene.name):
+                    result = bench.runScene(fb, scene(), frames=3)
+                    self.assertEqual(result["scene"], scene.name)
+                    self.assertEqual(result["frames"], 3)
+                    self.assertGreater(result["fps"], 0)
+                    self.assertLessEqual(result["p50_ms"], result["p99_ms"])
+
+    def testMain(self):
+        output = io.StringIO()
+        with contextlib.redirect_stdout(output):
+            bench.main(["--headless", "320x240x16", "--frames", "2", "--json"])
+        results = json.loads(output.getvalue())
+        self.assertEqual([result["scene"] for result in results], [scene.name for scene in bench.SCENES])
+        self.assertTrue(all(result["frames"] == 2 for result in results))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,70 @@
+"""
+Tests of the frame clock on a headless framebuffer, which paces on a timer.
+"""
+from pyframebuffer.clock import CLOCK_TIMER, FrameClock
+import pyframebuffer as pfb
+
+import time
+import unittest
+
+FBNUM = 11
+FPS = 100
+PERIOD_NS = 10000000
+
+
+class ClockTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, 16, 16).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        self.clock = FrameClock(self.fb, FPS)
+        self.addCleanup(self.clock.close)
+
+    def testTicks(self):
+        self.assertEqual(self.clock.mode, CLOCK_TIMER)
+        ticks = [self.clock.wait() for _ in range(5)]
+        for (previous, tick) in zip(ticks, ticks[1:]):
+            self.assertEqual(tick.frame, previous.frame + 1 + tick.dropped)
+            self.assertEqual(tick.deadline - previous.deadline, (tick.frame - previous.frame) * PERIOD_NS)
+            self.assertGreaterEqual(tick.lateness, 0)
+        self.assertEqual(self.clock.getStats()["period_ns"], PERIOD_NS)
+
+    def testDropped(self):
+        first = self.clock.wait()
+        # a frame drawn too slow drops the missed frames instead of queuing them
+        time.sleep(5.5 * PERIOD_NS / 1e9)
+        tick = self.clock.wait()
+        self.assertGreaterEqual(tick.dropped, 4)
+        self.assertEqual(tick.frame, first.frame + 1 + tick.dropped)
+        # the next tick is on time again
+        self.assertLess(self.clock.wait().lateness, PERIOD_NS)
+        stats = self.clock.getStats()
+        self.assertEqual(stats["ticks"], 3)
+        self.assertGreaterEqual(stats["missed"], 1)
+        self.assertGreaterEqual(stats["dropped"], tick.dropped)
+
+    def testPacing(self):
+        self.clock.wait()
+        start = time.monotonic()
+        for _ in range(10):
+            self.clock.wait()
+        self.assertGreaterEqual(time.monotonic() - start, 9 * PERIOD_NS / 1e9)
+
+    def testRun(self):
+        frames = []
+        self.clock.run(frames.append, frames=3)
+        self.assertEqual(len(frames), 3)
+        # returning False stops the clock
+        self.clock.run(lambda tick: frames.append(tick) or len(frames) < 5)
+        self.assertEqual(len(frames), 5)
+
+    def testClosed(self):
+        clocknum = self.clock.clocknum
+        self.clock.close()
+        self.clock.close()
+        with self.assertRaises(OSError):
+            pfb.fb.pyfb_clockWait(clocknum)
+
+
+if __name__ == "__main__":
+    unittest.main()
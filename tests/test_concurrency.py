@@ -0,0 +1,159 @@
+"""
+Tests of the framebuffers used by several threads and interpreters at once.
+"""
+import _pyfb as native  # type: ignore
+import pyframebuffer as pfb
+
+import os
+import sys
+import threading
+import unittest
+
+try:
+    import _interpreters as interpreters  # type: ignore
+except ImportError:
+    try:
+        import _xxsubinterpreters as interpreters  # type: ignore
+    except ImportError:
+        interpreters = None
+
+FBNUM = 13
+XRES = 64
+YRES = 48
+THREADS = 4
+
+
+def createInterpreter():
+    """
+    Creates a subinterpreter, with its own GIL where the Python version supports it.
+    """
+    if sys.version_info >= (3, 12) and not hasattr(interpreters, "exec"):
+        return interpreters.create(isolated=True)
+    return interpreters.create()
+
+
+def runInterpreter(interp, code):
+    """
+    Runs code in a subinterpreter and raises a RuntimeError if it failed.
+    """
+    if hasattr(interpreters, "exec"):
+        error = interpreters.exec(interp, code)
+        if error is not None:
+            raise RuntimeError(str(error))
+        return
+    interpreters.run_string(interp, code)
+
+
+class ThreadTest(unittest.TestCase):
+
+    def runThreads(self, target):
+        errors = []
+
+        def run(index):
+            try:
+                target(index)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(THREADS)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(errors, [])
+
+    def testOpenClose(self):
+        def run(index):
+            for i in range(200):
+                with pfb.openheadless(FBNUM + index % 2, XRES, YRES) as fb:
+                    fb.drawPixel(index, i % YRES, 0xFF0000FF)
+                    fb.update()
+
+        self.runThreads(run)
+        # every reference has been released, so the numbers are free for another size
+        for fbnum in (FBNUM, FBNUM + 1):
+            with pfb.openheadless(fbnum, XRES + 1, YRES):
+                pass
+
+    def testDrawFlush(self):
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+            def run(index):
+                color = (0x10 * (index + 1)) << 24 | 0xFF
+                for i in range(100):
+                    # every thread owns a band of rows
+                    fb.drawHorizontalLine(0, index * (YRES // THREADS) + i % (YRES // THREADS), XRES, color)
+                    fb.drawLine(0, 0, XRES - 1, YRES - 1, color)
+                    fb.update()
+
+            self.runThreads(run)
+            fb.update()
+            for index in range(THREADS):
+                color = (0x10 * (index + 1)) << 24 | 0xFF
+                self.assertEqual(fb.getPixel(XRES - 1, index * (YRES // THREADS)), color)
+            self.assertEqual(fb.capture(device=True), fb.capture(device=False))
+
+    def testUnbalancedClose(self):
+        with pfb.openheadless(FBNUM, XRES, YRES):
+            pass
+        with self.assertRaises(OSError):
+            native.pyfb_close(FBNUM)
+        with self.assertRaises(ValueError):
+            native.pyfb_close(pfb.MAX_FRAMEBUFFERS)
+
+
+@unittest.skipIf(interpreters is None, "subinterpreters are not available")
+class InterpreterTest(unittest.TestCase):
+    """
+    The subinterpreters import only the native module, as some standard modules imported
+    by the package can not be imported into an isolated interpreter of every Python version.
+    """
+
+    PATH = os.path.dirname(native.__file__)
+
+    def code(self, body):
+        return "import sys\nsys.path.insert(0, %r)\nimport _pyfb\n%s" % (self.PATH, body)
+
+    def testDraw(self):
+        body = ("_pyfb.pyfb_openVirtual(%d, %d, %d, 32, -1, _pyfb.PYFB_DUMP_RAW)\n"
+                "for i in range(200):\n"
+                "    _pyfb.pyfb_drawLine(%d, 0, 0, %d, i %% %d, 0xFF00FFFF)\n"
+                "    _pyfb.pyfb_flushBuffer(%d)\n"
+                "_pyfb.pyfb_close(%d)\n") % (FBNUM, XRES, YRES, FBNUM, XRES - 1, YRES, FBNUM, FBNUM)
+        errors = []
+
+        def run(interp):
+            try:
+                runInterpreter(interp, self.code(body))
+            except Exception as e:
+                errors.append(e)
+
+        interps = [createInterpreter() for _ in range(THREADS)]
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+            threads = [threading.Thread(target=run, args=(interp,)) for interp in interps]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            for interp in interps:
+                interpreters.destroy(interp)
+            self.assertEqual(errors, [])
+            self.assertEqual(fb.getPixel(XRES - 1, YRES - 1), 0xFF00FFFF)
+
+    def testReleaseOnDestroy(self):
+        interp = createInterpreter()
+        runInterpreter(interp, self.code("_pyfb.pyfb_openVirtual(%d, %d, %d, 32, -1, _pyfb.PYFB_DUMP_RAW)\n"
+                                         % (FBNUM, XRES, YRES)))
+        # the number is in use by the interpreter
+        with self.assertRaises(Exception):
+            with pfb.openheadless(FBNUM, XRES + 1, YRES):
+                pass
+        # and closing it here is refused, as this interpreter holds no reference
+        with self.assertRaises(OSError):
+            native.pyfb_close(FBNUM)
+        interpreters.destroy(interp)
+        with pfb.openheadless(FBNUM, XRES + 1, YRES):
+            pass
+
+
+if __name__ == "__main__":
+    unittest.main()
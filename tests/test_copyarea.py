@@ -0,0 +1,75 @@
+"""
+Tests of copyArea() on a headless framebuffer.
+"""
+import pyframebuffer as pfb
+
+import unittest
+
+FBNUM = 2
+XRES = 40
+YRES = 30
+
+
+class CopyAreaTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        # every pixel holds its own coordinates
+        for y in range(YRES):
+            for x in range(XRES):
+                self.fb.drawPixel(x, y, (x << 8 | y) << 8 | 0xFF)
+
+    def assertFrom(self, x, y, sx, sy):
+        self.assertEqual(self.fb.getPixel(x, y), (sx << 8 | sy) << 8 | 0xFF, "pixel %d,%d" % (x, y))
+
+    def testScrollUp(self):
+        self.fb.copyArea(0, 1, XRES, YRES - 1, 0, 0)
+        for y in range(YRES - 1):
+            self.assertFrom(0, y, 0, y + 1)
+            self.assertFrom(XRES - 1, y, XRES - 1, y + 1)
+        # the last row stays
+        self.assertFrom(5, YRES - 1, 5, YRES - 1)
+
+    def testScrollDown(self):
+        self.fb.copyArea(0, 0, XRES, YRES - 1, 0, 1)
+        for y in range(1, YRES):
+            self.assertFrom(3, y, 3, y - 1)
+        self.assertFrom(3, 0, 3, 0)
+
+    def testOverlapRight(self):
+        self.fb.copyArea(2, 2, 10, 10, 5, 3)
+        for y in range(10):
+            for x in range(10):
+                self.assertFrom(5 + x, 3 + y, 2 + x, 2 + y)
+
+    def testOverlapLeft(self):
+        self.fb.copyArea(5, 5, 10, 10, 3, 4)
+        for y in range(10):
+            for x in range(10):
+                self.assertFrom(3 + x, 4 + y, 5 + x, 5 + y)
+
+    def testClipped(self):
+        self.fb.copyArea(XRES - 5, YRES - 5, 100, 100, 0, 0)
+        self.assertFrom(0, 0, XRES - 5, YRES - 5)
+        self.assertFrom(4, 4, XRES - 1, YRES - 1)
+        self.assertFrom(5, 5, 5, 5)
+        with self.assertRaises(ValueError):
+            self.fb.copyArea(0, 0, 10, 10, XRES, YRES)
+
+    def testFlushScrolled(self):
+        self.fb.update()
+        self.fb.copyArea(0, 1, XRES, YRES - 1, 0, 0)
+        self.fb.drawHorizontalLine(0, YRES - 1, XRES, 0xFFFFFFFF)
+        self.fb.setStats()
+        self.fb.damage(0, 0, XRES, YRES)
+        self.fb.update()
+        self.assertEqual(self.fb.getStats()["flushBytes"], XRES * YRES * 4)
+        screen = self.fb.capture(device=True)
+        # the pixel 0,1 in the order red, green, blue and alpha
+        self.assertEqual(screen[:4], bytes([0, 0, 1, 0xFF]))
+        self.assertEqual(screen[(YRES - 1) * XRES * 4:], b"\xff" * XRES * 4)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,106 @@
+"""
+Tests of the bitmap fonts and drawText() on a headless framebuffer.
+"""
+from pyframebuffer.font import loadFont
+from support import writePSF1, writePSF2
+import pyframebuffer as pfb
+
+import os
+import tempfile
+import unittest
+
+FBNUM = 1
+RED = 0xFF0000FF
+BLUE = 0x0000FFFF
+
+
+class FontTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.addCleanup(self.tmp.cleanup)
+
+    def testLoadPSF2(self):
+        path = os.path.join(self.tmp.name, "font.psf.gz")
+        writePSF2(path, 8, 16)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        self.assertEqual(font.getGlyphSize(), (8, 16))
+        self.assertEqual(font.glyphs, 256)
+        self.assertEqual(font.measureText("AB\nA€xyz"), (5 * 8, 2 * 16))
+
+    def testLoadPSF1(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        writePSF1(path)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        self.assertEqual(font.getGlyphSize(), (8, 16))
+
+    def testDrawText(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        writePSF2(path, 12, 10, unicode=False)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        with pfb.openheadless(FBNUM, 64, 32) as fb:
+            fb.drawText(0, 0, "AB", RED, font)
+            # the full box of "A"
+            self.assertEqual(fb.getPixel(0, 0), RED)
+            self.assertEqual(fb.getPixel(11, 9), RED)
+            self.assertEqual(fb.getPixel(0, 10), 0)
+            # only the upper left pixel of "B"
+            self.assertEqual(fb.getPixel(12, 0), RED)
+            self.assertEqual(fb.getPixel(13, 0), 0)
+            self.assertEqual(fb.getPixel(12, 1), 0)
+
+    def testDrawTextUnicodeAndBackground(self):
+        path = os.path.join(self.tmp.name, "font.psf.gz")
+        writePSF2(path, 8, 16)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        with pfb.openheadless(FBNUM, 64, 32) as fb:
+            fb.drawText(0, 0, "€", RED, font, background=BLUE)
+            self.assertEqual(fb.getPixel(0, 0), RED)
+            self.assertEqual(fb.getPixel(1, 0), BLUE)
+            self.assertEqual(fb.getPixel(7, 15), BLUE)
+            self.assertEqual(fb.getPixel(8, 0), 0)
+
+    def testDrawTextClipped(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        writePSF1(path)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        with pfb.openheadless(FBNUM, 20, 20) as fb:
+            fb.drawText(16, 8, "AA\nA", RED, font)
+            self.assertEqual(fb.getPixel(19, 19), RED)
+            self.assertEqual(fb.getPixel(15, 8), 0)
+
+    def testDrawText16(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        writePSF1(path)
+        font = loadFont(path)
+        self.addCleanup(font.close)
+        with pfb.openheadless(FBNUM, 32, 16, 16) as fb:
+            fb.drawText(0, 0, "A", RED, font)
+            self.assertEqual(fb.getPixel(7, 15), RED)
+            self.assertEqual(fb.getPixel(8, 15), 0x000000FF)
+
+    def testClosedFont(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        writePSF1(path)
+        font = loadFont(path)
+        fontnum = font.fontnum
+        font.close()
+        self.assertIsNone(font.fontnum)
+        with self.assertRaises(Exception):
+            pfb.fb.pyfb_measureText(fontnum, "A")
+
+    def testInvalidFont(self):
+        path = os.path.join(self.tmp.name, "font.psf")
+        with open(path, "wb") as f:
+            f.write(b"not a font")
+        with self.assertRaises(Exception):
+            loadFont(path)
+
+
+if __name__ == "__main__":
+    unittest.main()
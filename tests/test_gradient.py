@@ -0,0 +1,104 @@
+"""
+Tests of the linear and radial gradient fills, on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import support
+import unittest
+
+FBNUM = 31
+XRES = 8
+YRES = 8
+BLACK = 0x000000FF
+WHITE = 0xFFFFFFFF
+RED = 0xFF0000FF
+
+
+def gray(color):
+    return color >> 24
+
+
+class GradientTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        self.fb.setStats()
+
+    def row(self, y):
+        return [self.fb.getPixel(x, y) for x in range(XRES)]
+
+    def testLinear(self):
+        self.fb.fillLinearGradient(0, 0, XRES, 1, [BLACK, WHITE])
+        # the colors of the pixel centers, from dark to light in even steps
+        self.assertEqual([gray(color) for color in self.row(0)], [0x10, 0x30, 0x50, 0x70, 0x8F, 0xAF, 0xCF, 0xEF])
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["gradient"], 1)
+        self.assertEqual(stats["pixels"], XRES)
+
+    def testAngle(self):
+        self.fb.fillLinearGradient(0, 0, 1, YRES, [BLACK, WHITE], angle=90)
+        column = [self.fb.getPixel(0, y) for y in range(YRES)]
+        self.fb.fillLinearGradient(0, 0, XRES, 1, [BLACK, WHITE])
+        self.assertEqual(column, self.row(0))
+
+    def testStops(self):
+        self.fb.fillLinearGradient(0, 0, XRES, 1, [(0, BLACK), (0.5, RED), (1, WHITE)])
+        row = self.row(0)
+        # red rises up to the middle stop, then green and blue
+        self.assertEqual([color >> 16 & 0xFF for color in row[:4]], [0] * 4)
+        self.assertEqual(row[4] >> 24, 0xFF)
+        self.assertLess(row[4] >> 16 & 0xFF, row[7] >> 16 & 0xFF)
+
+    def testRadial(self):
+        self.fb.fillRadialGradient(0, 0, XRES, YRES, [WHITE, BLACK])
+        row = [gray(color) for color in self.row(YRES // 2)]
+        # symmetric around the center, lightest in the middle
+        self.assertEqual(row, row[::-1])
+        self.assertEqual(row[:4], sorted(row[:4]))
+
+    def testEllipse(self):
+        self.fb.fillLinearGradient(0, 0, XRES, YRES, [BLACK, WHITE], shape=pfb.SHAPE_ELLIPSE)
+        # the corners are outside of the ellipse
+        self.assertEqual(self.fb.getPixel(0, 0), 0)
+        self.assertNotEqual(self.fb.getPixel(XRES // 2, YRES // 2), 0)
+        self.assertLess(self.fb.getStats()["pixels"], XRES * YRES)
+
+    def testClip(self):
+        self.fb.fillLinearGradient(-4, -4, XRES, YRES, [BLACK, WHITE])
+        self.assertNotEqual(self.fb.getPixel(0, 0), 0)
+        self.assertEqual(self.fb.getPixel(XRES // 2, YRES // 2), 0)
+        self.assertEqual(self.fb.getStats()["pixels"], XRES * YRES // 4)
+
+    def testDither(self):
+        self.fb.__exit__(None, None, None)
+        rows = []
+        for dither in (False, True):
+            with pfb.openheadless(FBNUM, 16, 2, 16) as fb:
+                fb.fillLinearGradient(0, 0, 16, 2, [BLACK, 0x202020FF], dither=dither)
+                rows.append([[fb.getPixel(x, y) for x in range(16)] for y in range(2)])
+        # without dithering the 16 bit colors form bands, dithering spreads the rows apart
+        self.assertEqual(rows[0][0], rows[0][1])
+        self.assertNotEqual(rows[1][0], rows[1][1])
+        self.assertNotEqual(rows[0], rows[1])
+
+    def testInvalid(self):
+        with self.assertRaises(ValueError):
+            self.fb.fillLinearGradient(0, 0, XRES, YRES, [(0.5, BLACK), (0.2, WHITE)])
+        with self.assertRaises(ValueError):
+            self.fb.fillLinearGradient(0, 0, XRES, YRES, [BLACK] * 17)
+
+    def testReplay(self):
+        def draw(fb):
+            fb.fillLinearGradient(0, 0, XRES, YRES, [BLACK, RED, WHITE], angle=45)
+            fb.fillRadialGradient(2, 2, 4, 4, [WHITE, BLACK], shape=pfb.SHAPE_ELLIPSE)
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertNotEqual(recorded[:4], recorded[-4:])
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
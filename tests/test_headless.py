@@ -0,0 +1,88 @@
+"""
+Tests of the headless framebuffers and their frame dumps.
+"""
+import pyframebuffer as pfb
+
+import os
+import struct
+import tempfile
+import unittest
+
+FBNUM = 6
+XRES = 6
+YRES = 4
+RED = 0xFF0000FF
+
+
+class HeadlessTest(unittest.TestCase):
+
+    def testResolution(self):
+        for depth in (16, 32):
+            with pfb.openheadless(FBNUM, XRES, YRES, depth) as fb:
+                self.assertEqual(fb.getResolution(), (XRES, YRES, depth))
+                self.assertEqual(fb.getCanvasSize(), (XRES, YRES))
+
+    def testInvalid(self):
+        for (xres, yres, depth) in ((0, YRES, 32), (XRES, 0, 32), (XRES, YRES, 24)):
+            with self.assertRaises(Exception):
+                with pfb.openheadless(FBNUM, xres, yres, depth):
+                    pass
+        with self.assertRaises(Exception):
+            with pfb.openheadless(FBNUM, XRES, YRES, dumpFormat=99):
+                pass
+
+    def testSharedNumber(self):
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb, pfb.openheadless(FBNUM, XRES, YRES) as other:
+            fb.drawPixel(0, 0, RED)
+            self.assertEqual(other.getPixel(0, 0), RED)
+            # the number is in use by another size
+            with self.assertRaises(Exception):
+                with pfb.openheadless(FBNUM, XRES + 1, YRES):
+                    pass
+        # the last close frees the number
+        with pfb.openheadless(FBNUM, XRES + 1, YRES) as fb:
+            self.assertEqual(fb.getPixel(0, 0), 0)
+
+    def testDumpRaw(self):
+        (readFd, writeFd) = os.pipe()
+        self.addCleanup(os.close, readFd)
+        with pfb.openheadless(FBNUM, XRES, YRES, 32, dump=writeFd, dumpFormat=pfb.DUMP_RAW) as fb:
+            fb.drawPixel(1, 0, RED)
+            fb.update()
+            fb.drawPixel(2, 0, RED)
+            fb.update()
+        os.close(writeFd)
+        frames = os.read(readFd, 2 * XRES * YRES * 4 + 1)
+        self.assertEqual(len(frames), 2 * XRES * YRES * 4)
+        pixels = struct.unpack("=%dI" % (2 * XRES * YRES), frames)
+        self.assertEqual(pixels[:3], (0, RED, 0))
+        self.assertEqual(pixels[XRES * YRES:XRES * YRES + 3], (0, RED, RED))
+
+    def testDumpRaw16(self):
+        (readFd, writeFd) = os.pipe()
+        self.addCleanup(os.close, readFd)
+        with pfb.openheadless(FBNUM, XRES, YRES, 16, dump=writeFd, dumpFormat=pfb.DUMP_RAW) as fb:
+            fb.drawPixel(0, 0, RED)
+            fb.update()
+        os.close(writeFd)
+        frame = os.read(readFd, XRES * YRES * 2 + 1)
+        self.assertEqual(len(frame), XRES * YRES * 2)
+        self.assertEqual(struct.unpack_from("=2H", frame), (0xF800, 0))
+
+    def testDumpPPM(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "frames.ppm")
+            with pfb.openheadless(FBNUM, XRES, YRES, dump=path) as fb:
+                fb.fill(RED)
+                fb.drawPixel(XRES - 1, YRES - 1, 0x00FF00FF)
+                fb.update()
+                fb.update()
+            with open(path, "rb") as f:
+                data = f.read()
+        header = b"P6\n%d %d\n255\n" % (XRES, YRES)
+        frame = header + b"\xff\x00\x00" * (XRES * YRES - 1) + b"\x00\xff\x00"
+        self.assertEqual(data, frame * 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
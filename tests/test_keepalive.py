@@ -0,0 +1,74 @@
+"""
+Tests of the keep-alive of closed framebuffers, on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import os
+import time
+import unittest
+
+FBNUM = 15
+XRES = 32
+YRES = 16
+PERIOD = 0.2
+WHITE = 0xFFFFFFFF
+
+
+def openFds():
+    return len(os.listdir("/proc/self/fd"))
+
+
+class KeepAliveTest(unittest.TestCase):
+
+    def setUp(self):
+        pfb.setKeepAlive(PERIOD, FBNUM)
+        self.addCleanup(pfb.setKeepAlive, 0, FBNUM)
+
+    def drawFrame(self):
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+            fb.setRotation(180)
+            fb.fill(WHITE)
+            fb.update()
+
+    def testReuse(self):
+        self.drawFrame()
+        fds = openFds()
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+            # the same memory, which still shows the last frame
+            self.assertEqual(openFds(), fds)
+            self.assertEqual(fb.capture(device=True), b"\xff" * XRES * YRES * 4)
+            # but a cleared offscreen buffer and the default state
+            self.assertEqual(fb.capture(device=False), bytes(XRES * YRES * 4))
+            self.assertEqual(fb.getRotation(), (0, False, False))
+            fb.drawPixel(0, 0, WHITE)
+            fb.damage(0, 0, 2, 1)
+            fb.update()
+            # a partial flush does not send the frame of the previous user
+            self.assertEqual(fb.capture(device=True)[:12], b"\xff" * 4 + bytes(4) + b"\xff" * 4)
+
+    def testRelease(self):
+        self.drawFrame()
+        fds = openFds()
+        time.sleep(PERIOD * 2.5)
+        # the reaper closed the memory
+        self.assertEqual(openFds(), fds - 1)
+        with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+            self.assertEqual(fb.capture(device=True), bytes(XRES * YRES * 4))
+
+    def testOtherSize(self):
+        self.drawFrame()
+        fds = openFds()
+        with pfb.openheadless(FBNUM, XRES * 2, YRES) as fb:
+            self.assertEqual(fb.getResolution(), (XRES * 2, YRES, 32))
+            self.assertEqual(openFds(), fds)
+            self.assertEqual(fb.capture(device=True), bytes(XRES * 2 * YRES * 4))
+
+    def testDisable(self):
+        self.drawFrame()
+        fds = openFds()
+        pfb.setKeepAlive(0, FBNUM)
+        self.assertEqual(openFds(), fds - 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,72 @@
+"""
+Tests of the mirror groups, between headless framebuffers of other sizes and depths.
+"""
+import pyframebuffer as pfb
+
+import unittest
+
+SOURCE = 18
+MEMBER = 19
+XRES = 32
+YRES = 16
+RED = 0xFF0000FF
+GREEN = 0x00FF00FF
+WHITE = 0xFFFFFFFF
+
+
+class MirrorTest(unittest.TestCase):
+
+    def setUp(self):
+        self.source = pfb.openheadless(SOURCE, XRES, YRES).__enter__()
+        self.addCleanup(self.source.__exit__, None, None, None)
+        # half the size and 16 bit
+        self.member = pfb.openheadless(MEMBER, XRES // 2, YRES // 2, 16).__enter__()
+        self.addCleanup(self.member.__exit__, None, None, None)
+        self.source.addMirror(self.member)
+
+    def testConvert(self):
+        self.source.fill(RED)
+        self.source.update()
+        self.assertEqual(self.member.capture(device=True), bytes([0xFF, 0, 0, 0xFF]) * (XRES // 2) * (YRES // 2))
+
+    def testDamage(self):
+        self.source.fill(RED)
+        self.source.update()
+        self.source.fill(0)
+        for (x, y) in ((4, 2), (5, 2), (4, 3), (5, 3)):
+            self.source.drawPixel(x, y, GREEN)
+        self.source.damage(4, 2, 2, 2)
+        self.member.setStats()
+        self.source.update()
+        # the damage is scaled to a single pixel of the member, the rest is not written
+        screen = self.member.capture(device=True)
+        self.assertEqual(screen[(1 * XRES // 2 + 2) * 4:][:4], bytes([0, 0xFF, 0, 0xFF]))
+        self.assertEqual(screen[:4], bytes([0xFF, 0, 0, 0xFF]))
+        stats = self.member.getStats()
+        self.assertEqual(stats["flushes"], 1)
+        self.assertEqual(stats["flushBytes"], 2)
+
+    def testRemove(self):
+        self.source.removeMirror(self.member)
+        self.source.fill(WHITE)
+        self.source.update()
+        self.assertEqual(self.member.capture(device=True), bytes([0, 0, 0, 0xFF]) * (XRES // 2) * (YRES // 2))
+        with self.assertRaises(ValueError):
+            self.source.removeMirror(self.member)
+
+    def testInvalid(self):
+        with self.assertRaises(ValueError):
+            self.source.addMirror(self.source)
+        with self.assertRaises(ValueError):
+            self.source.addMirror(self.member)
+
+    def testCloseMember(self):
+        # a closed member leaves the group, so the source flushes alone
+        self.member.__exit__(None, None, None)
+        self.source.fill(WHITE)
+        self.source.update()
+        self.assertEqual(self.source.capture(device=True)[:4], b"\xff" * 4)
+
+
+if __name__ == "__main__":
+    unittest.main()
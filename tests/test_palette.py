@@ -0,0 +1,111 @@
+"""
+Tests of the indexed canvas, on headless framebuffers.
+"""
+from pyframebuffer import colormap
+from pyframebuffer.sprite import loadSprite
+import pyframebuffer as pfb
+
+import array
+import support
+import unittest
+
+FBNUM = 26
+SOURCE = 27
+XRES = 4
+YRES = 2
+WHITE = 0xFFFFFFFF
+RED = 0xFF0000FF
+GREEN = 0x00FF00FF
+BLUE = 0x0000FFFF
+
+
+def pixels(*colors):
+    return b"".join(color.to_bytes(4, "big") for color in colors)
+
+
+class PaletteTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def testExpand(self):
+        self.fb.drawPixel(0, 0, RED)
+        self.fb.setPalette([WHITE, RED])
+        # switching clears the canvas to index 0
+        self.assertEqual(self.fb.getPixel(0, 0), 0)
+        self.fb.drawPixel(1, 0, 1)
+        self.assertEqual(self.fb.getPixel(1, 0), 1)
+        self.fb.update()
+        self.assertEqual(self.fb.capture()[:12], pixels(WHITE, RED, WHITE))
+
+    def testRecolor(self):
+        self.fb.setStats()
+        self.fb.setPalette([WHITE, RED])
+        self.fb.drawHorizontalLine(0, 1, XRES, 1)
+        self.fb.update()
+        self.fb.setPalette([BLUE, GREEN])
+        self.fb.update()
+        # the next update recolors the whole screen without redrawing
+        self.assertEqual(self.fb.capture(), pixels(*[BLUE] * XRES + [GREEN] * XRES))
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["palette"], 2)
+        self.assertEqual(stats["flushBytes"], 2 * XRES * YRES * 4)
+
+    def testShapes(self):
+        self.fb.setPalette([WHITE, RED, GREEN])
+        self.fb.fillTriangle(0, 0, XRES, 0, 0, YRES, 2)
+        self.fb.update()
+        self.assertEqual(self.fb.capture()[:4], pixels(GREEN))
+        self.assertEqual(self.fb.capture()[-4:], pixels(WHITE))
+
+    def testClear(self):
+        self.fb.setPalette([WHITE])
+        self.fb.clearPalette()
+        self.fb.drawPixel(0, 0, RED)
+        self.assertEqual(self.fb.getPixel(0, 0), RED)
+        self.assertEqual(self.fb.getResolution(), (XRES, YRES, 32))
+
+    def testInvalidPalette(self):
+        for colors in ([], [WHITE] * (pfb.PALETTE_SIZE + 1)):
+            with self.assertRaises(ValueError):
+                self.fb.setPalette(colors)
+
+    def testRejected(self):
+        with pfb.openheadless(SOURCE, 2, 2) as source:
+            source.setRotation(90)
+            with self.assertRaises(OSError):
+                source.setPalette([WHITE])
+            source.setRotation(0)
+
+            self.fb.setPalette([WHITE, RED])
+            sprite = loadSprite(1, 1, pixels(RED))
+            self.addCleanup(sprite.close)
+            for operation in (lambda: self.fb.setRotation(90),
+                              lambda: self.fb.writeRect(0, 0, 1, 1, pixels(RED)),
+                              lambda: self.fb.blitTransformed(source, (1, 0, 0, 0, 1, 0)),
+                              lambda: self.fb.drawSprite(0, 0, sprite),
+                              lambda: self.fb.blitScalar(array.array("B", [0] * 4), 0, 0, colormap.hot(), 0, 1, width=2),
+                              lambda: self.fb.fillLinearGradient(0, 0, XRES, YRES, [RED, WHITE]),
+                              lambda: self.fb.fillTriangle(0, 0, XRES, 0, 0, YRES, (0, 1, 1))):
+                with self.assertRaises(OSError):
+                    operation()
+            with self.assertRaises(ValueError):
+                self.fb.addMirror(source)
+
+    def testReplay(self):
+        def draw(fb):
+            fb.setPalette([WHITE, RED])
+            fb.drawLine(0, 0, XRES - 1, YRES - 1, 1)
+            fb.update()
+            fb.setPalette([BLUE, GREEN])
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[:8], pixels(GREEN, GREEN))
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,86 @@
+"""
+Tests of the points and polylines drawn from coordinate arrays, on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import array
+import support
+import unittest
+
+FBNUM = 29
+XRES = 8
+YRES = 4
+GREEN = 0x00FF00FF
+NAN = float("nan")
+
+
+class PlotTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        self.fb.setStats()
+
+    def drawn(self):
+        """
+        Returns the rows of the screen as strings with a # for every drawn pixel.
+        """
+        return ["".join("#" if self.fb.getPixel(x, y) else "." for x in range(XRES)) for y in range(YRES)]
+
+    def testPoints(self):
+        xs = array.array("f", [0, 1.6, -1, XRES - 1, NAN])
+        ys = array.array("f", [0, 0.4, 0, YRES - 1, 1])
+        self.fb.drawPoints(xs, ys, GREEN)
+        # the floats are rounded, the points off the screen or with NaN are skipped
+        self.assertEqual(self.drawn(), ["#.#.....", "........", "........", ".......#"])
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["points"], 1)
+        self.assertEqual(stats["pixels"], 3)
+
+    def testIntegerPoints(self):
+        self.fb.drawPoints(array.array("i", [1, 2]), array.array("i", [2, 3]), GREEN)
+        self.assertEqual(self.drawn()[2:], [".#......", "..#....."])
+
+    def testPolyline(self):
+        self.fb.drawPolyline(array.array("i", [0, 0, 3, 0, 3, 3]), GREEN)
+        self.assertEqual(self.drawn(), ["####....", "...#....", "...#....", "...#...."])
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["polyline"], 1)
+        # the pixel shared by both lines is drawn once
+        self.assertEqual(stats["pixels"], 7)
+
+    def testGap(self):
+        self.fb.drawPolyline(array.array("f", [0, 0, 2, 0, NAN, 0, 4, 0, 6, 0]), GREEN)
+        self.assertEqual(self.drawn()[0], "###.###.")
+
+    def testDecimate(self):
+        points = array.array("f", [0, 0, 0.1, 3, 0.2, 1, 5, 1])
+        self.fb.drawPolyline(points, GREEN, decimate=True)
+        # the points of the first column are drawn as a line from their minimum to their maximum
+        self.assertEqual(self.drawn(), ["#.......", "######..", "#.......", "#......."])
+        self.assertEqual(self.fb.getStats()["pixels"], 9)
+
+    def testClip(self):
+        self.fb.drawPolyline(array.array("f", [-10, -10, 20, 20]), GREEN)
+        self.assertEqual(self.drawn(), ["#.......", ".#......", "..#.....", "...#...."])
+
+    def testInvalid(self):
+        with self.assertRaises(ValueError):
+            self.fb.drawPoints(array.array("f", [0]), array.array("f", [0, 1]), GREEN)
+        with self.assertRaises(ValueError):
+            self.fb.drawPolyline(array.array("f", [0, 0, 1]), GREEN)
+
+    def testReplay(self):
+        def draw(fb):
+            fb.drawPoints(array.array("f", [1, 2, 3]), array.array("f", [3, 2, 1]), GREEN)
+            fb.drawPolyline(array.array("f", [0, 0, XRES - 1, YRES - 1, 0, YRES - 1]), GREEN, decimate=True)
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[:4], bytes([0, 0xFF, 0, 0xFF]))
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
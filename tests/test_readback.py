@@ -0,0 +1,82 @@
+"""
+Tests of getPixel(), readRect() and capture() on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import unittest
+
+FBNUM = 4
+XRES = 16
+YRES = 8
+RED = 0xFF0000FF
+GREEN = 0x00FF00FF
+BLUE = 0x0000FFFF
+
+
+class ReadbackTest(unittest.TestCase):
+
+    def open(self, depth):
+        fb = pfb.openheadless(FBNUM, XRES, YRES, depth).__enter__()
+        self.addCleanup(fb.__exit__, None, None, None)
+        return fb
+
+    def testGetPixel(self):
+        fb = self.open(32)
+        fb.drawPixel(3, 4, 0x12345678)
+        self.assertEqual(fb.getPixel(3, 4), 0x12345678)
+        self.assertEqual(fb.getPixel(4, 4), 0)
+        with self.assertRaises(ValueError):
+            fb.getPixel(XRES, 0)
+
+    def testGetPixel16(self):
+        fb = self.open(16)
+        fb.drawPixel(0, 0, RED)
+        fb.drawPixel(1, 0, GREEN)
+        fb.drawPixel(2, 0, BLUE)
+        # the channels are widened and the alpha is opaque
+        self.assertEqual([fb.getPixel(x, 0) for x in range(4)], [RED, GREEN, BLUE, 0x000000FF])
+
+    def testReadRect(self):
+        fb = self.open(32)
+        fb.drawHorizontalLine(2, 1, 3, RED)
+        fb.drawPixel(3, 2, BLUE)
+        buffer = bytearray(3 * 2 * 4)
+        fb.readRect(2, 1, 3, 2, buffer)
+        red = bytes([0xFF, 0, 0, 0xFF])
+        self.assertEqual(bytes(buffer), red * 3 + bytes(4) + bytes([0, 0, 0xFF, 0xFF]) + bytes(4))
+
+    def testReadRectInvalid(self):
+        fb = self.open(32)
+        with self.assertRaises(ValueError):
+            fb.readRect(XRES - 1, 0, 2, 1, bytearray(8))
+        with self.assertRaises(ValueError):
+            fb.readRect(0, 0, 2, 2, bytearray(15))
+
+    def testCapture(self):
+        for depth in (16, 32):
+            with self.subTest(depth=depth):
+                fb = self.open(depth)
+                fb.fill(BLUE)
+                fb.drawPixel(XRES - 1, YRES - 1, RED)
+                # the device shows nothing before the update, 16 bit pixels are opaque
+                blank = bytes([0, 0, 0, 0xFF if depth == 16 else 0])
+                self.assertEqual(fb.capture(device=True), blank * XRES * YRES)
+                screen = fb.capture(device=False)
+                self.assertEqual(screen, bytes([0, 0, 0xFF, 0xFF]) * (XRES * YRES - 1) + bytes([0xFF, 0, 0, 0xFF]))
+                fb.update()
+                self.assertEqual(fb.capture(device=True), screen)
+                fb.__exit__(None, None, None)
+
+    def testCaptureInto(self):
+        fb = self.open(32)
+        fb.fill(GREEN)
+        fb.update()
+        buffer = bytearray(XRES * YRES * 4)
+        self.assertIsNone(fb.capture(buffer))
+        self.assertEqual(bytes(buffer), bytes([0, 0xFF, 0, 0xFF]) * XRES * YRES)
+        with self.assertRaises(ValueError):
+            fb.capture(bytearray(XRES * YRES * 4 - 1))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,122 @@
+"""
+Tests of the draw call recording and its replay.
+"""
+from pyframebuffer import record
+from pyframebuffer.font import loadFont
+from support import recordAndReplay, writePSF1
+import pyframebuffer as pfb
+
+import contextlib
+import io
+import json
+import os
+import tempfile
+import time
+import unittest
+
+FBNUM = 10
+XRES = 48
+YRES = 32
+
+
+def drawScene(fb):
+    fb.fill(0x202020FF)
+    fb.drawLine(0, 0, XRES - 1, YRES - 1, 0xFF0000FF)
+    fb.drawHorizontalLine(2, 5, 20, 0x00FF00FF)
+    fb.drawVerticalLine(30, 1, 20, 0x0000FFFF)
+    fb.drawCircle(24, 16, 10, 0xFFFF00FF)
+    fb.drawEllipse(24, 16, 14, 6, 0x00FFFFFF)
+    fb.drawPixel(XRES - 1, 0, 0xFFFFFFFF)
+    fb.copyArea(0, 0, 10, 10, 36, 20)
+
+
+class RecordTest(unittest.TestCase):
+
+    def testReplay(self):
+        (recorded, replayed, result) = recordAndReplay(FBNUM, XRES, YRES, drawScene)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(result["flushes"], 1)
+        self.assertEqual((result["errors"], result["skipped"]), (0, 0))
+        # the fill is recorded as a write of the whole screen, plus the seven other calls and the flush
+        self.assertGreaterEqual(result["calls"], 8)
+
+    def testReplayCanvas(self):
+        def draw(fb):
+            fb.setCanvas(2 * XRES, YRES)
+            fb.drawHorizontalLine(XRES, 3, XRES, 0xFF0000FF)
+            fb.setViewport(XRES, 0)
+            fb.damage(0, 3, XRES, 1)
+
+        (recorded, replayed, result) = recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[3 * XRES * 4:3 * XRES * 4 + 4], bytes([0xFF, 0, 0, 0xFF]))
+        self.assertEqual(result["errors"], 0)
+
+    def testReplayText(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "font.psf")
+            writePSF1(path)
+
+            def draw(fb):
+                # the font is recorded, as it is loaded after the start
+                font = loadFont(path)
+                fb.drawText(3, 2, "AxA", 0xFF0000FF, font, background=0x0000FFFF)
+                font.close()
+
+            (recorded, replayed, result) = recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual((result["errors"], result["skipped"]), (0, 0))
+
+    def testFontLoadedBefore(self):
+        # a font loaded before the start is unknown to the replay, so its text is skipped
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "font.psf")
+            writePSF1(path)
+            font = loadFont(path)
+            self.addCleanup(font.close)
+
+        (recorded, replayed, result) = recordAndReplay(FBNUM, XRES, YRES, lambda fb: fb.drawText(0, 0, "A", 1, font))
+        self.assertEqual(result["skipped"], 1)
+        self.assertNotEqual(replayed, recorded)
+
+    def testPaced(self):
+        def draw(fb):
+            fb.drawPixel(0, 0, 1)
+            time.sleep(0.05)
+            fb.drawPixel(1, 0, 1)
+
+        with tempfile.TemporaryFile() as recording:
+            record.start(recording)
+            with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+                draw(fb)
+            record.stop()
+
+            recording.seek(0)
+            fast = record.replay(recording)
+            recording.seek(0)
+            paced = record.replay(recording, paced=True)
+
+        self.assertGreaterEqual(fast["recordedSeconds"], 0.05)
+        self.assertLess(fast["replaySeconds"], 0.05)
+        self.assertGreaterEqual(paced["replaySeconds"], 0.045)
+
+    def testMain(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "session.pfbr")
+            record.start(path)
+            with pfb.openheadless(FBNUM, XRES, YRES) as fb:
+                drawScene(fb)
+                fb.update()
+            record.stop()
+
+            output = io.StringIO()
+            with contextlib.redirect_stdout(output):
+                record.main([path, "--repeat", "2", "--json"])
+        results = json.loads(output.getvalue())
+        self.assertEqual(len(results), 2)
+        self.assertEqual(results[0]["calls"], results[1]["calls"])
+        self.assertEqual(results[0]["flushes"], 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
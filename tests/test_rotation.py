@@ -0,0 +1,99 @@
+"""
+Tests of the rotated and mirrored canvas, on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import socket
+import support
+import unittest
+
+FBNUM = 20
+XRES = 4
+YRES = 2
+RED = 0xFF0000FF
+
+
+class RotationTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def screen(self):
+        """
+        Returns the indices of the red pixels on the device.
+        """
+        capture = self.fb.capture(device=True)
+        return [i for i in range(XRES * YRES) if capture[i * 4:i * 4 + 4] == b"\xff\x00\x00\xff"]
+
+    def drawCorner(self):
+        self.fb.drawPixel(0, 0, RED)
+        self.fb.update()
+
+    def testQuarterTurn(self):
+        self.fb.setRotation(90)
+        self.assertEqual(self.fb.getResolution(), (YRES, XRES, 32))
+        self.assertEqual(self.fb.getRotation(), (90, False, False))
+        self.drawCorner()
+        # the upper left corner of the screen is the upper right corner of the device
+        self.assertEqual(self.screen(), [XRES - 1])
+        # while the offscreen buffer keeps the coordinates of the screen
+        self.assertEqual(self.fb.capture(device=False)[:4], b"\xff\x00\x00\xff")
+
+    def testHalfTurn(self):
+        self.fb.setRotation(180)
+        self.assertEqual(self.fb.getResolution(), (XRES, YRES, 32))
+        self.drawCorner()
+        self.assertEqual(self.screen(), [XRES * YRES - 1])
+
+    def testFlip(self):
+        self.fb.setRotation(0, flipX=True)
+        self.assertEqual(self.fb.getRotation(), (0, True, False))
+        self.drawCorner()
+        self.assertEqual(self.screen(), [XRES - 1])
+        self.fb.setRotation(0, flipY=True)
+        self.drawCorner()
+        self.assertEqual(self.screen(), [XRES * (YRES - 1)])
+
+    def testDamage(self):
+        self.fb.setRotation(270)
+        self.fb.update()
+        self.fb.setStats()
+        self.fb.drawPixel(0, 0, RED)
+        self.fb.damage(0, 0, 1, 1)
+        self.fb.update()
+        # only the rotated damage is written
+        self.assertEqual(self.screen(), [XRES * (YRES - 1)])
+        self.assertEqual(self.fb.getStats()["flushBytes"], 4)
+
+    def testReset(self):
+        self.fb.setRotation(90)
+        self.fb.drawPixel(0, 0, RED)
+        self.fb.setRotation(0)
+        # rotating clears the offscreen buffer and restores the resolution
+        self.assertEqual(self.fb.getResolution(), (XRES, YRES, 32))
+        self.assertEqual(self.fb.capture(device=False), bytes(XRES * YRES * 4))
+
+    def testInvalid(self):
+        with self.assertRaises(ValueError):
+            self.fb.setRotation(45)
+        (reader, writer) = socket.socketpair()
+        self.addCleanup(reader.close)
+        self.addCleanup(writer.close)
+        self.fb.startStream(writer)
+        self.addCleanup(self.fb.stopStream)
+        with self.assertRaises(OSError):
+            self.fb.setRotation(90)
+
+    def testReplay(self):
+        def draw(fb):
+            fb.setRotation(90, flipY=True)
+            fb.drawLine(0, 0, YRES - 1, XRES - 1, RED)
+
+        (recorded, replayed, _) = support.recordAndReplay(FBNUM + 1, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertNotEqual(recorded, bytes(XRES * YRES * 4))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,89 @@
+"""
+Tests of the colormapped blits of scalar arrays, on headless framebuffers.
+"""
+from pyframebuffer import colormap
+import pyframebuffer as pfb
+
+import array
+import support
+import unittest
+
+FBNUM = 28
+XRES = 8
+YRES = 4
+BLACK = 0x000000FF
+WHITE = 0xFFFFFFFF
+
+
+class ColormapTest(unittest.TestCase):
+
+    def testGradient(self):
+        gray = colormap.gray()
+        self.assertEqual(len(gray), colormap.COLORMAP_SIZE)
+        self.assertEqual((gray[0], gray[128], gray[-1]), (BLACK, 0x808080FF, WHITE))
+        self.assertEqual(colormap.hot()[-1], WHITE)
+        with self.assertRaises(ValueError):
+            colormap.gradient(BLACK)
+
+
+class ScalarTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def row(self, y, width=XRES):
+        return [self.fb.getPixel(x, y) for x in range(width)]
+
+    def testFloat(self):
+        self.fb.setStats()
+        values = array.array("f", [0, 0.5, 1, 2, -1, 0.25, 0.75, float("nan")])
+        self.fb.blitScalar(values, 0, 0, colormap.gray(), 0.0, 1.0, width=4)
+        # the values outside of the range are clamped, NaN maps to the first color
+        self.assertEqual(self.row(0, 4), [BLACK, 0x808080FF, WHITE, WHITE])
+        self.assertEqual(self.row(1, 4), [BLACK, 0x404040FF, 0xBFBFBFFF, BLACK])
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["blitScalar"], 1)
+        self.assertEqual(stats["pixels"], 8)
+
+    def testIntegers(self):
+        self.fb.blitScalar(array.array("B", [0, 255]), 0, 0, colormap.gray(), 0, 255, width=2)
+        self.fb.blitScalar(array.array("H", [65535, 0]), 0, 1, colormap.gray(), 0, 65535, width=2)
+        self.assertEqual(self.row(0, 2), [BLACK, WHITE])
+        self.assertEqual(self.row(1, 2), [WHITE, BLACK])
+
+    def testZoom(self):
+        self.fb.blitScalar(array.array("B", [255, 0]), 0, 0, colormap.gray(), 0, 255, zoom=2, width=2)
+        self.assertEqual(self.row(0, 5), [WHITE, WHITE, BLACK, BLACK, 0])
+        self.assertEqual(self.row(1, 5), [WHITE, WHITE, BLACK, BLACK, 0])
+        self.assertEqual(self.row(2, 5), [0] * 5)
+
+    def testClip(self):
+        # the values off the screen are clipped
+        self.fb.blitScalar(array.array("B", [255, 0, 0, 0]), XRES - 2, YRES - 2, colormap.gray(), 0, 255, zoom=2, width=2)
+        self.assertEqual(self.row(YRES - 1)[-3:], [0, WHITE, WHITE])
+
+    def testInvalid(self):
+        gray = colormap.gray()
+        with self.assertRaises(TypeError):
+            self.fb.blitScalar(array.array("d", [0]), 0, 0, gray, 0, 1, width=1)
+        with self.assertRaises(ValueError):
+            self.fb.blitScalar(array.array("B", [0] * 3), 0, 0, gray, 0, 1, width=2)
+        with self.assertRaises(ValueError):
+            self.fb.blitScalar(array.array("B", [0]), 0, 0, gray[:5], 0, 1, width=1)
+        with self.assertRaises(ValueError):
+            self.fb.blitScalar(array.array("B", [0]), 0, 0, gray, 0, 1, zoom=0, width=1)
+
+    def testReplay(self):
+        def draw(fb):
+            fb.blitScalar(array.array("f", [i / 31 for i in range(32)]), 0, 0, colormap.jet(), 0, 1, width=XRES)
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[:4], bytes([0, 0, 0x80, 0xFF]))
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,81 @@
+"""
+Tests of the shared offscreen buffer, with a headless owner.
+"""
+import pyframebuffer as pfb
+
+import os
+import unittest
+
+OWNER = 16
+CLIENT = 17
+XRES = 32
+YRES = 16
+RED = 0xFF0000FF
+
+
+class SharedTest(unittest.TestCase):
+
+    def setUp(self):
+        self.name = "/pyfb-test-%d" % os.getpid()
+        self.owner = pfb.openshared(OWNER, self.name, owner=True, headless=(XRES, YRES, 32)).__enter__()
+        self.addCleanup(self.owner.__exit__, None, None, None)
+
+    def testAttach(self):
+        with pfb.openshared(CLIENT, self.name) as client:
+            self.assertEqual(client.getResolution(), (XRES, YRES, 32))
+            # both draw into the same memory
+            client.drawPixel(1, 2, RED)
+            self.assertEqual(self.owner.getPixel(1, 2), RED)
+
+    def testDamage(self):
+        self.owner.update()
+        self.assertFalse(self.owner.waitDamage(0.01))
+        with pfb.openshared(CLIENT, self.name) as client:
+            client.drawHorizontalLine(2, 3, 5, RED)
+            client.damage(2, 3, 5, 1)
+            client.update()
+            # the update of the client only hands the damage over
+            self.assertEqual(self.owner.capture(device=True)[(3 * XRES + 2) * 4:][:4], bytes(4))
+
+        self.assertTrue(self.owner.waitDamage(1))
+        self.owner.setStats()
+        self.owner.update()
+        # the owner writes only the damage of the client
+        self.assertEqual(self.owner.getStats()["flushBytes"], 5 * 4)
+        screen = self.owner.capture(device=True)
+        self.assertEqual(screen[(3 * XRES + 2) * 4:][:5 * 4], bytes([0xFF, 0, 0, 0xFF]) * 5)
+        self.assertFalse(self.owner.waitDamage(0.01))
+
+    def testOtherProcess(self):
+        pid = os.fork()
+        if pid == 0:
+            status = 1
+            try:
+                with pfb.openshared(CLIENT, self.name) as client:
+                    client.drawVerticalLine(XRES - 1, 0, YRES, RED)
+                    client.damage(XRES - 1, 0, 1, YRES)
+                    client.update()
+                status = 0
+            finally:
+                os._exit(status)
+
+        (_, status) = os.waitpid(pid, 0)
+        self.assertEqual(status, 0)
+        self.assertTrue(self.owner.waitDamage(1))
+        self.owner.update()
+        self.assertEqual(self.owner.capture(device=True)[(YRES * XRES - 1) * 4:], bytes([0xFF, 0, 0, 0xFF]))
+
+    def testInvalidName(self):
+        for name in ("pyfb", "/", "/a/b"):
+            with self.assertRaises(ValueError):
+                with pfb.openshared(CLIENT, name):
+                    pass
+
+    def testMissingSegment(self):
+        with self.assertRaises(Exception):
+            with pfb.openshared(CLIENT, self.name + "-missing"):
+                pass
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,88 @@
+"""
+Tests of the run length encoded sprites, on headless framebuffers.
+"""
+from pyframebuffer.sprite import MAX_SPRITES, loadSprite
+import pyframebuffer as pfb
+
+import support
+import unittest
+
+FBNUM = 25
+XRES = 8
+YRES = 4
+RED = 0xFF0000FF
+MAGENTA = 0xFF00FFFF
+R = bytes([0xFF, 0, 0, 0xFF])
+M = bytes([0xFF, 0, 0xFF, 0xFF])
+T = bytes([0, 0xFF, 0, 100])
+
+
+class SpriteTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def row(self, y):
+        return [self.fb.getPixel(x, y) for x in range(XRES)]
+
+    def testColorKey(self):
+        sprite = loadSprite(4, 2, R + M + M + R + M + R + R + M, colorKey=MAGENTA)
+        self.addCleanup(sprite.close)
+        self.assertEqual(sprite.getSize(), (4, 2))
+        self.assertEqual((sprite.runs, sprite.opaque), (3, 4))
+        self.fb.fill(0x0000FFFF)
+        self.fb.drawSprite(1, 1, sprite)
+        # the keyed pixels keep the background
+        self.assertEqual(self.row(1)[:6], [0x0000FFFF, RED, 0x0000FFFF, 0x0000FFFF, RED, 0x0000FFFF])
+        self.assertEqual(self.row(2)[:6], [0x0000FFFF, 0x0000FFFF, RED, RED, 0x0000FFFF, 0x0000FFFF])
+
+    def testAlphaThreshold(self):
+        pixels = R + T + T + R
+        sprite = loadSprite(4, 1, pixels)
+        self.addCleanup(sprite.close)
+        self.assertEqual(sprite.opaque, 2)
+        # the threshold below the alpha of the green pixels makes them opaque
+        opaque = loadSprite(4, 1, pixels, alphaThreshold=100)
+        self.addCleanup(opaque.close)
+        self.assertEqual((opaque.runs, opaque.opaque), (1, 4))
+
+    def testClip(self):
+        sprite = loadSprite(4, 2, R + M + M + R + M + R + R + M, colorKey=MAGENTA)
+        self.addCleanup(sprite.close)
+        self.fb.setStats()
+        self.fb.drawSprite(-1, -1, sprite)
+        self.fb.drawSprite(XRES - 1, YRES - 1, sprite)
+        self.fb.drawSprite(XRES, 0, sprite)
+        self.assertEqual(self.row(0)[:3], [RED, RED, 0])
+        self.assertEqual(self.row(YRES - 1)[-1], RED)
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["sprite"], 3)
+        self.assertEqual(stats["pixels"], 3)
+
+    def testFree(self):
+        # freed sprites release their numbers
+        for _ in range(MAX_SPRITES + 1):
+            loadSprite(1, 1, R).close()
+        sprite = loadSprite(1, 1, R)
+        spritenum = sprite.spritenum
+        sprite.close()
+        sprite.close()
+        with self.assertRaises(Exception):
+            pfb.fb.pyfb_spriteInfo(spritenum)
+
+    def testReplay(self):
+        def draw(fb):
+            sprite = loadSprite(4, 2, R + M + M + R + M + R + R + M, colorKey=MAGENTA)
+            fb.drawSprite(2, 1, sprite)
+            sprite.close()
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[(XRES + 2) * 4:][:4], R)
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,77 @@
+"""
+Tests of the performance counters.
+"""
+import pyframebuffer as pfb
+
+import unittest
+
+FBNUM = 8
+XRES = 32
+YRES = 16
+
+
+class StatsTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def assertZero(self, stats):
+        self.assertEqual(set(stats["calls"].values()), {0})
+        self.assertEqual((stats["pixels"], stats["flushes"], stats["flushBytes"], stats["flushNs"]), (0, 0, 0, 0))
+        self.assertEqual(set(stats["flushHistogram"]), {0})
+
+    def testDisabledByDefault(self):
+        self.fb.drawPixel(0, 0, 1)
+        self.fb.update()
+        self.assertZero(self.fb.getStats())
+
+    def testCalls(self):
+        self.fb.setStats()
+        self.fb.drawPixel(1, 1, 1)
+        self.fb.drawHorizontalLine(0, 0, 10, 1)
+        self.fb.drawVerticalLine(0, 0, 5, 1)
+        self.fb.drawLine(0, 0, 9, 0, 1)
+        self.fb.drawCircle(10, 8, 3, 1)
+        self.fb.drawEllipse(10, 8, 4, 3, 1)
+        self.fb.copyArea(0, 0, 4, 4, 8, 8)
+        calls = self.fb.getStats()["calls"]
+        for name in ("pixel", "horizontalLine", "verticalLine", "line", "circle", "ellipse", "copyArea"):
+            self.assertEqual(calls[name], 1, name)
+        self.assertEqual(calls["text"], 0)
+
+    def testPixels(self):
+        self.fb.setStats()
+        self.fb.drawHorizontalLine(0, 0, 10, 1)
+        self.fb.drawVerticalLine(0, 1, 5, 1)
+        self.fb.drawPixel(XRES - 1, YRES - 1, 1)
+        self.assertEqual(self.fb.getStats()["pixels"], 10 + 5 + 1)
+
+    def testFlushes(self):
+        self.fb.setStats()
+        self.fb.update()
+        self.fb.damage(0, 0, 2, 3)
+        self.fb.update()
+        stats = self.fb.getStats()
+        self.assertEqual(stats["flushes"], 2)
+        self.assertEqual(stats["flushBytes"], (XRES * YRES + 2 * 3) * 4)
+        self.assertGreater(stats["flushNs"], 0)
+        self.assertEqual(sum(stats["flushHistogram"]), 2)
+
+    def testReset(self):
+        self.fb.setStats()
+        self.fb.drawPixel(0, 0, 1)
+        self.fb.update()
+        self.assertEqual(self.fb.getStats(reset=True)["calls"]["pixel"], 1)
+        self.assertZero(self.fb.getStats())
+
+    def testDisable(self):
+        self.fb.setStats()
+        self.fb.drawPixel(0, 0, 1)
+        self.fb.setStats(False)
+        self.fb.drawPixel(0, 0, 1)
+        self.assertEqual(self.fb.getStats()["calls"]["pixel"], 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,81 @@
+"""
+Tests of the frame stream, decoded by the StreamReader over a socket pair.
+"""
+from pyframebuffer import stream
+import pyframebuffer as pfb
+
+import socket
+import time
+import unittest
+
+FBNUM = 5
+XRES = 100
+YRES = 70
+TILE = 16
+
+
+class StreamTest(unittest.TestCase):
+
+    def open(self, depth, encoding):
+        fb = pfb.openheadless(FBNUM, XRES, YRES, depth).__enter__()
+        self.addCleanup(fb.__exit__, None, None, None)
+        (writer, reader) = socket.socketpair()
+        self.addCleanup(writer.close)
+        self.addCleanup(reader.close)
+        fb.startStream(writer, encoding, TILE)
+        return (fb, stream.StreamReader(reader))
+
+    def drawFrame(self, fb, frame):
+        fb.drawLine(0, frame, XRES - 1, YRES - 1 - frame, 0x10203040 * (frame + 1) | 0xFF)
+        fb.fillTriangle(5, 5, 90, 10 + frame, 40, 60, (0xFF0000FF, 0x00FF00FF, 0x0000FFFF))
+        fb.drawPixel(XRES - 1, YRES - 1, 0xFFFFFFFF)
+
+    def testEncodings(self):
+        for depth in (16, 32):
+            for encoding in (stream.STREAM_RAW, stream.STREAM_RLE, stream.STREAM_QOI):
+                with self.subTest(depth=depth, encoding=encoding):
+                    (fb, reader) = self.open(depth, encoding)
+                    for frame in range(3):
+                        self.drawFrame(fb, frame)
+                        fb.update()
+                        (_, key, _) = reader.readFrame()
+                        self.assertEqual(key, frame == 0)
+                        self.assertEqual((reader.width, reader.height), (XRES, YRES))
+                        self.assertEqual(bytes(reader.frame), fb.capture(device=False))
+                    fb.stopStream()
+                    fb.__exit__(None, None, None)
+
+    def testChangedTiles(self):
+        (fb, reader) = self.open(32, stream.STREAM_RLE)
+        fb.update()
+        (_, key, areas) = reader.readFrame()
+        self.assertTrue(key)
+
+        # one pixel changes one tile
+        fb.drawPixel(TILE + 1, 2 * TILE + 1, 0xFF0000FF)
+        fb.update()
+        (_, key, areas) = reader.readFrame()
+        self.assertFalse(key)
+        self.assertEqual(areas, [(TILE, 2 * TILE, TILE, TILE)])
+        self.assertEqual(bytes(reader.frame), fb.capture(device=False))
+
+        # the thread counts a frame after writing it
+        deadline = time.monotonic() + 5
+        while fb.getStreamStats()["frames"] < 2 and time.monotonic() < deadline:
+            time.sleep(0.001)
+        stats = fb.getStreamStats()
+        self.assertEqual(stats["frames"], 2)
+        self.assertFalse(stats["failed"])
+
+    def testInvalidEncoding(self):
+        fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(fb.__exit__, None, None, None)
+        (writer, reader) = socket.socketpair()
+        self.addCleanup(writer.close)
+        self.addCleanup(reader.close)
+        with self.assertRaises(Exception):
+            fb.startStream(writer, 99, TILE)
+
+
+if __name__ == "__main__":
+    unittest.main()
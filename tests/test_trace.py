@@ -0,0 +1,87 @@
+"""
+Tests of the frame timeline tracing.
+"""
+from pyframebuffer import trace
+import pyframebuffer as pfb
+
+import json
+import os
+import tempfile
+import threading
+import unittest
+
+FBNUM = 9
+
+
+class TraceTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, 32, 16).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        self.addCleanup(trace.stop)
+
+    def dump(self):
+        with tempfile.TemporaryFile() as f:
+            count = trace.dump(f)
+            f.seek(0)
+            document = json.loads(f.read())
+        events = [event for event in document["traceEvents"] if event["ph"] == "X"]
+        self.assertEqual(len(events), count)
+        return (document, events)
+
+    def testEvents(self):
+        trace.start()
+        self.fb.drawLine(0, 0, 5, 5, 1)
+        self.fb.update()
+        trace.stop()
+        # not recorded after stopping
+        self.fb.drawPixel(0, 0, 1)
+
+        (_, events) = self.dump()
+        self.assertEqual([event["name"] for event in events], ["drawLine", "flushWrite", "flush"])
+        for event in events:
+            self.assertEqual(event["args"]["fb"], FBNUM)
+            self.assertEqual(event["pid"], os.getpid())
+            self.assertGreaterEqual(event["dur"], 0)
+        # the write is nested into the flush
+        (write, flush) = events[1:]
+        self.assertGreaterEqual(write["ts"], flush["ts"])
+        self.assertLessEqual(write["ts"] + write["dur"], flush["ts"] + flush["dur"] + 0.001)
+
+    def testStartDiscards(self):
+        trace.start()
+        self.fb.drawPixel(0, 0, 1)
+        trace.stop()
+        trace.start()
+        self.fb.drawCircle(8, 8, 4, 1)
+        trace.stop()
+        (_, events) = self.dump()
+        self.assertEqual([event["name"] for event in events], ["drawCircle"])
+
+    def testThreads(self):
+        trace.start()
+        threads = [threading.Thread(target=self.fb.drawPixel, args=(i, 0, 1)) for i in range(3)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        trace.stop()
+        (document, events) = self.dump()
+        self.assertEqual(len(events), 3)
+        # every thread has its own track with a name
+        names = [event for event in document["traceEvents"] if event["ph"] == "M"]
+        self.assertEqual({event["tid"] for event in names}, {event["tid"] for event in events})
+
+    def testDumpPath(self):
+        trace.start()
+        self.fb.drawPixel(0, 0, 1)
+        trace.stop()
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "trace.json")
+            self.assertEqual(trace.dump(path), 1)
+            with open(path) as f:
+                self.assertEqual(json.load(f)["displayTimeUnit"], "ms")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,95 @@
+"""
+Tests of the transformed blits and the affine matrices, on headless framebuffers.
+"""
+from pyframebuffer import transform
+import pyframebuffer as pfb
+
+import support
+import unittest
+
+SOURCE = 22
+FBNUM = 23
+XRES = 8
+YRES = 8
+RED = 0xFF0000FF
+GREEN = 0x00FF00FF
+BLUE = 0x0000FFFF
+# red, green, blue and a transparent white
+PIXELS = bytes([0xFF, 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0])
+
+
+class MatrixTest(unittest.TestCase):
+
+    def testMultiply(self):
+        matrix = transform.multiply(transform.translate(2, 3), transform.scale(4, 5))
+        self.assertEqual(matrix, (4.0, 0.0, 2.0, 0.0, 5.0, 3.0))
+        self.assertEqual(transform.multiply(), transform.identity())
+
+    def testRotate(self):
+        (a, b, c, d, e, f) = transform.rotate(90)
+        # clockwise on the screen, the X axis turns to the Y axis
+        self.assertEqual((round(a), round(b), round(d), round(e)), (0, -1, 1, 0))
+
+
+class BlitTest(unittest.TestCase):
+
+    def setUp(self):
+        self.source = pfb.openheadless(SOURCE, 2, 2).__enter__()
+        self.addCleanup(self.source.__exit__, None, None, None)
+        self.source.writeRect(0, 0, 2, 2, PIXELS)
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def testNearest(self):
+        self.fb.setStats()
+        self.fb.blitTransformed(self.source, transform.scale(4))
+        self.assertEqual(self.fb.getPixel(0, 0), RED)
+        self.assertEqual(self.fb.getPixel(3, 3), RED)
+        self.assertEqual(self.fb.getPixel(4, 0), GREEN)
+        self.assertEqual(self.fb.getPixel(0, 4), BLUE)
+        # the transparent quarter is skipped
+        self.assertEqual(self.fb.getPixel(7, 7), 0)
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["blitTransformed"], 1)
+        self.assertEqual(stats["pixels"], 3 * 4 * 4)
+
+    def testBilinear(self):
+        self.fb.blitTransformed(self.source, transform.scale(4), pfb.FILTER_BILINEAR)
+        row = [self.fb.getPixel(x, 0) for x in range(XRES)]
+        # the pixel centers keep their colors and the pixels between them blend
+        self.assertEqual(row[:2], [RED, RED])
+        self.assertEqual(row[6:], [GREEN, GREEN])
+        reds = [color >> 24 for color in row[1:7]]
+        greens = [color >> 16 & 0xFF for color in row[1:7]]
+        self.assertEqual(reds, sorted(reds, reverse=True))
+        self.assertEqual(greens, sorted(greens))
+
+    def testRotate(self):
+        matrix = transform.multiply(transform.translate(2, 0), transform.rotate(90))
+        self.fb.blitTransformed(self.source, matrix)
+        self.assertEqual(self.fb.getPixel(0, 0), BLUE)
+        self.assertEqual(self.fb.getPixel(1, 0), RED)
+        self.assertEqual(self.fb.getPixel(1, 1), GREEN)
+        self.assertEqual(self.fb.getPixel(0, 1), 0)
+
+    def testClip(self):
+        # the transformed source is clipped at the edges of the screen
+        self.fb.blitTransformed(self.source, transform.multiply(transform.translate(XRES - 2, YRES - 2), transform.scale(4)))
+        self.assertEqual(self.fb.getPixel(XRES - 1, YRES - 1), RED)
+        self.assertEqual(self.fb.getPixel(XRES - 3, YRES - 3), 0)
+
+    def testReplay(self):
+        def draw(fb):
+            with pfb.openheadless(SOURCE + 2, 2, 2) as source:
+                source.writeRect(0, 0, 2, 2, PIXELS)
+                fb.blitTransformed(source, transform.scale(4), pfb.FILTER_BILINEAR)
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[:4], bytes([0xFF, 0, 0, 0xFF]))
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
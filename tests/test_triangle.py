@@ -0,0 +1,98 @@
+"""
+Tests of the flat and Gouraud shaded triangle fills, on headless framebuffers.
+"""
+import pyframebuffer as pfb
+
+import array
+import support
+import unittest
+
+FBNUM = 30
+XRES = 8
+YRES = 8
+RED = 0xFF0000FF
+GREEN = 0x00FF00FF
+BLUE = 0x0000FFFF
+
+
+class TriangleTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+        self.fb.setStats()
+
+    def drawn(self):
+        """
+        Returns the rows of the screen as strings with R, G or B for the red, green and blue
+        pixels and a dot for the others.
+        """
+        names = {RED: "R", GREEN: "G", BLUE: "B"}
+        return ["".join(names.get(self.fb.getPixel(x, y), ".") for x in range(XRES)) for y in range(YRES)]
+
+    def testFlat(self):
+        self.fb.fillTriangle(0, 0, XRES, 0, 0, YRES, RED)
+        # a pixel is filled if its center is in the triangle
+        self.assertEqual(self.drawn()[:2], ["RRRRRRR.", "RRRRRR.."])
+        self.assertEqual(self.drawn()[-1], "........")
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["triangle"], 1)
+        self.assertEqual(stats["pixels"], 28)
+
+    def testSharedEdge(self):
+        self.fb.fillTriangle(0, 0, XRES, 0, 0, YRES, RED)
+        self.fb.fillTriangle(XRES, 0, XRES, YRES, 0, YRES, GREEN)
+        # the triangles sharing the diagonal fill every pixel once
+        self.assertEqual(self.drawn()[0], "RRRRRRRG")
+        self.assertEqual(self.drawn()[-1], "GGGGGGGG")
+        self.assertEqual(self.fb.getStats()["pixels"], XRES * YRES)
+
+    def testGouraud(self):
+        self.fb.fillTriangle(0, 0, XRES, 0, 0, YRES, (RED, GREEN, BLUE))
+        # every pixel is dominated by the color of its nearest vertex
+        for (x, y, shift) in ((0, 0, 24), (XRES - 2, 0, 16), (0, YRES - 2, 8)):
+            color = self.fb.getPixel(x, y)
+            channels = [color >> s & 0xFF for s in (24, 16, 8)]
+            self.assertEqual(max(channels), color >> shift & 0xFF)
+        # and the channels are blended from the three colors
+        row = [self.fb.getPixel(x, 0) for x in range(XRES - 1)]
+        reds = [color >> 24 for color in row]
+        self.assertEqual(reds, sorted(reds, reverse=True))
+
+    def testBatch(self):
+        vertices = array.array("f", [0, 0, XRES, 0, 0, YRES, XRES, 0, XRES, YRES, 0, YRES])
+        self.fb.fillTriangles(vertices, [RED, GREEN])
+        self.assertEqual(self.drawn()[0], "RRRRRRRG")
+        stats = self.fb.getStats()
+        self.assertEqual(stats["calls"]["triangle"], 1)
+        self.assertEqual(stats["pixels"], XRES * YRES)
+        # one color for all, or one per vertex
+        self.fb.fillTriangles(vertices, BLUE)
+        self.assertEqual(set("".join(self.drawn())), {"B"})
+        self.fb.fillTriangles(vertices, [RED, GREEN, BLUE] * 2)
+
+    def testClip(self):
+        self.fb.fillTriangle(-4, -4, XRES * 3, -4, -4, YRES * 3, RED)
+        self.assertEqual(set("".join(self.drawn())), {"R"})
+        self.assertEqual(self.fb.getStats()["pixels"], XRES * YRES)
+
+    def testInvalid(self):
+        with self.assertRaises(ValueError):
+            self.fb.fillTriangles(array.array("f", [0, 0, XRES, 0, 0]), RED)
+        with self.assertRaises(ValueError):
+            self.fb.fillTriangles(array.array("f", [0, 0, XRES, 0, 0, YRES]), [RED, GREEN])
+
+    def testReplay(self):
+        def draw(fb):
+            fb.fillTriangle(0, 0, XRES, 0, 0, YRES, (RED, GREEN, BLUE))
+            fb.fillTriangles(array.array("f", [XRES, 0, XRES, YRES, 0, YRES]), [GREEN])
+
+        self.fb.__exit__(None, None, None)
+        (recorded, replayed, result) = support.recordAndReplay(FBNUM, XRES, YRES, draw)
+        self.assertEqual(replayed, recorded)
+        self.assertEqual(recorded[-4:], bytes([0, 0xFF, 0, 0xFF]))
+        self.assertEqual(result["errors"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,110 @@
+"""
+Tests of the canvas and the viewport, on a headless framebuffer and, if one is
+accessible, on the device /dev/fb0 for the panning by the driver.
+"""
+import _pyfb as native  # type: ignore
+import pyframebuffer as pfb
+
+import unittest
+
+FBNUM = 3
+XRES = 32
+YRES = 24
+RED = 0xFF0000FF
+
+
+def pixelAt(screen, xres, x, y):
+    """
+    Returns the pixel of a capture as 32 bit color value.
+    """
+    return int.from_bytes(screen[(y * xres + x) * 4:(y * xres + x + 1) * 4], "big")
+
+
+class ViewportTest(unittest.TestCase):
+
+    def setUp(self):
+        self.fb = pfb.openheadless(FBNUM, XRES, YRES).__enter__()
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+    def testCanvas(self):
+        self.assertEqual(self.fb.getCanvasSize(), (XRES, YRES))
+        self.fb.setCanvas(3 * XRES, 2 * YRES)
+        self.assertEqual(self.fb.getCanvasSize(), (3 * XRES, 2 * YRES))
+        self.assertEqual(self.fb.getViewport(), (0, 0))
+        # drawing addresses the whole canvas
+        self.fb.drawPixel(3 * XRES - 1, 2 * YRES - 1, RED)
+        self.assertEqual(self.fb.getPixel(3 * XRES - 1, 2 * YRES - 1), RED)
+        with self.assertRaises(ValueError):
+            self.fb.setCanvas(XRES - 1, YRES)
+
+    def testScroll(self):
+        self.fb.setCanvas(2 * XRES, 2 * YRES)
+        for y in range(2 * YRES):
+            self.fb.drawHorizontalLine(0, y, 2 * XRES, y << 8 | 0xFF)
+        self.fb.drawPixel(XRES + 3, YRES + 2, RED)
+        self.fb.update()
+        self.assertEqual(pixelAt(self.fb.capture(), XRES, 0, 0), 0x000000FF)
+
+        self.fb.setViewport(XRES, YRES)
+        self.assertEqual(self.fb.getViewport(), (XRES, YRES))
+        screen = self.fb.capture()
+        self.assertEqual(pixelAt(screen, XRES, 0, 0), YRES << 8 | 0xFF)
+        self.assertEqual(pixelAt(screen, XRES, 3, 2), RED)
+        self.assertEqual(screen, self.fb.capture(device=False))
+
+    def testInvalidViewport(self):
+        self.fb.setCanvas(2 * XRES, YRES)
+        self.fb.setViewport(XRES, 0)
+        with self.assertRaises(ValueError):
+            self.fb.setViewport(XRES + 1, 0)
+        with self.assertRaises(ValueError):
+            self.fb.setViewport(0, 1)
+        self.assertEqual(self.fb.getViewport(), (XRES, 0))
+
+    def testSetCanvasResetsViewport(self):
+        self.fb.setCanvas(2 * XRES, 2 * YRES)
+        self.fb.drawPixel(0, 0, RED)
+        self.fb.setViewport(5, 5)
+        self.fb.setCanvas(2 * XRES, 2 * YRES)
+        self.assertEqual(self.fb.getViewport(), (0, 0))
+        self.assertEqual(self.fb.getPixel(0, 0), 0)
+
+
+class PanningTest(unittest.TestCase):
+    """
+    The driver panning needs a device with a virtual resolution larger than the screen.
+    """
+
+    def setUp(self):
+        try:
+            self.fb = pfb.openfb(0).__enter__()
+        except Exception:
+            self.skipTest("/dev/fb0 is not accessible")
+        self.addCleanup(self.fb.__exit__, None, None, None)
+
+        (self.xres, self.yres, self.depth) = self.fb.getResolution()
+        self.fb.setCanvas(self.xres, 2 * self.yres)
+        if not native.pyfb_getCanvas(0)[4]:
+            self.skipTest("the driver can not pan /dev/fb0")
+
+    def testDamageOnly(self):
+        self.fb.fill(0)
+        self.fb.update()
+        self.fb.setStats()
+
+        # moving the viewport writes nothing
+        self.fb.setViewport(0, self.yres)
+        self.assertEqual(self.fb.getStats()["flushes"], 0)
+
+        # a damaged pixel writes only the pixel
+        self.fb.drawPixel(5, self.yres + 5, RED)
+        self.fb.damage(5, 5, 1, 1)
+        self.fb.update()
+        stats = self.fb.getStats()
+        self.assertEqual(stats["flushes"], 1)
+        self.assertEqual(stats["flushBytes"], self.depth // 8)
+        self.assertEqual(pixelAt(self.fb.capture(), self.xres, 5, 5), RED)
+
+
+if __name__ == "__main__":
+    unittest.main()